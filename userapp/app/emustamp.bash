@@ -0,0 +1,43 @@
+#!/bin/bash
+
+# Description: Runs the unmodified sym560_cmdline auto against the emulated
+#	       card (sym560_emu.so, built by "make emu") at each of a list of
+#	       event rates, and prints how many of the events the card saw
+#	       were captured and written, i.e. the loss curve of the whole
+#	       program.  Where the written column falls away from generated is
+#	       the throughput ceiling of the machine it runs on.
+#		Usage: emustamp.bash [seconds] [rate ...]
+#	       Other generator settings (see sym560_emu.c) can be given in
+#	       SYM560_EMU, e.g. SYM560_EMU="jitter=2000,burst=5" emustamp.bash 5 1000
+#	       Rate 0 hands the program an event as fast as it can take them.
+
+APPDIR=`cd \`dirname $0\` && pwd`
+SECONDS_EACH=${1:-5}
+shift
+RATES=${@:-"100 1000 10000 50000 100000 0"}
+
+if [ ! -e $APPDIR/sym560_emu.so ] || [ ! -e $APPDIR/sym560_cmdline ]
+then
+	echo "Build sym560_cmdline and the emulator first (make; make emu)"
+	exit 1
+fi
+
+WORKDIR=`mktemp -d`
+printf "%10s %12s %12s %12s %12s %8s\n" rate generated captured written overwritten lost%
+for RATE in $RATES
+do
+	mkdir $WORKDIR/$RATE
+	cd $WORKDIR/$RATE
+	# nothing shared with a real automated mode on the same machine
+	LD_PRELOAD=$APPDIR/sym560_emu.so SYM560_EMU="rate=$RATE${SYM560_EMU:+,$SYM560_EMU}" \
+		SYM560_EMU_STATS=$WORKDIR/$RATE/emu.stats \
+		timeout -s TERM $SECONDS_EACH $APPDIR/sym560_cmdline auto -S none -L none -M none \
+		-C none -J none -B 0 > cmdline.log 2>&1
+	GENERATED=`awk '{print $3}' emu.stats`
+	OVERWRITTEN=`awk '{print $7}' emu.stats`
+	CAPTURED=`awk '/Timestamping stopped/ {print $3}' cmdline.log`
+	WRITTEN=`cat *.timestampdata | grep -c YEAR`
+	LOST=`awk -v g=$GENERATED -v w=$WRITTEN 'BEGIN {printf "%.3f", g ? 100 * (g - w) / g : 0}'`
+	printf "%10s %12s %12s %12s %12s %8s\n" $RATE $GENERATED $CAPTURED $WRITTEN $OVERWRITTEN $LOST
+done
+rm -rf $WORKDIR
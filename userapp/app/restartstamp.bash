@@ -1,22 +1,22 @@
 #!/bin/bash
 
-# Description: Stops the automated timestamping by killing the event_cap
-#	       Process.
-#		Then restarts it. This is so that we can do intervals using cron
-# and miss less pulses when we restart the timestamping program.
+# Description: Starts a new timestamp file without stopping the automated
+#	       timestamping, by sending SIGHUP to the sym560_cmdline auto
+#	       process.  No pulses are missed across the switch.  If the
+#	       program is not running it is started.
+#		This is so that we can do intervals using cron.  Passing
+#	       "-r 3600" to sym560_cmdline auto gives hourly files without cron.
 
-# get process id of event_cap
-CHILD_PID=`ps aux | grep event_cap | awk '$11 !~ /grep/ {print $2}'`
+# get process id of sym560_cmdline auto
+AUTO_PID=`ps aux | grep "sym560_cmdline auto" | awk '$11 !~ /grep/ {print $2}'`
 
-echo "Killing PID = $CHILD_PID"
+if [ "${AUTO_PID}" != "" ]
+then
+	echo "Rotating PID = $AUTO_PID"
+	kill -HUP $AUTO_PID
+	exit 0
+fi
 
-while [ "${CHILD_PID}" != "" ]
-do
-	kill -9 $CHILD_PID
-	CHILD_PID=`ps aux | grep event_cap | awk '$11 !~ /grep/ {print $2}'`
-done
-
-# Now restart the sym560 command line program
+# Not running, so start the sym560 command line program
 cd /home/dds/epop_timestamps 
 sym560_cmdline auto >> /home/dds/logging/sym560cmdlineautolog.txt 2>&1
-
@@ -1,12 +1,13 @@
 #!/bin/bash
 
-# Description: Stops the automated timestamping by killing the event_cap
-#	       Process.
+# Description: Stops the automated timestamping by sending SIGTERM to the
+#	       sym560_cmdline auto process, which then writes out any
+#	       timestamps still buffered and exits.
 
-# get process id of event_cap
-CHILD_PID=`ps aux | grep event_cap | awk '$11 !~ /grep/ {print $2}'`
+# get process id of sym560_cmdline auto
+AUTO_PID=`ps aux | grep "sym560_cmdline auto" | awk '$11 !~ /grep/ {print $2}'`
 
-echo "Killing PID = $CHILD_PID"
+echo "Stopping PID = $AUTO_PID"
 
-# kill event_cap
-kill -9 $CHILD_PID
+# stop sym560_cmdline auto
+kill -TERM $AUTO_PID
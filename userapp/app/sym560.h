@@ -0,0 +1,77 @@
+/* File : 	sym560.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	libsym560, the capture pipeline without the menus, for programs
+ *		that want the event timestamps themselves rather than a file of
+ *		them (built by make lib as libsym560.a and libsym560.so).  The
+ *		caller owns everything: the handle, the ring memory the capture
+ *		thread fills and the buffers records are read into, so the library
+ *		allocates nothing and never prints or asks for input once open.
+ *
+ *		A program opens the card (or a simulator), configures it, starts
+ *		capture and then takes events in whichever way suits it:
+ *		sym560_read blocks for a batch, sym560_try_read never blocks, for
+ *		event loops and coroutines that poll on their own timer, and
+ *		sym560_dispatch hands batches to a callback straight from the ring
+ *		without copying them.  Only one thread may take events from a
+ *		handle.  The capture thread is woken with SIGUSR1, so the library
+ *		installs a handler for it on sym560_start.
+ *
+ *		The real-time profile (cfg->rt) reaches past the handle: on open
+ *		it locks all of the process's memory, present and future, and with
+ *		cfg->rt_cpu set sym560_start takes that CPU out of the calling
+ *		thread's affinity, which threads the caller creates afterwards
+ *		inherit.  What of it could not be applied is not printed but left
+ *		for sym560_rt_status.
+ */
+
+#ifndef SYM560_H
+#define SYM560_H
+
+#include <stdint.h>
+#include "sym560_capture.h"
+#include "sym560_device.h"
+#include "sym560_record.h"
+#include "sym560_sim.h"
+#include "sym560_status.h"
+
+/* bytes of ring memory to give sym560_open for 2^order records */
+#define SYM560_RING_BYTES(order)	(sizeof(struct sym560_record) << (order))
+
+/* ring memory must be aligned to this */
+#define SYM560_RING_ALIGN	RING_CACHELINE
+
+/* sym560_read: wait for events without a time limit */
+#define SYM560_FOREVER		-1
+
+struct sym560 {
+	int devfd;			/* /dev/symgps, -1 with a simulator */
+	struct sim *sim;		/* simulated source, NULL to use the card */
+	struct capture cap;
+	int running;			/* between sym560_start and sym560_stop */
+};
+
+/* called by sym560_dispatch with up to max records, in order, which are only
+ * valid until it returns */
+typedef void (*sym560_handler)(const struct sym560_record *rec, int n, void *arg);
+
+/* function declarations */
+int sym560_open(struct sym560 *h, const char *dev, const struct cap_config *cfg, void *ring_mem,
+		unsigned int order);
+int sym560_open_sim(struct sym560 *h, struct sim *sim, const struct cap_config *cfg, void *ring_mem,
+		unsigned int order);
+int sym560_set_event_source(struct sym560 *h, int source);
+int sym560_get_event_setup(struct sym560 *h, char *event, char *edge);
+int sym560_set_rate(struct sym560 *h, int rate);
+int sym560_gps_sync(struct sym560 *h);
+int sym560_start(struct sym560 *h);
+int sym560_stop(struct sym560 *h);
+void sym560_close(struct sym560 *h);
+int sym560_status(struct sym560 *h, struct sym560_status *st);
+int sym560_rt_status(struct sym560 *h);
+int sym560_time(struct sym560 *h, int64_t *ns);
+int sym560_try_read(struct sym560 *h, struct sym560_record *recs, int max);
+int sym560_read(struct sym560 *h, struct sym560_record *recs, int max, int timeout_ms);
+int sym560_dispatch(struct sym560 *h, sym560_handler fn, void *arg, int max);
+
+#endif /* SYM560_H */
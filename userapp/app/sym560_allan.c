@@ -0,0 +1,142 @@
+/* File : 	sym560_allan.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Streaming overlapping Allan deviation of sequence starts (see
+ *		sym560_allan.h).  adev_add takes the starts one at a time in
+ *		order; adev_deviation turns the sums, of one estimator or of many
+ *		merged with adev_merge, into the deviation at each tau.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sym560_allan.h"
+
+/*******************************************************************************/
+/* Function   : adev_init
+ * Inputs     : struct adev *a - estimator
+ * Returns    : Nothing
+ */
+void adev_init(struct adev *a) {
+	memset(a, 0, sizeof(*a));
+}
+/* end of function: adev_init */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : adev_term
+ * Inputs     : struct adev *a - estimator
+ *		const int64_t *x - ring of a level
+ *		uint64_t j - sample just added to it, counting from the run's first
+ *		int s - m, in samples of the level
+ *		int octave - which tau that is
+ * Returns    : Nothing
+ */
+static void adev_term(struct adev *a, const int64_t *x, uint64_t j, int s, int octave) {
+	int64_t d;
+
+	if (j < 2 * (uint64_t)s) {
+		return;
+	}
+	d = x[j & (ADEV_RING - 1)] - 2 * x[(j - s) & (ADEV_RING - 1)] + x[(j - 2 * s) & (ADEV_RING - 1)];
+	a->s.sum[octave] += (double)d * d;
+	a->s.n[octave]++;
+}
+/* end of function: adev_term */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : adev_add
+ * Inputs     : struct adev *a - estimator
+ *		int64_t ns - start of the table's next sequence
+ * Returns    : Nothing
+ * Description: Level L takes every 2^L-th start of the run.  The first level
+ *		works out m = 1, 2, 4 and 8, each of the others m = 8 of its own
+ *		samples.
+ */
+void adev_add(struct adev *a, int64_t ns) {
+	int64_t dt = ns - a->last;
+	uint64_t j;
+	int64_t *x;
+	int level, o;
+
+	if (a->last == 0 || dt <= 0 || (a->period != 0 && llabs(dt - a->period) > ADEV_GAP_NS)) {
+		a->k = 0;
+		a->period = 0;
+		a->s.runs++;
+	}
+	else {
+		if (a->period == 0) {
+			a->period = dt;
+		}
+		a->s.period_sum += dt;
+		a->s.periods++;
+	}
+	a->last = ns;
+
+	for (level = 0; level < ADEV_LEVELS && (a->k & ((1ULL << level) - 1)) == 0; level++) {
+		j = a->k >> level;
+		x = a->x[level];
+		x[j & (ADEV_RING - 1)] = ns;
+		if (level == 0) {
+			for (o = 0; o <= ADEV_DEPTH; o++) {
+				adev_term(a, x, j, 1 << o, o);
+			}
+		}
+		else {
+			adev_term(a, x, j, ADEV_STEP, level + ADEV_DEPTH);
+		}
+	}
+	a->k++;
+}
+/* end of function: adev_add */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : adev_merge
+ * Inputs     : struct adev_sums *to - sums added to
+ *		const struct adev_sums *from - sums to add
+ * Returns    : Nothing
+ */
+void adev_merge(struct adev_sums *to, const struct adev_sums *from) {
+	int o;
+
+	to->period_sum += from->period_sum;
+	to->periods += from->periods;
+	to->runs += from->runs;
+	for (o = 0; o < ADEV_OCTAVES; o++) {
+		to->sum[o] += from->sum[o];
+		to->n[o] += from->n[o];
+	}
+}
+/* end of function: adev_merge */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : adev_deviation
+ * Inputs     : const struct adev_sums *s - sums
+ *		int octave - tau of 2^octave periods
+ *		double *tau - receives tau, s
+ *		double *dev - receives the Allan deviation there
+ * Returns    : 0 on success
+ *             -1 if nothing was added at that tau
+ * Description: tau is taken as 2^octave mean periods, so sums of runs at
+ *		slightly different periods still add up.
+ */
+int adev_deviation(const struct adev_sums *s, int octave, double *tau, double *dev) {
+	double tau0, m = (double)(1ULL << octave);
+
+	if (s->n[octave] == 0 || s->periods == 0) {
+		return -1;
+	}
+	tau0 = (double)s->period_sum / s->periods / 1e9;
+	*tau = m * tau0;
+	*dev = sqrt(s->sum[octave] / (2.0 * s->n[octave])) / 1e9 / *tau;
+	return 0;
+}
+/* end of function: adev_deviation */
+/*******************************************************************************/
@@ -0,0 +1,68 @@
+/* File : 	sym560_allan.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Streaming overlapping Allan deviation of the starts of a pulse
+ *		table's sequences, to tell drift of the radar's clock from
+ *		trouble with the card.  The starts are taken as phase samples one
+ *		period apart, so the deviation at tau = m periods comes from the
+ *		second differences x[i + 2m] - 2 x[i + m] + x[i], in which the
+ *		period itself cancels.
+ *
+ *		tau runs over 1, 2, 4 ... 2^19 periods (over 10 hours at 70 ms).
+ *		Every start is kept for m up to 8; beyond that level L keeps one
+ *		start in 2^L, so m = 8 * 2^L is worked out 8 times over each 2m
+ *		rather than at every start.  The memory is fixed and each start
+ *		costs under two levels' work on average.
+ *
+ *		A start that is not one period after the last (a sequence missed,
+ *		or the radar paused) begins a new run, since the samples must be
+ *		evenly spaced.  Only the sums are kept, so those of any number of
+ *		minutes, files or stations add up to the deviation over all of
+ *		them.
+ */
+
+#ifndef SYM560_ALLAN_H
+#define SYM560_ALLAN_H
+
+#include <stdint.h>
+
+/* tau of 1, 2, 4 ... 2^(ADEV_OCTAVES - 1) periods */
+#define ADEV_OCTAVES		20
+
+/* m is 2^ADEV_DEPTH samples at every level but the first */
+#define ADEV_DEPTH		3
+#define ADEV_STEP		(1 << ADEV_DEPTH)
+#define ADEV_LEVELS		(ADEV_OCTAVES - ADEV_DEPTH)
+
+/* samples kept at each level, a power of 2 of at least 2 * ADEV_STEP + 1 */
+#define ADEV_RING		32
+
+/* a start this far from one period after the last begins a new run, ns */
+#define ADEV_GAP_NS		100000
+
+/* What adds up.  Written as it is into the timing files (sym560_timing.h),
+ * so its layout is fixed. */
+struct adev_sums {
+	int64_t period_sum;		/* periods of the runs, ns */
+	uint32_t periods;		/* how many */
+	uint32_t runs;			/* runs begun */
+	double sum[ADEV_OCTAVES];	/* squared second differences, ns^2 */
+	uint32_t n[ADEV_OCTAVES];	/* how many */
+};
+
+/* one table's estimator */
+struct adev {
+	struct adev_sums s;
+	int64_t last;			/* last start, 0 = none yet */
+	int64_t period;			/* of the run, 0 until its second start */
+	uint64_t k;			/* starts in the run */
+	int64_t x[ADEV_LEVELS][ADEV_RING];	/* recent starts at each level */
+};
+
+/* function declarations */
+void adev_init(struct adev *a);
+void adev_add(struct adev *a, int64_t ns);
+void adev_merge(struct adev_sums *to, const struct adev_sums *from);
+int adev_deviation(const struct adev_sums *s, int octave, double *tau, double *dev);
+
+#endif /* SYM560_ALLAN_H */
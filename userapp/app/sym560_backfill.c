@@ -0,0 +1,349 @@
+/* File : 	sym560_backfill.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	"sym560_cmdline backfill" (see sym560_backfill.h).  The files
+ *		are read in the order given through one pulse sequence detector,
+ *		as the tracker would have seen them had they been captured with
+ *		-Q, so sequences and the Allan deviation's runs carry on from one
+ *		file into the next.  Each minute's timing records (sym560_timing.h)
+ *		are appended to its day's YYYYMMDD.timing as soon as a sequence
+ *		of the next minute is found, so an archive of any length is read
+ *		in fixed memory.  The time index of each file (sym560_index.h) is
+ *		made again beside it while it is read, and each event can be
+ *		added to a column store (sym560_column.h) as the writer would.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include "sym560_record.h"
+#include "sym560_pulses.h"
+#include "sym560_timing.h"
+#include "sym560_index.h"
+#include "sym560_column.h"
+#include "sym560_backfill.h"
+
+/* what backfill has written */
+struct bf_out {
+	const char *outdir;
+	char *buf;			/* a minute's records */
+	uint64_t minutes;
+	int errors;
+	int idxfd;			/* index of the file being read, -1 = none */
+	struct idx_entry idx[IDX_SLICE];	/* entries not yet written to it */
+	int idx_len;
+	uint64_t entries;		/* index entries written */
+	const char *coldir;		/* column store, NULL = none */
+	struct col_day day;		/* the day being appended to */
+	struct col_pend pend;		/* rows waiting for the detector */
+	struct col_slice slice;		/* rows not yet written */
+	int col_len;
+	uint64_t rows;			/* rows written */
+};
+
+/*******************************************************************************/
+/* Function   : bf_minute
+ * Inputs     : struct bf_out *o - output
+ *		struct tim_acc *acc - minute being added up
+ * Returns    : Nothing
+ * Description: Appends the minute's records to its day's file and empties it.
+ */
+static void bf_minute(struct bf_out *o, struct tim_acc *acc) {
+	char name[TIM_FILENAME_LEN], path[PATH_MAX];
+	int64_t minute = acc->minute;
+	size_t len;
+	FILE *fp;
+
+	len = tim_acc_take(acc, o->buf);
+	if (len == 0) {
+		return;
+	}
+	tim_filename(minute, name);
+	snprintf(path, sizeof(path), "%s/%s", o->outdir, name);
+	fp = fopen(path, "a");
+	if (fp == NULL || fwrite(o->buf, len, 1, fp) != 1) {
+		/* say so once, not every minute */
+		if (o->errors++ == 0) {
+			printf("\nCould not write %s: %s\n", path, strerror(errno));
+		}
+	}
+	else {
+		o->minutes++;
+	}
+	if (fp != NULL) {
+		fclose(fp);
+	}
+}
+/* end of function: bf_minute */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bf_index
+ * Inputs     : struct bf_out *o - output
+ *		const char *file - file the index is of
+ * Returns    : Nothing
+ * Description: Writes out the entries kept so far.
+ */
+static void bf_index(struct bf_out *o, const char *file) {
+	ssize_t len = o->idx_len * sizeof(struct idx_entry);
+
+	if (o->idx_len == 0) {
+		return;
+	}
+	if (write(o->idxfd, o->idx, len) != len) {
+		if (o->errors++ == 0) {
+			printf("\nCould not write the index of %s: %s\n", file, strerror(errno));
+		}
+	}
+	else {
+		o->entries += o->idx_len;
+	}
+	o->idx_len = 0;
+}
+/* end of function: bf_index */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bf_col_write
+ * Inputs     : struct bf_out *o - output, with a column store
+ * Returns    : Nothing
+ * Description: Appends the rows kept so far to the day's columns.
+ */
+static void bf_col_write(struct bf_out *o) {
+	ssize_t len[COL_NCOL];
+	const void *col[COL_NCOL];
+	int k;
+
+	if (o->col_len == 0) {
+		return;
+	}
+	col[COL_TIME] = o->slice.ns;
+	col[COL_FLAGS] = o->slice.flags;
+	col[COL_SEQ] = o->slice.seq;
+	len[COL_TIME] = o->col_len * sizeof(*o->slice.ns);
+	len[COL_FLAGS] = o->col_len * sizeof(*o->slice.flags);
+	len[COL_SEQ] = o->col_len * sizeof(*o->slice.seq);
+	for (k = 0; k < COL_NCOL; k++) {
+		if (write(o->day.fd[k], col[k], len[k]) != len[k]) {
+			if (o->errors++ == 0) {
+				printf("\nCould not write the column store in %s: %s\n", o->coldir, strerror(errno));
+			}
+			break;
+		}
+	}
+	if (k == COL_NCOL) {
+		o->rows += o->col_len;
+	}
+	o->col_len = 0;
+}
+/* end of function: bf_col_write */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bf_columns
+ * Inputs     : struct bf_out *o - output, with a column store
+ *		int64_t upto - rows from this time on may still be pulses of a
+ *			       sequence the detector has not finished, INT64_MAX
+ *			       if there is no such sequence
+ * Returns    : Nothing
+ * Description: Moves the rows held back before upto into the slice, writing
+ *		it out when it is full or the day changes.  A day that cannot
+ *		be opened is left out.
+ */
+static void bf_columns(struct bf_out *o, int64_t upto) {
+	const struct col_row *r;
+
+	while ((r = col_pend_next(&o->pend, upto)) != NULL) {
+		if (r->ns / COL_DAY_NS != o->day.day) {
+			bf_col_write(o);
+			col_close(&o->day);
+			if (col_open(&o->day, o->coldir, r->ns) != 0 && o->errors++ == 0) {
+				printf("\nCould not open the column store's day in %s, leaving it out\n", o->coldir);
+			}
+		}
+		if (o->col_len == COL_SLICE) {
+			bf_col_write(o);
+		}
+		if (o->day.fd[0] != -1) {
+			o->slice.ns[o->col_len] = r->ns;
+			o->slice.flags[o->col_len] = r->flags;
+			o->slice.seq[o->col_len++] = col_seq_id(&o->day, r->tag);
+		}
+		col_pend_pop(&o->pend);
+	}
+}
+/* end of function: bf_columns */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bf_sequence
+ * Inputs     : struct bf_out *o - output
+ *		struct tim_acc *acc - minute being added up
+ *		int ret - what the detector returned
+ *		const struct seq_result *seq - the sequence, for SEQ_DONE
+ * Returns    : Nothing
+ */
+static void bf_sequence(struct bf_out *o, struct tim_acc *acc, int ret, const struct seq_result *seq) {
+	if (ret != SEQ_DONE) {
+		return;
+	}
+	if (o->coldir != NULL) {
+		col_pend_tag(&o->pend, seq);
+	}
+	if (tim_acc_due(acc, seq)) {
+		bf_minute(o, acc);
+	}
+	tim_acc_add(acc, seq);
+}
+/* end of function: bf_sequence */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : backfill
+ * Inputs     : char **files - timestamp files, in the order they were captured
+ *		int nfile - how many
+ *		const char *outdir - directory the day files are appended to
+ *		int format - PLS_TEXT or PLS_RAW
+ *		const char *tables - pulse tables (see seq_set_parse), NULL for no
+ *				     timing files
+ *		int64_t tol - how far from them a separation may be, ns
+ *		int64_t index_ns - time index interval, 0 for no index
+ *		const char *coldir - column store to add the events to, NULL
+ *				     for none
+ * Returns    : 0 on success
+ *             -1 if a table is not valid or a file could not be read or
+ *		written
+ * Description: A file that cannot be opened is passed over, ending the
+ *		Allan deviation's run at the gap it leaves.  Each index entry
+ *		points at the line after the record before its event, as the
+ *		writer's do, which may be a LOCK or MARKER line.  The rows of the
+ *		column store have REC_LOCK_UNKNOWN, as the files are read
+ *		without their LOCK lines.
+ */
+int backfill(char **files, int nfile, const char *outdir, int format, const char *tables, int64_t tol,
+		int64_t index_ns, const char *coldir) {
+	char name[PATH_MAX];
+	struct seq_set set;
+	struct seq_det det;
+	struct seq_result seq;
+	struct tim_acc acc;
+	struct pls_input in;
+	struct bf_out *o;
+	int64_t ns, stray, bucket;
+	long pos;
+	int f, k, ret = 0;
+
+	o = calloc(1, sizeof(*o));
+	if (o == NULL) {
+		return -1;
+	}
+	o->outdir = outdir;
+	o->coldir = coldir;
+	for (k = 0; k < COL_NCOL; k++) {
+		o->day.fd[k] = -1;
+	}
+	o->day.day = -1;
+	if (coldir != NULL && mkdir(coldir, 00755) != 0 && errno != EEXIST) {
+		printf("\nCould not create %s: %s\n", coldir, strerror(errno));
+		free(o);
+		return -1;
+	}
+	if (tables != NULL) {
+		if (seq_set_parse(&set, tables, tol) != 0) {
+			printf("\nInvalid pulse tables %s\n", tables);
+			free(o);
+			return -1;
+		}
+		o->buf = malloc(set.ntab * TIM_RECORD_MAX);
+		if (o->buf == NULL || tim_acc_init(&acc, &set, TIM_DEFAULT_WINDOW_NS) != 0) {
+			free(o->buf);
+			free(o);
+			seq_set_free(&set);
+			return -1;
+		}
+		seq_init(&det, &set);
+	}
+
+	for (f = 0; f < nfile; f++) {
+		memset(&in, 0, sizeof(in));
+		in.format = format;
+		if (rec_map_open(&in.map, files[f]) != 0) {
+			printf("\nCould not open %s: %s\n", files[f], strerror(errno));
+			ret = -1;
+			continue;
+		}
+		o->idxfd = -1;
+		if (index_ns > 0 && (idx_name(files[f], name, sizeof(name)) != 0
+				|| (o->idxfd = idx_open(name, format, index_ns, 1)) == -1)) {
+			printf("\nCould not open the index of %s\n", files[f]);
+			ret = -1;
+		}
+		bucket = -1;
+		pos = in.map.pos;
+		while (pls_read(&in, &ns) == 0) {
+			if (o->idxfd != -1 && idx_due(&bucket, ns, index_ns)) {
+				if (o->idx_len == IDX_SLICE) {
+					bf_index(o, files[f]);
+				}
+				o->idx[o->idx_len].ns = ns;
+				o->idx[o->idx_len++].offset = pos;
+			}
+			if (coldir != NULL) {
+				col_pend_add(&o->pend, ns, REC_LOCK_UNKNOWN);
+			}
+			if (tables != NULL) {
+				bf_sequence(o, &acc, seq_feed(&det, ns, &seq, &stray), &seq);
+			}
+			if (coldir != NULL) {
+				bf_columns(o, tables != NULL ? seq_oldest(&det) : INT64_MAX);
+			}
+			pos = in.map.pos;
+			/* past the blank line, where the writer's entry would be */
+			while (format == PLS_TEXT && pos < in.map.size && in.map.buf[pos] == '\n') {
+				pos++;
+			}
+		}
+		if (o->idxfd != -1) {
+			bf_index(o, files[f]);
+			close(o->idxfd);
+		}
+		rec_map_close(&in.map);
+	}
+
+	printf("%d files read", nfile);
+	if (tables != NULL) {
+		while ((f = seq_flush(&det, &seq, &stray)) != SEQ_NONE) {
+			bf_sequence(o, &acc, f, &seq);
+		}
+		bf_minute(o, &acc);
+		printf(", %llu sequences, %llu minutes of timing written to %s",
+				(unsigned long long)det.sequences, (unsigned long long)o->minutes, outdir);
+		tim_acc_free(&acc);
+		free(o->buf);
+		seq_set_free(&set);
+	}
+	if (index_ns > 0) {
+		printf(", %llu index entries written", (unsigned long long)o->entries);
+	}
+	if (coldir != NULL) {
+		bf_columns(o, INT64_MAX);
+		bf_col_write(o);
+		col_close(&o->day);
+		printf(", %llu rows added to %s", (unsigned long long)o->rows, coldir);
+	}
+	printf("\n");
+	ret = o->errors != 0 ? -1 : ret;
+	free(o);
+	return ret;
+}
+/* end of function: backfill */
+/*******************************************************************************/
@@ -0,0 +1,18 @@
+/* File : 	sym560_backfill.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Makes the sidecar files the automatic mode writes while
+ *		capturing for timestamp files captured without them, so archives
+ *		can be read the same way as new data.
+ */
+
+#ifndef SYM560_BACKFILL_H
+#define SYM560_BACKFILL_H
+
+#include <stdint.h>
+
+/* function declarations */
+int backfill(char **files, int nfile, const char *outdir, int format, const char *tables, int64_t tol,
+		int64_t index_ns, const char *coldir);
+
+#endif /* SYM560_BACKFILL_H */
@@ -0,0 +1,689 @@
+/* File : 	sym560_batch.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Parallel batch findpulse (see sym560_batch.h).
+ *
+ *		A chunk may only start at an event that comes at least a whole
+ *		sequence (the longest table plus the tolerance) after the one
+ *		before it.  No open sequence can take such an event and it cannot
+ *		pair with the one before, so whatever came before, the detector
+ *		is left holding just that event, exactly as a fresh one started
+ *		at it would be.  The chunk before ends with pls_break, which
+ *		writes what the next event would have made it write.  The last
+ *		thing it writes starts less than a sequence before the break, so
+ *		breaks are also kept out of the first sequence's length of each
+ *		hour, and the chunk after knows which PULSES TIMESTAMPED FOR came
+ *		last without waiting for the chunk before to finish.
+ *
+ *		The chunks are dealt round robin to one deque per thread.  A
+ *		thread takes its own from the front, in file order, and when it
+ *		has none left takes from the back of another's.  As nothing is
+ *		added once they start, a thread that finds every deque empty is
+ *		done.  Chunks are a few MB of input, so a lock per deque costs
+ *		nothing measurable.  The thread that finishes the last chunk of a
+ *		file writes it out and frees its chunks' output.  Files whose
+ *		output has the same name (because they start in the same minute)
+ *		are appended to it in the order they were given, as findpulse
+ *		would.
+ *
+ *		A chunk in which the input stops making sense (rec_map_text
+ *		fails before its end) ends the file there with the EOF line, as
+ *		findpulse does, and the chunks after it are dropped.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sym560_record.h"
+#include "sym560_pulses.h"
+#include "sym560_batch.h"
+
+#define NS_PER_HOUR	(3600 * 1000000000LL)
+
+/* stdio buffer for a chunk's output, and its first allocation */
+#define BAT_BUFFER	(1 << 20)
+#define BAT_OUT_MIN	(1 << 20)
+
+struct bat_chunk {
+	int file;
+	long begin;			/* bytes of the file it covers */
+	long end;
+	int64_t hour;			/* for pls_resume, -1 for a file's first chunk */
+	int stopped;			/* the input went bad in it */
+	char *out;			/* what it wrote */
+	size_t len;
+	size_t alloc;
+	uint64_t sequences;		/* its detector's counts */
+	uint64_t pulses;
+	uint64_t missing;
+	uint64_t strays;
+};
+
+struct bat_file {
+	const char *path;
+	char *map;			/* the file, NULL once written */
+	long size;
+	int events;			/* 0, 1 or 2 for two or more */
+	char name[PLS_FILENAME_LEN];	/* its output */
+	int first;			/* its chunks */
+	int nchunk;
+	atomic_int left;		/* chunks still to run */
+	int prior;			/* previous file with the same output, -1 if none */
+	int next;			/* next one, -1 if none */
+	int done;			/* all chunks run */
+	int written;
+};
+
+struct bat_deque {
+	pthread_mutex_t lock;
+	int *task;			/* chunks task[head] to task[tail - 1] are left */
+	int head;
+	int tail;
+};
+
+struct bat_pool {
+	struct bat_file *file;
+	int nfile;
+	struct bat_chunk *chunk;
+	int nchunk;
+	struct bat_deque dq[BAT_MAX_THREADS];
+	int nthread;
+	const struct seq_set *set;
+	int format;
+	const char *outdir;
+	pthread_mutex_t wlock;		/* serialises writing the files out */
+	int failed;
+};
+
+struct bat_worker {
+	struct bat_pool *b;
+	int id;
+	pthread_t tid;
+};
+
+
+/*******************************************************************************/
+/* Function   : bat_add
+ * Inputs     : struct bat_pool *b - batch
+ *		int fi - file the chunk is of
+ *		long begin, end - bytes of the file it covers
+ *		int64_t hour - for pls_resume, -1 for the first chunk
+ * Returns    : 0 on success
+ *             -1 if out of memory
+ */
+static int bat_add(struct bat_pool *b, int fi, long begin, long end, int64_t hour) {
+	struct bat_chunk *c;
+
+	if ((b->nchunk & (b->nchunk - 1)) == 0) {
+		c = realloc(b->chunk, (b->nchunk ? 2 * b->nchunk : 1) * sizeof(*c));
+		if (c == NULL) {
+			return -1;
+		}
+		b->chunk = c;
+	}
+	c = &b->chunk[b->nchunk++];
+	memset(c, 0, sizeof(*c));
+	c->file = fi;
+	c->begin = begin;
+	c->end = end;
+	c->hour = hour;
+	b->file[fi].nchunk++;
+	return 0;
+}
+/* end of function: bat_add */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bat_input
+ * Inputs     : const struct bat_pool *b - batch
+ *		const struct bat_file *f - mapped file
+ *		long begin, end - bytes of it to read
+ *		struct pls_input *in - receives the input
+ * Returns    : Nothing
+ */
+static void bat_input(const struct bat_pool *b, const struct bat_file *f, long begin, long end,
+		struct pls_input *in) {
+	memset(in, 0, sizeof(*in));
+	in->format = b->format;
+	in->map.buf = f->map;
+	in->map.size = end;
+	in->map.pos = begin;
+}
+/* end of function: bat_input */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bat_split
+ * Inputs     : struct bat_pool *b - batch
+ *		const struct bat_file *f - file to split
+ *		long from - where to start looking
+ *		long *at - receives where the next chunk starts
+ *		int64_t *hour - receives the hour of the event before it
+ * Returns    : 0 if a place was found
+ *             -1 if there is none after from
+ * Description: The first event at least a sequence after the one before it
+ *		and not in the first sequence's length of an hour (see above).
+ *		Looking starts at the record after from, so the events compared
+ *		are always neighbours.
+ */
+static int bat_split(const struct bat_pool *b, const struct bat_file *f, long from, long *at, int64_t *hour) {
+	int64_t gap = b->set->span + b->set->tol, margin = b->set->span + 2 * b->set->tol;
+	struct pls_input in;
+	int64_t ns, prev = 0;
+	char *nl;
+	long pos;
+	int have = 0;
+
+	if (b->format == PLS_RAW) {
+		from = (from + REC_RAW_LEN - 1) / REC_RAW_LEN * REC_RAW_LEN;
+	}
+	else if (from < f->size && (nl = memchr(f->map + from, '\n', f->size - from)) != NULL) {
+		from = nl - f->map + 1;
+	}
+	if (from >= f->size) {
+		return -1;
+	}
+	bat_input(b, f, from, f->size, &in);
+	for (;;) {
+		pos = in.map.pos;
+		if (pls_read(&in, &ns) != 0) {
+			return -1;
+		}
+		if (have && ns - prev >= gap && (prev - margin) / NS_PER_HOUR == prev / NS_PER_HOUR) {
+			break;
+		}
+		prev = ns;
+		have = 1;
+	}
+	*at = pos;
+	*hour = prev / NS_PER_HOUR;
+	return 0;
+}
+/* end of function: bat_split */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bat_plan
+ * Inputs     : struct bat_pool *b - batch
+ *		int fi - file to plan
+ *		long chunk - input per chunk, bytes
+ * Returns    : 0 on success, including when there is nothing in the file
+ *             -1 if it cannot be read or out of memory
+ * Description: Maps the file, names its output after its first event and
+ *		cuts it into chunks.  As with findpulse, a file of fewer than two
+ *		events gets no output and no chunks.
+ */
+static int bat_plan(struct bat_pool *b, int fi, long chunk) {
+	struct bat_file *f = &b->file[fi];
+	struct stat st;
+	int64_t first, ns, hour = -1, next;
+	struct pls_input in;
+	long begin = 0, at;
+	int fd;
+
+	f->first = b->nchunk;
+	f->prior = -1;
+	f->next = -1;
+	fd = open(f->path, O_RDONLY);
+	if (fd == -1 || fstat(fd, &st) == -1) {
+		printf("\nCould not open %s: %s\n", f->path, strerror(errno));
+		if (fd != -1) {
+			close(fd);
+		}
+		return -1;
+	}
+	f->size = st.st_size;
+	if (f->size > 0) {
+		f->map = mmap(NULL, f->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	close(fd);
+	if (f->map == MAP_FAILED) {
+		printf("\nCould not map %s: %s\n", f->path, strerror(errno));
+		f->map = NULL;
+		return -1;
+	}
+	if (f->map == NULL) {
+		return 0;
+	}
+	bat_input(b, f, 0, f->size, &in);
+	f->events = pls_read(&in, &first) == 0;
+	f->events += f->events && pls_read(&in, &ns) == 0;
+	if (f->events < 2) {
+		return 0;
+	}
+	pls_filename(first, f->name);
+
+	while (begin + chunk < f->size && bat_split(b, f, begin + chunk, &at, &next) == 0) {
+		if (bat_add(b, fi, begin, at, hour) != 0) {
+			return -1;
+		}
+		begin = at;
+		hour = next;
+	}
+	return bat_add(b, fi, begin, f->size, hour);
+}
+/* end of function: bat_plan */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bat_by_name
+ * Inputs     : const void *a, *b - file numbers, with bat_sorting set
+ * Returns    : Their order by output name, then by number
+ */
+static const struct bat_file *bat_sorting;
+
+static int bat_by_name(const void *a, const void *b) {
+	int ia = *(const int *)a, ib = *(const int *)b;
+	int cmp = strcmp(bat_sorting[ia].name, bat_sorting[ib].name);
+
+	return cmp != 0 ? cmp : ia - ib;
+}
+/* end of function: bat_by_name */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bat_link
+ * Inputs     : struct bat_pool *b - batch, planned
+ * Returns    : 0 on success
+ *             -1 if out of memory
+ * Description: Chains together the files that write the same output, in the
+ *		order given.
+ */
+static int bat_link(struct bat_pool *b) {
+	int *order, fi, n = 0;
+
+	order = malloc((b->nfile ? b->nfile : 1) * sizeof(*order));
+	if (order == NULL) {
+		return -1;
+	}
+	for (fi = 0; fi < b->nfile; fi++) {
+		if (b->file[fi].nchunk > 0) {
+			order[n++] = fi;
+		}
+	}
+	bat_sorting = b->file;
+	qsort(order, n, sizeof(*order), bat_by_name);
+	for (fi = 1; fi < n; fi++) {
+		if (strcmp(b->file[order[fi - 1]].name, b->file[order[fi]].name) == 0) {
+			b->file[order[fi]].prior = order[fi - 1];
+			b->file[order[fi - 1]].next = order[fi];
+		}
+	}
+	free(order);
+	return 0;
+}
+/* end of function: bat_link */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bat_take
+ * Inputs     : struct bat_pool *b - batch
+ *		int id - thread asking
+ * Returns    : The next chunk for it to run, -1 when there are none left
+ */
+static int bat_take(struct bat_pool *b, int id) {
+	struct bat_deque *dq;
+	int cnt, task = -1;
+
+	for (cnt = 0; cnt < b->nthread && task == -1; cnt++) {
+		dq = &b->dq[(id + cnt) % b->nthread];
+		pthread_mutex_lock(&dq->lock);
+		if (dq->head < dq->tail) {
+			/* its own from the front, others' from the back */
+			task = cnt == 0 ? dq->task[dq->head++] : dq->task[--dq->tail];
+		}
+		pthread_mutex_unlock(&dq->lock);
+	}
+	return task;
+}
+/* end of function: bat_take */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bat_append
+ * Inputs     : void *cookie - struct bat_chunk whose output this is
+ *		const char *buf - bytes written
+ *		size_t size - how many
+ * Returns    : size on success
+ *              0 if out of memory
+ * Description: fopencookie write function.  open_memstream does the same but
+ *		takes a third of the time findpulse does to keep up with it.
+ */
+static ssize_t bat_append(void *cookie, const char *buf, size_t size) {
+	struct bat_chunk *c = cookie;
+	size_t alloc = c->alloc ? c->alloc : BAT_OUT_MIN;
+	char *out;
+
+	while (c->len + size > alloc) {
+		alloc *= 2;
+	}
+	if (alloc != c->alloc) {
+		out = realloc(c->out, alloc);
+		if (out == NULL) {
+			return 0;
+		}
+		c->out = out;
+		c->alloc = alloc;
+	}
+	memcpy(c->out + c->len, buf, size);
+	c->len += size;
+	return size;
+}
+/* end of function: bat_append */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bat_run
+ * Inputs     : struct bat_pool *b - batch
+ *		struct bat_chunk *c - chunk to run
+ * Returns    : 0 on success
+ *             -1 if out of memory
+ */
+static int bat_run(struct bat_pool *b, struct bat_chunk *c) {
+	struct bat_file *f = &b->file[c->file];
+	struct pulses p;
+	struct pls_input in;
+	int64_t ns;
+	FILE *out;
+
+	out = fopencookie(c, "w", (cookie_io_functions_t){NULL, bat_append, NULL, NULL});
+	if (out == NULL) {
+		return -1;
+	}
+	setvbuf(out, NULL, _IOFBF, BAT_BUFFER);
+	bat_input(b, f, c->begin, c->end, &in);
+	if (c->begin == 0) {
+		pls_open(&p, out, b->set);
+	}
+	else {
+		pls_resume(&p, out, b->set, c->hour);
+	}
+	while (pls_read(&in, &ns) == 0) {
+		pls_event(&p, ns);
+	}
+	c->stopped = in.map.pos < c->end;
+	if (c->stopped || c->end == f->size) {
+		pls_close(&p);
+	}
+	else {
+		pls_break(&p);
+	}
+	c->sequences = p.det.sequences;
+	c->pulses = p.det.pulses;
+	c->missing = p.det.missing;
+	c->strays = p.det.strays;
+	/* a failed append shows up here */
+	return fclose(out) == 0 ? 0 : -1;
+}
+/* end of function: bat_run */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bat_write
+ * Inputs     : struct bat_pool *b - batch, with wlock held
+ *		int fi - file whose chunks have all run
+ * Returns    : Nothing
+ * Description: Appends its chunks' output to its pulses file, up to the one
+ *		the input went bad in, and frees them and the mapping.
+ */
+static void bat_write(struct bat_pool *b, int fi) {
+	struct bat_file *f = &b->file[fi];
+	struct bat_chunk *c;
+	char path[PATH_MAX];
+	FILE *fp;
+	int cnt, ok = 1;
+
+	snprintf(path, sizeof(path), "%s/%s", b->outdir, f->name);
+	fp = fopen(path, "a");
+	if (fp == NULL) {
+		printf("\nCould not open %s: %s\n", path, strerror(errno));
+		ok = 0;
+	}
+	for (cnt = 0; cnt < f->nchunk; cnt++) {
+		c = &b->chunk[f->first + cnt];
+		if (ok && c->out == NULL) {
+			printf("\nOut of memory processing %s\n", f->path);
+			ok = 0;
+		}
+		if (ok && fwrite(c->out, 1, c->len, fp) != c->len) {
+			printf("\nCould not write %s: %s\n", path, strerror(errno));
+			ok = 0;
+		}
+		free(c->out);
+		c->out = NULL;
+		if (c->stopped) {
+			/* findpulse stops at the same place, so the rest are not counted either */
+			f->nchunk = cnt + 1;
+		}
+	}
+	if (fp != NULL && fclose(fp) != 0 && ok) {
+		printf("\nCould not write %s: %s\n", path, strerror(errno));
+		ok = 0;
+	}
+	if (!ok) {
+		b->failed = 1;
+	}
+	munmap(f->map, f->size);
+	f->map = NULL;
+	f->written = 1;
+}
+/* end of function: bat_write */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bat_finish
+ * Inputs     : struct bat_pool *b - batch
+ *		int fi - file whose last chunk has just run
+ * Returns    : Nothing
+ * Description: Writes it out unless an earlier file of the same output is
+ *		still running, and then any later ones that were waiting on it.
+ */
+static void bat_finish(struct bat_pool *b, int fi) {
+	struct bat_file *f;
+
+	pthread_mutex_lock(&b->wlock);
+	f = &b->file[fi];
+	f->done = 1;
+	if (f->prior == -1 || b->file[f->prior].written) {
+		while (fi != -1 && b->file[fi].done) {
+			bat_write(b, fi);
+			fi = b->file[fi].next;
+		}
+	}
+	pthread_mutex_unlock(&b->wlock);
+}
+/* end of function: bat_finish */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bat_worker_main
+ * Inputs     : void *arg - struct bat_worker
+ * Returns    : NULL
+ */
+static void *bat_worker_main(void *arg) {
+	struct bat_worker *w = arg;
+	struct bat_pool *b = w->b;
+	struct bat_chunk *c;
+	int task;
+
+	while ((task = bat_take(b, w->id)) != -1) {
+		c = &b->chunk[task];
+		if (bat_run(b, c) != 0) {
+			free(c->out);
+			c->out = NULL;
+		}
+		if (atomic_fetch_sub(&b->file[c->file].left, 1) == 1) {
+			bat_finish(b, c->file);
+		}
+	}
+	return NULL;
+}
+/* end of function: bat_worker_main */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : batch
+ * Inputs     : char **files - timestamp files
+ *		int nfile - how many
+ *		const char *outdir - where the pulses files go
+ *		int format - PLS_TEXT or PLS_RAW
+ *		const char *tables - pulse tables (see seq_set_parse)
+ *		int64_t tol - how far from them a separation may be, ns
+ *		int threads - worker threads, 0 for one per core
+ *		long chunk - input per chunk, bytes (BAT_CHUNK)
+ * Returns    : 0 on success
+ *             -1 if a table is not valid or a file could not be read or
+ *		  written, in which case the others are still done
+ * Description: findpulse on each of files, with its output in outdir, and a
+ *		line per file of what was found in it.
+ */
+int batch(char **files, int nfile, const char *outdir, int format, const char *tables, int64_t tol,
+		int threads, long chunk) {
+	struct bat_pool b;
+	struct bat_worker *w = NULL;
+	struct seq_set set;
+	struct bat_file *f;
+	struct bat_chunk *c;
+	struct timespec t0, t1;
+	uint64_t seqs, pulses, missing, strays, total[4] = {0, 0, 0, 0};
+	int fi, cnt, made = 0, ret = 0;
+
+	if (seq_set_parse(&set, tables, tol) != 0) {
+		printf("\nInvalid pulse tables %s\n", tables);
+		return -1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	memset(&b, 0, sizeof(b));
+	b.nfile = nfile;
+	b.set = &set;
+	b.format = format;
+	b.outdir = outdir;
+	pthread_mutex_init(&b.wlock, NULL);
+	b.file = calloc(nfile ? nfile : 1, sizeof(*b.file));
+	if (b.file == NULL) {
+		printf("\nOut of memory\n");
+		seq_set_free(&set);
+		return -1;
+	}
+	for (fi = 0; fi < nfile; fi++) {
+		b.file[fi].path = files[fi];
+		if (bat_plan(&b, fi, chunk > 0 ? chunk : BAT_CHUNK) != 0) {
+			ret = -1;
+		}
+		atomic_init(&b.file[fi].left, b.file[fi].nchunk);
+	}
+
+	b.nthread = threads > 0 ? threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if (b.nthread > BAT_MAX_THREADS) {
+		b.nthread = BAT_MAX_THREADS;
+	}
+	if (b.nthread > b.nchunk) {
+		b.nthread = b.nchunk > 0 ? b.nchunk : 1;
+	}
+	w = calloc(b.nthread, sizeof(*w));
+	if (w == NULL || bat_link(&b) != 0) {
+		printf("\nOut of memory\n");
+		b.nthread = 0;
+		ret = -1;
+	}
+	for (cnt = 0; cnt < b.nthread; cnt++) {
+		pthread_mutex_init(&b.dq[cnt].lock, NULL);
+		b.dq[cnt].task = malloc((b.nchunk / b.nthread + 1) * sizeof(int));
+		if (b.dq[cnt].task == NULL) {
+			printf("\nOut of memory\n");
+			b.nthread = cnt;
+			ret = -1;
+			break;
+		}
+	}
+	for (cnt = 0; cnt < b.nchunk && b.nthread > 0; cnt++) {
+		b.dq[cnt % b.nthread].task[b.dq[cnt % b.nthread].tail++] = cnt;
+	}
+	for (cnt = 0; cnt < b.nthread; cnt++) {
+		w[cnt].b = &b;
+		w[cnt].id = cnt;
+		if (pthread_create(&w[cnt].tid, NULL, bat_worker_main, &w[cnt]) != 0) {
+			break;
+		}
+		made++;
+	}
+	if (made == 0 && b.nthread > 0) {
+		/* could not start any, so run them all here */
+		bat_worker_main(&w[0]);
+	}
+	for (cnt = 0; cnt < made; cnt++) {
+		pthread_join(w[cnt].tid, NULL);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	for (fi = 0; fi < nfile; fi++) {
+		f = &b.file[fi];
+		if (f->events < 2) {
+			printf("%s: %s\n", f->path, f->events == 0 ? "NO TIMESTAMPS FOUND" : "Only 1 timestamp found");
+			continue;
+		}
+		seqs = pulses = missing = strays = 0;
+		for (cnt = 0; cnt < f->nchunk; cnt++) {
+			c = &b.chunk[f->first + cnt];
+			seqs += c->sequences;
+			pulses += c->pulses;
+			missing += c->missing;
+			strays += c->strays;
+		}
+		if (!f->written) {
+			ret = -1;
+		}
+		printf("%s: %s, %llu sequences, %llu pulses, %llu missing, %llu strays\n", f->path,
+			f->written ? f->name : "NOT WRITTEN", (unsigned long long)seqs, (unsigned long long)pulses,
+			(unsigned long long)missing, (unsigned long long)strays);
+		total[0] += seqs;
+		total[1] += pulses;
+		total[2] += missing;
+		total[3] += strays;
+	}
+	printf("%d files, %d chunks, %d threads, %.3f s: %llu sequences, %llu pulses, %llu missing, %llu strays\n",
+		nfile, b.nchunk, made, (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9,
+		(unsigned long long)total[0], (unsigned long long)total[1], (unsigned long long)total[2],
+		(unsigned long long)total[3]);
+
+	for (fi = 0; fi < nfile; fi++) {
+		if (b.file[fi].map != NULL) {
+			munmap(b.file[fi].map, b.file[fi].size);
+		}
+	}
+	for (cnt = 0; cnt < b.nchunk; cnt++) {
+		free(b.chunk[cnt].out);
+	}
+	for (cnt = 0; cnt < BAT_MAX_THREADS; cnt++) {
+		free(b.dq[cnt].task);
+	}
+	free(b.chunk);
+	free(b.file);
+	free(w);
+	seq_set_free(&set);
+	return ret != 0 || b.failed ? -1 : 0;
+}
+/* end of function: batch */
+/*******************************************************************************/
@@ -0,0 +1,29 @@
+/* File : 	sym560_batch.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Reprocesses archives of timestamp files with the compiled
+ *		findpulse (sym560_pulses.h) on all cores at once.  Each file is
+ *		cut into chunks where the gap between two events is too long for
+ *		any sequence to span, the chunks are run on a pool of threads that
+ *		take work from each other when they run out, and each file's
+ *		pulses_*.txt is put back together from its chunks in order.  The
+ *		files written are byte for byte those of running findpulse on each
+ *		input in turn.
+ */
+
+#ifndef SYM560_BATCH_H
+#define SYM560_BATCH_H
+
+#include <stdint.h>
+
+/* default input per chunk, bytes */
+#define BAT_CHUNK		(4 << 20)
+
+/* most worker threads */
+#define BAT_MAX_THREADS		256
+
+/* function declarations */
+int batch(char **files, int nfile, const char *outdir, int format, const char *tables, int64_t tol,
+	int threads, long chunk);
+
+#endif /* SYM560_BATCH_H */
@@ -0,0 +1,3950 @@
+/* File : 	sym560_bench.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Benchmarks for the timestamping pipeline using the simulated
+ *		event source (sym560_sim.c), so no card is required.
+ *
+ *		sym560_bench capture [-r rate] [-t seconds] [-s stall_ms] [-c rt_cpu]
+ *				     [-d] [-W uring|thread]
+ *		    Compares the old event_cap design (one 12 byte write per event,
+ *		    converted to text after capture) with the capture/writer threads.
+ *		    Output goes through a pipe to a "disk" thread which, with -s,
+ *		    stops reading for stall_ms once a second to mimic a filesystem
+ *		    hiccup.  Reports events generated, written and lost for each, and
+ *		    the capture thread's page faults and context switches.  -c runs
+ *		    the threads with the real-time profile, -d with the drop-oldest
+ *		    output policy and -W with the given IO backend.
+ *
+ *		sym560_bench rotate [-r rate] [-n events] [-R rotate_s] [-H hup_ms]
+ *		    Runs the simulator through the writer while rotating on rotate_s
+ *		    boundaries and on a cap_rotate call every hup_ms, then reads every
+ *		    file back in name order and checks that each event appears exactly
+ *		    once and in order.
+ *
+ *		sym560_bench control [-r rate] [-n events] [-H cmd_ms]
+ *		    The same check with the control socket up and a command and a
+ *		    marker every cmd_ms, which must not cost a single event.
+ *
+ *		sym560_bench journal [-r rate] [-n events] [-H kill_ms]
+ *		    Captures into a journal in a child process, kills it with
+ *		    SIGKILL after kill_ms, recovers from the journal and checks that
+ *		    every event the child captured is in the output once, in order.
+ *		    A second child is killed 500 ms later, once buffers have been
+ *		    written, and its journal left as if the writer had not seen them
+ *		    complete, which recovery must find out from the file.  A third
+ *		    child's writes fail part way through as on a full disk, and
+ *		    every event from there on must be kept for the next start.
+ *
+ *		sym560_bench format [-n records] [-f file]
+ *		    Checks that rec_format_text reproduces the timestamp file (by
+ *		    default ../pulse_seq_script/test.txt) byte for byte from the
+ *		    parsed times and agrees with the sprintf formatter on random
+ *		    bytes, then times the two.
+ *
+ *		sym560_bench status [-r rate] [-n events] [-H period_ms]
+ *		    Publishes the status every period_ms while capturing and reads
+ *		    it back continuously, checking every copy is consistent.
+ *
+ *		sym560_bench stream [-r rate] [-n events] [-k subscribers] [-H slow_ms]
+ *		    Serves the live stream to the given number of subscribers, the
+ *		    last of which pauses slow_ms after every packet, and checks what
+ *		    each of them received and that a second server is refused.
+ *
+ *		sym560_bench metrics [-r rate] [-n events] [-H export_ms]
+ *		    Exports the metrics every export_ms while capturing and checks
+ *		    each export is well formed and the totals add up.
+ *
+ *		sym560_bench radar [-t seconds] [-H late_ms]
+ *		    Captures simulated pulse sequences while a thread plays radar
+ *		    control, pushing the metadata of most of them into the channel
+ *		    ahead of time or late_ms after, along with some that match no
+ *		    sequence, and checks that the output joins each one correctly.
+ *		    Then again with every event reaching the writer a while after
+ *		    it was stamped, which must not cut any sequence short.
+ *
+ *		sym560_bench tracker [-t seconds] [-R rotate_s]
+ *		    Captures simulated pulse sequences with a tracker, starting a
+ *		    new file every rotate_s, and checks every sequence is written
+ *		    once as a DETECTED line with all of its pulses, including those
+ *		    that cross from one file into the next, and that the timing
+ *		    histograms of each minute hold every pulse.
+ *
+ *		sym560_bench timing [-n pulses]
+ *		    Checks every timing histogram bucket holds the values it should,
+ *		    times adding the given number of jittered pulses to them and
+ *		    reads a minute back from its record.
+ *
+ *		sym560_bench allan [-n starts]
+ *		    Adds jittered sequence starts to the streaming Allan deviation
+ *		    estimator, times it and compares it with the deviation worked
+ *		    out from every second difference of the whole series.
+ *
+ *		sym560_bench index [-n events] [-R rotate_s]
+ *		    Captures events 10 ms apart with the writer keeping the time
+ *		    index of each file, checks every index entry, then extracts
+ *		    30 s ranges with the indexes and without them, checking each
+ *		    against every event, and checks the indexes backfill makes.
+ *
+ *		sym560_bench delta [-n events]
+ *		    Compresses pulse sequences exactly on time, jittered and
+ *		    jittered with missing pulses and pauses into delta of delta
+ *		    blocks, checks they decode exactly, whole and a block at a
+ *		    time, and reports the size against raw event times and text
+ *		    and the speed of each way.  The last are also taken through
+ *		    convert to compressed blocks and back to text.
+ *
+ *		sym560_bench columns [-n events]
+ *		    Captures pulse sequences across a UTC day boundary with a
+ *		    tracker and the column store, checks every event is a row of
+ *		    its day with its sequence and pulse, that backfill makes the
+ *		    same store from the text files, and times a pass over the
+ *		    mapped time column against parsing the text.
+ *
+ *		sym560_bench sequence [-n sequences]
+ *		    Feeds the pulse sequence detector sequences of the default
+ *		    table with jitter, random missing pulses and stray events in
+ *		    between, and checks it finds each of them as generated.
+ *
+ *		sym560_bench findpulse [-n events] [-f file]
+ *		    Runs findpulse.pl and sym560_cmdline findpulse over the timestamp
+ *		    file (by default ../pulse_seq_script/test2.txt) and over copies
+ *		    of it an hour apart making up the given number of events,
+ *		    checks the two outputs are identical and times each.  The
+ *		    compiled one is also run on the copies as raw event times.
+ *
+ *		sym560_bench tables [-n sequences]
+ *		    Feeds the detector sequences of three tables at once, two of
+ *		    them built in and one given at run time, and checks each is
+ *		    found with its own table, then times one table against three
+ *		    on the same events.
+ *
+ *		sym560_bench batch [-n events] [-f file] [-j threads]
+ *		    Runs sym560_cmdline findpulse one file at a time and batch at 1,
+ *		    2, 4, ... threads (up to the number of cores, and at least 8)
+ *		    over copies of the timestamp file cut into several files, and
+ *		    checks every pulses file batch writes is the same as findpulse's.
+ *
+ *		sym560_bench parse [-n timestamps] [-f file]
+ *		    Writes copies of the timestamp file, as written and with other
+ *		    indentation and line ends, reads them back with rec_parse_text
+ *		    and with the mapped parser rec_map_text and converts them to raw
+ *		    event times, checking each finds every timestamp, and times
+ *		    each against plain read() calls on the same file.
+ *
+ *		sym560_bench lib [-r rate] [-n events]
+ *		    Takes the simulator's events through libsym560 (sym560.h) in
+ *		    each of its three ways, blocking batches, polling and the
+ *		    callback, into a small ring so that it wraps, and checks every
+ *		    event captured is received once and in order.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <limits.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "sym560_functions.h"
+#include "sym560_capture.h"
+#include "sym560_seq.h"
+#include "sym560_pulses.h"
+#include "sym560_batch.h"
+#include "sym560_convert.h"
+#include "sym560_delta.h"
+#include "sym560_timing.h"
+#include "sym560_index.h"
+#include "sym560_backfill.h"
+#include "sym560_column.h"
+#include "sym560.h"
+
+struct disk {
+	int rdfd;		/* read end of the pipe */
+	int outfd;		/* file the data ends up in */
+	int stall_ms;		/* time to stop reading once a second */
+	uint64_t bytes;
+};
+
+/*******************************************************************************/
+/* Function   : disk_thread_main
+ * Inputs     : void *arg - the struct disk
+ * Returns    : NULL
+ * Description: Copies the pipe into the output file, stalling once a second.
+ */
+static void *disk_thread_main(void *arg) {
+	struct disk *dk = arg;
+	struct timespec ts;
+	char buff[65536];
+	int64_t last = sim_now();
+	int ret;
+
+	for (;;) {
+		ret = read(dk->rdfd, buff, sizeof(buff));
+		if (ret <= 0) {
+			break;
+		}
+		write(dk->outfd, buff, ret);
+		dk->bytes += ret;
+		if (dk->stall_ms > 0 && sim_now() - last > 1000000000LL) {
+			ts.tv_sec = dk->stall_ms / 1000;
+			ts.tv_nsec = (dk->stall_ms % 1000) * 1000000L;
+			nanosleep(&ts, NULL);
+			last = sim_now();
+		}
+	}
+	return NULL;
+}
+/* end of function: disk_thread_main */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : disk_start
+ * Inputs     : struct disk *dk - disk to set up
+ *		pthread_t *tid - receives the thread id
+ *		const char *path - output file
+ *		int stall_ms - stall length
+ * Returns    : Write end of the pipe, -1 on failure
+ */
+static int disk_start(struct disk *dk, pthread_t *tid, const char *path, int stall_ms) {
+	int pfd[2];
+
+	if (pipe(pfd) == -1) {
+		return -1;
+	}
+	dk->rdfd = pfd[0];
+	dk->outfd = open(path, O_WRONLY|O_CREAT|O_TRUNC, 00644);
+	dk->stall_ms = stall_ms;
+	dk->bytes = 0;
+	pthread_create(tid, NULL, disk_thread_main, dk);
+	return pfd[1];
+}
+/* end of function: disk_start */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : disk_finish
+ * Inputs     : struct disk *dk - disk started by disk_start
+ *		pthread_t tid - its thread
+ *		int wrfd - write end of the pipe
+ * Returns    : Nothing
+ */
+static void disk_finish(struct disk *dk, pthread_t tid, int wrfd) {
+	close(wrfd);
+	pthread_join(tid, NULL);
+	close(dk->rdfd);
+	close(dk->outfd);
+}
+/* end of function: disk_finish */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_legacy
+ * Inputs     : double rate - events per second
+ *		uint64_t count - events to generate
+ *		int stall_ms - disk stall
+ * Returns    : 0 on success
+ * Description: The event_cap loop: wait, then write 12 bytes, for every event.
+ *		The binary file is converted to text afterwards like autostamp
+ *		used to, and that conversion is timed separately.
+ */
+static int bench_legacy(double rate, uint64_t count, int stall_ms) {
+	struct sim sim;
+	struct disk dk;
+	pthread_t tid;
+	unsigned char raw[12];
+	char txtbuff[512];
+	int wrfd, binfile, txtfile;
+	uint64_t written = 0;
+	int64_t t0, t1;
+
+	wrfd = disk_start(&dk, &tid, "/tmp/sym560_bench_interrupt_data", stall_ms);
+	if (wrfd == -1) {
+		return -1;
+	}
+	sim_init(&sim, rate, count);
+	t0 = sim_now();
+	while (sim_wait(&sim, raw) == 0) {
+		write(wrfd, raw, 12);
+		written++;
+	}
+	t1 = sim_now();
+	disk_finish(&dk, tid, wrfd);
+
+	printf("  legacy : %10llu generated %10llu written %10llu lost %8.0f events/s",
+		(unsigned long long)count, (unsigned long long)written,
+		(unsigned long long)sim.lost, written / ((t1 - t0) / 1e9));
+
+	/* conversion to text, one sprintf/strlen/write per record as it was done */
+	binfile = open("/tmp/sym560_bench_interrupt_data", O_RDONLY);
+	txtfile = open("/tmp/sym560_bench_legacy.txt", O_WRONLY|O_CREAT|O_TRUNC, 00644);
+	t0 = sim_now();
+	while (read(binfile, raw, 12) == 12) {
+		rec_format_text_sprintf(raw, txtbuff);
+		write(txtfile, txtbuff, strlen(txtbuff));
+	}
+	t1 = sim_now();
+	close(binfile);
+	close(txtfile);
+	printf(" (+%.3f s conversion)\n", (t1 - t0) / 1e9);
+	remove("/tmp/sym560_bench_interrupt_data");
+	remove("/tmp/sym560_bench_legacy.txt");
+	return 0;
+}
+/* end of function: bench_legacy */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_ring
+ * Inputs     : double rate - events per second
+ *		uint64_t count - events to generate
+ *		int stall_ms - disk stall
+ *		int rt_cpu - CPU for the real-time profile, -1 for the default
+ *		int policy - CAP_IO_BLOCK or CAP_IO_DROP_OLDEST
+ *		int backend - IO_AUTO, IO_URING or IO_THREAD
+ * Returns    : 0 on success
+ * Description: The capture/writer threads from sym560_capture.c.
+ */
+static int bench_ring(double rate, uint64_t count, int stall_ms, int rt_cpu, int policy, int backend) {
+	struct capture cap;
+	struct cap_config cfg;
+	struct sim sim;
+	struct disk dk;
+	struct timespec pause = {0, 1000000};
+	pthread_t tid;
+	int wrfd;
+	int64_t t0, t1;
+
+	wrfd = disk_start(&dk, &tid, "/tmp/sym560_bench_ring.txt", stall_ms);
+	if (wrfd == -1) {
+		return -1;
+	}
+	sim_init(&sim, rate, count);
+	cap_config_default(&cfg);
+	if (rt_cpu >= 0) {
+		cfg.rt = 1;
+		cfg.rt_cpu = rt_cpu;
+	}
+	cfg.io_policy = policy;
+	cfg.io_backend = backend;
+	if (cap_init(&cap, &cfg, -1, wrfd, &sim) != 0) {
+		return -1;
+	}
+	t0 = sim_now();
+	cap_start(&cap);
+	cap_print_rt(&cap);
+	while (atomic_load(&cap.cap_done) == 0) {
+		nanosleep(&pause, NULL);
+	}
+	t1 = sim_now();
+	cap_stop(&cap);
+	disk_finish(&dk, tid, wrfd);
+
+	printf("  ring   : %10llu generated %10llu written %10llu lost %8.0f events/s",
+		(unsigned long long)count, (unsigned long long)cap.written,
+		(unsigned long long)(sim.lost + cap.overflows + cap.dropped), cap.written / ((t1 - t0) / 1e9));
+	printf(" (%llu ring overflows)\n", (unsigned long long)cap.overflows);
+	printf("           ");
+	cap_print_usage(&cap);
+	printf("           ");
+	cap_print_io(&cap);
+	cap_free(&cap);
+	remove("/tmp/sym560_bench_ring.txt");
+	return 0;
+}
+/* end of function: bench_ring */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : is_timestampdata
+ * Inputs     : const struct dirent *ent - directory entry
+ * Returns    : 1 for *.timestampdata files, 0 otherwise
+ */
+static int is_timestampdata(const struct dirent *ent) {
+	return strstr(ent->d_name, ".timestampdata") != NULL;
+}
+/* end of function: is_timestampdata */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : is_timing
+ * Inputs     : const struct dirent *ent - directory entry
+ * Returns    : 1 for *.timing files, 0 otherwise
+ */
+static int is_timing(const struct dirent *ent) {
+	return strstr(ent->d_name, ".timing") != NULL;
+}
+/* end of function: is_timing */
+/*******************************************************************************/
+
+/* what bench_readback found */
+struct readback {
+	int nfiles;
+	uint64_t found;			/* timestamps read */
+	uint64_t bad;			/* off the grid, repeated or out of order */
+	uint64_t gaps;			/* grid points with no timestamp */
+	uint64_t markers;		/* MARKER lines */
+};
+
+
+/*******************************************************************************/
+/* Function   : bench_readback
+ * Inputs     : const struct sim *sim - simulator that produced the files
+ *		uint64_t count - events generated
+ *		struct readback *rb - receives the counts
+ * Returns    : Nothing
+ * Description: Reads every timestampdata file in the current directory back in
+ *		name order, removing them as it goes.  The simulator puts event k at
+ *		start + k * period, so the timestamps must follow exactly that grid;
+ *		anything off the grid, repeated or out of order counts as bad, and
+ *		skipped grid points count as gaps.  MARKER lines are counted too.
+ */
+static void bench_readback(const struct sim *sim, uint64_t count, struct readback *rb) {
+	struct dirent **names;
+	char line[256];
+	FILE *fp;
+	int64_t ns, step_ns = sim->period_ns, last = -1;
+	int cnt;
+
+	memset(rb, 0, sizeof(*rb));
+	rb->nfiles = scandir(".", &names, is_timestampdata, alphasort);
+	for (cnt = 0; cnt < rb->nfiles; cnt++) {
+		fp = fopen(names[cnt]->d_name, "r");
+		while (fp != NULL && rec_parse_text(fp, &ns) == 0) {
+			if ((ns - sim->start_ns) % step_ns != 0 || ns <= last) {
+				rb->bad++;
+			}
+			else {
+				/* events skipped since the previous one */
+				rb->gaps += (ns - (last >= 0 ? last : sim->start_ns - step_ns)) / step_ns - 1;
+			}
+			last = ns;
+			rb->found++;
+		}
+		if (fp != NULL) {
+			rewind(fp);
+			while (fgets(line, sizeof(line), fp) != NULL) {
+				if (strstr(line, "MARKER") != NULL) {
+					rb->markers++;
+				}
+			}
+			fclose(fp);
+		}
+		remove(names[cnt]->d_name);
+		free(names[cnt]);
+	}
+	free(names);
+	/* and any after the last one read */
+	rb->gaps += count - 1 - (last - sim->start_ns) / step_ns;
+}
+/* end of function: bench_readback */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_rotate
+ * Inputs     : double rate - events per second, 0 for unpaced
+ *		uint64_t count - events to generate
+ *		double rotate_s - rotation boundary interval
+ *		int hup_ms - interval between cap_rotate calls
+ * Returns    : 0 if every written event was found exactly once and in order
+ *             -1 otherwise
+ * Description: Continuity check for output file rotation.  Events the simulator
+ *		overwrote or the capture thread had to drop (ring overflow) never
+ *		reach the writer and are allowed to be missing; anything else missing,
+ *		repeated or out of order is an error.
+ */
+static int bench_rotate(double rate, uint64_t count, double rotate_s, int hup_ms) {
+	struct capture cap;
+	struct cap_config cfg;
+	struct sim sim;
+	struct timespec pause;
+	struct readback rb;
+	char dir[] = "/tmp/sym560_rotateXXXXXX";
+	char filename[CAP_FILENAME_LEN];
+	int outfd;
+
+	if (mkdtemp(dir) == NULL || chdir(dir) == -1) {
+		printf("\nCould not create %s\n", dir);
+		return -1;
+	}
+	sim_init(&sim, rate, count);
+	cap_config_default(&cfg);
+	cfg.rotate_ns = (int64_t)(rotate_s * 1e9);
+
+	cap_filename(sim.start_ns, filename);
+	outfd = open(filename, O_RDWR|O_CREAT|O_APPEND, 00644);
+	if (cap_init(&cap, &cfg, -1, outfd, &sim) != 0) {
+		return -1;
+	}
+	pause.tv_sec = hup_ms / 1000;
+	pause.tv_nsec = (hup_ms % 1000) * 1000000L;
+	cap_start(&cap);
+	while (atomic_load(&cap.cap_done) == 0) {
+		nanosleep(&pause, NULL);
+		cap_rotate(&cap);
+	}
+	cap_stop(&cap);
+	close(cap.outfd);
+
+	bench_readback(&sim, count, &rb);
+	chdir("/tmp");
+	rmdir(dir);
+
+	printf("  %llu events, %llu written, %llu lost, %llu ring overflows, %llu rotations, %d files\n",
+		(unsigned long long)count, (unsigned long long)cap.written, (unsigned long long)sim.lost,
+		(unsigned long long)cap.overflows, (unsigned long long)cap.rotations, rb.nfiles);
+	printf("  read back %llu, %llu out of order or repeated, %llu missing\n",
+		(unsigned long long)rb.found, (unsigned long long)rb.bad, (unsigned long long)rb.gaps);
+	cap_free(&cap);
+	if (rb.bad != 0 || rb.found != cap.written || rb.gaps != sim.lost + cap.overflows + cap.dropped) {
+		printf("  FAILED\n");
+		return -1;
+	}
+	printf("  OK: every event appears exactly once, in order\n");
+	return 0;
+}
+/* end of function: bench_rotate */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : ctl_send
+ * Inputs     : const char *path - control socket
+ *		const char *cmd - command line, including the newline
+ *		char *reply - receives the reply line
+ *		int len - size of reply
+ * Returns    : 0 if the reply starts with OK
+ *             -1 otherwise
+ * Description: One connection per command, the way a script would use it.
+ */
+static int ctl_send(const char *path, const char *cmd, char *reply, int len) {
+	struct sockaddr_un addr;
+	int sock, ret, got = 0;
+
+	reply[0] = '\0';
+	sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	if (sock == -1 || connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+		if (sock != -1) {
+			close(sock);
+		}
+		return -1;
+	}
+	send(sock, cmd, strlen(cmd), MSG_NOSIGNAL);
+	while (got < len - 1 && (got == 0 || reply[got - 1] != '\n')) {
+		ret = recv(sock, reply + got, len - 1 - got, 0);
+		if (ret <= 0) {
+			break;
+		}
+		got += ret;
+	}
+	reply[got] = '\0';
+	close(sock);
+	return strncmp(reply, "OK", 2) == 0 ? 0 : -1;
+}
+/* end of function: ctl_send */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_control
+ * Inputs     : double rate - events per second
+ *		uint64_t count - events to generate
+ *		int cmd_ms - interval between control commands
+ * Returns    : 0 if no event was lost to the control traffic and every marker
+ *		was written
+ *             -1 otherwise
+ * Description: Runs the simulator with the control socket up and cycles through
+ *		status, flush and rotate commands, plus a marker, every cmd_ms.  There
+ *		is no card, so the register commands are only checked for refusing
+ *		cleanly.  The output is then read back as in bench_rotate.
+ */
+static int bench_control(double rate, uint64_t count, int cmd_ms) {
+	static const char *cmds[] = {"status\n", "flush\n", "rotate\n", "setup\n"};
+	struct capture cap;
+	struct control ctl;
+	struct cap_config cfg;
+	struct sim sim;
+	struct timespec pause;
+	struct readback rb;
+	char dir[] = "/tmp/sym560_controlXXXXXX";
+	char filename[CAP_FILENAME_LEN], path[64], reply[256], text[REC_MARKER_MAX + 1];
+	uint64_t sent = 0, ok = 0, marks = 0;
+	int outfd, expect;
+
+	if (mkdtemp(dir) == NULL || chdir(dir) == -1) {
+		printf("\nCould not create %s\n", dir);
+		return -1;
+	}
+	sim_init(&sim, rate, count);
+	cap_config_default(&cfg);
+	cap_filename(sim.start_ns, filename);
+	outfd = open(filename, O_RDWR|O_CREAT|O_APPEND, 00644);
+	if (cap_init(&cap, &cfg, -1, outfd, &sim) != 0) {
+		return -1;
+	}
+	sprintf(path, "%s/ctl", dir);
+	pause.tv_sec = cmd_ms / 1000;
+	pause.tv_nsec = (cmd_ms % 1000) * 1000000L;
+	cap_start(&cap);
+	if (ctl_start(&ctl, &cap, -1, path) != 0) {
+		cap_stop(&cap);
+		return -1;
+	}
+	while (atomic_load(&cap.cap_done) == 0) {
+		nanosleep(&pause, NULL);
+		/* the setup command has no card to read so it should be refused */
+		expect = strcmp(cmds[sent % 4], "setup\n") != 0;
+		if ((ctl_send(path, cmds[sent % 4], reply, sizeof(reply)) == 0) == expect) {
+			ok++;
+		}
+		else {
+			printf("  unexpected reply to %.*s: %s\n", (int)strlen(cmds[sent % 4]) - 1,
+				cmds[sent % 4], reply);
+		}
+		sent++;
+		sprintf(text, "bench marker %llu", (unsigned long long)marks);
+		if (cap_mark(&cap, text) == 0) {
+			marks++;
+		}
+	}
+	ctl_stop(&ctl);
+	cap_stop(&cap);
+	close(cap.outfd);
+
+	bench_readback(&sim, count, &rb);
+	chdir("/tmp");
+	rmdir(dir);
+
+	printf("  %llu events, %llu written, %llu lost, %llu ring overflows, %d files\n",
+		(unsigned long long)count, (unsigned long long)cap.written, (unsigned long long)sim.lost,
+		(unsigned long long)cap.overflows, rb.nfiles);
+	printf("  %llu commands, %llu answered as expected, %llu markers queued, %llu written\n",
+		(unsigned long long)sent, (unsigned long long)ok, (unsigned long long)marks,
+		(unsigned long long)rb.markers);
+	printf("  read back %llu, %llu out of order or repeated, %llu missing\n",
+		(unsigned long long)rb.found, (unsigned long long)rb.bad, (unsigned long long)rb.gaps);
+	cap_free(&cap);
+	if (rb.bad != 0 || rb.found != cap.written || rb.gaps != sim.lost + cap.overflows + cap.dropped
+			|| ok != sent || rb.markers != marks) {
+		printf("  FAILED\n");
+		return -1;
+	}
+	printf("  OK: every event and marker written once, every command answered\n");
+	return 0;
+}
+/* end of function: bench_control */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_journal_rewind
+ * Inputs     : const char *path - journal left by a killed run
+ * Returns    : Records the tail was moved back over
+ * Description: Moves the tail back over the buffers the writer had already
+ *		retired, as long as their records are still in the ring, which
+ *		is how the journal is left when the process is killed after the
+ *		buffers reached the file but before the writer saw them complete.
+ */
+static uint64_t bench_journal_rewind(const char *path) {
+	struct jnl_header *hdr;
+	uint64_t head, tail, pos;
+	int fd, k;
+
+	fd = open(path, O_RDWR);
+	hdr = fd == -1 ? MAP_FAILED : mmap(NULL, JNL_HDR_LEN, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	if (hdr == MAP_FAILED) {
+		if (fd != -1) {
+			close(fd);
+		}
+		return 0;
+	}
+	head = atomic_load(&hdr->ring.head);
+	tail = pos = atomic_load(&hdr->ring.tail);
+	for (;;) {
+		for (k = 0; k < JNL_BUFS; k++) {
+			if (hdr->buf[k].ring_end == pos && hdr->buf[k].ring_start < pos) {
+				break;
+			}
+		}
+		if (k == JNL_BUFS || head - hdr->buf[k].ring_start > (1ULL << hdr->order)) {
+			break;
+		}
+		pos = hdr->buf[k].ring_start;
+	}
+	atomic_store(&hdr->ring.tail, pos);
+	munmap(hdr, JNL_HDR_LEN);
+	close(fd);
+	return tail - pos;
+}
+/* end of function: bench_journal_rewind */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_journal_run
+ * Inputs     : double rate - events per second
+ *		uint64_t count - events to generate
+ *		int kill_ms - how long the child captures before being killed
+ *		int rewind - move the tail back over the buffers already written
+ * Returns    : 0 if every event committed to the journal was written exactly
+ *		once, in order
+ *             -1 otherwise
+ * Description: The child syncs after every write so that, at the moment it is
+ *		killed, there is usually output still waiting on the disk.  The
+ *		parent then runs a capture with no events at all over the same
+ *		journal, which only has the leftovers to write, and reads back
+ *		everything as in bench_rotate.  With rewind the buffers the child
+ *		had written must be found in the file and skipped.
+ */
+static int bench_journal_run(double rate, uint64_t count, int kill_ms, int rewind) {
+	struct capture cap;
+	struct cap_config cfg;
+	struct journal jnl;
+	struct sim sim, none;
+	struct timespec pause = {0, 1000000};
+	struct readback rb;
+	char dir[] = "/tmp/sym560_journalXXXXXX";
+	char filename[CAP_FILENAME_LEN];
+	uint64_t committed, recovered, skipped, rewound = 0;
+	pid_t pid;
+	int outfd;
+
+	if (mkdtemp(dir) == NULL || chdir(dir) == -1) {
+		printf("\nCould not create %s\n", dir);
+		return -1;
+	}
+	sim_init(&sim, rate, count);
+	cap_config_default(&cfg);
+	cfg.journal = "bench.journal";
+	cap_filename(sim.start_ns, filename);
+
+	pid = fork();
+	if (pid == 0) {
+		cfg.sync_ns = -1;
+		outfd = open(filename, O_RDWR|O_CREAT|O_APPEND, 00644);
+		if (cap_init(&cap, &cfg, -1, outfd, &sim) != 0) {
+			_exit(1);
+		}
+		cap_start(&cap);
+		while (atomic_load(&cap.cap_done) == 0) {
+			nanosleep(&pause, NULL);
+		}
+		cap_stop(&cap);
+		_exit(0);
+	}
+	pause.tv_sec = kill_ms / 1000;
+	pause.tv_nsec = (kill_ms % 1000) * 1000000L;
+	nanosleep(&pause, NULL);
+	kill(pid, SIGKILL);
+	waitpid(pid, NULL, 0);
+
+	if (jnl_open(&jnl, cfg.journal, CAP_RING_ORDER) != 0) {
+		return -1;
+	}
+	committed = atomic_load(&jnl_ring(&jnl)->head);
+	jnl_close(&jnl);
+	if (rewind) {
+		rewound = bench_journal_rewind(cfg.journal);
+	}
+
+	/* a source that has nothing more to give */
+	none = sim;
+	none.next = none.limit = 1;
+	outfd = open(filename, O_RDWR|O_CREAT|O_APPEND, 00644);
+	if (cap_init(&cap, &cfg, -1, outfd, &none) != 0) {
+		return -1;
+	}
+	recovered = cap.jnl.recovered;
+	skipped = cap.jnl.skipped;
+	cap_start(&cap);
+	cap_stop(&cap);
+	close(cap.outfd);
+	cap_free(&cap);
+
+	remove(cfg.journal);
+	bench_readback(&sim, count, &rb);
+	chdir("/tmp");
+	rmdir(dir);
+
+	printf("  killed after %d ms: %llu events committed to the journal, %llu of them not yet written\n",
+		kill_ms, (unsigned long long)committed, (unsigned long long)recovered);
+	if (rewind) {
+		printf("  tail moved back over %llu events already written, %llu found in the file and skipped\n",
+			(unsigned long long)rewound, (unsigned long long)skipped);
+	}
+	printf("  read back %llu, %llu out of order or repeated, %llu recovery markers\n",
+		(unsigned long long)rb.found, (unsigned long long)rb.bad, (unsigned long long)rb.markers);
+	if (rb.bad != 0 || rb.found != committed || rb.markers != (recovered != 0)
+			|| (rewind && (rewound == 0 || skipped < rewound))) {
+		printf("  FAILED\n");
+		return -1;
+	}
+	printf("  OK: every committed event written exactly once, in order\n");
+	return 0;
+}
+/* end of function: bench_journal_run */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_journal_full
+ * Inputs     : double rate - events per second
+ *		uint64_t count - events to generate, no more than the ring holds
+ *		off_t limit - size the child's timestamp file cannot grow past
+ * Returns    : 0 if every event was written exactly once, in order
+ *             -1 otherwise
+ * Description: The child captures with RLIMIT_FSIZE set once the journal is
+ *		allocated, so its writes fail part way through a buffer as on a
+ *		full disk.  Its journal must keep every event from that buffer on,
+ *		which the parent then writes with the limit gone.
+ */
+static int bench_journal_full(double rate, uint64_t count, off_t limit) {
+	struct capture cap;
+	struct cap_config cfg;
+	struct sim sim, none;
+	struct readback rb;
+	struct rlimit rl;
+	struct timespec pause = {0, 1000000};
+	char dir[] = "/tmp/sym560_journalXXXXXX";
+	char filename[CAP_FILENAME_LEN];
+	uint64_t committed, recovered, skipped;
+	pid_t pid;
+	int outfd, status;
+
+	if (mkdtemp(dir) == NULL || chdir(dir) == -1) {
+		printf("\nCould not create %s\n", dir);
+		return -1;
+	}
+	sim_init(&sim, rate, count);
+	cap_config_default(&cfg);
+	cfg.journal = "bench.journal";
+	cap_filename(sim.start_ns, filename);
+
+	pid = fork();
+	if (pid == 0) {
+		outfd = open(filename, O_RDWR|O_CREAT|O_APPEND, 00644);
+		if (cap_init(&cap, &cfg, -1, outfd, &sim) != 0) {
+			_exit(1);
+		}
+		signal(SIGXFSZ, SIG_IGN);
+		rl.rlim_cur = rl.rlim_max = limit;
+		setrlimit(RLIMIT_FSIZE, &rl);
+		cap_start(&cap);
+		while (atomic_load(&cap.cap_done) == 0) {
+			nanosleep(&pause, NULL);
+		}
+		cap_stop(&cap);
+		_exit(cap.io.failed_write != 0 ? 0 : 2);
+	}
+	waitpid(pid, &status, 0);
+
+	none = sim;
+	none.next = none.limit = 1;
+	outfd = open(filename, O_RDWR|O_CREAT|O_APPEND, 00644);
+	if (cap_init(&cap, &cfg, -1, outfd, &none) != 0) {
+		return -1;
+	}
+	committed = atomic_load(&cap.ring->head);
+	recovered = cap.jnl.recovered;
+	skipped = cap.jnl.skipped;
+	cap_start(&cap);
+	cap_stop(&cap);
+	close(cap.outfd);
+	cap_free(&cap);
+
+	remove(cfg.journal);
+	bench_readback(&sim, count, &rb);
+	chdir("/tmp");
+	rmdir(dir);
+
+	printf("  file limited to %lld bytes: write %s, %llu events committed to the journal, %llu left in it,"
+		" %llu of those in the file\n",
+		(long long)limit, WIFEXITED(status) && WEXITSTATUS(status) == 0 ? "failed" : "DID NOT FAIL",
+		(unsigned long long)committed, (unsigned long long)recovered, (unsigned long long)skipped);
+	printf("  read back %llu, %llu out of order or repeated, %llu recovery markers\n",
+		(unsigned long long)rb.found, (unsigned long long)rb.bad, (unsigned long long)rb.markers);
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || rb.bad != 0 || rb.found != committed
+			|| recovered == 0 || rb.markers != 1) {
+		printf("  FAILED\n");
+		return -1;
+	}
+	printf("  OK: the events of the failed writes were kept and written once, in order\n");
+	return 0;
+}
+/* end of function: bench_journal_full */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_journal
+ * Inputs     : double rate - events per second
+ *		uint64_t count - events to generate
+ *		int kill_ms - how long the child captures before the first kill
+ * Returns    : 0 if both runs wrote every committed event exactly once
+ *             -1 otherwise
+ * Description: Kills one child after kill_ms, usually before its first buffer
+ *		goes out, and another half a second later, once several have been
+ *		written, with the journal then left as if none of them had been
+ *		seen to complete.  A third child's writes fail once its file is
+ *		256 KB long.
+ */
+static int bench_journal(double rate, uint64_t count, int kill_ms) {
+	if (bench_journal_run(rate, count, kill_ms, 0) != 0
+			|| bench_journal_run(rate, count, kill_ms + 500, 1) != 0) {
+		return -1;
+	}
+	if (count > 1ULL << (CAP_RING_ORDER - 1)) {
+		count = 1ULL << (CAP_RING_ORDER - 1);
+	}
+	return bench_journal_full(rate, count, 256 * 1024);
+}
+/* end of function: bench_journal */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_format
+ * Inputs     : uint64_t count - records to format for the timing
+ *		const char *golden - timestamp file to reproduce
+ * Returns    : 0 if every check passed
+ *             -1 otherwise
+ * Description: The golden file must hold nothing but timestamps, as the files
+ *		in userapp/pulse_seq_script do.  The random records include nibbles
+ *		over 9, which only the sprintf formatter handles, to check the
+ *		fallback.  Both formatters are then timed filling CAP_WRBUFF_LEN
+ *		buffers the way the writer does.
+ */
+static int bench_format(uint64_t count, const char *golden) {
+	struct stat st;
+	FILE *fp;
+	char *want, *got, *buff;
+	unsigned char raw[REC_RAW_LEN], *raws;
+	char a[REC_TEXT_MAX], b[REC_TEXT_MAX];
+	int64_t ns, t0, t1;
+	size_t len = 0, pos;
+	uint64_t cnt, records = 0, mismatch = 0, fallback = 0;
+	int fd, la, lb, ret = 0;
+
+	/* golden file: parse, encode, format, compare */
+	fd = open(golden, O_RDONLY);
+	if (fd == -1 || fstat(fd, &st) != 0) {
+		printf("\nCould not open %s\n", golden);
+		return -1;
+	}
+	want = malloc(st.st_size + 1);
+	got = malloc(st.st_size + REC_TEXT_MAX);
+	if (read(fd, want, st.st_size) != st.st_size) {
+		st.st_size = 0;
+	}
+	close(fd);
+	fp = fopen(golden, "r");
+	while (rec_parse_text(fp, &ns) == 0 && len < (size_t)st.st_size) {
+		rec_encode(ns, raw);
+		len += rec_format_text(raw, got + len);
+		records++;
+	}
+	fclose(fp);
+	printf("  golden : %s, %llu records, %zu of %lld bytes reproduced: %s\n", golden,
+		(unsigned long long)records, len, (long long)st.st_size,
+		(len == (size_t)st.st_size && memcmp(want, got, len) == 0) ? "identical" : "DIFFERENT");
+	if (len != (size_t)st.st_size || memcmp(want, got, len) != 0) {
+		ret = -1;
+	}
+	free(want);
+	free(got);
+
+	/* random bytes against the reference */
+	srand(560);
+	for (cnt = 0; cnt < 1000000; cnt++) {
+		for (la = 0; la < REC_RAW_LEN; la++) {
+			raw[la] = rand();
+		}
+		/* mostly valid BCD so the table path is exercised as well */
+		if (cnt % 4 != 0) {
+			for (la = 0; la < REC_RAW_LEN; la++) {
+				raw[la] = (raw[la] >> 4) % 10 << 4 | (raw[la] & 0x0F) % 10;
+			}
+		}
+		la = rec_format_text(raw, a);
+		lb = rec_format_text_sprintf(raw, b);
+		if (la != lb || memcmp(a, b, la + 1) != 0) {
+			mismatch++;
+		}
+		/* a record with every nibble 0-9 is 87 characters */
+		if (lb > 87) {
+			fallback++;
+		}
+	}
+	printf("  random : 1000000 records, %llu printing a nibble over 9 as two digits, %llu differ from sprintf\n",
+		(unsigned long long)fallback, (unsigned long long)mismatch);
+	if (mismatch != 0) {
+		ret = -1;
+	}
+
+	/* timing, over a day's worth of 1 ms spaced events */
+	raws = malloc(count * REC_RAW_LEN);
+	buff = malloc(CAP_WRBUFF_LEN);
+	for (cnt = 0; cnt < count; cnt++) {
+		rec_encode(1444000000000000000LL + (int64_t)cnt * 1000100, raws + cnt * REC_RAW_LEN);
+	}
+	for (la = 0; la < 2; la++) {
+		t0 = sim_now();
+		pos = 0;
+		len = 0;
+		for (cnt = 0; cnt < count; cnt++) {
+			if (pos + REC_TEXT_MAX > CAP_WRBUFF_LEN) {
+				len += pos;
+				pos = 0;
+			}
+			if (la == 0) {
+				pos += rec_format_text_sprintf(raws + cnt * REC_RAW_LEN, buff + pos);
+			}
+			else {
+				pos += rec_format_text(raws + cnt * REC_RAW_LEN, buff + pos);
+			}
+		}
+		len += pos;
+		t1 = sim_now();
+		printf("  %s: %llu records, %6.1f ns/record, %7.1f MB/s\n",
+			la == 0 ? "sprintf" : "table  ", (unsigned long long)count,
+			(double)(t1 - t0) / count, len / ((t1 - t0) / 1e3));
+	}
+	free(raws);
+	free(buff);
+	return ret;
+}
+/* end of function: bench_format */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_status
+ * Inputs     : double rate - events per second
+ *		uint64_t count - events to generate
+ *		int period_ms - status broker sampling interval
+ * Returns    : 0 if every status read was consistent
+ *             -1 otherwise
+ * Description: Runs the simulator with the status broker publishing every
+ *		period_ms and reads the status back as fast as possible while it
+ *		does.  Every copy must be complete and move forward from the one
+ *		before, and once the broker is stopped there must be nothing left
+ *		to read.
+ */
+static int bench_status(double rate, uint64_t count, int period_ms) {
+	struct capture cap;
+	struct cap_config cfg;
+	struct broker br;
+	struct sim sim;
+	struct sym560_status st, last;
+	struct timespec t0, t1, pause = {0, 100000};
+	uint64_t reads = 0, fails = 0, bad = 0, updates = 0;
+	int outfd;
+
+	sim_init(&sim, rate, count);
+	cap_config_default(&cfg);
+	outfd = open("/dev/null", O_WRONLY);
+	if (cap_init(&cap, &cfg, -1, outfd, &sim) != 0) {
+		return -1;
+	}
+	cap_start(&cap);
+	if (stat_start(&br, &cap, -1, period_ms * 1000000LL) != 0) {
+		cap_stop(&cap);
+		return -1;
+	}
+	memset(&last, 0, sizeof(last));
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	while (atomic_load(&cap.cap_done) == 0) {
+		reads++;
+		if (stat_read(&st) != 0) {
+			/* not published yet, or late by three periods on a busy machine */
+			fails++;
+			continue;
+		}
+		if ((st.seq & 1) != 0 || st.samples < last.samples || st.written > st.captured
+				|| st.captured < last.captured || st.updated_ns < last.updated_ns
+				|| st.lock != REC_LOCK_ALL || st.antenna != -1) {
+			bad++;
+		}
+		updates += st.samples != last.samples;
+		last = st;
+		/* a monitoring tool would poll far less often than this */
+		nanosleep(&pause, NULL);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	stat_stop(&br);
+	cap_stop(&cap);
+	close(cap.outfd);
+	cap_free(&cap);
+
+	printf("  %llu reads in %.2f s, %llu samples seen, %llu reads refused as stale\n",
+		(unsigned long long)reads, (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9,
+		(unsigned long long)updates, (unsigned long long)fails);
+	printf("  %llu inconsistent, last sample %llu captured %llu written\n",
+		(unsigned long long)bad, (unsigned long long)last.captured,
+		(unsigned long long)last.written);
+	if (bad != 0 || updates < 2 || stat_read(&st) == 0) {
+		printf("  FAILED\n");
+		return -1;
+	}
+	printf("  OK: every read consistent, nothing left once the broker stopped\n");
+	return 0;
+}
+/* end of function: bench_status */
+/*******************************************************************************/
+
+
+/* one subscriber in bench_stream */
+struct subscriber {
+	const char *path;
+	int slow_ms;			/* pause after every packet, 0 = read flat out */
+	int sock;
+	pthread_t thread;
+	uint64_t received;		/* records */
+	uint64_t lags;			/* STR_LAG packets */
+	uint64_t missed;		/* events they said were skipped */
+	uint64_t gaps;			/* events missing from the seq numbers */
+	uint64_t bad;			/* records out of order or repeated */
+	int dropped;			/* disconnected before the end */
+};
+
+/*******************************************************************************/
+/* Function   : sub_thread_main
+ * Inputs     : void *arg - the struct subscriber
+ * Returns    : NULL
+ * Description: Reads the stream until the server disconnects it, checking the
+ *		seq numbers of the records against the lag notices.
+ */
+static void *sub_thread_main(void *arg) {
+	struct subscriber *sub = arg;
+	struct str_header *hdr;
+	struct sym560_record *rec;
+	struct timespec pause;
+	char pkt[sizeof(struct str_header) + STR_BATCH * sizeof(struct sym560_record)];
+	uint64_t next = 0, cnt;
+	int ret, first = 1;
+
+	pause.tv_sec = sub->slow_ms / 1000;
+	pause.tv_nsec = (sub->slow_ms % 1000) * 1000000L;
+	hdr = (struct str_header *)pkt;
+	rec = (struct sym560_record *)(pkt + sizeof(*hdr));
+	for (;;) {
+		ret = recv(sub->sock, pkt, sizeof(pkt), 0);
+		if (ret <= 0) {
+			break;
+		}
+		if (hdr->type == STR_LAG) {
+			sub->lags++;
+			sub->missed += hdr->missed;
+			continue;
+		}
+		for (cnt = 0; cnt < hdr->count; cnt++) {
+			if (!first && rec[cnt].seq < next) {
+				sub->bad++;
+			}
+			else if (!first) {
+				sub->gaps += rec[cnt].seq - next;
+			}
+			next = rec[cnt].seq + 1;
+			first = 0;
+		}
+		sub->received += hdr->count;
+		if (sub->slow_ms != 0) {
+			nanosleep(&pause, NULL);
+		}
+	}
+	close(sub->sock);
+	return NULL;
+}
+/* end of function: sub_thread_main */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_stream
+ * Inputs     : double rate - events per second
+ *		uint64_t count - events to generate
+ *		int clients - subscribers, the last of which reads slowly
+ *		int slow_ms - the slow subscriber's pause after every packet
+ * Returns    : 0 if the stream behaved
+ *             -1 otherwise
+ * Description: A second server must refuse the socket while the first one
+ *		is up.  Every subscriber but the last must receive exactly the
+ *		events the writer took from the ring, in order.  The last one pauses
+ *		slow_ms after every packet; every gap it sees has to be accounted
+ *		for by a lag notice or by the capture's own losses, and at high
+ *		rates it should end up disconnected.  The archive must not lose
+ *		anything on its account.
+ */
+static int bench_stream(double rate, uint64_t count, int clients, int slow_ms) {
+	struct capture cap;
+	struct cap_config cfg;
+	struct stream str, other;
+	struct sim sim;
+	struct sockaddr_un addr;
+	struct subscriber sub[STR_MAX_CLIENTS];
+	struct timespec pause = {0, 1000000};
+	char path[] = "/tmp/sym560_bench.stream";
+	uint64_t lost;
+	int outfd, cnt, ret = 0;
+
+	if (clients < 1 || clients > STR_MAX_CLIENTS) {
+		printf("  between 1 and %d subscribers\n", STR_MAX_CLIENTS);
+		return -1;
+	}
+	sim_init(&sim, rate, count);
+	cap_config_default(&cfg);
+	outfd = open("/dev/null", O_WRONLY);
+	if (cap_init(&cap, &cfg, -1, outfd, &sim) != 0) {
+		return -1;
+	}
+	if (str_start(&str, &cap, path) != 0) {
+		cap_free(&cap);
+		return -1;
+	}
+
+	/* everyone is connected before the first event */
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	memset(sub, 0, sizeof(sub));
+	for (cnt = 0; cnt < clients; cnt++) {
+		sub[cnt].slow_ms = cnt == clients - 1 ? slow_ms : 0;
+		sub[cnt].sock = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+		if (connect(sub[cnt].sock, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+			printf("  could not connect to %s (errno %d)\n", path, errno);
+			return -1;
+		}
+		pthread_create(&sub[cnt].thread, NULL, sub_thread_main, &sub[cnt]);
+	}
+	while (atomic_load(&str.accepted) != (uint64_t)clients) {
+		nanosleep(&pause, NULL);
+	}
+
+	/* a second server must not take the socket from under them */
+	if (str_start(&other, &cap, path) == 0) {
+		printf("  a second server took over %s\n", path);
+		return -1;
+	}
+
+	cap_start(&cap);
+	while (atomic_load(&cap.cap_done) == 0) {
+		nanosleep(&pause, NULL);
+	}
+	cap_stop(&cap);
+	str_stop(&str);
+	for (cnt = 0; cnt < clients; cnt++) {
+		pthread_join(sub[cnt].thread, NULL);
+	}
+	close(cap.outfd);
+	cap_free(&cap);
+
+	lost = cap.overflows + cap.dropped;
+	printf("  %llu events, %llu written, %llu lost at the source, %llu ring overflows\n",
+		(unsigned long long)count, (unsigned long long)cap.written,
+		(unsigned long long)sim.lost, (unsigned long long)cap.overflows);
+	printf("  ");
+	str_print(&str);
+	for (cnt = 0; cnt < clients; cnt++) {
+		printf("  subscriber %2d%s: %llu received, %llu lag notices for %llu events, "
+			"%llu missing, %llu out of order\n", cnt, sub[cnt].slow_ms != 0 ? " (slow)" : "",
+			(unsigned long long)sub[cnt].received, (unsigned long long)sub[cnt].lags,
+			(unsigned long long)sub[cnt].missed, (unsigned long long)sub[cnt].gaps,
+			(unsigned long long)sub[cnt].bad);
+		if (sub[cnt].bad != 0 || sub[cnt].gaps < sub[cnt].missed
+				|| sub[cnt].gaps > sub[cnt].missed + lost) {
+			ret = -1;
+		}
+		if (sub[cnt].slow_ms == 0 && (sub[cnt].received != cap.written || sub[cnt].lags != 0)) {
+			ret = -1;
+		}
+	}
+	if (ret != 0) {
+		printf("  FAILED\n");
+		return -1;
+	}
+	printf("  OK: every subscriber kept up or was told what it missed\n");
+	return 0;
+}
+/* end of function: bench_stream */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : met_value
+ * Inputs     : const char *text - exported metrics
+ *		const char *series - series name with any labels, e.g. name_count
+ * Returns    : Its value, -1 if it is not there
+ */
+static double met_value(const char *text, const char *series) {
+	const char *p = text;
+	size_t len = strlen(series);
+
+	while ((p = strstr(p, series)) != NULL) {
+		if ((p == text || p[-1] == '\n') && p[len] == ' ') {
+			return atof(p + len + 1);
+		}
+		p += len;
+	}
+	return -1;
+}
+/* end of function: met_value */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : met_check
+ * Inputs     : const char *text - exported metrics
+ * Returns    : Number of malformed lines and inconsistent histograms
+ * Description: Every line must be a comment or "series value", and every
+ *		histogram's buckets must never go down and end at its count.
+ */
+static int met_check(const char *text) {
+	const char *line, *end, *sp;
+	double value, prev = 0;
+	int bad = 0, inhist = 0;
+
+	for (line = text; *line != '\0'; line = end + 1) {
+		end = strchr(line, '\n');
+		if (end == NULL) {
+			return bad + 1;
+		}
+		if (*line == '#') {
+			inhist = 0;
+			continue;
+		}
+		sp = memchr(line, ' ', end - line);
+		if (sp == NULL || sp == line) {
+			bad++;
+			continue;
+		}
+		value = atof(sp + 1);
+		if (memchr(line, '{', sp - line) != NULL && strstr(line, "_bucket{") != NULL
+				&& strstr(line, "_bucket{") < sp) {
+			if (inhist && value < prev) {
+				bad++;
+			}
+			inhist = 1;
+			prev = value;
+		}
+		else if (sp - line > 6 && strncmp(sp - 6, "_count", 6) == 0 && value != prev) {
+			bad++;
+		}
+	}
+	return bad;
+}
+/* end of function: met_check */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_metrics
+ * Inputs     : double rate - events per second
+ *		uint64_t count - events to generate
+ *		int period_ms - how often to export
+ * Returns    : 0 if every export was well formed and the totals add up
+ *             -1 otherwise
+ * Description: Exports every period_ms while the simulator runs, checking each
+ *		export and that the counters never go backwards, then checks the
+ *		writer's histograms account for every event written.
+ */
+static int bench_metrics(double rate, uint64_t count, int period_ms) {
+	struct capture cap;
+	struct cap_config cfg;
+	struct exporter ex;
+	struct sim sim;
+	struct timespec pause, t0, t1;
+	char *text;
+	double written, last = 0, fmt_ns = 0;
+	uint64_t exports = 0;
+	int outfd, bad = 0, len = 0;
+
+	text = malloc(MET_BUFF_LEN);
+	sim_init(&sim, rate, count);
+	cap_config_default(&cfg);
+	outfd = open("/dev/null", O_WRONLY);
+	if (text == NULL || cap_init(&cap, &cfg, -1, outfd, &sim) != 0) {
+		return -1;
+	}
+	memset(&ex, 0, sizeof(ex));
+	ex.cap = &cap;
+	pause.tv_sec = period_ms / 1000;
+	pause.tv_nsec = (period_ms % 1000) * 1000000L;
+	cap_start(&cap);
+	while (atomic_load(&cap.cap_done) == 0) {
+		nanosleep(&pause, NULL);
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		len = met_format(&ex, text, MET_BUFF_LEN);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		fmt_ns += (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+		exports++;
+		written = met_value(text, "sym560_events_written_total");
+		if (len == -1 || met_check(text) != 0 || written < last) {
+			bad++;
+		}
+		last = written;
+	}
+	cap_stop(&cap);
+	close(cap.outfd);
+	len = met_format(&ex, text, MET_BUFF_LEN);
+	cap_free(&cap);
+
+	printf("  %llu events, %llu written, %llu lost at the source\n",
+		(unsigned long long)count, (unsigned long long)cap.written, (unsigned long long)sim.lost);
+	printf("  %llu exports of %d bytes, %.0f us each, %d malformed or going backwards\n",
+		(unsigned long long)exports, len, exports != 0 ? fmt_ns / exports / 1000 : 0, bad);
+	printf("  %.0f batches, %.1f records per batch, mean writer latency %.1f us\n",
+		met_value(text, "sym560_writer_batch_records_count"),
+		met_value(text, "sym560_writer_batch_records_sum")
+			/ met_value(text, "sym560_writer_batch_records_count"),
+		met_value(text, "sym560_writer_latency_seconds_sum") * 1e6
+			/ met_value(text, "sym560_writer_latency_seconds_count"));
+	if (bad != 0 || len == -1 || met_check(text) != 0
+			|| met_value(text, "sym560_events_written_total") != cap.written
+			|| met_value(text, "sym560_writer_batch_records_sum") != cap.written
+			|| met_value(text, "sym560_seconds_since_last_event") < 0) {
+		printf("  FAILED\n");
+		free(text);
+		return -1;
+	}
+	printf("  OK: every export well formed, the batches add up to the events written\n");
+	free(text);
+	return 0;
+}
+/* end of function: bench_metrics */
+/*******************************************************************************/
+
+
+/* radar control as played by bench_radar */
+struct radar_feed {
+	struct sim *sim;
+	const char *name;
+	uint64_t nseq;			/* sequences the simulator will produce */
+	int late_ms;			/* how long after its sequence an even entry is pushed */
+	uint64_t pushed;		/* entries for real sequences */
+	uint64_t orphans;		/* entries for none */
+	uint64_t failed;		/* pushes refused */
+};
+
+/*******************************************************************************/
+/* Function   : radar_jitter
+ * Inputs     : uint64_t k - sequence number
+ * Returns    : How far, in ns, sequence k's intended start is from its real one
+ */
+static int64_t radar_jitter(uint64_t k) {
+	return ((int64_t)(k * 37 % 401) - 200) * 1000;
+}
+/* end of function: radar_jitter */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : radar_thread_main
+ * Inputs     : void *arg - the struct radar_feed
+ * Returns    : NULL
+ * Description: Odd sequences are described 20 ms before they start and even
+ *		ones late_ms after, every tenth not at all, and every seventh is
+ *		followed by an entry for a sequence 35 ms later, which never comes.
+ */
+static void *radar_thread_main(void *arg) {
+	struct radar_feed *rf = arg;
+	struct rad_producer p;
+	struct rad_meta m;
+	struct timespec ts;
+	int64_t due, now;
+	uint64_t k;
+
+	if (rad_open(&p, rf->name) != 0) {
+		rf->failed = rf->nseq;
+		return NULL;
+	}
+	for (k = 0; k < rf->nseq; k++) {
+		due = rf->sim->t0 + (int64_t)k * rf->sim->period_ns
+			+ (k % 2 != 0 ? -20000000LL : rf->late_ms * 1000000LL);
+		now = sim_now();
+		if (due > now) {
+			ts.tv_sec = (due - now) / 1000000000LL;
+			ts.tv_nsec = (due - now) % 1000000000LL;
+			nanosleep(&ts, NULL);
+		}
+		m.start_ns = rf->sim->start_ns + (int64_t)k * rf->sim->period_ns + radar_jitter(k);
+		m.seq_id = k;
+		m.beam = k % 16;
+		m.freq_khz = 10000 + k % 16 * 100;
+		if (k % 10 != 9) {
+			if (rad_push(&p, &m) == 0) {
+				rf->pushed++;
+			}
+			else {
+				rf->failed++;
+			}
+		}
+		if (k % 7 == 0) {
+			m.start_ns += 35000000LL;
+			m.seq_id = 1000000 + k;
+			if (rad_push(&p, &m) == 0) {
+				rf->orphans++;
+			}
+			else {
+				rf->failed++;
+			}
+		}
+	}
+	rad_close(&p);
+	return NULL;
+}
+/* end of function: radar_thread_main */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_radar
+ * Inputs     : double seconds - how long to capture
+ *		int late_ms - how late the even entries are pushed
+ *		int lag_ms - how long after being stamped each event is read
+ * Returns    : 0 if every entry was joined to its own sequence and nothing else
+ *             -1 otherwise
+ * Description: Sequences of findpulse.pl's table every 70 ms.  Each SEQUENCE
+ *		line is checked against what was pushed for it: its time must be
+ *		the sequence's real start and its offset the jitter put on the
+ *		intended one.  Only the simulator's losses may leave a sequence
+ *		short of pulses, however late its last one reaches the writer.
+ */
+static int bench_radar(double seconds, int late_ms, int lag_ms) {
+	static const double psep[] = {21.0, 12.0, 3.0, 4.5, 6.0, 16.5, 1.5};
+	struct capture cap;
+	struct cap_config cfg;
+	struct joiner rad;
+	struct sim sim;
+	struct radar_feed rf;
+	pthread_t tid;
+	FILE *fp;
+	char path[] = "/tmp/sym560_radarXXXXXX", name[64], line[256], *at;
+	int year, day, hour, min, sec, found, npulse, outfd;
+	unsigned int beam, freq, present;
+	unsigned long long id;
+	long long frac, last = -1;
+	double offset;
+	int64_t ns;
+	uint64_t k, lines = 0, bad = 0, short_seqs = 0;
+
+	memset(&rf, 0, sizeof(rf));
+	rf.nseq = (uint64_t)(seconds * 1000 / 70);
+	if (sim_init_pattern(&sim, psep, 7, 70, rf.nseq * 8) != 0) {
+		return -1;
+	}
+	sim.start_ns -= lag_ms * 1000000LL;
+	outfd = mkstemp(path);
+	cap_config_default(&cfg);
+	if (outfd == -1 || cap_init(&cap, &cfg, -1, outfd, &sim) != 0) {
+		return -1;
+	}
+	sprintf(name, "/sym560_radar_bench%d", (int)getpid());
+	rf.sim = &sim;
+	rf.name = name;
+	rf.late_ms = late_ms;
+	cap_start(&cap);
+	if (rad_start(&rad, &cap, name, RAD_DEFAULT_TOL_NS) != 0) {
+		cap_stop(&cap);
+		return -1;
+	}
+	pthread_create(&tid, NULL, radar_thread_main, &rf);
+	pthread_join(tid, NULL);
+	while (atomic_load(&cap.cap_done) == 0) {
+		usleep(10000);
+	}
+	/* give the writer the rest of the window to join the late entries */
+	usleep(late_ms * 1000 + 100000);
+	cap_stop(&cap);
+	rad_stop(&rad, &cap);
+	close(cap.outfd);
+	cap_free(&cap);
+
+	fp = fopen(path, "r");
+	while (fp != NULL && fgets(line, sizeof(line), fp) != NULL) {
+		at = strstr(line, "SEQUENCE =");
+		if (at == NULL) {
+			continue;
+		}
+		lines++;
+		if (sscanf(at, "SEQUENCE = %d-%d %d:%d:%d.%lld UTC ID %llu BEAM %u FREQ %u kHz "
+				"OFFSET %lf us PULSES %d/%d 0x%x", &year, &day, &hour, &min, &sec, &frac,
+				&id, &beam, &freq, &offset, &found, &npulse, &present) != 13) {
+			bad++;
+			continue;
+		}
+		k = id;
+		ns = rec_ns(year, day, hour, min, sec, frac);
+		if (k >= rf.nseq || k % 10 == 9 || (long long)k <= last
+				|| ns != sim.start_ns + (int64_t)k * sim.period_ns
+				|| fabs(offset * 1000 + radar_jitter(k)) > 100 || beam != k % 16
+				|| found != __builtin_popcount(present) || npulse != 8) {
+			bad++;
+		}
+		if (found != npulse) {
+			short_seqs++;
+		}
+		last = k;
+	}
+	if (fp != NULL) {
+		fclose(fp);
+	}
+	unlink(path);
+
+	printf("  %llu sequences, %llu events lost at the source, %llu entries pushed, %llu with no sequence\n",
+		(unsigned long long)rf.nseq, (unsigned long long)sim.lost,
+		(unsigned long long)rf.pushed, (unsigned long long)rf.orphans);
+	printf("  %llu joined, %llu sequences with no entry, %llu entries with no sequence\n",
+		(unsigned long long)rad.joined, (unsigned long long)rad.unjoined,
+		(unsigned long long)rad.orphans);
+	printf("  %llu SEQUENCE lines, %llu wrong, %llu short of pulses\n", (unsigned long long)lines,
+		(unsigned long long)bad, (unsigned long long)short_seqs);
+	if (bad != 0 || rf.failed != 0 || lines != rad.joined || rad.orphans != rf.orphans
+			|| short_seqs > sim.lost
+			|| rad.joined + rad.unjoined < rf.pushed
+			|| (sim.lost == 0 && rad.joined != rf.pushed)) {
+		printf("  FAILED\n");
+		return -1;
+	}
+	printf("  OK: every sequence joined to its own entry, the others let go\n");
+	return 0;
+}
+/* end of function: bench_radar */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_tracker
+ * Inputs     : double seconds - how long to capture
+ *		double rotate_s - rotation boundary interval
+ * Returns    : 0 if every sequence was found once, whole and in order
+ *             -1 otherwise
+ * Description: Sequences of findpulse.pl's table every 70 ms, with a new
+ *		file starting part way through one of them.  Each DETECTED line
+ *		must give the start of the next sequence with every pulse at +0.0,
+ *		unless the simulator lost some of its events, and the timestamps
+ *		around the lines must still all read back.  The sequence split
+ *		between two files is only found whole if the detector carried on
+ *		from one into the other.  The metrics are checked against the
+ *		tracker's counts before it is stopped.  The timing histograms are
+ *		read back from the day's file: the minute boundary splits them
+ *		into two records, which between them must hold every sequence
+ *		and every pulse seen, each at 0.
+ */
+static int bench_tracker(double seconds, double rotate_s) {
+	static const double psep[] = {21.0, 12.0, 3.0, 4.5, 6.0, 16.5, 1.5};
+	struct capture cap;
+	struct cap_config cfg;
+	struct tracker trk;
+	struct exporter ex;
+	struct sim sim;
+	struct dirent **names;
+	FILE *fp;
+	char dir[] = "/tmp/sym560_trackerXXXXXX", filename[CAP_FILENAME_LEN], line[512], name[SEQ_NAME_LEN];
+	char *at, *buff;
+	int year, day, hour, min, sec, found, npulse, nfiles, ntiming, cnt, k, len, outfd, metrics_bad;
+	struct tim_header hdr;
+	struct adev_sums sums, stab;
+	double tau, dev;
+	uint32_t within[SEQ_MAX_PULSES];
+	uint64_t (*count)[TIM_BUCKETS], all[TIM_BUCKETS];
+	uint64_t records = 0, hist_seqs = 0, hist_missing = 0, hist_pulses = 0, hist_within = 0, hist_bad = 0;
+	int64_t prev_minute = 0;
+	unsigned int present;
+	long long frac;
+	double resid;
+	int64_t ns, first_ns, last_ns = 0, rotate_ns = (int64_t)(rotate_s * 1e9);
+	uint64_t nseq, seq, next = 0, lines = 0, bad = 0, crossed = 0, whole = 0, events = 0, disorder = 0;
+
+	if (mkdtemp(dir) == NULL || chdir(dir) == -1) {
+		printf("\nCould not create %s\n", dir);
+		return -1;
+	}
+	nseq = (uint64_t)(seconds * 1000 / 70);
+	if (sim_init_pattern(&sim, psep, 7, 70, nseq * 8) != 0) {
+		return -1;
+	}
+	/* stamped so that a minute, and so a new file, starts 30 ms into the
+	 * middle sequence; stamps ahead of the clock also keep trk_idle from
+	 * giving up on any of the sequences */
+	sim.start_ns = (sim.start_ns / 60000000000LL + 2) * 60000000000LL
+		- (int64_t)(nseq / 2) * sim.period_ns - 30000000LL;
+	cap_config_default(&cfg);
+	cfg.rotate_ns = rotate_ns;
+	cap_filename(sim.start_ns, filename);
+	outfd = open(filename, O_RDWR|O_CREAT|O_APPEND, 00644);
+	if (outfd == -1 || cap_init(&cap, &cfg, -1, outfd, &sim) != 0) {
+		return -1;
+	}
+	if (trk_start(&trk, &cap, "katscan", SEQ_DEFAULT_TOL_NS, TIM_DEFAULT_WINDOW_NS) != 0) {
+		cap_free(&cap);
+		return -1;
+	}
+	cap_start(&cap);
+	while (atomic_load(&cap.cap_done) == 0) {
+		usleep(10000);
+	}
+	cap_stop(&cap);
+
+	/* the export as it would be on the way out */
+	memset(&ex, 0, sizeof(ex));
+	ex.cap = &cap;
+	buff = malloc(MET_BUFF_LEN);
+	len = buff != NULL ? met_format(&ex, buff, MET_BUFF_LEN) : -1;
+	metrics_bad = len == -1 || met_check(buff) != 0
+		|| met_value(buff, "sym560_sequences_total{table=\"katscan\"}") != trk.sequences
+		|| met_value(buff, "sym560_sequence_pulses_missing_total") != trk.missing
+		|| met_value(buff, "sym560_sequence_completeness") < 0;
+	free(buff);
+	trk_stop(&trk, &cap);
+	close(cap.outfd);
+	cap_free(&cap);
+
+	nfiles = scandir(".", &names, is_timestampdata, alphasort);
+	for (cnt = 0; cnt < nfiles; cnt++) {
+		fp = fopen(names[cnt]->d_name, "r");
+		/* every event is still there around the lines */
+		first_ns = -1;
+		while (fp != NULL && rec_parse_text(fp, &ns) == 0) {
+			if (ns <= last_ns || (sim.lost == 0 && ns != sim.start_ns + sim_event_ns(&sim, events))) {
+				disorder++;
+			}
+			if (first_ns == -1) {
+				first_ns = ns;
+			}
+			last_ns = ns;
+			events++;
+		}
+		if (fp != NULL) {
+			rewind(fp);
+		}
+		while (fp != NULL && fgets(line, sizeof(line), fp) != NULL) {
+			at = strstr(line, "DETECTED =");
+			if (at == NULL) {
+				continue;
+			}
+			lines++;
+			if (sscanf(at, "DETECTED = %d-%d %d:%d:%d.%lld UTC %15s %d/%d 0x%x RESIDUALS%n",
+					&year, &day, &hour, &min, &sec, &frac, name, &found, &npulse,
+					&present, &len) != 10) {
+				bad++;
+				continue;
+			}
+			ns = rec_ns(year, day, hour, min, sec, frac);
+			seq = (ns - sim.start_ns) / sim.period_ns;
+			if ((ns - sim.start_ns) % sim.period_ns != 0 || seq < next || strcmp(name, "katscan") != 0
+					|| npulse != 8 || found != __builtin_popcount(present)
+					|| (sim.lost == 0 && found != 8)) {
+				bad++;
+			}
+			next = seq + 1;
+			if (found == 8) {
+				whole++;
+			}
+			at += len;
+			for (k = 0; k < npulse; k++) {
+				if (present & (1U << k) ? sscanf(at, " %lf%n", &resid, &len) != 1 || resid != 0
+						: sscanf(at, " -%n", &len) != 0 || len == 0) {
+					bad++;
+					break;
+				}
+				at += len;
+			}
+			/* its first pulse went into an earlier file */
+			if (ns < first_ns) {
+				crossed++;
+			}
+		}
+		if (fp != NULL) {
+			fclose(fp);
+		}
+		remove(names[cnt]->d_name);
+		free(names[cnt]);
+	}
+	free(names);
+
+	/* the histograms of the minutes, all in one day's file */
+	count = calloc(SEQ_MAX_PULSES, sizeof(*count));
+	memset(all, 0, sizeof(all));
+	memset(&stab, 0, sizeof(stab));
+	ntiming = count != NULL ? scandir(".", &names, is_timing, alphasort) : -1;
+	for (cnt = 0; cnt < ntiming; cnt++) {
+		fp = fopen(names[cnt]->d_name, "r");
+		while (fp != NULL && (len = tim_read(fp, &hdr, within, &sums, count, all)) == 0) {
+			records++;
+			adev_merge(&stab, &sums);
+			if (strcmp(hdr.table, "katscan") != 0 || hdr.npulse != 8 || hdr.window_ns != TIM_DEFAULT_WINDOW_NS
+					|| hdr.minute_ns % 60000000000LL != 0 || hdr.minute_ns <= prev_minute) {
+				hist_bad++;
+			}
+			prev_minute = hdr.minute_ns;
+			hist_seqs += hdr.sequences;
+			hist_missing += hdr.missing;
+			for (k = 0; k < hdr.npulse; k++) {
+				hist_within += within[k];
+			}
+		}
+		if (fp == NULL || len == -1) {
+			hist_bad++;
+		}
+		if (fp != NULL) {
+			fclose(fp);
+		}
+		remove(names[cnt]->d_name);
+		free(names[cnt]);
+	}
+	if (ntiming > 0) {
+		free(names);
+	}
+	for (k = 0; k < TIM_BUCKETS; k++) {
+		hist_pulses += all[k];
+	}
+	if (all[TIM_HALF] != hist_pulses) {
+		hist_bad++;
+	}
+	/* the simulated starts are exactly 70 ms apart, so the deviation is 0
+	 * at every tau the run was long enough for */
+	for (k = 0; k < ADEV_OCTAVES; k++) {
+		if (adev_deviation(&stab, k, &tau, &dev) == 0
+				&& (dev != 0 || stab.period_sum != (int64_t)stab.periods * sim.period_ns)) {
+			hist_bad++;
+		}
+	}
+	if (stab.n[0] == 0) {
+		hist_bad++;
+	}
+	free(count);
+	chdir("/tmp");
+	rmdir(dir);
+
+	printf("  %llu sequences in %d files, %llu events lost at the source\n",
+		(unsigned long long)nseq, nfiles, (unsigned long long)sim.lost);
+	printf("  ");
+	trk_print(&trk);
+	printf("  %llu DETECTED lines, %llu with every pulse, %llu across a file boundary, %llu wrong\n",
+		(unsigned long long)lines, (unsigned long long)whole, (unsigned long long)crossed,
+		(unsigned long long)bad);
+	printf("  read back %llu events, %llu not where they were generated\n",
+		(unsigned long long)events, (unsigned long long)disorder);
+	printf("  timing histograms: %llu minutes, %llu sequences, %llu pulses, %llu inside the window, %llu wrong\n",
+		(unsigned long long)records, (unsigned long long)hist_seqs, (unsigned long long)hist_pulses,
+		(unsigned long long)hist_within, (unsigned long long)hist_bad);
+	printf("  Allan deviation: %u runs, %u terms at tau of one period\n", stab.runs, stab.n[0]);
+	if (hist_bad != 0 || records < 2 || records != trk.minutes || hist_seqs != trk.sequences
+			|| hist_missing != trk.missing || hist_pulses != trk.pulses || hist_within != trk.pulses) {
+		printf("  FAILED (timing histograms)\n");
+		return -1;
+	}
+	if (bad != 0 || nfiles < 2 || crossed == 0 || lines != trk.sequences || trk.pulses + trk.strays != events
+			|| events != cap.written || (sim.lost == 0 && lines != nseq) || disorder != 0
+			|| metrics_bad) {
+		printf("  FAILED%s\n", metrics_bad ? " (metrics)" : "");
+		return -1;
+	}
+	printf("  OK: every sequence found once and in order, whichever file it ended in, and timed\n");
+	return 0;
+}
+/* end of function: bench_tracker */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_timing
+ * Inputs     : uint64_t pulses - how many pulses to add
+ * Returns    : 0 if the buckets and the record are right
+ *             -1 otherwise
+ * Description: Every bucket must run on from the one before, hold its own
+ *		edges and be no wider than 1/8 of the values in it, and every
+ *		value out to 100 us and a million random ones further out must
+ *		land in a bucket holding it.  The pulses are jittered by a few us
+ *		with one in a thousand far out, as a radar's would be, and added
+ *		to one histogram; its record, with some Allan deviation sums, is
+ *		then read back through a file.
+ */
+static int bench_timing(uint64_t pulses) {
+	struct seq_set set;
+	struct tim_hist *h;
+	struct tim_header hdr;
+	struct adev_sums sums, sums_back;
+	struct timespec t0, t1;
+	uint32_t within[SEQ_MAX_PULSES];
+	uint64_t (*count)[TIM_BUCKETS], all[TIM_BUCKETS], cnt, bad = 0, in = 0, missed = 0;
+	int64_t *resid, lo, hi, prev_hi = 0, v;
+	size_t len = 0;
+	char *buf;
+	FILE *fp;
+	double secs;
+	int b, k, ret = -1;
+
+	/* the buckets themselves */
+	for (b = 0; b < TIM_BUCKETS; b++) {
+		tim_bounds(b, &lo, &hi);
+		if ((b > 0 && lo != prev_hi + 1) || tim_bucket(lo) != b || tim_bucket(hi) != b
+				|| (hi != lo && (hi - lo) * 8 > (lo < 0 ? -hi : lo))) {
+			bad++;
+		}
+		prev_hi = hi;
+	}
+	srand(560);
+	for (cnt = 0; cnt < 1200001; cnt++) {
+		v = cnt <= 200000 ? (int64_t)cnt - 100000
+			: ((int64_t)rand() << 4 ^ rand()) % (1LL << 25) * (rand() % 2 ? 1 : -1);
+		tim_bounds(tim_bucket(v), &lo, &hi);
+		if ((v < lo && tim_bucket(v) != 0) || (v > hi && tim_bucket(v) != TIM_BUCKETS - 1)) {
+			bad++;
+		}
+	}
+	printf("  buckets: %d of them, exact to 16 ns and 1/8 of the value beyond, %llu wrong\n",
+		TIM_BUCKETS, (unsigned long long)bad);
+
+	if (seq_set_parse(&set, "katscan", SEQ_DEFAULT_TOL_NS) != 0) {
+		return -1;
+	}
+	h = calloc(1, sizeof(*h));
+	count = calloc(SEQ_MAX_PULSES, sizeof(*count));
+	resid = malloc(pulses * sizeof(*resid));
+	buf = malloc(TIM_RECORD_MAX);
+	if (h == NULL || count == NULL || resid == NULL || buf == NULL) {
+		printf("\nCould not allocate %llu pulses\n", (unsigned long long)pulses);
+		bad++;
+		pulses = 0;
+	}
+	for (cnt = 0; cnt < pulses; cnt++) {
+		resid[cnt] = rand() % 1000 != 0 ? rand() % 3001 + rand() % 3001 - 3000
+			: rand() % 90001 + 10000;
+		in += resid[cnt] >= -TIM_DEFAULT_WINDOW_NS && resid[cnt] <= TIM_DEFAULT_WINDOW_NS;
+	}
+
+	/* the tracker's part for each pulse */
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (cnt = 0; cnt < pulses; cnt++) {
+		tim_add(h, cnt % 8, resid[cnt], TIM_DEFAULT_WINDOW_NS);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+	/* and back from its record */
+	if (pulses != 0) {
+		h->sequences = pulses / 8;
+		memset(&sums, 0, sizeof(sums));
+		for (k = 0; k < ADEV_OCTAVES; k++) {
+			sums.sum[k] = k * 1e9 + 0.5;
+			sums.n[k] = k;
+		}
+		len = tim_encode(h, &sums, &set.tab[0], 60000000000LL, TIM_DEFAULT_WINDOW_NS, buf);
+		fp = tmpfile();
+		memset(all, 0, sizeof(all));
+		if (fp == NULL || fwrite(buf, len, 1, fp) != 1) {
+			bad++;
+		}
+		else {
+			rewind(fp);
+			if (tim_read(fp, &hdr, within, &sums_back, count, all) != 0
+					|| tim_read(fp, &hdr, within, &sums_back, count, all) != 1
+					|| hdr.sequences != pulses / 8 || hdr.minute_ns != 60000000000LL
+					|| memcmp(&sums, &sums_back, sizeof(sums)) != 0) {
+				bad++;
+			}
+			for (k = 0; k < 8; k++) {
+				in -= within[k];
+				for (b = 0; b < TIM_BUCKETS; b++) {
+					missed += count[k][b] != h->count[k][b];
+				}
+			}
+		}
+		if (fp != NULL) {
+			fclose(fp);
+		}
+	}
+	printf("  %llu pulses added in %.3f s, %.2f ns each\n", (unsigned long long)pulses, secs,
+		pulses != 0 ? secs * 1e9 / pulses : 0.0);
+	printf("  record of the minute: %zu bytes, %llu buckets read back wrong, window count off by %lld\n",
+		len, (unsigned long long)missed, (long long)in);
+	if (bad == 0 && missed == 0 && in == 0) {
+		printf("  OK: every value in its bucket and the minute read back whole\n");
+		ret = 0;
+	}
+	else {
+		printf("  FAILED\n");
+	}
+	seq_set_free(&set);
+	free(h);
+	free(count);
+	free(resid);
+	free(buf);
+	return ret;
+}
+/* end of function: bench_timing */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_allan
+ * Inputs     : uint64_t starts - how many sequence starts to add
+ * Returns    : 0 if the streaming estimate agrees with the direct one
+ *             -1 otherwise
+ * Description: Starts 70 ms apart with 1 us of white phase noise, for which
+ *		the Allan deviation is sqrt(3) us / tau.  Up to m = 8 the streaming
+ *		estimator must give the same sums as working out every second
+ *		difference of the whole series; beyond, where it only works out
+ *		some of them, it must agree with those and with the theory to
+ *		within what its number of terms allows.  The sums are taken out
+ *		every 857 starts, as the tracker does each minute, and must add up
+ *		to those of an estimator left alone.
+ */
+static int bench_allan(uint64_t starts) {
+	struct adev *a, *whole;
+	struct adev_sums total;
+	struct timespec t0, t1;
+	int64_t *x, d;
+	double secs, tau, dev, direct, theory, sum, u1, u2;
+	uint64_t i, n, m, bad = 0;
+	int o;
+
+	a = malloc(sizeof(*a));
+	whole = malloc(sizeof(*whole));
+	x = malloc(starts * sizeof(*x));
+	if (a == NULL || whole == NULL || x == NULL) {
+		printf("\nCould not allocate %llu starts\n", (unsigned long long)starts);
+		free(a);
+		free(whole);
+		free(x);
+		return -1;
+	}
+	srand(560);
+	for (i = 0; i < starts; i++) {
+		u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+		u2 = rand() / (RAND_MAX + 1.0);
+		x[i] = 1800000000000000000LL + (int64_t)i * 70000000 + llrint(1000 * sqrt(-2 * log(u1)) * cos(2 * M_PI * u2));
+	}
+
+	adev_init(a);
+	adev_init(whole);
+	memset(&total, 0, sizeof(total));
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < starts; i++) {
+		adev_add(a, x[i]);
+		if (i % 857 == 856) {
+			adev_merge(&total, &a->s);
+			memset(&a->s, 0, sizeof(a->s));
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	adev_merge(&total, &a->s);
+	for (i = 0; i < starts; i++) {
+		adev_add(whole, x[i]);
+	}
+
+	printf("  %llu starts added in %.3f s, %.1f ns each\n", (unsigned long long)starts, secs,
+		starts != 0 ? secs * 1e9 / starts : 0.0);
+	printf("  %12s %10s %12s %12s %12s\n", "tau s", "terms", "streaming", "all terms", "theory");
+	for (o = 0; o < ADEV_OCTAVES; o++) {
+		if (adev_deviation(&total, o, &tau, &dev) != 0) {
+			continue;
+		}
+		m = 1ULL << o;
+		sum = 0;
+		n = 0;
+		for (i = 0; i + 2 * m < starts; i++) {
+			d = x[i + 2 * m] - 2 * x[i + m] + x[i];
+			sum += (double)d * d;
+			n++;
+		}
+		direct = sqrt(sum / (2.0 * n)) / 1e9 / tau;
+		theory = sqrt(3.0) * 1e-6 / tau;
+		printf("  %12.3f %10u %12.3e %12.3e %12.3e\n", tau, total.n[o], dev, direct, theory);
+		/* the sums taken out in pieces are those of the whole */
+		if (total.n[o] != whole->s.n[o] || fabs(total.sum[o] - whole->s.sum[o]) > 1e-9 * whole->s.sum[o]) {
+			bad++;
+		}
+		/* every term while m is at most 8, then a share of them */
+		if (o <= ADEV_DEPTH ? (n != total.n[o] || fabs(dev - direct) > 1e-9 * direct)
+				: fabs(dev / direct - 1) > 4 / sqrt(total.n[o]) + 0.01) {
+			bad++;
+		}
+		if (total.n[o] >= 1000 && fabs(dev / theory - 1) > 0.05) {
+			bad++;
+		}
+	}
+	if (total.runs != 1 || total.periods != starts - 1) {
+		bad++;
+	}
+	free(a);
+	free(whole);
+	free(x);
+	if (bad != 0) {
+		printf("  FAILED: %llu wrong\n", (unsigned long long)bad);
+		return -1;
+	}
+	printf("  OK: the streaming estimate follows the direct one, whichever way its sums are split\n");
+	return 0;
+}
+/* end of function: bench_allan */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_sequence
+ * Inputs     : uint64_t count - sequences to generate
+ * Returns    : 0 if every sequence and stray was found as generated
+ *             -1 otherwise
+ * Description: A sequence starts every 100 ms, each pulse up to 20 us off and
+ *		missing one time in five, keeping at least two so that it can be
+ *		recognised.  One gap in four also has a stray event 80 ms in, where
+ *		it fits no pulse of either neighbouring sequence.
+ */
+static int bench_sequence(uint64_t count) {
+	struct seq_set set;
+	struct seq_table *tab = &set.tab[0];
+	struct seq_det det;
+	struct seq_result seq;
+	struct timespec t0, t1;
+	uint32_t *want;
+	int64_t *strays, stray, start, ns;
+	uint64_t cnt, done = 0, nstray = 0, found = 0, events = 0, bad = 0;
+	int k, ret;
+	double took;
+
+	want = malloc(count * sizeof(*want));
+	strays = malloc(count * sizeof(*strays));
+	if (want == NULL || strays == NULL || seq_set_parse(&set, SEQ_DEFAULT_SEPS, SEQ_DEFAULT_TOL_NS) != 0) {
+		return -1;
+	}
+	seq_init(&det, &set);
+	srand(560);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (cnt = 0; cnt < count; cnt++) {
+		do {
+			want[cnt] = 0;
+			for (k = 0; k < tab->npulse; k++) {
+				want[cnt] |= (rand() % 5 != 0) << k;
+			}
+		} while (__builtin_popcount(want[cnt]) < 2);
+		start = 1000000000LL + (int64_t)cnt * 100000000LL;
+		for (k = 0; k <= tab->npulse; k++) {
+			if (k == tab->npulse) {
+				if (rand() % 4 != 0) {
+					break;
+				}
+				ns = start + 80000000LL;
+				strays[nstray++] = ns;
+			}
+			else if (want[cnt] & (1U << k)) {
+				ns = start + tab->off[k] + rand() % 40001 - 20000;
+			}
+			else {
+				continue;
+			}
+			events++;
+			ret = seq_feed(&det, ns, &seq, &stray);
+			if (ret == SEQ_DONE) {
+				bad += seq.present != want[done++];
+			}
+			else if (ret == SEQ_STRAY) {
+				bad += found >= nstray || stray != strays[found];
+				found++;
+			}
+		}
+	}
+	ret = seq_flush(&det, &seq, &stray);
+	if (ret == SEQ_DONE) {
+		bad += seq.present != want[done++];
+	}
+	else if (ret == SEQ_STRAY) {
+		bad += found >= nstray || stray != strays[found];
+		found++;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	took = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+
+	printf("  %llu sequences, %llu pulses, %llu missing, %llu strays, %.1f ns per event\n",
+		(unsigned long long)det.sequences, (unsigned long long)det.pulses,
+		(unsigned long long)det.missing, (unsigned long long)det.strays, took / events);
+	free(want);
+	free(strays);
+	seq_set_free(&set);
+	if (bad != 0 || done != count || found != nstray || det.strays != nstray
+			|| det.pulses + det.missing != count * tab->npulse) {
+		printf("  FAILED: %llu of %llu sequences and %llu of %llu strays found, %llu wrong\n",
+			(unsigned long long)done, (unsigned long long)count, (unsigned long long)found,
+			(unsigned long long)nstray, (unsigned long long)bad);
+		return -1;
+	}
+	printf("  OK: every sequence found with the pulses it was generated with\n");
+	return 0;
+}
+/* end of function: bench_sequence */
+/*******************************************************************************/
+
+
+/* what bench_lib checks the events it receives against */
+struct lib_check {
+	uint64_t got;			/* events received */
+	uint64_t next_seq;		/* sequence number expected next */
+	uint64_t bad;			/* out of order or wrongly decoded */
+	int64_t last_ns;
+};
+
+/*******************************************************************************/
+/* Function   : lib_check_batch
+ * Inputs     : const struct sym560_record *rec - events received
+ *		int n - how many
+ *		void *arg - the struct lib_check
+ * Returns    : Nothing
+ * Description: Also the sym560_dispatch callback.  Events must arrive with
+ *		increasing sequence numbers, skipping only those that overflowed
+ *		the ring, their times increasing and agreeing with the raw bytes.
+ */
+static void lib_check_batch(const struct sym560_record *rec, int n, void *arg) {
+	struct lib_check *chk = arg;
+	int cnt;
+
+	for (cnt = 0; cnt < n; cnt++) {
+		chk->bad += rec[cnt].seq < chk->next_seq || rec[cnt].ns <= chk->last_ns
+			|| rec[cnt].ns != rec_decode(rec[cnt].raw);
+		chk->next_seq = rec[cnt].seq + 1;
+		chk->last_ns = rec[cnt].ns;
+		chk->got++;
+	}
+}
+/* end of function: lib_check_batch */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_lib
+ * Inputs     : double rate - events per second, 0 = as fast as they are read
+ *		uint64_t count - events per run
+ * Returns    : 0 if every run received every event it captured
+ *             -1 otherwise
+ * Description: Runs the simulator three times, taking its events with
+ *		sym560_read, sym560_try_read and sym560_dispatch in turn, batches
+ *		of up to 256.  The ring holds 4096 events.  The status and time
+ *		calls are checked against the simulator on the way.
+ */
+static int bench_lib(double rate, uint64_t count) {
+	static const char *name[3] = {"sym560_read", "sym560_try_read", "sym560_dispatch"};
+	struct sym560_record recs[256];
+	struct sym560_status st;
+	struct cap_config cfg;
+	struct lib_check chk;
+	struct sym560 h;
+	struct sim sim;
+	struct timespec t0, t1, pause = {0, 100000};
+	void *ring_mem;
+	int64_t card_ns;
+	double took;
+	int mode, n, done, failed = 0;
+
+	if (posix_memalign(&ring_mem, SYM560_RING_ALIGN, SYM560_RING_BYTES(12)) != 0) {
+		return -1;
+	}
+	cap_config_default(&cfg);
+	for (mode = 0; mode < 3; mode++) {
+		sim_init(&sim, rate, count);
+		sym560_open_sim(&h, &sim, &cfg, ring_mem, 12);
+		memset(&chk, 0, sizeof(chk));
+		if (sym560_time(&h, &card_ns) != 0 || card_ns < sim.start_ns || sym560_start(&h) != 0) {
+			printf("  %s: could not start\n", name[mode]);
+			failed = 1;
+			sym560_close(&h);
+			continue;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		for (;;) {
+			if (mode == 0) {
+				n = sym560_read(&h, recs, 256, 1000);
+				if (n == -1) {
+					break;
+				}
+				lib_check_batch(recs, n, &chk);
+			}
+			else {
+				/* looked at first, so nothing committed before the thread exited is missed */
+				done = atomic_load(&h.cap.cap_done);
+				if (mode == 1) {
+					n = sym560_try_read(&h, recs, 256);
+					lib_check_batch(recs, n, &chk);
+				}
+				else {
+					n = sym560_dispatch(&h, lib_check_batch, &chk, 256);
+				}
+				if (n == 0 && done) {
+					break;
+				}
+				if (n == 0) {
+					nanosleep(&pause, NULL);
+				}
+			}
+		}
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		took = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+		sym560_status(&h, &st);
+		sym560_close(&h);
+
+		printf("  %-16s %llu received of %llu captured in %.3f s (%.0f events/s), %llu lost at the source, %llu ring overflows\n",
+			name[mode], (unsigned long long)chk.got, (unsigned long long)st.captured, took,
+			chk.got / took, (unsigned long long)sim.lost, (unsigned long long)st.dropped);
+		if (chk.bad != 0 || chk.got + st.dropped != st.captured || st.captured + sim.lost != count
+				|| st.written != chk.got || st.lock != REC_LOCK_ALL || st.backlog != 0) {
+			printf("  FAILED: %llu events out of order or wrongly decoded\n", (unsigned long long)chk.bad);
+			failed = 1;
+		}
+	}
+	free(ring_mem);
+	if (failed) {
+		return -1;
+	}
+	printf("  OK: every event captured was received once, in order\n");
+	return 0;
+}
+/* end of function: bench_lib */
+/*******************************************************************************/
+
+
+/* tables for bench_tables: the two built in and a longer one given at run time */
+#define BENCH_TABLES	"katscan/7pulse/exp16=1.2,3.6,8.4,18.0,7.2,28.8,14.4,9.6,46.8,2.4,20.4,19.2,15.6,6.0,10.8"
+
+/*******************************************************************************/
+/* Function   : bench_detect
+ * Inputs     : const struct seq_set *set - tables to look for
+ *		const int64_t *ns - event times
+ *		uint64_t n - how many
+ *		const uint8_t *table - table each sequence was generated from
+ *		const uint32_t *want - pulses each was generated with
+ *		uint64_t count - sequences
+ *		const char *what - name for the report
+ * Returns    : 0 if every sequence was found with its table and pulses
+ *             -1 otherwise
+ */
+static int bench_detect(const struct seq_set *set, const int64_t *ns, uint64_t n, const uint8_t *table,
+		const uint32_t *want, uint64_t count, const char *what) {
+	struct seq_det det;
+	struct seq_result seq;
+	int64_t stray, t0, t1;
+	uint64_t cnt, done = 0, wrong_table = 0, wrong_pulses = 0;
+	int ret;
+
+	seq_init(&det, set);
+	t0 = sim_now();
+	for (cnt = 0; cnt <= n; cnt++) {
+		ret = cnt < n ? seq_feed(&det, ns[cnt], &seq, &stray) : seq_flush(&det, &seq, &stray);
+		if (ret == SEQ_DONE && done < count) {
+			wrong_table += set->tab[seq.table].npulse != set->tab[table[done]].npulse
+				|| strcmp(set->tab[seq.table].name, set->tab[table[done]].name) != 0;
+			wrong_pulses += seq.present != want[done];
+			done++;
+		}
+	}
+	t1 = sim_now();
+	printf("  %-28s %8.1f ns per event, %llu sequences, %llu with the wrong table, %llu with the wrong pulses,"
+		" %llu strays\n", what, (double)(t1 - t0) / n, (unsigned long long)det.sequences,
+		(unsigned long long)wrong_table, (unsigned long long)wrong_pulses, (unsigned long long)det.strays);
+	return det.sequences == count && wrong_table == 0 && wrong_pulses == 0 && det.strays == 0 ? 0 : -1;
+}
+/* end of function: bench_detect */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_tables
+ * Inputs     : uint64_t count - sequences to generate
+ * Returns    : 0 if every sequence was found with its table and pulses
+ *             -1 otherwise
+ * Description: A sequence starts every 250 ms, from a table picked at random,
+ *		each pulse up to 20 us off and missing one time in five, keeping at
+ *		least three.  The katscan only run is timed with katscan alone and
+ *		with all three tables, whose index is searched for every pair.
+ */
+static int bench_tables(uint64_t count) {
+	struct seq_set one, three;
+	const struct seq_table *t;
+	int64_t *ns, start;
+	uint8_t *table;
+	uint32_t *want;
+	uint64_t cnt, n;
+	int k, mixed, ret = 0;
+
+	ns = malloc(count * SEQ_MAX_PULSES * sizeof(*ns));
+	table = malloc(count);
+	want = malloc(count * sizeof(*want));
+	if (ns == NULL || table == NULL || want == NULL || seq_set_parse(&one, "katscan", SEQ_DEFAULT_TOL_NS) != 0
+			|| seq_set_parse(&three, BENCH_TABLES, SEQ_DEFAULT_TOL_NS) != 0) {
+		return -1;
+	}
+	for (k = 0; k < three.ntab; k++) {
+		printf("  %-8s %2d pulses over %6.1f ms\n", three.tab[k].name, three.tab[k].npulse,
+			three.tab[k].off[three.tab[k].npulse - 1] / 1e6);
+	}
+	printf("  separation index: %d buckets of %.1f us, %u entries\n\n", three.nbucket,
+		(1 << three.shift) / 1e3, three.bucket[three.nbucket]);
+
+	for (mixed = 0; mixed < 2; mixed++) {
+		srand(560);
+		n = 0;
+		for (cnt = 0; cnt < count; cnt++) {
+			table[cnt] = mixed ? rand() % three.ntab : 0;
+			t = &three.tab[table[cnt]];
+			do {
+				want[cnt] = 0;
+				for (k = 0; k < t->npulse; k++) {
+					want[cnt] |= (rand() % 5 != 0) << k;
+				}
+			} while (__builtin_popcount(want[cnt]) < 3);
+			start = 1000000000LL + (int64_t)cnt * 250000000LL;
+			for (k = 0; k < t->npulse; k++) {
+				if (want[cnt] & (1U << k)) {
+					ns[n++] = start + t->off[k] + rand() % 40001 - 20000;
+				}
+			}
+		}
+		if (!mixed) {
+			ret |= bench_detect(&one, ns, n, table, want, count, "katscan, 1 table");
+			ret |= bench_detect(&three, ns, n, table, want, count, "katscan, 3 tables");
+		}
+		else {
+			ret |= bench_detect(&three, ns, n, table, want, count, "mixed, 3 tables");
+		}
+	}
+	seq_set_free(&one);
+	seq_set_free(&three);
+	free(ns);
+	free(table);
+	free(want);
+	if (ret != 0) {
+		printf("  FAILED\n");
+		return -1;
+	}
+	printf("  OK: every sequence found with its own table and pulses\n");
+	return 0;
+}
+/* end of function: bench_tables */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_same
+ * Inputs     : const char *a, *b - files to compare
+ * Returns    : 1 if both exist and hold the same bytes
+ *              0 otherwise
+ */
+static int bench_same(const char *a, const char *b) {
+	FILE *fa = fopen(a, "r"), *fb = fopen(b, "r");
+	char ba[65536], bb[65536];
+	size_t la, lb;
+	int same = fa != NULL && fb != NULL;
+
+	while (same) {
+		la = fread(ba, 1, sizeof(ba), fa);
+		lb = fread(bb, 1, sizeof(bb), fb);
+		same = la == lb && memcmp(ba, bb, la) == 0;
+		if (la == 0) {
+			break;
+		}
+	}
+	if (fa != NULL) {
+		fclose(fa);
+	}
+	if (fb != NULL) {
+		fclose(fb);
+	}
+	return same;
+}
+/* end of function: bench_same */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_pulses
+ * Inputs     : const char *script - findpulse.pl, NULL if it cannot be found
+ *		const char *input - timestamp file, in the current directory
+ *		const char *name - what to call it in the report
+ *		uint64_t events - timestamps in it
+ *		int64_t first - time of the first of them
+ *		const char *raw - the same as raw event times, or NULL
+ * Returns    : 0 if the outputs were identical
+ *             -1 otherwise
+ * Description: findpulse.pl auto names its output after the first event, in
+ *		the current directory.
+ */
+static int bench_pulses(const char *script, const char *input, const char *name, uint64_t events,
+		int64_t first, const char *raw) {
+	char cmd[PATH_MAX * 2], perl_out[PLS_FILENAME_LEN];
+	int64_t t0, t1, t2, t3;
+	int same = 1;
+
+	pls_filename(first, perl_out);
+	unlink(perl_out);
+	unlink("native.txt");
+	unlink("raw.txt");
+	t0 = sim_now();
+	if (script != NULL) {
+		snprintf(cmd, sizeof(cmd), "perl %s auto %s > /dev/null", script, input);
+		if (system(cmd) != 0) {
+			script = NULL;
+		}
+	}
+	t1 = sim_now();
+	findpulse(input, "native.txt", PLS_TEXT, SEQ_DEFAULT_SEPS, SEQ_DEFAULT_TOL_NS);
+	t2 = sim_now();
+	if (raw != NULL) {
+		findpulse(raw, "raw.txt", PLS_RAW, SEQ_DEFAULT_SEPS, SEQ_DEFAULT_TOL_NS);
+	}
+	t3 = sim_now();
+
+	printf("  %s: %llu events\n", name, (unsigned long long)events);
+	if (script != NULL) {
+		same = bench_same(perl_out, "native.txt");
+		printf("    findpulse.pl   %9.1f ms  %7.2f us/event\n", (t1 - t0) / 1e6, (t1 - t0) / 1e3 / events);
+	}
+	printf("    findpulse      %9.1f ms  %7.2f us/event", (t2 - t1) / 1e6, (t2 - t1) / 1e3 / events);
+	if (script != NULL) {
+		printf("  %5.1fx, output %s", (double)(t1 - t0) / (t2 - t1), same ? "identical" : "DIFFERENT");
+	}
+	printf("\n");
+	if (raw != NULL) {
+		printf("    findpulse -r   %9.1f ms  %7.2f us/event  %5.1fx, output %s\n", (t3 - t2) / 1e6,
+			(t3 - t2) / 1e3 / events, script != NULL ? (double)(t1 - t0) / (t3 - t2) : 0.0,
+			bench_same("native.txt", "raw.txt") ? "identical" : "DIFFERENT");
+		same = same && bench_same("native.txt", "raw.txt");
+	}
+	unlink(perl_out);
+	unlink("native.txt");
+	unlink("raw.txt");
+	return same ? 0 : -1;
+}
+/* end of function: bench_pulses */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_findpulse
+ * Inputs     : uint64_t count - events in the larger run
+ *		const char *input - timestamp file
+ * Returns    : 0 if every output matched
+ *             -1 otherwise
+ * Description: The copies are an hour apart so that the larger run also
+ *		crosses days, without any two events close enough in their seconds
+ *		alone to trip findpulse.pl up.  Each copy stops after the last whole
+ *		sequence in the file, as findpulse.pl mangles a sequence that is
+ *		cut short by the next event (see sym560_pulses.c).  Without perl
+ *		only the compiled one is timed.
+ */
+static int bench_findpulse(uint64_t count, const char *input) {
+	char dir[] = "/tmp/sym560_findpulseXXXXXX";
+	char script[PATH_MAX], path[PATH_MAX], txt[REC_TEXT_MAX];
+	unsigned char raw[REC_RAW_LEN];
+	struct seq_set set;
+	struct seq_det det;
+	struct seq_result seq;
+	int64_t *ns, stray;
+	uint64_t cnt, n = 0, whole = 0, max = 1 << 16;
+	FILE *fp, *text, *bin;
+	int have_perl, ret;
+
+	have_perl = realpath("../pulse_seq_script/findpulse.pl", script) != NULL
+		&& system("perl -e 1 2> /dev/null") == 0;
+	if (realpath(input, path) == NULL || (fp = fopen(path, "r")) == NULL) {
+		printf("\nCould not open %s\n", input);
+		return -1;
+	}
+	ns = malloc(max * sizeof(*ns));
+	while (ns != NULL && rec_parse_text(fp, &ns[n]) == 0) {
+		if (++n == max) {
+			max *= 2;
+			ns = realloc(ns, max * sizeof(*ns));
+		}
+	}
+	fclose(fp);
+	if (ns == NULL || n < 2 || mkdtemp(dir) == NULL || chdir(dir) == -1) {
+		printf("\nNeed at least two timestamps in %s and a directory to work in\n", input);
+		return -1;
+	}
+	if (!have_perl) {
+		printf("  findpulse.pl or perl not found, timing the compiled one alone\n");
+	}
+
+	ret = bench_pulses(have_perl ? script : NULL, path, input, n, ns[0], NULL);
+
+	seq_set_parse(&set, SEQ_DEFAULT_SEPS, SEQ_DEFAULT_TOL_NS);
+	seq_init(&det, &set);
+	for (cnt = 0; cnt < n; cnt++) {
+		if (seq_feed(&det, ns[cnt], &seq, &stray) == SEQ_DONE && seq.ns[seq.last] == ns[cnt]) {
+			whole = cnt + 1;
+		}
+	}
+	seq_set_free(&set);
+	if (whole < 2) {
+		whole = n;
+	}
+
+	text = fopen("copies.txt", "w");
+	bin = fopen("copies.raw", "w");
+	for (cnt = 0; cnt < count && text != NULL && bin != NULL; cnt++) {
+		rec_encode(ns[cnt % whole] + (int64_t)(cnt / whole) * 3600 * 1000000000LL, raw);
+		fwrite(txt, rec_format_text(raw, txt), 1, text);
+		fwrite(raw, REC_RAW_LEN, 1, bin);
+	}
+	if (text != NULL) {
+		fclose(text);
+	}
+	if (bin != NULL) {
+		fclose(bin);
+	}
+	if (cnt == count && count >= 2) {
+		snprintf(txt, sizeof(txt), "%llu copies", (unsigned long long)((count + whole - 1) / whole));
+		ret |= bench_pulses(have_perl ? script : NULL, "copies.txt", txt, count, ns[0], "copies.raw");
+	}
+	unlink("copies.txt");
+	unlink("copies.raw");
+	chdir("/tmp");
+	rmdir(dir);
+	free(ns);
+
+	if (ret != 0) {
+		printf("  FAILED\n");
+		return -1;
+	}
+	printf("  OK: the same pulses files as findpulse.pl\n");
+	return 0;
+}
+/* end of function: bench_findpulse */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : is_pulses
+ * Inputs     : const struct dirent *ent - directory entry
+ * Returns    : 1 for pulses_*.txt files, 0 otherwise
+ */
+static int is_pulses(const struct dirent *ent) {
+	return strncmp(ent->d_name, "pulses_", 7) == 0;
+}
+/* end of function: is_pulses */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_compare
+ * Inputs     : const char *want - directory of serial findpulse output
+ *		const char *got - directory of batch output
+ * Returns    : 1 if both hold the same pulses files with the same bytes
+ *              0 otherwise
+ * Description: Removes the files in got as it goes.
+ */
+static int bench_compare(const char *want, const char *got) {
+	struct dirent **names;
+	char a[PATH_MAX], b[PATH_MAX];
+	int cnt, n, same;
+
+	n = scandir(want, &names, is_pulses, alphasort);
+	same = n > 0;
+	for (cnt = 0; cnt < n; cnt++) {
+		snprintf(a, sizeof(a), "%s/%s", want, names[cnt]->d_name);
+		snprintf(b, sizeof(b), "%s/%s", got, names[cnt]->d_name);
+		same = same && bench_same(a, b);
+		unlink(b);
+		free(names[cnt]);
+	}
+	if (n >= 0) {
+		free(names);
+	}
+	/* and nothing else */
+	return rmdir(got) == 0 && same;
+}
+/* end of function: bench_compare */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_clear
+ * Inputs     : const char *dir - directory of pulses files
+ * Returns    : Nothing
+ * Description: Removes it and them.
+ */
+static void bench_clear(const char *dir) {
+	struct dirent **names;
+	char path[PATH_MAX];
+	int cnt, n;
+
+	n = scandir(dir, &names, is_pulses, alphasort);
+	for (cnt = 0; cnt < n; cnt++) {
+		snprintf(path, sizeof(path), "%s/%s", dir, names[cnt]->d_name);
+		unlink(path);
+		free(names[cnt]);
+	}
+	if (n >= 0) {
+		free(names);
+	}
+	rmdir(dir);
+}
+/* end of function: bench_clear */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_quiet
+ * Inputs     : int fd - -1 to send stdout to /dev/null, or what that returned
+ *			 to put it back
+ * Returns    : The stdout to put back later
+ */
+static int bench_quiet(int fd) {
+	int null;
+
+	fflush(stdout);
+	if (fd == -1) {
+		fd = dup(STDOUT_FILENO);
+		null = open("/dev/null", O_WRONLY);
+		dup2(null, STDOUT_FILENO);
+		close(null);
+		return fd;
+	}
+	dup2(fd, STDOUT_FILENO);
+	close(fd);
+	return -1;
+}
+/* end of function: bench_quiet */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_batch
+ * Inputs     : uint64_t count - events in all
+ *		const char *input - timestamp file
+ *		int threads - most threads to try, 0 for the default
+ * Returns    : 0 if every batch output matched findpulse's
+ *             -1 otherwise
+ * Description: Lays copies of the file end to end from ten minutes before an
+ *		hour, so that chunks are cut near and across hour boundaries, and
+ *		cuts the result into four files.  A fifth file starts as the
+ *		first does, so both go to the same pulses file, and has a broken
+ *		record part way through, and a sixth holds a single event.  All of
+ *		them are run through findpulse one at a time and through batch
+ *		with 1 MB chunks at 1, 2, 4, ... threads, and the whole lot again
+ *		as raw event times.
+ */
+static int bench_batch(uint64_t count, const char *input, int threads) {
+	char dir[] = "/tmp/sym560_batchXXXXXX";
+	char path[PATH_MAX], txt[REC_TEXT_MAX], out[32], *files[6];
+	unsigned char raw[REC_RAW_LEN];
+	int64_t *ns, shift, t, t0, t1, serial, serial_raw, hour = 3600 * 1000000000LL;
+	uint64_t cnt, n = 0, max = 1 << 16, part = count / 4;
+	FILE *fp, *text[6], *bin;
+	int cpus = (int)sysconf(_SC_NPROCESSORS_ONLN), nt, ret = 0, saved, k;
+	char *raw_file[1] = {"all.raw"};
+
+	if (realpath(input, path) == NULL || (fp = fopen(path, "r")) == NULL) {
+		printf("\nCould not open %s\n", input);
+		return -1;
+	}
+	ns = malloc(max * sizeof(*ns));
+	while (ns != NULL && rec_parse_text(fp, &ns[n]) == 0) {
+		if (++n == max) {
+			max *= 2;
+			ns = realloc(ns, max * sizeof(*ns));
+		}
+	}
+	fclose(fp);
+	if (ns == NULL || n < 2 || part < 2 || mkdtemp(dir) == NULL || chdir(dir) == -1) {
+		printf("\nNeed at least two timestamps in %s, eight events and a directory to work in\n", input);
+		free(ns);
+		return -1;
+	}
+
+	/* each copy 300 ms after the last, the first ten minutes before an hour */
+	shift = (ns[0] / hour + 1) * hour - hour / 6 - ns[0];
+	for (k = 0; k < 6; k++) {
+		snprintf(out, sizeof(out), "part%d.txt", k);
+		files[k] = strdup(out);
+		text[k] = fopen(out, "w");
+	}
+	bin = fopen("all.raw", "w");
+	for (cnt = 0; cnt < 4 * part; cnt++) {
+		t = ns[cnt % n] + shift + (int64_t)(cnt / n) * (ns[n - 1] - ns[0] + 300 * 1000000LL);
+		rec_encode(t, raw);
+		rec_format_text(raw, txt);
+		fputs(txt, text[cnt / part]);
+		if (cnt < part / 2) {
+			fputs(cnt == part / 4 ? "       YEAR = 2015\n        DAY = ???\n\n" : txt, text[4]);
+		}
+		if (cnt == 0) {
+			fputs(txt, text[5]);
+		}
+		fwrite(raw, REC_RAW_LEN, 1, bin);
+	}
+	for (k = 0; k < 6; k++) {
+		fclose(text[k]);
+	}
+	fclose(bin);
+	free(ns);
+
+	printf("  %llu events in 4 files and 2 more, %d cores\n", (unsigned long long)(4 * part), cpus);
+	mkdir("serial", 0755);
+	mkdir("serial_raw", 0755);
+	saved = bench_quiet(-1);
+	t0 = sim_now();
+	for (k = 0; k < 6; k++) {
+		snprintf(path, sizeof(path), "../%s", files[k]);
+		chdir("serial");
+		findpulse(path, NULL, PLS_TEXT, SEQ_DEFAULT_SEPS, SEQ_DEFAULT_TOL_NS);
+		chdir("..");
+	}
+	t1 = sim_now();
+	serial = t1 - t0;
+	chdir("serial_raw");
+	findpulse("../all.raw", NULL, PLS_RAW, SEQ_DEFAULT_SEPS, SEQ_DEFAULT_TOL_NS);
+	chdir("..");
+	serial_raw = sim_now() - t1;
+	bench_quiet(saved);
+	printf("    findpulse, one file at a time  %9.1f ms\n", serial / 1e6);
+	printf("    findpulse -r                   %9.1f ms\n", serial_raw / 1e6);
+
+	for (nt = 1; nt <= (threads > 0 ? threads : (cpus > 8 ? cpus : 8)); nt *= 2) {
+		mkdir("batch", 0755);
+		saved = bench_quiet(-1);
+		t0 = sim_now();
+		k = batch(files, 6, "batch", PLS_TEXT, SEQ_DEFAULT_SEPS, SEQ_DEFAULT_TOL_NS, nt, 1 << 20);
+		t1 = sim_now();
+		bench_quiet(saved);
+		k = k == 0 && bench_compare("serial", "batch");
+		printf("    batch -j %-3d                   %9.1f ms  %5.2fx, output %s\n", nt, (t1 - t0) / 1e6,
+			(double)serial / (t1 - t0), k ? "identical" : "DIFFERENT");
+		ret |= k ? 0 : -1;
+
+		mkdir("batch", 0755);
+		saved = bench_quiet(-1);
+		t0 = sim_now();
+		k = batch(raw_file, 1, "batch", PLS_RAW, SEQ_DEFAULT_SEPS, SEQ_DEFAULT_TOL_NS, nt, 1 << 20);
+		t1 = sim_now();
+		bench_quiet(saved);
+		k = k == 0 && bench_compare("serial_raw", "batch");
+		printf("    batch -j %-3d -r                %9.1f ms  %5.2fx, output %s\n", nt, (t1 - t0) / 1e6,
+			(double)serial_raw / (t1 - t0), k ? "identical" : "DIFFERENT");
+		ret |= k ? 0 : -1;
+	}
+	if (cpus < 2) {
+		printf("  only one core here, so the threads take turns rather than run at once\n");
+	}
+
+	for (k = 0; k < 6; k++) {
+		unlink(files[k]);
+		free(files[k]);
+	}
+	unlink("all.raw");
+	bench_clear("serial");
+	bench_clear("serial_raw");
+	chdir("/tmp");
+	rmdir(dir);
+
+	if (ret != 0) {
+		printf("  FAILED\n");
+		return -1;
+	}
+	printf("  OK: the same pulses files as findpulse\n");
+	return 0;
+}
+/* end of function: bench_batch */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_restyle
+ * Inputs     : const char *txt - record as rec_format_text writes it
+ *		int style - 0 as it is, 1 tab indented, 2 not indented, 3 CRLF
+ *		FILE *fp - where it goes
+ * Returns    : Nothing
+ * Description: The ways older files and hand edited ones differ.
+ */
+static void bench_restyle(const char *txt, int style, FILE *fp) {
+	const char *line = txt, *nl;
+
+	if (style == 0) {
+		fputs(txt, fp);
+		return;
+	}
+	while ((nl = strchr(line, '\n')) != NULL) {
+		while (*line == ' ') {
+			line++;
+		}
+		fputs(style == 1 && line != nl ? "\t" : "", fp);
+		fwrite(line, nl - line, 1, fp);
+		fputs(style == 3 ? "\r\n" : "\n", fp);
+		line = nl + 1;
+	}
+}
+/* end of function: bench_restyle */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_parse_file
+ * Inputs     : const char *name - timestamp file
+ *		int mapped - read it with rec_map_text rather than rec_parse_text
+ *		const int64_t *want - the timestamps it holds
+ *		uint64_t count - how many
+ *		int64_t *took - receives how long it took, ns
+ * Returns    : 1 if exactly those were read
+ *              0 otherwise
+ */
+static int bench_parse_file(const char *name, int mapped, const int64_t *want, uint64_t count, int64_t *took) {
+	struct rec_map map;
+	uint64_t n = 0;
+	int64_t t0, ns;
+	int same = 1;
+	FILE *fp;
+
+	t0 = sim_now();
+	if (mapped) {
+		if (rec_map_open(&map, name) != 0) {
+			return 0;
+		}
+		while (rec_map_text(&map, &ns) == 0) {
+			same = same && n < count && ns == want[n];
+			n++;
+		}
+		rec_map_close(&map);
+	}
+	else {
+		fp = fopen(name, "r");
+		if (fp == NULL) {
+			return 0;
+		}
+		setvbuf(fp, NULL, _IOFBF, 1 << 20);
+		while (rec_parse_text(fp, &ns) == 0) {
+			same = same && n < count && ns == want[n];
+			n++;
+		}
+		fclose(fp);
+	}
+	*took = sim_now() - t0;
+	return same && n == count;
+}
+/* end of function: bench_parse_file */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_parse
+ * Inputs     : uint64_t count - timestamps
+ *		const char *input - timestamp file
+ * Returns    : 0 if every way of reading found the same timestamps
+ *             -1 otherwise
+ * Description: Writes copies of the file end to end as rec_format_text does
+ *		and again with the records in turn tab indented, not indented and
+ *		with CRLF line ends, with LOCK and MARKER lines among them.  Each
+ *		is read with rec_parse_text and with rec_map_text, and the first
+ *		converted to raw event times.  For scale, the first is also read
+ *		with plain read() calls, which is as fast as the bytes can be got
+ *		from the page cache.
+ */
+static int bench_parse(uint64_t count, const char *input) {
+	char dir[] = "/tmp/sym560_parseXXXXXX";
+	char path[PATH_MAX], txt[REC_TEXT_MAX], *buf;
+	unsigned char raw[REC_RAW_LEN];
+	int64_t *ns, *want, took, t0;
+	uint64_t cnt, n = 0, max = 1 << 16;
+	FILE *fp, *canon, *styled;
+	struct rec_map map;
+	struct stat st;
+	double mb[2];
+	int ret = 0, fd, same, k;
+	ssize_t got;
+
+	if (realpath(input, path) == NULL || (fp = fopen(path, "r")) == NULL) {
+		printf("\nCould not open %s\n", input);
+		return -1;
+	}
+	ns = malloc(max * sizeof(*ns));
+	while (ns != NULL && rec_parse_text(fp, &ns[n]) == 0) {
+		if (++n == max) {
+			max *= 2;
+			ns = realloc(ns, max * sizeof(*ns));
+		}
+	}
+	fclose(fp);
+	want = malloc((count ? count : 1) * sizeof(*want));
+	buf = malloc(1 << 20);
+	if (ns == NULL || want == NULL || buf == NULL || n < 2 || mkdtemp(dir) == NULL || chdir(dir) == -1) {
+		printf("\nNeed at least two timestamps in %s, memory and a directory to work in\n", input);
+		free(ns);
+		free(want);
+		free(buf);
+		return -1;
+	}
+
+	canon = fopen("canon.txt", "w");
+	styled = fopen("styled.txt", "w");
+	for (cnt = 0; cnt < count && canon != NULL && styled != NULL; cnt++) {
+		want[cnt] = ns[cnt % n] + (int64_t)(cnt / n) * (ns[n - 1] - ns[0] + 300 * 1000000LL);
+		rec_encode(want[cnt], raw);
+		rec_format_text(raw, txt);
+		fputs(txt, canon);
+		if (cnt % 1000 == 0) {
+			rec_format_lock(cnt % 2000 ? REC_LOCK_ALL : 0, txt);
+			fputs(txt, styled);
+			rec_format_marker(want[cnt], "bench", txt);
+			fputs(txt, styled);
+			rec_format_text(raw, txt);
+		}
+		bench_restyle(txt, cnt % 4, styled);
+	}
+	if (canon != NULL) {
+		fclose(canon);
+	}
+	if (styled != NULL) {
+		fclose(styled);
+	}
+	free(ns);
+	stat("canon.txt", &st);
+	mb[0] = st.st_size / 1e6;
+	stat("styled.txt", &st);
+	mb[1] = st.st_size / 1e6;
+	printf("  %llu timestamps, %.0f MB as written, %.0f MB restyled\n", (unsigned long long)count, mb[0], mb[1]);
+
+	fd = open("canon.txt", O_RDONLY);
+	t0 = sim_now();
+	while (fd != -1 && (got = read(fd, buf, 1 << 20)) > 0);
+	took = sim_now() - t0;
+	if (fd != -1) {
+		close(fd);
+	}
+	printf("    read()                     %8.1f ms  %7.0f MB/s\n", took / 1e6, mb[0] * 1e3 / (took / 1e6));
+
+	for (k = 0; k < 4; k++) {
+		same = bench_parse_file(k < 2 ? "canon.txt" : "styled.txt", k % 2, want, count, &took);
+		printf("    %-14s %-11s %8.1f ms  %7.0f MB/s  %6.1f ns/timestamp  %s\n",
+			k % 2 ? "rec_map_text" : "rec_parse_text", k < 2 ? "as written" : "restyled", took / 1e6,
+			mb[k / 2] * 1e3 / (took / 1e6), (double)took / count, same ? "all found" : "DIFFERENT");
+		ret |= same ? 0 : -1;
+	}
+
+	fd = bench_quiet(-1);
+	t0 = sim_now();
+	k = convert("canon.txt", "canon.raw", CONV_RAW);
+	took = sim_now() - t0;
+	bench_quiet(fd);
+	same = k == 0 && rec_map_open(&map, "canon.raw") == 0;
+	for (cnt = 0; same && cnt < count; cnt++) {
+		same = rec_map_raw(&map, &t0) == 0 && t0 == want[cnt];
+	}
+	same = same && rec_map_raw(&map, &t0) != 0;
+	rec_map_close(&map);
+	printf("    convert to raw             %8.1f ms  %7.0f MB/s  %s\n", took / 1e6, mb[0] * 1e3 / (took / 1e6),
+		same ? "all found" : "DIFFERENT");
+	ret |= same ? 0 : -1;
+
+	unlink("canon.txt");
+	unlink("styled.txt");
+	unlink("canon.raw");
+	chdir("/tmp");
+	rmdir(dir);
+	free(want);
+	free(buf);
+
+	if (ret != 0) {
+		printf("  FAILED\n");
+		return -1;
+	}
+	printf("  OK: every way of reading found the same timestamps\n");
+	return 0;
+}
+/* end of function: bench_parse */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_index_check
+ * Inputs     : char **files - timestamp files
+ *		int nfile - how many
+ *		uint64_t *entries - receives the index entries read
+ * Returns    : Index entries that are wrong or missing
+ * Description: Each file's index must hold, in order, the first event of
+ *		every interval its events fall in, each pointing at a place
+ *		the event is the next one read from.
+ */
+static uint64_t bench_index_check(char **files, int nfile, uint64_t *entries) {
+	char name[PATH_MAX];
+	struct idx_header hdr;
+	struct idx_entry e;
+	struct rec_map map, at;
+	int64_t ns, got, bucket;
+	uint64_t bad = 0;
+	int f, have;
+	FILE *fp;
+
+	*entries = 0;
+	for (f = 0; f < nfile; f++) {
+		idx_name(files[f], name, sizeof(name));
+		fp = fopen(name, "r");
+		if (fp == NULL || fread(&hdr, sizeof(hdr), 1, fp) != 1 || hdr.magic != IDX_MAGIC
+				|| hdr.version != IDX_VERSION || hdr.format != IDX_TEXT || hdr.interval_ns <= 0
+				|| rec_map_open(&map, files[f]) != 0) {
+			bad++;
+			if (fp != NULL) {
+				fclose(fp);
+			}
+			continue;
+		}
+		bucket = -1;
+		while (rec_map_text(&map, &ns) == 0) {
+			if (!idx_due(&bucket, ns, hdr.interval_ns)) {
+				continue;
+			}
+			have = fread(&e, sizeof(e), 1, fp) == 1;
+			at = map;
+			at.pos = have ? e.offset : 0;
+			if (!have || e.ns != ns || at.pos < 0 || at.pos >= map.size
+					|| rec_map_text(&at, &got) != 0 || got != ns) {
+				bad++;
+			}
+			*entries += have;
+		}
+		/* and nothing more */
+		while (fread(&e, sizeof(e), 1, fp) == 1) {
+			bad++;
+		}
+		rec_map_close(&map);
+		fclose(fp);
+	}
+	return bad;
+}
+/* end of function: bench_index_check */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_index_query
+ * Inputs     : char **files - timestamp files
+ *		int nfile - how many
+ *		const int64_t *all - every event in them, in order
+ *		uint64_t count - how many
+ *		int64_t from, to - range to extract
+ *		int64_t *took - time taken is added to it, ns
+ * Returns    : 1 if extract wrote exactly the events from..to, 0 if not
+ */
+static int bench_index_query(char **files, int nfile, const int64_t *all, uint64_t count,
+		int64_t from, int64_t to, int64_t *took) {
+	struct rec_map map;
+	uint64_t lo = 0, hi = count, mid;
+	int64_t t0, ns;
+	int quiet, same = 1;
+
+	quiet = bench_quiet(-1);
+	t0 = sim_now();
+	extract(files, nfile, IDX_TEXT, from, to, "range.txt");
+	*took += sim_now() - t0;
+	bench_quiet(quiet);
+
+	/* first event at or after from */
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (all[mid] < from) {
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
+		}
+	}
+	if (rec_map_open(&map, "range.txt") != 0) {
+		return 0;
+	}
+	while (rec_map_text(&map, &ns) == 0) {
+		same = same && lo < count && all[lo] == ns && ns <= to;
+		lo++;
+	}
+	rec_map_close(&map);
+	remove("range.txt");
+	return same && (lo == count || all[lo] > to);
+}
+/* end of function: bench_index_query */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_index
+ * Inputs     : uint64_t count - events to capture
+ *		double rotate_s - rotation boundary interval
+ * Returns    : 0 if every index was right and every range came out whole
+ *             -1 otherwise
+ * Description: Captures simulated events 10 ms apart with the writer keeping
+ *		the default time index, rotating every rotate_s (at least a
+ *		minute's worth of events go into a file, the resolution of the
+ *		names).  Every index is checked against its file, and ranges of
+ *		30 s are extracted with the indexes and, fewer of them, without,
+ *		each checked against all of the events.  The indexes are then
+ *		made again by backfill and checked the same way.
+ */
+static int bench_index(uint64_t count, double rotate_s) {
+	struct capture cap;
+	struct cap_config cfg;
+	struct sim sim;
+	struct dirent **names;
+	struct rec_map map;
+	char dir[] = "/tmp/sym560_indexXXXXXX", filename[CAP_FILENAME_LEN], name[PATH_MAX], **files;
+	int64_t *all, ns, span, from, t0, took_idx = 0, took_scan = 0, took_fill;
+	uint64_t n = 0, entries, fill_entries, bad, fill_bad, wrong = 0, scan_wrong = 0;
+	int nfiles, cnt, outfd, quiet, queries = 1000, scans = 20;
+
+	if (mkdtemp(dir) == NULL || chdir(dir) == -1) {
+		printf("\nCould not create %s\n", dir);
+		return -1;
+	}
+	sim_init(&sim, 0, count);
+	sim.period_ns = 10000000;
+	cap_config_default(&cfg);
+	cfg.rotate_ns = (int64_t)(rotate_s * 1e9);
+	cfg.index_ns = IDX_DEFAULT_INTERVAL_NS;
+	cap_filename(sim.start_ns, filename);
+	outfd = open(filename, O_RDWR|O_CREAT|O_APPEND, 00644);
+	if (outfd == -1 || cap_init(&cap, &cfg, -1, outfd, &sim) != 0) {
+		return -1;
+	}
+	if (cap_index(&cap, filename) != 0) {
+		cap_free(&cap);
+		return -1;
+	}
+	cap_start(&cap);
+	while (atomic_load(&cap.cap_done) == 0) {
+		usleep(10000);
+	}
+	cap_stop(&cap);
+	close(cap.outfd);
+	cap_free(&cap);
+
+	/* every event, read the whole way through */
+	nfiles = scandir(".", &names, is_timestampdata, alphasort);
+	all = malloc(count * sizeof(*all));
+	files = malloc((nfiles > 0 ? nfiles : 1) * sizeof(*files));
+	if (all == NULL || files == NULL) {
+		nfiles = 0;
+	}
+	for (cnt = 0; cnt < nfiles; cnt++) {
+		files[cnt] = names[cnt]->d_name;
+		if (rec_map_open(&map, files[cnt]) != 0) {
+			continue;
+		}
+		while (n < count && rec_map_text(&map, &ns) == 0) {
+			all[n++] = ns;
+		}
+		rec_map_close(&map);
+	}
+	bad = nfiles > 0 ? bench_index_check(files, nfiles, &entries) : 1;
+
+	/* 30 s ranges anywhere in the capture, a little either side too */
+	srand(560);
+	span = n > 0 ? all[n - 1] - all[0] + 60000000000LL : 1;
+	for (cnt = 0; cnt < queries && n > 0; cnt++) {
+		from = all[0] - 30000000000LL + (int64_t)(((double)rand() / RAND_MAX) * span) / 100 * 100;
+		if (!bench_index_query(files, nfiles, all, n, from, from + 30000000000LL, &took_idx)) {
+			wrong++;
+		}
+	}
+
+	/* the same without the indexes, then made again by backfill */
+	for (cnt = 0; cnt < nfiles; cnt++) {
+		idx_name(files[cnt], name, sizeof(name));
+		remove(name);
+	}
+	srand(560);
+	for (cnt = 0; cnt < scans && n > 0; cnt++) {
+		from = all[0] - 30000000000LL + (int64_t)(((double)rand() / RAND_MAX) * span) / 100 * 100;
+		if (!bench_index_query(files, nfiles, all, n, from, from + 30000000000LL, &took_scan)) {
+			scan_wrong++;
+		}
+	}
+	quiet = bench_quiet(-1);
+	t0 = sim_now();
+	backfill(files, nfiles, ".", PLS_TEXT, NULL, 0, IDX_DEFAULT_INTERVAL_NS, NULL);
+	took_fill = sim_now() - t0;
+	bench_quiet(quiet);
+	fill_bad = nfiles > 0 ? bench_index_check(files, nfiles, &fill_entries) : 1;
+
+	for (cnt = 0; cnt < nfiles; cnt++) {
+		idx_name(files[cnt], name, sizeof(name));
+		remove(name);
+		remove(files[cnt]);
+		free(names[cnt]);
+	}
+	if (nfiles >= 0) {
+		free(names);
+	}
+	free(files);
+	free(all);
+	chdir("/tmp");
+	rmdir(dir);
+
+	printf("  %llu events in %d files, %llu written, %llu read back\n", (unsigned long long)count,
+		nfiles, (unsigned long long)cap.written, (unsigned long long)n);
+	printf("  written by the capture: %llu index entries, %llu wrong or missing\n",
+		(unsigned long long)entries, (unsigned long long)bad);
+	printf("  made again by backfill: %llu index entries, %llu wrong or missing, %.3f s\n",
+		(unsigned long long)fill_entries, (unsigned long long)fill_bad, took_fill / 1e9);
+	printf("  30 s ranges: %.3f ms each with the indexes (%d), %.3f ms without (%d), %llu wrong\n",
+		took_idx / 1e6 / queries, queries, took_scan / 1e6 / scans, scans,
+		(unsigned long long)(wrong + scan_wrong));
+	if (bad != 0 || fill_bad != 0 || entries == 0 || fill_entries != entries || wrong != 0 || scan_wrong != 0
+			|| n != cap.written || n != count - sim.lost - cap.overflows) {
+		printf("  FAILED\n");
+		return -1;
+	}
+	printf("  OK: every index entry where it should be and every range extracted whole\n");
+	return 0;
+}
+/* end of function: bench_index */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_delta_run
+ * Inputs     : const int64_t *want - event times
+ *		uint64_t count - how many
+ *		int npulse - pulses in a sequence
+ *		const char *name - what to call them in the report
+ * Returns    : 0 if they decoded exactly as they were
+ *             -1 otherwise
+ * Description: Encodes the events a block at a time as convert does, then
+ *		decodes every block and, on their own, the middle one, found by
+ *		stepping over the headers before it.
+ */
+static int bench_delta_run(const int64_t *want, uint64_t count, int npulse, const char *name) {
+	unsigned char raw[REC_RAW_LEN];
+	char txt[REC_TEXT_MAX], *buf;
+	struct dlt_block hdr;
+	struct dlt_enc *enc;
+	int64_t *ns, t0, enc_ns, dec_ns;
+	uint64_t cnt, got = 0, bad = 0, text = 0, blocks = 0, at_lag = 0, first;
+	size_t len = 0, pos, used;
+	int n, k;
+
+	enc = malloc(sizeof(*enc));
+	ns = malloc(DLT_BLOCK * sizeof(*ns));
+	buf = malloc((count / DLT_BLOCK + 1) * DLT_BLOCK_MAX);
+	if (enc == NULL || ns == NULL || buf == NULL) {
+		printf("\nCould not allocate memory for %llu events\n", (unsigned long long)count);
+		free(enc);
+		free(ns);
+		free(buf);
+		return -1;
+	}
+	for (cnt = 0; cnt < count; cnt++) {
+		rec_encode(want[cnt], raw);
+		text += rec_format_text(raw, txt);
+	}
+
+	dlt_enc_init(enc);
+	t0 = sim_now();
+	for (cnt = 0; cnt < count; cnt++) {
+		len += dlt_enc_add(enc, want[cnt], buf + len);
+	}
+	len += dlt_enc_flush(enc, buf + len);
+	enc_ns = sim_now() - t0;
+
+	t0 = sim_now();
+	for (pos = 0; pos < len; pos += used) {
+		n = dlt_decode(buf + pos, len - pos, ns, &used);
+		if (n < 0) {
+			bad++;
+			break;
+		}
+		for (k = 0; k < n && got + k < count; k++) {
+			bad += ns[k] != want[got + k];
+		}
+		got += n;
+	}
+	dec_ns = sim_now() - t0;
+
+	/* the middle block alone */
+	for (pos = 0, first = 0; pos < len; pos += sizeof(hdr) + hdr.bytes, first += hdr.count) {
+		memcpy(&hdr, buf + pos, sizeof(hdr));
+		blocks++;
+		at_lag += hdr.lag == npulse;
+	}
+	for (pos = 0, first = 0; pos < len && first + DLT_BLOCK <= count / 2; pos += sizeof(hdr) + hdr.bytes) {
+		memcpy(&hdr, buf + pos, sizeof(hdr));
+		first += hdr.count;
+	}
+	n = dlt_decode(buf + pos, len - pos, ns, &used);
+	for (k = 0; k < n; k++) {
+		bad += first + k >= count || ns[k] != want[first + k];
+	}
+	bad += n <= 0 && count > 0;
+
+	printf("    %-20s %6.2f bytes/event  %5.1fx raw  %6.1fx text  lag %d in %3.0f%% of blocks\n",
+		name, (double)len / count, count * (double)REC_RAW_LEN / len, (double)text / len, npulse,
+		100.0 * at_lag / blocks);
+	printf("    %-20s encode %5.1f ns/event  decode %5.2f ns/event, %4.2f GB/s of times  %s\n",
+		"", (double)enc_ns / count, (double)dec_ns / count, count * 8.0 / dec_ns,
+		bad == 0 && got == count ? "exact" : "DIFFERENT");
+	free(enc);
+	free(ns);
+	free(buf);
+	return bad == 0 && got == count ? 0 : -1;
+}
+/* end of function: bench_delta_run */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_delta
+ * Inputs     : uint64_t count - events of each kind
+ * Returns    : 0 if every kind decoded exactly and convert gave back the
+ *		same text
+ *             -1 otherwise
+ * Description: Sequences of the default table start every 100 ms, first
+ *		exactly on time, then with every pulse up to 1 us off in the
+ *		card's 100 ns steps, then with that and one pulse in twenty
+ *		missing and a pause of up to 2 s, as between scans, every 30
+ *		sequences.  The last kind is also written as text and taken
+ *		through convert to compressed blocks and back.
+ */
+static int bench_delta(uint64_t count) {
+	const char *name[] = {"exact", "jittered", "jittered, gaps"};
+	char dir[] = "/tmp/sym560_deltaXXXXXX";
+	unsigned char raw[REC_RAW_LEN];
+	char txt[REC_TEXT_MAX];
+	struct seq_set set;
+	struct seq_table *tab = &set.tab[0];
+	struct stat st[2];
+	int64_t *want, start;
+	uint64_t cnt, seq;
+	int kind, k, fd, ret = 0, same;
+	FILE *fp;
+
+	want = malloc((count ? count : 1) * sizeof(*want));
+	if (want == NULL || count == 0 || seq_set_parse(&set, SEQ_DEFAULT_SEPS, SEQ_DEFAULT_TOL_NS) != 0) {
+		printf("\nNeed memory for %llu events\n", (unsigned long long)count);
+		free(want);
+		return -1;
+	}
+	srand(560);
+	for (kind = 0; kind < 3; kind++) {
+		start = rec_ns(2026, 291, 0, 0, 0, 0);
+		for (cnt = 0, seq = 0; cnt < count; seq++) {
+			for (k = 0; k < tab->npulse && cnt < count; k++) {
+				if (kind == 2 && rand() % 20 == 0) {
+					continue;
+				}
+				want[cnt++] = start + tab->off[k] + (kind ? (rand() % 21 - 10) * 100 : 0);
+			}
+			start += 100000000LL;
+			if (kind == 2 && seq % 30 == 29) {
+				start += (int64_t)(rand() % 20000) * 100000;
+			}
+		}
+		ret |= bench_delta_run(want, count, tab->npulse, name[kind]);
+	}
+	seq_set_free(&set);
+
+	/* the last kind through convert */
+	same = mkdtemp(dir) != NULL && chdir(dir) == 0 && (fp = fopen("events.txt", "w")) != NULL;
+	for (cnt = 0; same && cnt < count; cnt++) {
+		rec_encode(want[cnt], raw);
+		rec_format_text(raw, txt);
+		fputs(txt, fp);
+	}
+	if (same) {
+		fclose(fp);
+		fd = bench_quiet(-1);
+		same = convert("events.txt", "events.dlt", CONV_DELTA) == 0
+			&& convert("events.dlt", "events.back", CONV_TEXT) == 0;
+		bench_quiet(fd);
+		same = same && bench_same("events.txt", "events.back")
+			&& stat("events.txt", &st[0]) == 0 && stat("events.dlt", &st[1]) == 0;
+	}
+	if (same) {
+		printf("    convert                %.1f MB of text in %.2f MB, back to the same text\n",
+			st[0].st_size / 1e6, st[1].st_size / 1e6);
+	}
+	else {
+		printf("    convert                DIFFERENT\n");
+		ret = -1;
+	}
+	unlink("events.txt");
+	unlink("events.dlt");
+	unlink("events.back");
+	chdir("/tmp");
+	rmdir(dir);
+	free(want);
+
+	if (ret != 0) {
+		printf("  FAILED\n");
+		return -1;
+	}
+	printf("  OK: every kind decoded exactly, whole and a block at a time\n");
+	return 0;
+}
+/* end of function: bench_delta */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_columns_check
+ * Inputs     : const char *store - column store
+ *		int64_t day0 - the first day in it, ns
+ *		int ndays - how many days from it
+ *		const int64_t *want - every event, in order
+ *		uint64_t count - how many
+ *		uint64_t *seqs - receives the sequences numbered in all the days
+ * Returns    : Rows wrong or missing
+ * Description: Every row must be the next event, a pulse of a complete
+ *		katscan sequence numbered one up from its pulse, and in the
+ *		sequence numbered one up from the row before's unless it is
+ *		its pulse 2 to 8, counting from 1 each day.
+ */
+static uint64_t bench_columns_check(const char *store, int64_t day0, int ndays, const int64_t *want, uint64_t count,
+		uint64_t *seqs) {
+	struct col_view v;
+	char day[COL_DAYNAME_LEN], path[PATH_MAX];
+	uint64_t i, n = 0, bad = 0;
+	uint32_t pulse, id;
+	int d;
+
+	*seqs = 0;
+	for (d = 0; d < ndays; d++) {
+		col_dayname(day0 + d * COL_DAY_NS, day);
+		snprintf(path, sizeof(path), "%s/%s", store, day);
+		if (col_map(path, &v) != 0) {
+			bad++;
+			continue;
+		}
+		id = 0;
+		for (i = 0; i < v.rows; i++, n++) {
+			pulse = (v.flags[i] & COL_PULSE_MASK) >> COL_PULSE_SHIFT;
+			if (pulse == 1 || i == 0) {
+				id++;
+			}
+			if (n >= count || v.ns[i] != want[n] || v.ns[i] / COL_DAY_NS != day0 / COL_DAY_NS + d
+					|| pulse != n % 8 + 1 || v.seq[i] != id || !(v.flags[i] & COL_COMPLETE)
+					|| (v.flags[i] & COL_TABLE_MASK) != 0) {
+				bad++;
+			}
+		}
+		*seqs += id;
+		col_unmap(&v);
+	}
+	return bad + (n != count);
+}
+/* end of function: bench_columns_check */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_columns_rm
+ * Inputs     : const char *store - column store
+ *		int64_t day0 - the first day in it, ns
+ *		int ndays - how many days from it
+ * Returns    : Nothing
+ * Description: Removes it and its days.
+ */
+static void bench_columns_rm(const char *store, int64_t day0, int ndays) {
+	static const char *file[] = {"schema", "time", "flags", "seq"};
+	char day[COL_DAYNAME_LEN], path[PATH_MAX];
+	int d, k;
+
+	for (d = 0; d < ndays; d++) {
+		col_dayname(day0 + d * COL_DAY_NS, day);
+		for (k = 0; k < 4; k++) {
+			snprintf(path, sizeof(path), "%s/%s/%s", store, day, file[k]);
+			unlink(path);
+		}
+		snprintf(path, sizeof(path), "%s/%s", store, day);
+		rmdir(path);
+	}
+	rmdir(store);
+}
+/* end of function: bench_columns_rm */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : bench_columns
+ * Inputs     : uint64_t count - events
+ * Returns    : 0 if both stores hold every event as it should be
+ *             -1 otherwise
+ * Description: Captures katscan sequences unpaced, stamped so that a UTC
+ *		day starts 30 ms into the middle one (and far enough ahead of
+ *		the clock that trk_idle leaves every sequence to the next
+ *		event), with a tracker and the column store.  No more events
+ *		are made than the ring holds, so none are lost however far the
+ *		writer falls behind.  The store is
+ *		checked against the simulator's events and the text files, then
+ *		made again by backfill from the text files, which must give the
+ *		same times and sequences.  Reports how long a pass over the
+ *		mapped time column takes against parsing the text.
+ */
+static int bench_columns(uint64_t count) {
+	static const double psep[] = {21.0, 12.0, 3.0, 4.5, 6.0, 16.5, 1.5};
+	struct capture cap;
+	struct cap_config cfg;
+	struct tracker trk;
+	struct sim sim;
+	struct col_view v, f;
+	struct rec_map map;
+	struct dirent **names;
+	char dir[] = "/tmp/sym560_columnsXXXXXX", filename[CAP_FILENAME_LEN], day[COL_DAYNAME_LEN];
+	char a[PATH_MAX], b[PATH_MAX], **files;
+	int64_t *want, ns, day0, t0, took_map = 0, took_text = 0, took_fill;
+	uint64_t nseq, i, n = 0, text = 0, text_bad = 0, bad, seqs, fill_bad, fill_seqs, differ = 0, sum = 0;
+	int nfiles, cnt, d, outfd, quiet;
+
+	if (mkdtemp(dir) == NULL || chdir(dir) == -1) {
+		printf("\nCould not create %s\n", dir);
+		return -1;
+	}
+	nseq = (count < (1 << CAP_RING_ORDER) ? count : (1 << CAP_RING_ORDER)) / 8;
+	want = malloc((nseq * 8 + 1) * sizeof(*want));
+	if (want == NULL || nseq == 0 || sim_init_pattern(&sim, psep, 7, 70, nseq * 8) != 0) {
+		free(want);
+		return -1;
+	}
+	sim.paced = 0;
+	sim.start_ns = (sim.start_ns / COL_DAY_NS + 2) * COL_DAY_NS
+		- (int64_t)(nseq / 2) * sim.period_ns - 30000000LL;
+	day0 = sim.start_ns / COL_DAY_NS * COL_DAY_NS;
+	cap_config_default(&cfg);
+	cap_filename(sim.start_ns, filename);
+	outfd = open(filename, O_RDWR|O_CREAT|O_APPEND, 00644);
+	if (outfd == -1 || cap_init(&cap, &cfg, -1, outfd, &sim) != 0) {
+		free(want);
+		return -1;
+	}
+	if (cap_columns(&cap, "store") != 0
+			|| trk_start(&trk, &cap, "katscan", SEQ_DEFAULT_TOL_NS, TIM_DEFAULT_WINDOW_NS) != 0) {
+		cap_free(&cap);
+		free(want);
+		return -1;
+	}
+	cap_start(&cap);
+	while (atomic_load(&cap.cap_done) == 0) {
+		usleep(10000);
+	}
+	cap_stop(&cap);
+	trk_stop(&trk, &cap);
+	close(cap.outfd);
+	cap_free(&cap);
+
+	for (i = 0; i < nseq * 8; i++) {
+		want[i] = sim.start_ns + sim_event_ns(&sim, i);
+	}
+	bad = bench_columns_check("store", day0, 2, want, nseq * 8, &seqs);
+
+	/* the time column against the text, and the time each takes to read */
+	nfiles = scandir(".", &names, is_timestampdata, alphasort);
+	files = malloc((nfiles > 0 ? nfiles : 1) * sizeof(*files));
+	t0 = sim_now();
+	for (cnt = 0; cnt < nfiles && files != NULL; cnt++) {
+		files[cnt] = names[cnt]->d_name;
+		if (rec_map_open(&map, files[cnt]) != 0) {
+			continue;
+		}
+		while (rec_map_text(&map, &ns) == 0) {
+			sum += ns;
+			text++;
+		}
+		rec_map_close(&map);
+	}
+	took_text = sim_now() - t0;
+	for (d = 0; d < 2; d++) {
+		col_dayname(day0 + d * COL_DAY_NS, day);
+		snprintf(a, sizeof(a), "store/%s", day);
+		if (col_map(a, &v) != 0) {
+			continue;
+		}
+		t0 = sim_now();
+		for (i = 0; i < v.rows; i++) {
+			sum -= v.ns[i];
+		}
+		took_map += sim_now() - t0;
+		n += v.rows;
+		col_unmap(&v);
+	}
+	text_bad = sum != 0 || n != text;
+
+	/* made again from the text */
+	quiet = bench_quiet(-1);
+	t0 = sim_now();
+	backfill(files, files != NULL ? nfiles : 0, ".", PLS_TEXT, "katscan", SEQ_DEFAULT_TOL_NS, 0, "fill");
+	took_fill = sim_now() - t0;
+	bench_quiet(quiet);
+	fill_bad = bench_columns_check("fill", day0, 2, want, nseq * 8, &fill_seqs);
+	for (d = 0; d < 2; d++) {
+		col_dayname(day0 + d * COL_DAY_NS, day);
+		snprintf(a, sizeof(a), "store/%s/time", day);
+		snprintf(b, sizeof(b), "fill/%s/time", day);
+		differ += !bench_same(a, b);
+		snprintf(a, sizeof(a), "store/%s/seq", day);
+		snprintf(b, sizeof(b), "fill/%s/seq", day);
+		differ += !bench_same(a, b);
+		snprintf(a, sizeof(a), "store/%s", day);
+		snprintf(b, sizeof(b), "fill/%s", day);
+		if (col_map(a, &v) != 0 || col_map(b, &f) != 0) {
+			differ++;
+			continue;
+		}
+		for (i = 0; i < v.rows && i < f.rows; i++) {
+			differ += (v.flags[i] & ~COL_LOCK_MASK) != (f.flags[i] & ~COL_LOCK_MASK);
+		}
+		col_unmap(&v);
+		col_unmap(&f);
+	}
+
+	for (cnt = 0; cnt < nfiles; cnt++) {
+		remove(names[cnt]->d_name);
+		free(names[cnt]);
+	}
+	if (nfiles >= 0) {
+		free(names);
+	}
+	nfiles = scandir(".", &names, is_timing, alphasort);
+	for (cnt = 0; cnt < nfiles; cnt++) {
+		remove(names[cnt]->d_name);
+		free(names[cnt]);
+	}
+	if (nfiles >= 0) {
+		free(names);
+	}
+	bench_columns_rm("store", day0, 2);
+	bench_columns_rm("fill", day0, 2);
+	free(files);
+	free(want);
+	chdir("/tmp");
+	rmdir(dir);
+
+	printf("  %llu events, %llu written, %llu lost at the source\n", (unsigned long long)(nseq * 8),
+		(unsigned long long)cap.written, (unsigned long long)sim.lost);
+	printf("  ");
+	trk_print(&trk);
+	printf("  written by the capture: %llu rows, %llu sequences over 2 days, %llu wrong or missing\n",
+		(unsigned long long)n, (unsigned long long)seqs, (unsigned long long)bad);
+	printf("  made again by backfill: %llu sequences, %llu wrong or missing, %llu differing, %.3f s\n",
+		(unsigned long long)fill_seqs, (unsigned long long)fill_bad, (unsigned long long)differ,
+		took_fill / 1e9);
+	printf("  reading every time: %.2f ns each from the mapped column, %.2f ns from the text\n",
+		n ? (double)took_map / n : 0.0, text ? (double)took_text / text : 0.0);
+	/* the sequence across midnight is numbered in both days */
+	if (bad != 0 || fill_bad != 0 || differ != 0 || text_bad != 0 || sim.lost != 0
+			|| cap.written != nseq * 8 || seqs != trk.sequences + 1 || fill_seqs != seqs) {
+		printf("  FAILED\n");
+		return -1;
+	}
+	printf("  OK: every event a row of its day with its sequence and pulse, the same from backfill\n");
+	return 0;
+}
+/* end of function: bench_columns */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : usage
+ * Inputs     : None
+ * Returns    : Nothing
+ */
+static void usage(void) {
+	printf("USAGE: sym560_bench capture [-r rate] [-t seconds] [-s stall_ms] [-c rt_cpu] [-d] [-W uring|thread]\n");
+	printf("       rate 0 runs unpaced to find the throughput ceiling, -c uses the\n");
+	printf("       real-time profile with the capture thread on rt_cpu, -d drops the\n");
+	printf("       oldest events instead of waiting when the disk falls behind\n");
+	printf("       sym560_bench rotate [-r rate] [-n events] [-R rotate_s] [-H hup_ms]\n");
+	printf("       sym560_bench control [-r rate] [-n events] [-H cmd_ms]\n");
+	printf("       sym560_bench journal [-r rate] [-n events] [-H kill_ms]\n");
+	printf("       sym560_bench format [-n records] [-f file]\n");
+	printf("       sym560_bench status [-r rate] [-n events] [-H period_ms]\n");
+	printf("       sym560_bench stream [-r rate] [-n events] [-k subscribers] [-H slow_ms]\n");
+	printf("       sym560_bench metrics [-r rate] [-n events] [-H export_ms]\n");
+	printf("       sym560_bench radar [-t seconds] [-H late_ms]\n");
+	printf("       sym560_bench tracker [-t seconds] [-R rotate_s]\n");
+	printf("       sym560_bench timing [-n pulses]\n");
+	printf("       sym560_bench allan [-n starts]\n");
+	printf("       sym560_bench index [-n events] [-R rotate_s]\n");
+	printf("       sym560_bench delta [-n events]\n");
+	printf("       sym560_bench columns [-n events]\n");
+	printf("       sym560_bench sequence [-n sequences]\n");
+	printf("       sym560_bench tables [-n sequences]\n");
+	printf("       sym560_bench batch [-n events] [-f file] [-j threads]\n");
+	printf("       sym560_bench parse [-n timestamps] [-f file]\n");
+	printf("       sym560_bench findpulse [-n events] [-f file]\n");
+	printf("       sym560_bench lib [-r rate] [-n events]\n");
+}
+/* end of function: usage */
+/*******************************************************************************/
+
+
+int main(int argc, char **argv) {
+	double rate = 10000, seconds = 5, rotate_s = 1;
+	int stall_ms = 0, hup_ms = 5, clients = 12, threads = 0, rt_cpu = -1, policy = CAP_IO_BLOCK, backend = IO_AUTO, opt;
+	uint64_t count, events = 1000000;
+	const char *golden = NULL;
+
+	if (argc < 2) {
+		usage();
+		return 1;
+	}
+	optind = 2;
+	while ((opt = getopt(argc, argv, "r:t:s:n:R:H:c:dW:f:k:j:")) != -1) {
+		switch (opt) {
+			case 'n':
+				events = strtoull(optarg, NULL, 10);
+				break;
+			case 'R':
+				rotate_s = atof(optarg);
+				break;
+			case 'H':
+				hup_ms = atoi(optarg);
+				break;
+			case 'r':
+				rate = atof(optarg);
+				break;
+			case 't':
+				seconds = atof(optarg);
+				break;
+			case 's':
+				stall_ms = atoi(optarg);
+				break;
+			case 'c':
+				rt_cpu = atoi(optarg);
+				break;
+			case 'f':
+				golden = optarg;
+				break;
+			case 'k':
+				clients = atoi(optarg);
+				break;
+			case 'j':
+				threads = atoi(optarg);
+				break;
+			case 'd':
+				policy = CAP_IO_DROP_OLDEST;
+				break;
+			case 'W':
+				backend = strcmp(optarg, "thread") == 0 ? IO_THREAD : IO_URING;
+				break;
+			default:
+				usage();
+				return 1;
+		}
+	}
+
+	if (strcmp(argv[1], "capture") == 0) {
+		count = (uint64_t)((rate > 0 ? rate : 1000000) * seconds);
+		printf("\nSimulated source: %.0f events/s for %.1f s, disk stall %d ms/s\n\n",
+			rate, seconds, stall_ms);
+		bench_legacy(rate, count, stall_ms);
+		bench_ring(rate, count, stall_ms, rt_cpu, policy, backend);
+		return 0;
+	}
+	if (strcmp(argv[1], "rotate") == 0) {
+		printf("\nRotation: %llu events at %.0f events/s, rotate every %.1f s and every %d ms\n\n",
+			(unsigned long long)events, rate, rotate_s, hup_ms);
+		return bench_rotate(rate, events, rotate_s, hup_ms) == 0 ? 0 : 1;
+	}
+	if (strcmp(argv[1], "control") == 0) {
+		printf("\nControl socket: %llu events at %.0f events/s, a command every %d ms\n\n",
+			(unsigned long long)events, rate, hup_ms);
+		return bench_control(rate, events, hup_ms) == 0 ? 0 : 1;
+	}
+	if (strcmp(argv[1], "format") == 0) {
+		printf("\nText formatter: golden file, random records, %llu records timed\n\n",
+			(unsigned long long)events);
+		return bench_format(events, golden != NULL ? golden : "../pulse_seq_script/test.txt") == 0 ? 0 : 1;
+	}
+	if (strcmp(argv[1], "journal") == 0) {
+		printf("\nJournal: %llu events at %.0f events/s, killed after %d ms\n\n",
+			(unsigned long long)events, rate, hup_ms);
+		return bench_journal(rate, events, hup_ms) == 0 ? 0 : 1;
+	}
+	if (strcmp(argv[1], "status") == 0) {
+		printf("\nStatus broker: %llu events at %.0f events/s, a sample every %d ms\n\n",
+			(unsigned long long)events, rate, hup_ms);
+		return bench_status(rate, events, hup_ms) == 0 ? 0 : 1;
+	}
+	if (strcmp(argv[1], "stream") == 0) {
+		printf("\nStream: %llu events at %.0f events/s, %d subscribers, one pausing %d ms per packet\n\n",
+			(unsigned long long)events, rate, clients, hup_ms);
+		return bench_stream(rate, events, clients, hup_ms) == 0 ? 0 : 1;
+	}
+	if (strcmp(argv[1], "metrics") == 0) {
+		printf("\nMetrics: %llu events at %.0f events/s, exported every %d ms\n\n",
+			(unsigned long long)events, rate, hup_ms);
+		return bench_metrics(rate, events, hup_ms) == 0 ? 0 : 1;
+	}
+	if (strcmp(argv[1], "radar") == 0) {
+		printf("\nRadar control join: %.1f s of sequences, entries up to %d ms late\n\n",
+			seconds, hup_ms);
+		if (bench_radar(seconds, hup_ms, 0) != 0) {
+			return 1;
+		}
+		printf("\nThe same with every event read %lld ms after it was stamped\n\n", CAP_LATE_NS * 3 / 4000000);
+		return bench_radar(seconds, hup_ms, CAP_LATE_NS * 3 / 4000000) == 0 ? 0 : 1;
+	}
+	if (strcmp(argv[1], "tracker") == 0) {
+		printf("\nSequences found while capturing: %.1f s of sequences, a new file every %.2f s\n\n",
+			seconds, rotate_s);
+		return bench_tracker(seconds, rotate_s) == 0 ? 0 : 1;
+	}
+	if (strcmp(argv[1], "timing") == 0) {
+		printf("\nTiming histograms: %llu pulses\n\n", (unsigned long long)events);
+		return bench_timing(events) == 0 ? 0 : 1;
+	}
+	if (strcmp(argv[1], "allan") == 0) {
+		printf("\nAllan deviation: %llu sequence starts\n\n", (unsigned long long)events);
+		return bench_allan(events) == 0 ? 0 : 1;
+	}
+	if (strcmp(argv[1], "index") == 0) {
+		printf("\nTime index: %llu events 10 ms apart, a new file every %.0f s\n\n",
+			(unsigned long long)events, rotate_s < 60 ? 60 : rotate_s);
+		return bench_index(events, rotate_s) == 0 ? 0 : 1;
+	}
+	if (strcmp(argv[1], "delta") == 0) {
+		printf("\nDelta of delta blocks: %llu events of %s ms sequences\n\n",
+			(unsigned long long)events, SEQ_DEFAULT_SEPS);
+		return bench_delta(events) == 0 ? 0 : 1;
+	}
+	if (strcmp(argv[1], "columns") == 0) {
+		count = events < (1 << CAP_RING_ORDER) ? events : (1 << CAP_RING_ORDER);
+		printf("\nColumn store: %llu events of %s ms sequences across a day boundary\n\n",
+			(unsigned long long)count, SEQ_DEFAULT_SEPS);
+		return bench_columns(events) == 0 ? 0 : 1;
+	}
+	if (strcmp(argv[1], "sequence") == 0) {
+		printf("\nSequence detector: %llu sequences of %s ms\n\n",
+			(unsigned long long)events, SEQ_DEFAULT_SEPS);
+		return bench_sequence(events) == 0 ? 0 : 1;
+	}
+	if (strcmp(argv[1], "tables") == 0) {
+		printf("\nSequence detector: %llu sequences of %s\n\n", (unsigned long long)events, BENCH_TABLES);
+		return bench_tables(events) == 0 ? 0 : 1;
+	}
+	if (strcmp(argv[1], "findpulse") == 0) {
+		printf("\nfindpulse: findpulse.pl against the compiled detector, %llu events in the larger run\n\n",
+			(unsigned long long)events);
+		return bench_findpulse(events, golden != NULL ? golden : "../pulse_seq_script/test2.txt") == 0 ? 0 : 1;
+	}
+	if (strcmp(argv[1], "batch") == 0) {
+		printf("\nbatch: findpulse one file at a time against batch on all cores\n\n");
+		return bench_batch(events, golden != NULL ? golden : "../pulse_seq_script/test2.txt", threads) == 0 ? 0 : 1;
+	}
+	if (strcmp(argv[1], "parse") == 0) {
+		printf("\nText parser: rec_parse_text against rec_map_text, %llu timestamps\n\n",
+			(unsigned long long)events);
+		return bench_parse(events, golden != NULL ? golden : "../pulse_seq_script/test2.txt") == 0 ? 0 : 1;
+	}
+	if (strcmp(argv[1], "lib") == 0) {
+		printf("\nlibsym560: %llu events at %.0f events/s, each way of reading them\n\n",
+			(unsigned long long)events, rate);
+		return bench_lib(rate, events) == 0 ? 0 : 1;
+	}
+	usage();
+	return 1;
+}
+/* end of main */
@@ -0,0 +1,1620 @@
+/* File : 	sym560_capture.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Capture and writer threads used by both the automatic and the
+ *		manual timestamping modes.  The capture thread only waits on the
+ *		event ioctl and copies the 12 bytes into a preallocated ring slot;
+ *		all formatting happens on the writer thread, which hands full
+ *		buffers to sym560_io to be written out asynchronously, so a slow disk
+ *		can no longer hold up the next event.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sym560_functions.h"
+#include "sym560_capture.h"
+#include "sym560_index.h"
+#include "sym560_column.h"
+
+_Static_assert(CAP_WRBUFS <= JNL_BUFS, "the journal cannot note every writer buffer");
+
+/*******************************************************************************/
+/* Function   : cap_wakeup
+ * Inputs     : int sig - signal number
+ * Returns    : Nothing
+ * Description: Empty SIGUSR1 handler.  Its only purpose is to interrupt the
+ *		capture thread's ioctl (or simulator sleep) when stopping.
+ */
+static void cap_wakeup(int sig) {
+}
+/* end of function: cap_wakeup */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_prefault_stack
+ * Inputs     : None
+ * Returns    : Nothing
+ * Description: Touches the capture thread's stack ahead of time so the first
+ *		events do not take page faults on it (real-time profile only).
+ */
+static void cap_prefault_stack(void) {
+	volatile char stack[CAP_STACK_PREFAULT];
+
+	memset((char *)stack, 0, sizeof(stack));
+}
+/* end of function: cap_prefault_stack */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_thread_main
+ * Inputs     : void *arg - the struct capture
+ * Returns    : NULL
+ * Description: Capture loop.  Waits for an event, stamps it with a sequence
+ *		number and its decoded time and publishes it to the ring.  If the
+ *		writer has fallen so far behind that the ring is full the event is
+ *		counted and dropped rather than waiting.  The page faults and context
+ *		switches the thread takes while capturing are left in cap_usage.
+ */
+static void *cap_thread_main(void *arg) {
+	struct capture *cap = arg;
+	struct sym560_record *rec;
+	unsigned char raw[REC_RAW_LEN];
+	struct rusage ru0, ru1;
+	uint64_t seq = 0;
+	sigset_t set;
+	int ret;
+
+	sigemptyset(&set);
+	sigaddset(&set, SIGUSR1);
+	pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+	if (cap->cfg.rt) {
+		cap_prefault_stack();
+	}
+	getrusage(RUSAGE_THREAD, &ru0);
+
+	while (atomic_load_explicit(&cap->stop, memory_order_relaxed) == 0) {
+		if (cap->sim != NULL) {
+			ret = sim_wait(cap->sim, raw);
+		}
+		else {
+			ret = ioctl(cap->devfd, IOCTL_EVENT_CAPTURE, raw);
+		}
+		/* the driver hands back the previous event when interrupted, so
+		 * anything read after a stop request is discarded */
+		if (atomic_load_explicit(&cap->stop, memory_order_relaxed) != 0) {
+			break;
+		}
+		if (ret == -1) {
+			if (cap->sim != NULL) {
+				break;
+			}
+			if (errno != EINTR && !cap->quiet) {
+				printf("\nEvent capture ioctl failed (errno %d)\n", errno);
+			}
+			continue;
+		}
+
+		rec = ring_reserve(cap->ring);
+		if (rec == NULL) {
+			atomic_fetch_add_explicit(&cap->overflows, 1, memory_order_relaxed);
+		}
+		else {
+			memcpy(rec->raw, raw, REC_RAW_LEN);
+			rec->ns = rec_decode(raw);
+			rec->seq = seq;
+			rec->type = REC_EVENT;
+			rec->lock = atomic_load_explicit(&cap->lock, memory_order_relaxed);
+			ring_commit(cap->ring);
+		}
+		if (seq == 0) {
+			atomic_store(&cap->first_ns, sim_now());
+		}
+		seq++;
+		atomic_store_explicit(&cap->captured, seq, memory_order_relaxed);
+	}
+
+	getrusage(RUSAGE_THREAD, &ru1);
+	cap->cap_usage.ru_minflt = ru1.ru_minflt - ru0.ru_minflt;
+	cap->cap_usage.ru_majflt = ru1.ru_majflt - ru0.ru_majflt;
+	cap->cap_usage.ru_nvcsw = ru1.ru_nvcsw - ru0.ru_nvcsw;
+	cap->cap_usage.ru_nivcsw = ru1.ru_nivcsw - ru0.ru_nivcsw;
+
+	atomic_store_explicit(&cap->cap_done, 1, memory_order_release);
+	return NULL;
+}
+/* end of function: cap_thread_main */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : lock_thread_main
+ * Inputs     : void *arg - the struct capture
+ * Returns    : NULL
+ * Description: Reads the lock register every lock_poll_ns so that records are
+ *		stamped with the lock state in effect, and reports when the lock is
+ *		acquired or lost.  Sleeps in short steps so cap_stop is not held up.
+ */
+static void *lock_thread_main(void *arg) {
+	struct capture *cap = arg;
+	struct timespec step = {0, 100000000};
+	int64_t slept;
+	int lock, prev;
+
+	prev = atomic_load(&cap->lock);
+	while (atomic_load_explicit(&cap->stop, memory_order_relaxed) == 0) {
+		for (slept = 0; slept < cap->cfg.lock_poll_ns; slept += 100000000) {
+			if (atomic_load_explicit(&cap->stop, memory_order_relaxed) != 0) {
+				return NULL;
+			}
+			nanosleep(&step, NULL);
+		}
+		lock = GPS_lock_status(cap->devfd);
+		if (lock == -1 || lock == prev) {
+			continue;
+		}
+		atomic_store_explicit(&cap->lock, lock, memory_order_relaxed);
+		prev = lock;
+		if (cap->quiet) {
+			continue;
+		}
+		if (lock == REC_LOCK_ALL) {
+			printf("\nGPS has been locked\n");
+		}
+		else {
+			printf("\nWARNING: GPS lock status is now 0x%02x\n", lock);
+		}
+		fflush(stdout);
+	}
+	return NULL;
+}
+/* end of function: lock_thread_main */
+/*******************************************************************************/
+
+
+/* the column store the writer appends to, see cap_columns */
+struct col_out {
+	char dir[PATH_MAX];
+	struct col_day day;		/* the day being appended to */
+	struct col_pend pend;		/* rows held back for the tracker */
+	struct col_slice slice[CAP_WRBUFS];	/* rows of each buffer */
+	uint64_t lost;			/* rows of days whose files could not be opened */
+};
+
+/* writer thread state */
+struct writer {
+	struct capture *cap;
+	char *buf;			/* buffer being filled, NULL if none is free */
+	int cur;			/* its index */
+	int len;			/* bytes in it */
+	int64_t buf_t0;			/* CLOCK_MONOTONIC time its first byte went in */
+	int64_t file_end;		/* bytes written or queued to the current file */
+	int64_t alloc_end;		/* the current file is preallocated up to here */
+	int64_t last_sync;		/* CLOCK_MONOTONIC time of the last fdatasync queued */
+	uint64_t drop_pending;		/* events dropped since the last one written */
+	int64_t drop_ns;		/* time of the first of them */
+	int lock;			/* lock state of the last record written */
+	uint64_t rd;			/* next ring record to format */
+	uint64_t end[CAP_WRBUFS];	/* ring position after the last record in each buffer */
+	uint64_t marked;		/* ring position after the last buffer handed to the disk */
+	struct stat file_st;		/* the current file, for the journal */
+	char path[PATH_MAX];		/* and its absolute path, "" if unknown */
+	int inflight;			/* buffers handed to the disk and not yet retired */
+	int held;			/* a write failed, so the journal's tail stays put */
+	int idx_len;			/* index entries in the current buffer's slice */
+	int64_t idx_bucket;		/* interval of the current file's last index entry, -1 = none */
+	int col_len;			/* column rows in the current buffer's slice */
+};
+
+/*******************************************************************************/
+/* Function   : wr_retire
+ * Inputs     : struct writer *w - writer state
+ * Returns    : Nothing
+ * Description: Retires the buffers the disk has finished with, oldest first,
+ *		and hands ring slots back to the capture thread.  Without a journal
+ *		a record's slot is free as soon as it has been formatted.  With one
+ *		it is only freed once the buffer holding its text has been written,
+ *		so the journal's tail never passes an event that is not yet in the
+ *		timestamp file.  Once a write has failed nothing more is freed: the
+ *		events from there on stay in the journal for the next start, and
+ *		new ones are lost when the ring fills.
+ */
+static void wr_retire(struct writer *w) {
+	struct capture *cap = w->cap;
+	uint64_t failed;
+	int old;
+
+	while (w->inflight > 0) {
+		old = (w->cur + CAP_WRBUFS - w->inflight) % CAP_WRBUFS;
+		if (!io_complete(&cap->io, cap->wrbuff_seq[old] - 1)) {
+			break;
+		}
+		if (cap->cfg.journal != NULL && !w->held) {
+			failed = atomic_load_explicit(&cap->io.failed_write, memory_order_relaxed);
+			if (failed != 0 && failed <= cap->wrbuff_seq[old]) {
+				w->held = 1;
+				printf("\nCould not write the output, keeping the events from here on in the journal %s\n",
+						cap->cfg.journal);
+				fflush(stdout);
+			}
+			else {
+				ring_release_to(cap->ring, w->end[old]);
+			}
+		}
+		w->inflight--;
+	}
+	if (cap->cfg.journal == NULL) {
+		ring_release_to(cap->ring, w->rd);
+	}
+}
+/* end of function: wr_retire */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : wr_buffer
+ * Inputs     : struct writer *w - writer state
+ * Returns    : 1 if w->buf is ready to be filled, 0 if every buffer is still
+ *		waiting on the disk
+ * Description: Buffers are used round robin, so the next one is always the one
+ *		handed to the disk longest ago.
+ */
+static int wr_buffer(struct writer *w) {
+	struct capture *cap = w->cap;
+
+	if (w->buf != NULL) {
+		return 1;
+	}
+	io_poll(&cap->io);
+	wr_retire(w);
+	if (w->inflight == CAP_WRBUFS) {
+		return 0;
+	}
+	cap->wrbuff_seq[w->cur] = 0;
+	w->buf = cap->wrbuff + (size_t)w->cur * CAP_WRBUFF_LEN;
+	w->len = 0;
+	return 1;
+}
+/* end of function: wr_buffer */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : wr_alloc
+ * Inputs     : struct writer *w - writer state
+ * Returns    : Nothing
+ * Description: Keeps the preallocated part of the current file at least
+ *		CAP_WRBUFS buffers ahead of what has been written.
+ */
+static void wr_alloc(struct writer *w) {
+	struct capture *cap = w->cap;
+
+	while (cap->cfg.prealloc != 0
+			&& w->file_end + CAP_WRBUFS * CAP_WRBUFF_LEN > w->alloc_end) {
+		io_queue(&cap->io, IO_ALLOC, cap->outfd, NULL, cap->cfg.prealloc, w->alloc_end);
+		w->alloc_end += cap->cfg.prealloc;
+	}
+}
+/* end of function: wr_alloc */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : wr_submit
+ * Inputs     : struct writer *w - writer state
+ * Returns    : Nothing
+ * Description: Hands the current buffer, if it holds anything, to the IO backend
+ *		and queues an fdatasync behind it if the sync policy calls for one.
+ *		The index entries of its records are written straight after it, as
+ *		are its column rows, so the buffer and its slices are retired
+ *		together.  Returns straight away; the buffer is reused once the
+ *		writes are done.
+ */
+static void wr_submit(struct writer *w) {
+	struct capture *cap = w->cap;
+	struct col_slice *s;
+	uint64_t seq = 0;
+	int64_t now;
+
+	if (w->buf == NULL || (w->len == 0 && w->col_len == 0)) {
+		return;
+	}
+	if (w->len != 0) {
+		/* once held, the note of the buffer that failed must survive
+		 * for jnl_settle to cut what part of it got to the file */
+		if (cap->cfg.journal != NULL && !w->held) {
+			jnl_mark(&cap->jnl, w->cur, w->marked, w->rd, w->file_end, w->file_end + w->len,
+					&w->file_st, w->path[0] != '\0' ? w->path : NULL);
+		}
+		seq = io_queue(&cap->io, IO_WRITE, cap->outfd, w->buf, w->len, 0);
+	}
+	if (w->idx_len != 0) {
+		seq = io_queue(&cap->io, IO_WRITE, cap->idxfd, (const char *)(cap->idx + (size_t)w->cur * IDX_SLICE),
+				w->idx_len * sizeof(struct idx_entry), 0);
+		w->idx_len = 0;
+	}
+	if (w->col_len != 0) {
+		s = &cap->col->slice[w->cur];
+		io_queue(&cap->io, IO_WRITE, cap->col->day.fd[COL_TIME], (const char *)s->ns,
+				w->col_len * sizeof(*s->ns), 0);
+		io_queue(&cap->io, IO_WRITE, cap->col->day.fd[COL_FLAGS], (const char *)s->flags,
+				w->col_len * sizeof(*s->flags), 0);
+		seq = io_queue(&cap->io, IO_WRITE, cap->col->day.fd[COL_SEQ], (const char *)s->seq,
+				w->col_len * sizeof(*s->seq), 0);
+		w->col_len = 0;
+	}
+	cap->wrbuff_seq[w->cur] = seq + 1;
+	w->end[w->cur] = w->rd;
+	w->marked = w->rd;
+	w->inflight++;
+	w->file_end += w->len;
+	w->buf = NULL;
+	w->cur = (w->cur + 1) % CAP_WRBUFS;
+	wr_alloc(w);
+
+	if (cap->cfg.sync_ns < 0) {
+		io_queue(&cap->io, IO_SYNC, cap->outfd, NULL, 0, 0);
+	}
+	else if (cap->cfg.sync_ns > 0) {
+		now = sim_now();
+		if (now - w->last_sync >= cap->cfg.sync_ns) {
+			io_queue(&cap->io, IO_SYNC, cap->outfd, NULL, 0, 0);
+			w->last_sync = now;
+		}
+	}
+}
+/* end of function: wr_submit */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : wr_space
+ * Inputs     : struct writer *w - writer state
+ *		int need - bytes about to be added
+ * Returns    : 1 if there is room, 0 if no buffer is free
+ * Description: Submits the current buffer first if need would not fit.
+ */
+static int wr_space(struct writer *w, int need) {
+	if (w->buf != NULL && w->len + need > CAP_WRBUFF_LEN) {
+		wr_submit(w);
+	}
+	if (!wr_buffer(w)) {
+		return 0;
+	}
+	if (w->len == 0 && w->col_len == 0) {
+		w->buf_t0 = sim_now();
+	}
+	return 1;
+}
+/* end of function: wr_space */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : wr_index
+ * Inputs     : struct writer *w - writer state, with room for need bytes
+ *		int64_t ns - time of the record about to be formatted
+ *		int need - bytes it needs
+ * Returns    : 0 once it has an index entry if it needs one
+ *             -1 if no buffer is free
+ * Description: The record gets an entry if it is the current file's first
+ *		of an index interval.  A buffer whose slice is full is written
+ *		early to make room.
+ */
+static int wr_index(struct writer *w, int64_t ns, int need) {
+	struct capture *cap = w->cap;
+	struct idx_entry *e;
+
+	if (cap->idxfd == -1) {
+		return 0;
+	}
+	if (w->idx_len == IDX_SLICE) {
+		wr_submit(w);
+		if (!wr_space(w, need)) {
+			return -1;
+		}
+	}
+	if (idx_due(&w->idx_bucket, ns, cap->cfg.index_ns)) {
+		e = cap->idx + (size_t)w->cur * IDX_SLICE + w->idx_len++;
+		e->ns = ns;
+		e->offset = w->file_end + w->len;
+	}
+	return 0;
+}
+/* end of function: wr_index */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : wr_col_day
+ * Inputs     : struct writer *w - writer state, with a column store
+ *		int64_t ns - time of the first row of the next day
+ * Returns    : Nothing
+ * Description: Finishes the last day's files behind the rows already in the
+ *		buffer and opens the next day's.  If they cannot be opened, that
+ *		day's rows are left out.
+ */
+static void wr_col_day(struct writer *w, int64_t ns) {
+	struct capture *cap = w->cap;
+	struct col_out *c = cap->col;
+	int k;
+
+	wr_submit(w);
+	for (k = 0; k < COL_NCOL; k++) {
+		if (c->day.fd[k] != -1) {
+			io_queue(&cap->io, IO_SYNC, c->day.fd[k], NULL, 0, 0);
+			io_queue(&cap->io, IO_CLOSE, c->day.fd[k], NULL, 0, 0);
+		}
+	}
+	if (col_open(&c->day, c->dir, ns) != 0) {
+		printf("\nCould not open the column store's day in %s, leaving it out\n", c->dir);
+	}
+}
+/* end of function: wr_col_day */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : wr_columns
+ * Inputs     : struct writer *w - writer state
+ *		int64_t upto - rows from this time on may still be pulses of a
+ *			       sequence the tracker has not finished, INT64_MAX if
+ *			       there is no such sequence
+ * Returns    : 0 once every row before upto is in a slice
+ *             -1 if no buffer is free
+ * Description: Moves the rows held back for the column store into the slice
+ *		of the current buffer.  A buffer whose slice is full is written
+ *		early to make room.
+ */
+static int wr_columns(struct writer *w, int64_t upto) {
+	struct col_out *c = w->cap->col;
+	const struct col_row *r;
+	struct col_slice *s;
+
+	while ((r = col_pend_next(&c->pend, upto)) != NULL) {
+		if (r->ns / COL_DAY_NS != c->day.day) {
+			wr_col_day(w, r->ns);
+		}
+		if (w->col_len == COL_SLICE) {
+			wr_submit(w);
+		}
+		if (!wr_space(w, 0)) {
+			return -1;
+		}
+		if (c->day.fd[0] != -1) {
+			s = &c->slice[w->cur];
+			s->ns[w->col_len] = r->ns;
+			s->flags[w->col_len] = r->flags;
+			s->seq[w->col_len++] = col_seq_id(&c->day, r->tag);
+		}
+		else {
+			c->lost++;
+		}
+		col_pend_pop(&c->pend);
+	}
+	return 0;
+}
+/* end of function: wr_columns */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : wr_open
+ * Inputs     : struct writer *w - writer state
+ * Returns    : Nothing
+ * Description: Picks up the size of a newly opened output file (it may be an
+ *		existing file being appended to) and starts preallocating it.  Its
+ *		first record gets an index entry.  With a journal it also finds
+ *		out which file it is, for jnl_mark.
+ */
+static void wr_open(struct writer *w) {
+	struct capture *cap = w->cap;
+	char link[64];
+	ssize_t len;
+
+	w->file_end = lseek(cap->outfd, 0, SEEK_END);
+	if (w->file_end < 0) {
+		w->file_end = 0;
+	}
+	w->path[0] = '\0';
+	if (cap->cfg.journal != NULL && fstat(cap->outfd, &w->file_st) == 0) {
+		snprintf(link, sizeof(link), "/proc/self/fd/%d", cap->outfd);
+		len = readlink(link, w->path, sizeof(w->path) - 1);
+		w->path[len > 0 ? len : 0] = '\0';
+	}
+	w->alloc_end = w->file_end;
+	w->idx_bucket = -1;
+	wr_alloc(w);
+}
+/* end of function: wr_open */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : wr_close
+ * Inputs     : struct writer *w - writer state
+ *		int closefd - also close the file
+ * Returns    : Nothing
+ * Description: Queues everything needed to finish the current file behind its
+ *		last write: the unused preallocation is trimmed off and the data
+ *		synced, then the file and its index are closed if asked.  The index
+ *		is not synced, "sym560_cmdline backfill" can make it again.  The
+ *		column store's files are synced too but stay open, as they go on
+ *		to the end of the day.
+ */
+static void wr_close(struct writer *w, int closefd) {
+	struct capture *cap = w->cap;
+	int k;
+
+	wr_submit(w);
+	if (cap->cfg.prealloc != 0) {
+		io_queue(&cap->io, IO_TRIM, cap->outfd, NULL, 0, w->file_end);
+	}
+	io_queue(&cap->io, IO_SYNC, cap->outfd, NULL, 0, 0);
+	for (k = 0; cap->col != NULL && k < COL_NCOL; k++) {
+		if (cap->col->day.fd[k] != -1) {
+			io_queue(&cap->io, IO_SYNC, cap->col->day.fd[k], NULL, 0, 0);
+		}
+	}
+	if (closefd) {
+		io_queue(&cap->io, IO_CLOSE, cap->outfd, NULL, 0, 0);
+		if (cap->idxfd != -1) {
+			io_queue(&cap->io, IO_CLOSE, cap->idxfd, NULL, 0, 0);
+			cap->idxfd = -1;
+		}
+	}
+}
+/* end of function: wr_close */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : wr_index_open
+ * Inputs     : struct capture *cap - capture with an index
+ *		const char *filename - timestamp file
+ * Returns    : File descriptor of its index, -1 if it could not be opened
+ */
+static int wr_index_open(struct capture *cap, const char *filename) {
+	char name[PATH_MAX];
+	int fd = -1;
+
+	if (idx_name(filename, name, sizeof(name)) == 0) {
+		fd = idx_open(name, IDX_TEXT, cap->cfg.index_ns, 0);
+	}
+	if (fd == -1) {
+		printf("\nCould not open the index of %s, writing it without one\n", filename);
+	}
+	return fd;
+}
+/* end of function: wr_index_open */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : wr_rotate
+ * Inputs     : struct writer *w - writer state
+ *		int64_t name_ns - UTC time used to name the new file (the time of
+ *				  the first record going into it)
+ * Returns    : 0 on success
+ *             -1 if the new file could not be opened
+ * Description: Switches the output to a new file.  Only ever called by the writer
+ *		between two records, so every record lands in exactly one file.  The
+ *		old file is finished off (see wr_close) behind its last write, and if
+ *		the new file cannot be opened the writer simply keeps going with the
+ *		old one.  The same goes if the name has not changed (two rotations
+ *		within a minute): the current file is the new file, and a second
+ *		descriptor would have to guess where the writes still queued on the
+ *		first one will end.
+ */
+static int wr_rotate(struct writer *w, int64_t name_ns) {
+	struct capture *cap = w->cap;
+	char filename[CAP_FILENAME_LEN];
+	struct stat cur, next;
+	int fd;
+
+	cap_filename(name_ns, filename);
+	fd = open(filename, O_RDWR|O_CREAT|O_APPEND, 00644);
+	if (fd == -1) {
+		printf("\nCould not open %s, continuing in the current file\n", filename);
+		return -1;
+	}
+	if (fstat(fd, &next) == 0 && fstat(cap->outfd, &cur) == 0
+			&& next.st_dev == cur.st_dev && next.st_ino == cur.st_ino) {
+		close(fd);
+		return 0;
+	}
+	wr_close(w, 1);
+	cap->outfd = fd;
+	if (cap->idx != NULL) {
+		cap->idxfd = wr_index_open(cap, filename);
+	}
+	wr_open(w);
+	atomic_fetch_add_explicit(&cap->rotations, 1, memory_order_relaxed);
+	return 0;
+}
+/* end of function: wr_rotate */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : wr_markers
+ * Inputs     : struct writer *w - writer state
+ *		int64_t upto_ns - write the markers made at or before this time
+ * Returns    : 0 once every such marker is written
+ *             -1 if the buffers ran out first
+ * Description: Moves markers queued by cap_mark into the output, oldest first,
+ *		stopping at the first one newer than upto_ns.
+ */
+static int wr_markers(struct writer *w, int64_t upto_ns) {
+	struct capture *cap = w->cap;
+	uint64_t tail = atomic_load_explicit(&cap->mark_tail, memory_order_relaxed);
+	uint64_t head = atomic_load_explicit(&cap->mark_head, memory_order_acquire);
+	struct cap_marker *mk;
+	int ret = 0;
+
+	while (tail != head) {
+		mk = &cap->marker[tail & (CAP_MARKERS - 1)];
+		if (mk->ns > upto_ns) {
+			break;
+		}
+		if (!wr_space(w, REC_TEXT_MAX)) {
+			ret = -1;
+			break;
+		}
+		w->len += rec_format_marker(mk->ns, mk->text, w->buf + w->len);
+		tail++;
+	}
+	atomic_store_explicit(&cap->mark_tail, tail, memory_order_release);
+	return ret;
+}
+/* end of function: wr_markers */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : wr_drop_oldest
+ * Inputs     : struct writer *w - writer state
+ * Returns    : Nothing
+ * Description: CAP_IO_DROP_OLDEST policy, used while every buffer is waiting on
+ *		the disk.  Once the ring is three quarters full the oldest events are
+ *		discarded until it is half full, so the capture thread always has
+ *		room for new ones.  The gap is noted in the output ahead of the next
+ *		event written.  Not used with a journal, whose records stay in the
+ *		ring until they are written.
+ */
+static void wr_drop_oldest(struct writer *w) {
+	struct capture *cap = w->cap;
+	struct sym560_record *rec;
+	uint64_t size = cap->ring->mask + 1, count, n;
+
+	count = ring_count(cap->ring);
+	if (count <= size / 4 * 3) {
+		return;
+	}
+	count -= size / 2;
+	while (count > 0) {
+		n = ring_peek_from(cap->ring, w->rd, &rec);
+		if (n == 0) {
+			break;
+		}
+		if (n > count) {
+			n = count;
+		}
+		if (w->drop_pending == 0) {
+			w->drop_ns = rec[0].ns;
+		}
+		w->drop_pending += n;
+		atomic_fetch_add_explicit(&cap->dropped, n, memory_order_relaxed);
+		w->rd += n;
+		ring_release_to(cap->ring, w->rd);
+		count -= n;
+	}
+}
+/* end of function: wr_drop_oldest */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : wr_thread_main
+ * Inputs     : void *arg - the struct capture
+ * Returns    : NULL
+ * Description: Writer loop.  Formats the records waiting in the ring into the
+ *		current output buffer and hands each full buffer to the IO backend,
+ *		which writes them out in order without the writer waiting.  A partly
+ *		filled buffer goes out once it is CAP_WRITE_DELAY_NS old.  When idle
+ *		the writer sleeps for a millisecond instead of being woken, which
+ *		keeps the capture side free of system calls.  If every buffer is
+ *		still waiting on the disk the io_policy decides whether to wait or
+ *		to discard the oldest events; either way it is counted.
+ *		A new file is started before the first record stamped at or after a
+ *		multiple of rotate_ns, or before the next record after cap_rotate.
+ *		Either way the file is named from that record's time.  A LOCK line
+ *		goes ahead of any record whose lock state differs from the record
+ *		before it; each file starts out assuming LOCKED, so files captured
+ *		entirely while locked are unchanged.  Markers from cap_mark go ahead
+ *		of the first record stamped after them, or are written on their own
+ *		once CAP_MARKER_SLACK_NS old if no such record turns up.  With a
+ *		joiner (see sym560_radar.c) every record also goes through its
+ *		sequence detector, and a SEQUENCE line follows the event that
+ *		completes a join.  With a tracker (see sym560_tracker.c) likewise,
+ *		and a DETECTED line follows the event that finishes a sequence; the
+ *		detector carries on across files.  With cap_index each file's
+ *		first record of every index interval gets an entry in its index.
+ *		With cap_columns every record is also a row of the column store,
+ *		held back while the tracker may still put it in a sequence.  A
+ *		cap_flush request is answered once everything taken from the ring
+ *		so far has been written and synced.  Exits, after finishing the current file
+ *		(but leaving it open), once cap_stop has been called, the capture
+ *		thread has exited and the ring is empty.
+ */
+static void *wr_thread_main(void *arg) {
+	struct capture *cap = arg;
+	struct writer w;
+	struct sym560_record *rec;
+	struct stream *str;
+	struct joiner *rad;
+	struct tracker *trk;
+	struct timespec idle = {0, 1000000}, now;
+	char note[REC_MARKER_MAX + 1];
+	int64_t rotate_ns = cap->cfg.rotate_ns, upto_ns;
+	uint64_t n, cnt, flush_req, flush_seen = 0, flush_io = 0;
+	int done, pending = 0, flushing = 0, stalled = 0, len;
+
+	memset(&w, 0, sizeof(w));
+	w.cap = cap;
+	w.lock = REC_LOCK_ALL;
+	w.last_sync = sim_now();
+	w.rd = atomic_load_explicit(&cap->ring->tail, memory_order_relaxed);
+	w.marked = w.rd;
+	wr_open(&w);
+
+	/* records the journal kept from a run that did not finish go first */
+	if (cap->jnl.recovered != 0 && ring_peek_from(cap->ring, w.rd, &rec) != 0) {
+		sprintf(note, "%llu events recovered from an interrupted run",
+				(unsigned long long)cap->jnl.recovered);
+		wr_space(&w, REC_TEXT_MAX);
+		w.len += rec_format_marker(rec->ns, note, w.buf + w.len);
+	}
+
+	for (;;) {
+		io_poll(&cap->io);
+		if (atomic_exchange_explicit(&cap->rotate_req, 0, memory_order_acquire) != 0) {
+			pending = 1;
+		}
+		if (flushing && io_complete(&cap->io, flush_io)) {
+			atomic_store_explicit(&cap->flush_done, flush_seen, memory_order_release);
+			flushing = 0;
+		}
+		flush_req = atomic_load_explicit(&cap->flush_req, memory_order_acquire);
+
+		/* finished once cap_stop has been called, so markers queued right up
+		 * to then are still written, and the capture thread has exited */
+		done = atomic_load_explicit(&cap->stop, memory_order_acquire)
+			&& atomic_load_explicit(&cap->cap_done, memory_order_acquire);
+
+		if (!wr_buffer(&w)) {
+			/* every buffer is still waiting on the disk */
+			if (!stalled) {
+				atomic_fetch_add_explicit(&cap->stalls, 1, memory_order_relaxed);
+				stalled = 1;
+			}
+			if (cap->cfg.io_policy == CAP_IO_DROP_OLDEST) {
+				wr_drop_oldest(&w);
+				nanosleep(&idle, NULL);
+			}
+			else {
+				io_wait(&cap->io, cap->wrbuff_seq[w.cur] - 1);
+			}
+			continue;
+		}
+		stalled = 0;
+
+		n = ring_peek_from(cap->ring, w.rd, &rec);
+		rad = atomic_load_explicit(&cap->radar, memory_order_acquire);
+		trk = atomic_load_explicit(&cap->tracker, memory_order_acquire);
+		if (n == 0) {
+			if (trk != NULL) {
+				clock_gettime(CLOCK_REALTIME, &now);
+				upto_ns = done ? INT64_MAX : now.tv_sec * 1000000000LL + now.tv_nsec;
+				while (wr_space(&w, TRK_TEXT_MAX)
+						&& (len = trk_idle(trk, upto_ns, w.buf + w.len)) != 0) {
+					w.len += len;
+					if (cap->col != NULL) {
+						col_pend_tag(&cap->col->pend, &trk->last);
+					}
+				}
+			}
+			if (rad != NULL) {
+				clock_gettime(CLOCK_REALTIME, &now);
+				upto_ns = done ? INT64_MAX : now.tv_sec * 1000000000LL + now.tv_nsec;
+				while (wr_space(&w, RAD_TEXT_MAX)
+						&& (len = rad_idle(rad, upto_ns, w.buf + w.len)) != 0) {
+					w.len += len;
+				}
+			}
+			if (atomic_load_explicit(&cap->mark_head, memory_order_relaxed)
+					!= atomic_load_explicit(&cap->mark_tail, memory_order_relaxed)) {
+				clock_gettime(CLOCK_REALTIME, &now);
+				upto_ns = now.tv_sec * 1000000000LL + now.tv_nsec - CAP_MARKER_SLACK_NS;
+				wr_markers(&w, done ? INT64_MAX : upto_ns);
+			}
+			if (cap->col != NULL) {
+				/* at the end every row, once the tracker has let go of them */
+				if (wr_columns(&w, trk != NULL ? seq_oldest(&trk->det) : INT64_MAX) != 0
+						|| (done && cap->col->pend.head != cap->col->pend.tail)) {
+					continue;
+				}
+			}
+			if (done) {
+				wr_close(&w, 0);
+				io_drain(&cap->io);
+				wr_retire(&w);
+				atomic_store_explicit(&cap->flush_done, flush_req, memory_order_release);
+				break;
+			}
+			if (!flushing && flush_req != flush_seen) {
+				wr_submit(&w);
+				flush_io = io_queue(&cap->io, IO_SYNC, cap->outfd, NULL, 0, 0);
+				flush_seen = flush_req;
+				flushing = 1;
+			}
+			if ((w.len > 0 || w.col_len > 0) && sim_now() - w.buf_t0 >= CAP_WRITE_DELAY_NS) {
+				wr_submit(&w);
+			}
+			nanosleep(&idle, NULL);
+			continue;
+		}
+
+		cnt = 0;
+		while (cnt < n) {
+			if (rotate_ns != 0 && rec[cnt].ns >= cap->next_rotate) {
+				if (cap->next_rotate != 0) {
+					pending = 1;
+				}
+				cap->next_rotate = (rec[cnt].ns / rotate_ns + 1) * rotate_ns;
+			}
+			if (pending) {
+				if (wr_rotate(&w, rec[cnt].ns) == 0) {
+					w.lock = REC_LOCK_ALL;
+				}
+				pending = 0;
+			}
+			if (wr_markers(&w, rec[cnt].ns) != 0 || !wr_space(&w, 3 * REC_TEXT_MAX + RAD_TEXT_MAX + TRK_TEXT_MAX)
+					|| wr_index(&w, rec[cnt].ns, 3 * REC_TEXT_MAX + RAD_TEXT_MAX + TRK_TEXT_MAX) != 0) {
+				break;
+			}
+			/* a free row for col_pend_add */
+			if (cap->col != NULL && cap->col->pend.head - cap->col->pend.tail == COL_PENDING
+					&& wr_columns(&w, trk != NULL ? seq_oldest(&trk->det) : INT64_MAX) != 0) {
+				break;
+			}
+			if (w.drop_pending != 0) {
+				sprintf(note, "%llu events dropped, output could not keep up",
+						(unsigned long long)w.drop_pending);
+				w.len += rec_format_marker(w.drop_ns, note, w.buf + w.len);
+				w.drop_pending = 0;
+			}
+			if (rec[cnt].lock != w.lock && rec[cnt].lock != REC_LOCK_UNKNOWN) {
+				w.lock = rec[cnt].lock;
+				w.len += rec_format_lock(w.lock, w.buf + w.len);
+			}
+			w.len += rec_format_text(rec[cnt].raw, w.buf + w.len);
+			if (rad != NULL) {
+				w.len += rad_feed(rad, rec[cnt].ns, w.buf + w.len);
+			}
+			if (cap->col != NULL) {
+				col_pend_add(&cap->col->pend, rec[cnt].ns, rec[cnt].lock);
+			}
+			if (trk != NULL) {
+				len = trk_feed(trk, rec[cnt].ns, w.buf + w.len);
+				if (len != 0 && cap->col != NULL) {
+					col_pend_tag(&cap->col->pend, &trk->last);
+				}
+				w.len += len;
+			}
+			w.rd++;
+			cnt++;
+			if (cap->col != NULL && wr_columns(&w, trk != NULL ? seq_oldest(&trk->det) : INT64_MAX) != 0) {
+				break;
+			}
+		}
+		if (cnt != 0) {
+			/* before the slots can be handed back to the capture thread */
+			str = atomic_load_explicit(&cap->stream, memory_order_acquire);
+			if (str != NULL) {
+				str_publish(str, rec, cnt);
+			}
+			clock_gettime(CLOCK_REALTIME, &now);
+			upto_ns = now.tv_sec * 1000000000LL + now.tv_nsec - rec[0].ns;
+			met_observe(&cap->met_latency, upto_ns > 0 ? upto_ns / 1000 : 0);
+			met_observe(&cap->met_batch, cnt);
+			met_observe(&cap->met_backlog, cap->ring->head_cache - (w.rd - cnt));
+			atomic_store_explicit(&cap->last_ns, rec[cnt - 1].ns, memory_order_relaxed);
+		}
+		wr_retire(&w);
+		atomic_fetch_add_explicit(&cap->written, cnt, memory_order_relaxed);
+
+		if (!flushing && flush_req != flush_seen) {
+			wr_submit(&w);
+			flush_io = io_queue(&cap->io, IO_SYNC, cap->outfd, NULL, 0, 0);
+			flush_seen = flush_req;
+			flushing = 1;
+		}
+	}
+	return NULL;
+}
+/* end of function: wr_thread_main */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_config_default
+ * Inputs     : struct cap_config *cfg - configuration to fill in
+ * Returns    : Nothing
+ * Description: Defaults match the behaviour before these options existed.
+ */
+void cap_config_default(struct cap_config *cfg) {
+	memset(cfg, 0, sizeof(*cfg));
+	cfg->rotate_ns = 0;
+	cfg->lock_poll_ns = 1000000000LL;
+	cfg->rt = 0;
+	cfg->rt_cpu = -1;
+	cfg->rt_prio = CAP_RT_PRIO;
+	cfg->ctl_path = NULL;
+	cfg->stream_path = NULL;
+	cfg->metrics_path = NULL;
+	cfg->radar_name = NULL;
+	cfg->tables = NULL;
+	cfg->io_backend = IO_AUTO;
+	cfg->io_policy = CAP_IO_BLOCK;
+	cfg->sync_ns = 0;
+	cfg->prealloc = CAP_PREALLOC;
+	cfg->journal = NULL;
+	cfg->status_ns = 0;
+}
+/* end of function: cap_config_default */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_filename
+ * Inputs     : int64_t ns - UTC time in nanoseconds
+ *		char *filename - buffer of at least CAP_FILENAME_LEN bytes
+ * Returns    : Nothing
+ * Description: Names timestamp files YYYYMMDD.HHMM.timestampdata.
+ */
+void cap_filename(int64_t ns, char *filename) {
+	time_t rawtime = ns / 1000000000LL;
+	struct tm tm;
+
+	gmtime_r(&rawtime, &tm);
+	sprintf(filename, "%04d%02d%02d.%02d%02d.timestampdata",
+			tm.tm_year+1900,
+			tm.tm_mon+1,
+			tm.tm_mday,
+			tm.tm_hour,
+			tm.tm_min);
+}
+/* end of function: cap_filename */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_alloc_locked
+ * Inputs     : size_t len - bytes wanted
+ *		size_t *maplen - receives the length actually mapped
+ * Returns    : The memory, NULL on failure
+ * Description: Real-time profile allocation.  Tries explicit hugepages first
+ *		and falls back to ordinary pages with a transparent hugepage hint.
+ *		Either way every page is written here so that it is faulted in (and
+ *		locked, after mlockall) before capture starts.
+ */
+static void *cap_alloc_locked(size_t len, size_t *maplen) {
+	void *mem;
+
+	*maplen = (len + CAP_HUGEPAGE - 1) & ~((size_t)CAP_HUGEPAGE - 1);
+	mem = mmap(NULL, *maplen, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+	if (mem == MAP_FAILED) {
+		mem = mmap(NULL, *maplen, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+		if (mem == MAP_FAILED) {
+			return NULL;
+		}
+		madvise(mem, *maplen, MADV_HUGEPAGE);
+	}
+	memset(mem, 0, *maplen);
+	return mem;
+}
+/* end of function: cap_alloc_locked */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_free_ring
+ * Inputs     : struct capture *cap - capture state
+ * Returns    : Nothing
+ * Description: Releases the ring however cap_init set it up.
+ */
+static void cap_free_ring(struct capture *cap) {
+	if (cap->cfg.journal != NULL) {
+		jnl_close(&cap->jnl);
+	}
+	else if (cap->ring_maplen != 0) {
+		munmap(cap->ring_mem.rec, cap->ring_maplen);
+		cap->ring_maplen = 0;
+	}
+	else {
+		ring_free(&cap->ring_mem);
+	}
+}
+/* end of function: cap_free_ring */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_init
+ * Inputs     : struct capture *cap - capture state to set up
+ *		const struct cap_config *cfg - options (copied)
+ *		int devfd - device file descriptor
+ *		int outfd - plain text output file descriptor
+ *		struct sim *sim - simulated source, NULL to use the card
+ * Returns    : 0 on success
+ *             -1 on failure
+ * Description: Allocates the ring and output buffers up front so that nothing
+ *		is allocated once capture is running.  The output buffers are page
+ *		aligned and a whole number of pages long.  With the real-time profile
+ *		all memory is locked (current and future, so thread stacks too) and
+ *		the buffers are prefaulted, on hugepages where available.  With
+ *		cfg->journal the ring is the one in the journal file (see
+ *		sym560_journal.h) and any records left in it are written out first;
+ *		its pages cannot be kept from writeback, so capture can then wait
+ *		on the disk even with the real-time profile.
+ */
+int cap_init(struct capture *cap, const struct cap_config *cfg, int devfd, int outfd, struct sim *sim) {
+	void *mem;
+
+	memset(cap, 0, sizeof(*cap));
+	cap->cfg = *cfg;
+	cap->devfd = devfd;
+	cap->outfd = outfd;
+	cap->idxfd = -1;
+	cap->sim = sim;
+	cap->ring = &cap->ring_mem;
+
+	if (cfg->rt && mlockall(MCL_CURRENT|MCL_FUTURE) != 0) {
+		cap->rt_failed |= CAP_RT_MLOCK;
+	}
+
+	if (cfg->journal != NULL) {
+		if (jnl_open(&cap->jnl, cfg->journal, CAP_RING_ORDER) != 0) {
+			return -1;
+		}
+		cap->ring = jnl_ring(&cap->jnl);
+		if (cap->jnl.skipped != 0) {
+			printf("\n%llu events in %s were already written by the run that left them\n",
+					(unsigned long long)cap->jnl.skipped, cfg->journal);
+		}
+		if (cap->jnl.recovered != 0) {
+			printf("\nRecovered %llu events from %s, left by a run that did not finish\n",
+					(unsigned long long)cap->jnl.recovered, cfg->journal);
+		}
+		if (cfg->io_policy == CAP_IO_DROP_OLDEST) {
+			printf("\nWARNING: events are never dropped from the journal, waiting on the disk instead\n");
+			cap->cfg.io_policy = CAP_IO_BLOCK;
+		}
+		if (cfg->rt) {
+			printf("\nWARNING: the capture thread can wait on writeback of the journal, "
+					"which the real-time profile cannot prevent\n");
+		}
+	}
+	else if (cfg->rt) {
+		mem = cap_alloc_locked(sizeof(struct sym560_record) << CAP_RING_ORDER, &cap->ring_maplen);
+		if (mem == NULL) {
+			printf("\nCould not allocate the event ring\n");
+			return -1;
+		}
+		ring_init_mem(cap->ring, CAP_RING_ORDER, mem);
+	}
+	else if (ring_init(cap->ring, CAP_RING_ORDER) != 0) {
+		printf("\nCould not allocate the event ring\n");
+		return -1;
+	}
+
+	if (cfg->rt) {
+		cap->wrbuff = cap_alloc_locked(CAP_WRBUFS * CAP_WRBUFF_LEN, &cap->wrbuff_maplen);
+	}
+	else if (posix_memalign(&mem, CAP_WRBUFF_ALIGN, CAP_WRBUFS * CAP_WRBUFF_LEN) == 0) {
+		cap->wrbuff = mem;
+	}
+	if (cap->wrbuff == NULL) {
+		printf("\nCould not allocate the output buffers\n");
+		cap_free_ring(cap);
+		return -1;
+	}
+	pthread_mutex_init(&cap->mark_lock, NULL);
+	return 0;
+}
+/* end of function: cap_init */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_index
+ * Inputs     : struct capture *cap - capture set up by cap_init, not started
+ *		const char *filename - name outfd was opened with
+ * Returns    : 0 on success
+ *             -1 if there is no time index (cfg.index_ns is 0 or the memory
+ *		could not be had)
+ * Description: Has the writer keep a sparse time index of the output (see
+ *		sym560_index.h), an entry for the first event of every index_ns,
+ *		beside outfd and every file it rotates to.  A file whose index
+ *		cannot be opened is written without one.
+ */
+int cap_index(struct capture *cap, const char *filename) {
+	if (cap->cfg.index_ns <= 0) {
+		return -1;
+	}
+	cap->idx = malloc(CAP_WRBUFS * IDX_SLICE * sizeof(struct idx_entry));
+	if (cap->idx == NULL) {
+		printf("\nCould not allocate the time index\n");
+		return -1;
+	}
+	cap->idxfd = wr_index_open(cap, filename);
+	return 0;
+}
+/* end of function: cap_index */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_columns
+ * Inputs     : struct capture *cap - capture set up by cap_init, not started
+ *		const char *dir - the store, made if it does not exist
+ * Returns    : 0 on success
+ *             -1 if dir cannot be made or the memory could not be had
+ * Description: Has the writer add every event to the column store in dir
+ *		(see sym560_column.h), starting a day's directory for the first
+ *		event of each UTC day.  With a tracker each row gives the
+ *		sequence and pulse it was.
+ */
+int cap_columns(struct capture *cap, const char *dir) {
+	struct col_out *c;
+	int k;
+
+	if (mkdir(dir, 00755) != 0 && errno != EEXIST) {
+		printf("\nCould not create %s: %s\n", dir, strerror(errno));
+		return -1;
+	}
+	c = calloc(1, sizeof(*c));
+	if (c == NULL) {
+		printf("\nCould not allocate the column store\n");
+		return -1;
+	}
+	snprintf(c->dir, sizeof(c->dir), "%s", dir);
+	for (k = 0; k < COL_NCOL; k++) {
+		c->day.fd[k] = -1;
+	}
+	c->day.day = -1;
+	cap->col = c;
+	return 0;
+}
+/* end of function: cap_columns */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_init_consumer
+ * Inputs     : struct capture *cap - capture state to set up
+ *		const struct cap_config *cfg - options (copied)
+ *		int devfd - device file descriptor
+ *		struct sim *sim - simulated source, NULL to use the card
+ *		void *ring_mem - storage for 2^order records, cache line aligned,
+ *				 kept by the caller until cap_free
+ *		unsigned int order - ring capacity is 2^order records
+ * Returns    : 0
+ * Description: Capture without a writer thread, for a caller that takes the
+ *		records from cap->ring itself (see sym560_lib.c).  Nothing is
+ *		allocated, and nothing is printed from here on (cap->quiet).  There
+ *		is no output file, so cfg->journal and the IO options are ignored;
+ *		cfg->rt still locks memory and pins the capture thread.
+ */
+int cap_init_consumer(struct capture *cap, const struct cap_config *cfg, int devfd, struct sim *sim,
+		void *ring_mem, unsigned int order) {
+	memset(cap, 0, sizeof(*cap));
+	cap->cfg = *cfg;
+	cap->cfg.journal = NULL;
+	cap->devfd = devfd;
+	cap->outfd = -1;
+	cap->idxfd = -1;
+	cap->sim = sim;
+	cap->quiet = 1;
+	cap->ring = &cap->ring_mem;
+	ring_init_mem(cap->ring, order, ring_mem);
+
+	if (cfg->rt && mlockall(MCL_CURRENT|MCL_FUTURE) != 0) {
+		cap->rt_failed |= CAP_RT_MLOCK;
+	}
+	pthread_mutex_init(&cap->mark_lock, NULL);
+	return 0;
+}
+/* end of function: cap_init_consumer */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_rt_isolate
+ * Inputs     : struct capture *cap - capture state set up by cap_init
+ * Returns    : Nothing
+ * Description: Takes rt_cpu out of the calling thread's CPU set.  The writer and
+ *		lock threads (and anything the caller starts later) inherit it, which
+ *		leaves rt_cpu to the capture thread.  Not possible on a single CPU,
+ *		which is noted in rt_failed.
+ */
+static void cap_rt_isolate(struct capture *cap) {
+	cpu_set_t cpus;
+
+	if (cap->cfg.rt_cpu < 0) {
+		return;
+	}
+	if (sched_getaffinity(0, sizeof(cpus), &cpus) != 0) {
+		return;
+	}
+	CPU_CLR(cap->cfg.rt_cpu, &cpus);
+	if (CPU_COUNT(&cpus) == 0 || sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+		cap->rt_failed |= CAP_RT_ISOLATE;
+	}
+}
+/* end of function: cap_rt_isolate */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_create_thread
+ * Inputs     : struct capture *cap - capture state set up by cap_init
+ * Returns    : 0 on success
+ *             -1 on failure
+ * Description: Starts the capture thread.  With the real-time profile it is
+ *		pinned to rt_cpu and runs SCHED_FIFO at rt_prio; if the process is
+ *		not allowed real-time scheduling it is started pinned but with the
+ *		normal policy, with a warning.
+ */
+static int cap_create_thread(struct capture *cap) {
+	pthread_attr_t attr;
+	struct sched_param param;
+	cpu_set_t cpus;
+	int ret;
+
+	if (cap->cfg.rt == 0) {
+		return pthread_create(&cap->cap_thread, NULL, cap_thread_main, cap) == 0 ? 0 : -1;
+	}
+
+	pthread_attr_init(&attr);
+	if (cap->cfg.rt_cpu >= 0) {
+		CPU_ZERO(&cpus);
+		CPU_SET(cap->cfg.rt_cpu, &cpus);
+		pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+	}
+	pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+	param.sched_priority = cap->cfg.rt_prio;
+	pthread_attr_setschedparam(&attr, &param);
+	ret = pthread_create(&cap->cap_thread, &attr, cap_thread_main, cap);
+	if (ret == EPERM) {
+		cap->rt_failed |= CAP_RT_FIFO;
+		pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+		ret = pthread_create(&cap->cap_thread, &attr, cap_thread_main, cap);
+	}
+	pthread_attr_destroy(&attr);
+	return ret == 0 ? 0 : -1;
+}
+/* end of function: cap_create_thread */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_start
+ * Inputs     : struct capture *cap - capture state set up by cap_init
+ * Returns    : 0 on success
+ *             -1 on failure
+ * Description: Enables event interrupts on the card (as event_cap used to) and
+ *		starts the writer and capture threads, plus the lock thread if the
+ *		lock state is being polled.  The lock register is read once here
+ *		so the very first record carries the right state.  The threads are
+ *		created with every signal blocked so that signals sent to the
+ *		process are left to the caller; the capture thread then unblocks
+ *		SIGUSR1 only, and the IO backend is set up under the same mask.  A
+ *		simulated card is always locked.  Without output buffers
+ *		(cap_init_consumer) there is no writer thread.  With the
+ *		real-time profile the caller, and with it every thread other than
+ *		the capture thread, is first moved off rt_cpu.  What of the profile
+ *		could not be applied is left in rt_failed (see cap_print_rt).
+ */
+int cap_start(struct capture *cap) {
+	struct sigaction sa;
+	sigset_t all, old;
+	unsigned char user_buff[4];
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = cap_wakeup;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGUSR1, &sa, NULL);
+
+	cap->lock = REC_LOCK_UNKNOWN;
+	if (cap->sim != NULL) {
+		cap->lock = REC_LOCK_ALL;
+	}
+	else if (cap->cfg.lock_poll_ns != 0) {
+		cap->lock = GPS_lock_status(cap->devfd);
+		if (cap->lock == -1) {
+			cap->lock = REC_LOCK_UNKNOWN;
+		}
+	}
+
+	if (cap->sim == NULL) {
+		/* device IO function that enables PCI card interrupts*/
+		ioctl(cap->devfd, IOCTL_CHECK_INTCSR);
+
+		/* enable event driven interrupts and clear event status bit */
+		user_buff[0] = 0x09;
+		write_pci(cap->devfd, REG_HARD_CTRL, user_buff, 1);
+	}
+
+	if (cap->cfg.rt) {
+		cap_rt_isolate(cap);
+	}
+
+	sigfillset(&all);
+	pthread_sigmask(SIG_BLOCK, &all, &old);
+	if (cap->wrbuff != NULL && io_init(&cap->io, cap->cfg.io_backend) != 0) {
+		pthread_sigmask(SIG_SETMASK, &old, NULL);
+		printf("\nCould not set up output IO\n");
+		return -1;
+	}
+	/* the journal keeps whatever a failed write did not get to the file,
+	 * and jnl_settle needs the file to end where that write began */
+	cap->io.hold = cap->cfg.journal != NULL;
+	if (cap->wrbuff != NULL && pthread_create(&cap->wr_thread, NULL, wr_thread_main, cap) != 0) {
+		io_free(&cap->io);
+		pthread_sigmask(SIG_SETMASK, &old, NULL);
+		printf("\nCould not start the writer thread\n");
+		return -1;
+	}
+	if (cap_create_thread(cap) != 0) {
+		atomic_store(&cap->stop, 1);
+		atomic_store(&cap->cap_done, 1);
+		if (cap->wrbuff != NULL) {
+			pthread_join(cap->wr_thread, NULL);
+			io_free(&cap->io);
+		}
+		pthread_sigmask(SIG_SETMASK, &old, NULL);
+		if (!cap->quiet) {
+			printf("\nCould not start the capture thread\n");
+		}
+		return -1;
+	}
+	if (cap->sim == NULL && cap->cfg.lock_poll_ns != 0) {
+		if (pthread_create(&cap->lock_thread, NULL, lock_thread_main, cap) == 0) {
+			cap->lock_running = 1;
+		}
+		else if (!cap->quiet) {
+			printf("\nCould not start the lock thread, lock state will not be updated\n");
+		}
+	}
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	return 0;
+}
+/* end of function: cap_start */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_stop
+ * Inputs     : struct capture *cap - running capture
+ * Returns    : 0 on success
+ * Description: Disables event interrupts, wakes the capture thread out of the
+ *		ioctl and waits for the writer to drain everything still in the
+ *		ring and for the IO backend to finish writing it out.  SIGUSR1
+ *		is resent until the capture thread has exited in case the first
+ *		one arrived before it went back to sleep.
+ */
+int cap_stop(struct capture *cap) {
+	struct timespec pause = {0, 10000000};
+	unsigned char user_buff[4];
+
+	atomic_store(&cap->stop, 1);
+	if (cap->sim == NULL) {
+		/*disable the interrupt and clear the status bits*/
+		user_buff[0] = 0x01;
+		write_pci(cap->devfd, REG_HARD_CTRL, user_buff, 1);
+	}
+	while (atomic_load(&cap->cap_done) == 0) {
+		pthread_kill(cap->cap_thread, SIGUSR1);
+		nanosleep(&pause, NULL);
+	}
+	pthread_join(cap->cap_thread, NULL);
+	if (cap->wrbuff != NULL) {
+		pthread_join(cap->wr_thread, NULL);
+		io_free(&cap->io);
+	}
+	if (cap->lock_running) {
+		pthread_join(cap->lock_thread, NULL);
+		cap->lock_running = 0;
+	}
+	return 0;
+}
+/* end of function: cap_stop */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_rotate
+ * Inputs     : struct capture *cap - running capture
+ * Returns    : Nothing
+ * Description: Asks the writer to start a new file before it writes the next
+ *		record.  Safe to call from any thread.
+ */
+void cap_rotate(struct capture *cap) {
+	atomic_store_explicit(&cap->rotate_req, 1, memory_order_release);
+}
+/* end of function: cap_rotate */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_mark
+ * Inputs     : struct capture *cap - running capture
+ *		const char *text - description of the change (truncated to
+ *				   REC_MARKER_MAX characters)
+ * Returns    : 0 on success
+ *             -1 if the marker queue is full
+ * Description: Queues an in-band marker stamped with the current UTC time for
+ *		the writer.  Safe to call from any thread.
+ */
+int cap_mark(struct capture *cap, const char *text) {
+	struct cap_marker *mk;
+	struct timespec now;
+	uint64_t head;
+
+	pthread_mutex_lock(&cap->mark_lock);
+	head = atomic_load_explicit(&cap->mark_head, memory_order_relaxed);
+	if (head - atomic_load_explicit(&cap->mark_tail, memory_order_acquire) >= CAP_MARKERS) {
+		pthread_mutex_unlock(&cap->mark_lock);
+		return -1;
+	}
+	mk = &cap->marker[head & (CAP_MARKERS - 1)];
+	clock_gettime(CLOCK_REALTIME, &now);
+	mk->ns = now.tv_sec * 1000000000LL + now.tv_nsec;
+	snprintf(mk->text, sizeof(mk->text), "%s", text);
+	atomic_store_explicit(&cap->mark_head, head + 1, memory_order_release);
+	pthread_mutex_unlock(&cap->mark_lock);
+	return 0;
+}
+/* end of function: cap_mark */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_flush
+ * Inputs     : struct capture *cap - running capture
+ * Returns    : 0 once the writer has written and synced what it has
+ *             -1 if it did not answer within CAP_FLUSH_TIMEOUT_MS
+ * Description: Asks the writer to write out its buffer and fdatasync the
+ *		current file, and waits for the sync to complete.
+ */
+int cap_flush(struct capture *cap) {
+	struct timespec pause = {0, 1000000};
+	uint64_t req;
+	int cnt;
+
+	req = atomic_fetch_add(&cap->flush_req, 1) + 1;
+	for (cnt = 0; cnt < CAP_FLUSH_TIMEOUT_MS; cnt++) {
+		if (atomic_load_explicit(&cap->flush_done, memory_order_acquire) >= req) {
+			return 0;
+		}
+		nanosleep(&pause, NULL);
+	}
+	return -1;
+}
+/* end of function: cap_flush */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_free
+ * Inputs     : struct capture *cap - stopped capture
+ * Returns    : Nothing
+ */
+void cap_free(struct capture *cap) {
+	cap_free_ring(cap);
+	if (cap->wrbuff_maplen != 0) {
+		munmap(cap->wrbuff, cap->wrbuff_maplen);
+		cap->wrbuff_maplen = 0;
+	}
+	else {
+		free(cap->wrbuff);
+	}
+	cap->wrbuff = NULL;
+	if (cap->idxfd != -1) {
+		close(cap->idxfd);
+		cap->idxfd = -1;
+	}
+	free(cap->idx);
+	cap->idx = NULL;
+	if (cap->col != NULL) {
+		col_close(&cap->col->day);
+		free(cap->col);
+		cap->col = NULL;
+	}
+	pthread_mutex_destroy(&cap->mark_lock);
+}
+/* end of function: cap_free */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_print_usage
+ * Inputs     : const struct capture *cap - stopped capture
+ * Returns    : Nothing
+ * Description: Reports the page faults and context switches the capture thread
+ *		took while capturing.  Involuntary switches mean something else was
+ *		given the capture thread's CPU.
+ */
+void cap_print_usage(const struct capture *cap) {
+	printf("Capture thread: %ld minor and %ld major page faults, %ld involuntary and %ld voluntary context switches\n",
+			cap->cap_usage.ru_minflt, cap->cap_usage.ru_majflt,
+			cap->cap_usage.ru_nivcsw, cap->cap_usage.ru_nvcsw);
+}
+/* end of function: cap_print_usage */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_print_io
+ * Inputs     : const struct capture *cap - stopped capture
+ * Returns    : Nothing
+ * Description: Reports what the writer handed to the disk and how often the
+ *		disk held it up.  A stall is one stretch of time with every output
+ *		buffer waiting on the disk; with CAP_IO_DROP_OLDEST events may have
+ *		been dropped during it.
+ */
+void cap_print_io(const struct capture *cap) {
+	printf("Output: %llu writes, %.1f MB, %llu syncs through %s, %llu stalls, %llu events dropped, %llu errors\n",
+			(unsigned long long)cap->io.writes, cap->io.bytes / 1e6,
+			(unsigned long long)cap->io.syncs, io_backend_name(&cap->io),
+			(unsigned long long)cap->stalls, (unsigned long long)cap->dropped,
+			(unsigned long long)cap->io.errors);
+	if (cap->io.failed_write != 0 && cap->cfg.journal != NULL) {
+		printf("Events not written are kept in the journal %s and written on the next start\n",
+				cap->cfg.journal);
+	}
+}
+/* end of function: cap_print_io */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : cap_print_rt
+ * Inputs     : const struct capture *cap - started capture
+ * Returns    : Nothing
+ * Description: Warns about each part of the real-time profile that could not
+ *		be applied.  cap_init and cap_start only note them in rt_failed,
+ *		so that the library can leave them to its caller.
+ */
+void cap_print_rt(const struct capture *cap) {
+	if (cap->rt_failed & CAP_RT_MLOCK) {
+		printf("\nWARNING: could not lock memory\n");
+	}
+	if (cap->rt_failed & CAP_RT_ISOLATE) {
+		printf("\nWARNING: could not keep other threads off CPU %d\n", cap->cfg.rt_cpu);
+	}
+	if (cap->rt_failed & CAP_RT_FIFO) {
+		printf("\nWARNING: not permitted to use SCHED_FIFO, capturing with the normal policy\n");
+	}
+}
+/* end of function: cap_print_rt */
+/*******************************************************************************/
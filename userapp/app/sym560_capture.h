@@ -0,0 +1,173 @@
+/* File : 	sym560_capture.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	In-process event capture.  A capture thread waits on the event
+ *		ioctl and pushes each timestamp into a single producer / single
+ *		consumer ring, and a writer thread drains the ring into the plain text
+ *		output file.  Replaces the old event_cap child process.
+ */
+
+#ifndef SYM560_CAPTURE_H
+#define SYM560_CAPTURE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/resource.h>
+#include "sym560_io.h"
+#include "sym560_journal.h"
+#include "sym560_metrics.h"
+#include "sym560_ring.h"
+#include "sym560_sim.h"
+
+/* ring holds 2^CAP_RING_ORDER records (2 MB, over a minute of pulses at 1 kHz) */
+#define CAP_RING_ORDER	16
+
+/* longest name produced by cap_filename */
+#define CAP_FILENAME_LEN	32
+
+/* the writer formats into CAP_WRBUFS page aligned buffers of CAP_WRBUFF_LEN bytes
+ * and hands each full one to the IO backend (sym560_io.c), so up to
+ * CAP_WRBUFS - 1 buffers can be waiting on the disk while it fills the next */
+#define CAP_WRBUFS	8
+#define CAP_WRBUFF_LEN	(256 * 1024)
+#define CAP_WRBUFF_ALIGN	4096
+
+/* a partly filled buffer is written once it is this old */
+#define CAP_WRITE_DELAY_NS	50000000LL
+
+/* what the writer does when every buffer is still waiting on the disk */
+#define CAP_IO_BLOCK		0	/* wait; once the ring fills new events are dropped */
+#define CAP_IO_DROP_OLDEST	1	/* keep draining the ring, discarding the oldest events */
+
+/* output files are preallocated this far ahead by default */
+#define CAP_PREALLOC	(8 * 1024 * 1024)
+
+/* real-time profile: default SCHED_FIFO priority of the capture thread, how much
+ * of its stack to prefault, and the hugepage size the buffers are rounded to */
+#define CAP_RT_PRIO		50
+#define CAP_STACK_PREFAULT	(64 * 1024)
+#define CAP_HUGEPAGE		(2 * 1024 * 1024)
+
+/* parts of the real-time profile that could not be applied, in cap->rt_failed */
+#define CAP_RT_MLOCK		0x01	/* locking the process's memory */
+#define CAP_RT_ISOLATE		0x02	/* keeping the caller's threads off rt_cpu */
+#define CAP_RT_FIFO		0x04	/* SCHED_FIFO for the capture thread */
+
+/* in-band markers waiting for the writer (a power of 2), and how long the writer
+ * holds one back waiting for an event stamped after it before writing it anyway */
+#define CAP_MARKERS		64
+#define CAP_MARKER_SLACK_NS	1000000000LL
+
+/* an event can reach the writer this long after it was stamped, so the radar
+ * joiner and the tracker finish no sequence it could still belong to until then */
+#define CAP_LATE_NS		200000000LL
+
+/* how long cap_flush waits for the writer */
+#define CAP_FLUSH_TIMEOUT_MS	2000
+
+/* a change made while capturing, written in time order among the events */
+struct cap_marker {
+	int64_t ns;			/* UTC time of the change */
+	char text[REC_MARKER_MAX + 1];
+};
+
+struct stream;
+struct joiner;
+struct tracker;
+struct idx_entry;
+struct col_out;
+
+/* tunables for the automatic mode, see cap_config_default for the defaults */
+struct cap_config {
+	int64_t rotate_ns;		/* start a new file at multiples of this (UTC), 0 = never */
+	int64_t lock_poll_ns;		/* how often to read the GPS lock state, 0 = never */
+	int rt;				/* real-time profile, see cap_init and cap_start */
+	int rt_cpu;			/* CPU reserved for the capture thread, -1 = any */
+	int rt_prio;			/* SCHED_FIFO priority of the capture thread */
+	const char *ctl_path;		/* control socket for autostamp, NULL = none */
+	const char *stream_path;	/* live event stream socket for autostamp, NULL = none */
+	const char *metrics_path;	/* metrics file for autostamp, NULL = none */
+	const char *radar_name;		/* radar control metadata channel for autostamp, NULL = none */
+	const char *tables;		/* pulse tables autostamp finds sequences of, NULL = none */
+	int io_backend;			/* IO_AUTO, IO_URING or IO_THREAD */
+	int io_policy;			/* CAP_IO_BLOCK or CAP_IO_DROP_OLDEST */
+	int64_t sync_ns;		/* fdatasync at most this often, 0 = only on rotation,
+					 * flush and stop, -1 = after every write */
+	int64_t prealloc;		/* preallocate output files this many bytes at a time, 0 = never */
+	const char *journal;		/* journal file holding the ring, NULL = ring in memory */
+	int64_t status_ns;		/* autostamp's status broker sampling interval, 0 = none */
+	int64_t index_ns;		/* autostamp's time index interval (see cap_index), 0 = none */
+	const char *columns;		/* autostamp's column store directory (see cap_columns), NULL = none */
+};
+
+struct capture {
+	struct cap_config cfg;
+	int devfd;			/* /dev/symgps, unused with a simulator */
+	int outfd;			/* plain text output file, owned by the writer once started */
+	int idxfd;			/* its time index, -1 = none, likewise owned by the writer */
+	struct idx_entry *idx;		/* writer only: CAP_WRBUFS slices of IDX_SLICE index entries,
+					 * one for each buffer, NULL without an index */
+	struct col_out *col;		/* writer only: the column store, NULL without one */
+	struct sim *sim;		/* simulated source, NULL to use the card */
+	struct ring *ring;		/* capture thread -> writer thread: ring_mem or the journal's */
+	struct ring ring_mem;
+	struct journal jnl;		/* used if cfg.journal is set */
+	char *wrbuff;			/* CAP_WRBUFS writer output buffers, NULL without a writer */
+	uint64_t wrbuff_seq[CAP_WRBUFS];	/* writer only: IO request writing each buffer + 1, 0 = none */
+	struct wio io;			/* writer's IO backend */
+	_Atomic(struct stream *) stream;	/* live subscribers fed by the writer, see str_start */
+	_Atomic(struct joiner *) radar;	/* radar control metadata joined by the writer, see rad_start */
+	_Atomic(struct tracker *) tracker;	/* sequences found by the writer, see trk_start */
+	size_t ring_maplen;		/* ring storage mapped by cap_init (real-time profile) */
+	size_t wrbuff_maplen;		/* likewise for wrbuff */
+	pthread_t cap_thread;
+	pthread_t wr_thread;
+	pthread_t lock_thread;		/* polls the lock state, see cap_start */
+	int lock_running;
+	_Atomic int stop;		/* set by cap_stop */
+	_Atomic int cap_done;		/* set when the capture thread has exited */
+	_Atomic uint64_t captured;	/* events read from the source */
+	_Atomic uint64_t overflows;	/* events dropped because the ring was full */
+	_Atomic uint64_t written;	/* events formatted for outfd */
+	_Atomic uint64_t dropped;	/* events discarded by CAP_IO_DROP_OLDEST */
+	_Atomic uint64_t stalls;	/* times the writer found every buffer waiting on the disk */
+	struct met_hist met_batch;	/* records per writer batch */
+	struct met_hist met_backlog;	/* records waiting in the ring when the writer takes a batch */
+	struct met_hist met_latency;	/* event time to the writer formatting it, in microseconds */
+	_Atomic int64_t last_ns;	/* time of the last event the writer took */
+	_Atomic int rotate_req;		/* set by cap_rotate, cleared by the writer */
+	_Atomic uint64_t rotations;	/* files started by the writer */
+	_Atomic int lock;		/* REC_LOCK_* state stamped on new records */
+	_Atomic int64_t first_ns;	/* CLOCK_MONOTONIC time of the first event, 0 = none yet */
+	int64_t next_rotate;		/* writer only: UTC ns of the next file boundary */
+	struct cap_marker marker[CAP_MARKERS];	/* cap_mark -> writer queue */
+	_Atomic uint64_t mark_head;	/* next marker slot to fill */
+	_Atomic uint64_t mark_tail;	/* next marker for the writer */
+	pthread_mutex_t mark_lock;	/* serializes cap_mark callers */
+	_Atomic uint64_t flush_req;	/* bumped by cap_flush */
+	_Atomic uint64_t flush_done;	/* last flush_req the writer has completed */
+	struct rusage cap_usage;	/* capture thread faults and context switches while capturing */
+	int rt_failed;			/* CAP_RT_* parts of the real-time profile not applied */
+	int quiet;			/* set by cap_init_consumer: nothing is printed once capturing */
+};
+
+/* function declarations */
+void cap_config_default(struct cap_config *cfg);
+void cap_filename(int64_t ns, char *filename);
+int cap_init(struct capture *cap, const struct cap_config *cfg, int devfd, int outfd, struct sim *sim);
+int cap_init_consumer(struct capture *cap, const struct cap_config *cfg, int devfd, struct sim *sim,
+		void *ring_mem, unsigned int order);
+int cap_index(struct capture *cap, const char *filename);
+int cap_columns(struct capture *cap, const char *dir);
+int cap_start(struct capture *cap);
+int cap_stop(struct capture *cap);
+void cap_rotate(struct capture *cap);
+int cap_mark(struct capture *cap, const char *text);
+int cap_flush(struct capture *cap);
+void cap_free(struct capture *cap);
+void cap_print_usage(const struct capture *cap);
+void cap_print_io(const struct capture *cap);
+void cap_print_rt(const struct capture *cap);
+
+#endif /* SYM560_CAPTURE_H */
@@ -11,28 +11,318 @@
  *		mode, automatic mode, is used to timestamp events without requiring any user
  *		input.  To run in automatic mode, supply the argument "auto".  To stop auto 
  *		mode, the script stopstamp.bash can be used.  Both the automated and manual
- *		timestamping functions make use of the event_cap process which should be 
- *		compiled alongside this application.
+ *		timestamping functions capture events in-process on a dedicated thread
+ *		(see sym560_capture.c).  The other subcommands read or analyse
+ *		timestamp files without opening the device.  "sym560_cmdline help"
+ *		prints the usage of each of them and its options; the user guide
+ *		(documentation/UserGuide.tex) describes them in full.
  */
 
+#include <limits.h>
+
 #include "sym560_functions.h"
+#include "sym560_seq.h"
+#include "sym560_monitor.h"
+#include "sym560_pulses.h"
+#include "sym560_batch.h"
+#include "sym560_convert.h"
+#include "sym560_timing.h"
+#include "sym560_backfill.h"
+#include "sym560_index.h"
+
+/*******************************************************************************/
+/* Function   : usage
+ * Inputs     : None
+ * Returns    : Nothing
+ */
+static void usage(void) {
+	printf("USAGE: sym560_cmdline                     manual mode, menus on the terminal\n");
+	printf("       sym560_cmdline auto [options]      timestamp events until SIGTERM or SIGINT\n");
+	printf("           -r seconds      start a new file at multiples of this (UTC), SIGHUP starts one now\n");
+	printf("           -R cpu          real-time profile with the capture thread on this CPU\n");
+	printf("           -P priority     real-time profile at this SCHED_FIFO priority\n");
+	printf("           -S path         control socket (default %s), \"none\" for none\n", CTL_DEFAULT_PATH);
+	printf("           -y seconds      fdatasync at most this often, -1 after every write\n");
+	printf("           -a MB           preallocate output files this far ahead, 0 for not at all\n");
+	printf("           -W backend      IO backend: uring, thread or auto (the default)\n");
+	printf("           -d              drop the oldest events rather than wait on the disk\n");
+	printf("           -J path         keep events in a journal file until written, e.g. %s\n", JNL_DEFAULT_PATH);
+	printf("           -B seconds      publish the card status this often, 0 for not at all\n");
+	printf("           -L path         live event stream socket (default %s), \"none\" for none\n", STR_DEFAULT_PATH);
+	printf("           -M path         metrics file (default %s), \"none\" for none\n", MET_DEFAULT_PATH);
+	printf("           -C name         join radar control metadata from this channel, usually %s\n", RAD_DEFAULT_NAME);
+	printf("           -Q tables       find the pulse sequences of these tables while capturing\n");
+	printf("           -I seconds      time index entries this far apart, 0 for no index\n");
+	printf("           -D dir          append every event to the column store in dir\n");
+	printf("       sym560_cmdline monitor [-L stream_socket] [-p tables] [-i seconds]\n");
+	printf("           live view of a running automatic mode\n");
+	printf("       sym560_cmdline findpulse [-p tables] [-t tolerance_us] [-o outfile] [-r] inputfile\n");
+	printf("           the compiled findpulse.pl; -r reads 12 byte event times, \"-\" reads stdin\n");
+	printf("       sym560_cmdline batch [-p tables] [-t tolerance_us] [-d outdir] [-j threads] [-c chunk_MB] [-r] inputfile ...\n");
+	printf("           findpulse on many files at once on all cores\n");
+	printf("       sym560_cmdline convert [-f raw|delta|text] [-o outfile] inputfile\n");
+	printf("           a timestamp file as raw event times, compressed blocks or text\n");
+	printf("       sym560_cmdline timing [-m] timingfile ...\n");
+	printf("           timing error quantiles and Allan deviation of YYYYMMDD.timing files, -m by minute\n");
+	printf("       sym560_cmdline backfill [-p tables] [-t tolerance_us] [-d outdir] [-r] [-I index_seconds] [-D column_dir] inputfile ...\n");
+	printf("           timing files, time indexes and column store rows for archived files\n");
+	printf("       sym560_cmdline extract -f YYYY:DDD:HH:MM:SS[.fraction] -t YYYY:DDD:HH:MM:SS[.fraction] [-o outfile] [-r] inputfile ...\n");
+	printf("           the events of a time range, through the time indexes\n");
+	printf("       tables are separated by '/', each a known one (\"katscan\", \"7pulse\") or\n");
+	printf("       [name=]ms,ms,... giving the separations between its pulses, default %s\n", SEQ_DEFAULT_SEPS);
+}
+/* end of function: usage */
+/*******************************************************************************/
+
 
 int main(int argc, char **argv)
 {
 	char ch[30];
-	int fd, ret;
-	char filename[32];	
+	int fd, ret, opt;
+	char filename[CAP_FILENAME_LEN];	
+	struct cap_config cfg;
 	/* Get date and time for the filename */
 	time_t rawtime;
-	struct tm *ptm;
 	time(&rawtime);
-	ptm = gmtime(&rawtime);
-	sprintf(filename, "%04d%02d%02d.%02d%02d.timestampdata",
-			ptm->tm_year+1900,
-			ptm->tm_mon+1,
-			ptm->tm_mday,
-			ptm->tm_hour,
-			ptm->tm_min);
+	cap_filename((int64_t)rawtime * 1000000000LL, filename);
+	
+	if ((argc > 1) && (strcmp(argv[1], "help") == 0 || strcmp(argv[1], "-h") == 0
+			|| strcmp(argv[1], "--help") == 0)) {
+		usage();
+		return 0;
+	}
+	
+	/* the monitor only talks to a running automatic mode, never to the device */
+	if ((argc > 1) && (strcmp(argv[1], "monitor") == 0)) {
+		const char *stream_path = STR_DEFAULT_PATH, *seps = SEQ_DEFAULT_SEPS;
+		double refresh_s = MON_REFRESH_S;
+		
+		optind = 2;
+		while ((opt = getopt(argc, argv, "L:p:i:")) != -1) {
+			switch (opt) {
+				case 'L':
+					stream_path = optarg;
+					break;
+				case 'p':
+					seps = optarg;
+					break;
+				case 'i':
+					refresh_s = atof(optarg);
+					break;
+				default:
+					printf("USAGE: sym560_cmdline monitor [-L stream_socket] [-p tables] [-i seconds]\n");
+					exit(1);
+			}
+		}
+		return monitor(stream_path, seps, refresh_s) == 0 ? 0 : 1;
+	}
+	
+	/* nor does sorting a timestamp file into pulse sequences */
+	if ((argc > 1) && (strcmp(argv[1], "findpulse") == 0)) {
+		const char *seps = SEQ_DEFAULT_SEPS, *outfile = NULL;
+		int64_t tol = SEQ_DEFAULT_TOL_NS;
+		int format = PLS_TEXT;
+		
+		optind = 2;
+		while ((opt = getopt(argc, argv, "p:t:o:r")) != -1) {
+			switch (opt) {
+				case 'p':
+					seps = optarg;
+					break;
+				case 't':
+					tol = (int64_t)(atof(optarg) * 1000);
+					break;
+				case 'o':
+					outfile = optarg;
+					break;
+				case 'r':
+					format = PLS_RAW;
+					break;
+				default:
+					optind = argc;
+			}
+		}
+		if (optind != argc - 1) {
+			printf("USAGE: sym560_cmdline findpulse [-p tables] [-t tolerance_us] [-o outfile] [-r] inputfile\n");
+			exit(1);
+		}
+		return findpulse(argv[optind], outfile, format, seps, tol) == 0 ? 0 : 1;
+	}
+	
+	/* or a whole archive of them */
+	if ((argc > 1) && (strcmp(argv[1], "batch") == 0)) {
+		const char *seps = SEQ_DEFAULT_SEPS, *outdir = ".";
+		int64_t tol = SEQ_DEFAULT_TOL_NS;
+		int format = PLS_TEXT, threads = 0;
+		long chunk = BAT_CHUNK;
+		
+		optind = 2;
+		while ((opt = getopt(argc, argv, "p:t:d:j:c:r")) != -1) {
+			switch (opt) {
+				case 'p':
+					seps = optarg;
+					break;
+				case 't':
+					tol = (int64_t)(atof(optarg) * 1000);
+					break;
+				case 'd':
+					outdir = optarg;
+					break;
+				case 'j':
+					threads = atoi(optarg);
+					break;
+				case 'c':
+					chunk = (long)(atof(optarg) * (1 << 20));
+					break;
+				case 'r':
+					format = PLS_RAW;
+					break;
+				default:
+					optind = argc;
+			}
+		}
+		if (optind >= argc) {
+			printf("USAGE: sym560_cmdline batch [-p tables] [-t tolerance_us] [-d outdir] [-j threads] [-c chunk_MB] [-r] inputfile ...\n");
+			exit(1);
+		}
+		return batch(&argv[optind], argc - optind, outdir, format, seps, tol, threads, chunk) == 0 ? 0 : 1;
+	}
+	
+	/* or converting one to raw event times, compressed blocks or text */
+	if ((argc > 1) && (strcmp(argv[1], "convert") == 0)) {
+		const char *outfile = NULL, *suffix[] = {"raw", "dlt", "txt"};
+		char outname[PATH_MAX];
+		int format = CONV_RAW;
+		
+		optind = 2;
+		while ((opt = getopt(argc, argv, "o:f:")) != -1) {
+			switch (opt) {
+				case 'o':
+					outfile = optarg;
+					break;
+				case 'f':
+					if (strcmp(optarg, "raw") == 0) {
+						format = CONV_RAW;
+					}
+					else if (strcmp(optarg, "delta") == 0) {
+						format = CONV_DELTA;
+					}
+					else if (strcmp(optarg, "text") == 0) {
+						format = CONV_TEXT;
+					}
+					else {
+						optind = argc;
+					}
+					break;
+				default:
+					optind = argc;
+			}
+		}
+		if (optind != argc - 1) {
+			printf("USAGE: sym560_cmdline convert [-f raw|delta|text] [-o outfile] inputfile\n");
+			exit(1);
+		}
+		if (outfile == NULL) {
+			snprintf(outname, sizeof(outname), "%s.%s", argv[optind], suffix[format]);
+			outfile = outname;
+		}
+		return convert(argv[optind], outfile, format) == 0 ? 0 : 1;
+	}
+	
+	/* or reading back the timing histograms of the automatic mode */
+	if ((argc > 1) && (strcmp(argv[1], "timing") == 0)) {
+		int minutes = 0;
+		
+		optind = 2;
+		while ((opt = getopt(argc, argv, "m")) != -1) {
+			switch (opt) {
+				case 'm':
+					minutes = 1;
+					break;
+				default:
+					optind = argc;
+			}
+		}
+		if (optind >= argc) {
+			printf("USAGE: sym560_cmdline timing [-m] timingfile ...\n");
+			exit(1);
+		}
+		return timing(&argv[optind], argc - optind, minutes) == 0 ? 0 : 1;
+	}
+	
+	/* or making them for an archive captured without them */
+	if ((argc > 1) && (strcmp(argv[1], "backfill") == 0)) {
+		const char *seps = SEQ_DEFAULT_SEPS, *outdir = ".", *coldir = NULL;
+		int64_t tol = SEQ_DEFAULT_TOL_NS, index_ns = IDX_DEFAULT_INTERVAL_NS;
+		int format = PLS_TEXT;
+		
+		optind = 2;
+		while ((opt = getopt(argc, argv, "p:t:d:rI:D:")) != -1) {
+			switch (opt) {
+				case 'p':
+					seps = strcmp(optarg, "none") == 0 ? NULL : optarg;
+					break;
+				case 't':
+					tol = (int64_t)(atof(optarg) * 1000);
+					break;
+				case 'd':
+					outdir = optarg;
+					break;
+				case 'r':
+					format = PLS_RAW;
+					break;
+				case 'I':
+					index_ns = (int64_t)(atof(optarg) * 1e9);
+					break;
+				case 'D':
+					coldir = optarg;
+					break;
+				default:
+					optind = argc;
+			}
+		}
+		if (optind >= argc) {
+			printf("USAGE: sym560_cmdline backfill [-p tables] [-t tolerance_us] [-d outdir] [-r] [-I index_seconds] [-D column_dir] inputfile ...\n");
+			exit(1);
+		}
+		return backfill(&argv[optind], argc - optind, outdir, format, seps, tol, index_ns, coldir) == 0 ? 0 : 1;
+	}
+	
+	/* or reading a time range out of them */
+	if ((argc > 1) && (strcmp(argv[1], "extract") == 0)) {
+		const char *outfile = "-";
+		int64_t from = -1, to = -1;
+		int format = PLS_TEXT;
+		
+		optind = 2;
+		while ((opt = getopt(argc, argv, "f:t:o:r")) != -1) {
+			switch (opt) {
+				case 'f':
+					if (idx_parse_time(optarg, &from) != 0) {
+						optind = argc;
+					}
+					break;
+				case 't':
+					if (idx_parse_time(optarg, &to) != 0) {
+						optind = argc;
+					}
+					break;
+				case 'o':
+					outfile = optarg;
+					break;
+				case 'r':
+					format = PLS_RAW;
+					break;
+				default:
+					optind = argc;
+			}
+		}
+		if (optind >= argc || from < 0 || to < 0) {
+			printf("USAGE: sym560_cmdline extract -f YYYY:DDD:HH:MM:SS[.fraction] -t YYYY:DDD:HH:MM:SS[.fraction] [-o outfile] [-r] inputfile ...\n");
+			exit(1);
+		}
+		return extract(&argv[optind], argc - optind, format, from, to, outfile) == 0 ? 0 : 1;
+	}
 	
 	/* open the device for read and write */
 	fd = open("/dev/symgps", O_RDWR);
@@ -43,7 +333,105 @@ int main(int argc, char **argv)
 	
 	/* check command line arguments and if the first one is "auto" then call the auto function */
 	if ((argc > 1) && (strcmp(argv[1],"auto") == 0)) {
-		autostamp(fd, filename);
+		/* options following "auto" */
+		cap_config_default(&cfg);
+		cfg.ctl_path = CTL_DEFAULT_PATH;
+		cfg.status_ns = STAT_DEFAULT_NS;
+		cfg.stream_path = STR_DEFAULT_PATH;
+		cfg.metrics_path = MET_DEFAULT_PATH;
+		cfg.index_ns = IDX_DEFAULT_INTERVAL_NS;
+		optind = 2;
+		while ((opt = getopt(argc, argv, "r:R:P:S:y:a:W:dJ:B:L:M:C:Q:I:D:")) != -1) {
+			switch (opt) {
+				case 'r':
+					/* start a new file every so many seconds (UTC aligned) */
+					cfg.rotate_ns = (int64_t)(atof(optarg) * 1e9);
+					break;
+				case 'R':
+					/* real-time profile with the capture thread on this CPU */
+					cfg.rt = 1;
+					cfg.rt_cpu = atoi(optarg);
+					break;
+				case 'P':
+					/* real-time profile at this SCHED_FIFO priority */
+					cfg.rt = 1;
+					cfg.rt_prio = atoi(optarg);
+					break;
+				case 'S':
+					/* control socket path, "none" for no socket */
+					cfg.ctl_path = strcmp(optarg, "none") == 0 ? NULL : optarg;
+					break;
+				case 'y':
+					/* fdatasync at most this often, -1 after every write */
+					cfg.sync_ns = atof(optarg) < 0 ? -1 : (int64_t)(atof(optarg) * 1e9);
+					break;
+				case 'a':
+					/* preallocate output files this many MB at a time */
+					cfg.prealloc = (int64_t)(atof(optarg) * 1024 * 1024);
+					break;
+				case 'W':
+					/* IO backend */
+					if (strcmp(optarg, "uring") == 0) {
+						cfg.io_backend = IO_URING;
+					}
+					else if (strcmp(optarg, "thread") == 0) {
+						cfg.io_backend = IO_THREAD;
+					}
+					else if (strcmp(optarg, "auto") == 0) {
+						cfg.io_backend = IO_AUTO;
+					}
+					else {
+						printf("\nUnknown IO backend %s, use uring, thread or auto\n", optarg);
+						close(fd);
+						exit(1);
+					}
+					break;
+				case 'd':
+					/* drop the oldest events rather than wait on the disk */
+					cfg.io_policy = CAP_IO_DROP_OLDEST;
+					break;
+				case 'J':
+					/* journal file, "none" for no journal (the default) */
+					cfg.journal = strcmp(optarg, "none") == 0 ? NULL : optarg;
+					break;
+				case 'B':
+					/* publish the card status this often, 0 for not at all */
+					cfg.status_ns = (int64_t)(atof(optarg) * 1e9);
+					break;
+				case 'L':
+					/* live event stream socket path, "none" for no stream */
+					cfg.stream_path = strcmp(optarg, "none") == 0 ? NULL : optarg;
+					break;
+				case 'M':
+					/* metrics file, "none" for no metrics */
+					cfg.metrics_path = strcmp(optarg, "none") == 0 ? NULL : optarg;
+					break;
+				case 'C':
+					/* radar control metadata channel, "none" for no channel (the default) */
+					cfg.radar_name = strcmp(optarg, "none") == 0 ? NULL : optarg;
+					break;
+				case 'Q':
+					/* pulse tables to find sequences of, "none" for none */
+					cfg.tables = strcmp(optarg, "none") == 0 ? NULL : optarg;
+					break;
+				case 'I':
+					/* time index entries this far apart, 0 for no index */
+					cfg.index_ns = (int64_t)(atof(optarg) * 1e9);
+					break;
+				case 'D':
+					/* column store directory */
+					cfg.columns = optarg;
+					break;
+				default:
+					printf("USAGE: sym560_cmdline auto [-r rotate_seconds] [-R rt_cpu] [-P rt_priority] [-S control_socket]\n"
+						"                          [-y sync_seconds] [-a prealloc_MB] [-W uring|thread|auto] [-d] [-J journal]\n"
+						"                          [-B status_seconds] [-L stream_socket] [-M metrics_file]\n"
+						"                          [-C radar_channel] [-Q tables] [-I index_seconds] [-D column_dir]\n");
+					close(fd);
+					exit(1);
+			}
+		}
+		autostamp(fd, filename, &cfg);
 		close(fd);
 		/* Do not call findpulse.pl automatically here, do it in cron or something */
 		/* execl("/usr/bin/findpulse.pl", "findpulse", "auto", filename, NULL); */
@@ -0,0 +1,394 @@
+/* File : 	sym560_column.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Column store of the events (see sym560_column.h): opening a
+ *		day to append to, the rows held back for the detector, and
+ *		mapping a day to read it.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sym560_column.h"
+
+/* names and types of the columns, in schema order */
+static const char *col_names[COL_NCOL] = {"time", "flags", "seq"};
+static const char *col_types[COL_NCOL] = {"i8", "u4", "u4"};
+static const uint32_t col_sizes[COL_NCOL] = {8, 4, 4};
+
+/*******************************************************************************/
+/* Function   : col_dayname
+ * Inputs     : int64_t ns - UTC time in nanoseconds
+ *		char *name - buffer of at least COL_DAYNAME_LEN bytes
+ * Returns    : Nothing
+ * Description: Names day directories YYYYMMDD, as the timing files.
+ */
+void col_dayname(int64_t ns, char *name) {
+	time_t rawtime = ns / 1000000000LL;
+	struct tm tm;
+
+	gmtime_r(&rawtime, &tm);
+	sprintf(name, "%04d%02d%02d", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+}
+/* end of function: col_dayname */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : col_schema
+ * Inputs     : const char *path - the day's schema file
+ *		int64_t day_ns - UTC start of the day
+ * Returns    : 0 if it is there or has been written
+ *             -1 if it cannot be written or is not this version's
+ * Description: One shorter than a schema, as a crash while writing it
+ *		would leave, is written again.
+ */
+static int col_schema(const char *path, int64_t day_ns) {
+	struct col_schema sch, old;
+	ssize_t got;
+	int fd, c;
+
+	memset(&sch, 0, sizeof(sch));
+	sch.magic = COL_MAGIC;
+	sch.version = COL_VERSION;
+	sch.ncol = COL_NCOL;
+	sch.day_ns = day_ns;
+	for (c = 0; c < COL_NCOL; c++) {
+		strcpy(sch.col[c].name, col_names[c]);
+		/* numpy's byte order mark */
+		sch.col[c].dtype[0] = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ ? '<' : '>';
+		strcpy(sch.col[c].dtype + 1, col_types[c]);
+		sch.col[c].size = col_sizes[c];
+	}
+
+	fd = open(path, O_RDWR|O_CREAT, 00644);
+	if (fd == -1) {
+		return -1;
+	}
+	got = pread(fd, &old, sizeof(old), 0);
+	/* new, or cut short by a crash while it was being written */
+	if (got >= 0 && got < (ssize_t)sizeof(old)) {
+		got = pwrite(fd, &sch, sizeof(sch), 0);
+		old = sch;
+	}
+	close(fd);
+	if (got != (ssize_t)sizeof(old)) {
+		return -1;
+	}
+	return memcmp(&old, &sch, sizeof(sch)) == 0 ? 0 : -1;
+}
+/* end of function: col_schema */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : col_last_seq
+ * Inputs     : int fd - the seq column
+ *		uint64_t rows - rows in it
+ * Returns    : The last sequence id in it, 0 if none
+ * Description: Reads back from the end a block at a time until it finds one.
+ */
+static uint32_t col_last_seq(int fd, uint64_t rows) {
+	uint32_t seq[4096];
+	uint64_t n;
+
+	while (rows > 0) {
+		n = rows < 4096 ? rows : 4096;
+		rows -= n;
+		if (pread(fd, seq, n * sizeof(*seq), rows * sizeof(*seq)) != (ssize_t)(n * sizeof(*seq))) {
+			return 0;
+		}
+		while (n > 0) {
+			if (seq[--n] != 0) {
+				return seq[n];
+			}
+		}
+	}
+	return 0;
+}
+/* end of function: col_last_seq */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : col_open
+ * Inputs     : struct col_day *d - day to open
+ *		const char *dir - the store
+ *		int64_t ns - UTC time of the first row going in, ns
+ * Returns    : 0 on success
+ *             -1 if the day could not be opened, leaving d with its day set
+ *		and no files open
+ * Description: Makes the day's directory and schema if they are new.  Rows
+ *		appended before are kept, cut back to the shortest column, and
+ *		the sequence ids carry on from the last of them.
+ */
+int col_open(struct col_day *d, const char *dir, int64_t ns) {
+	char name[COL_DAYNAME_LEN], path[PATH_MAX];
+	struct stat st;
+	uint64_t rows = UINT64_MAX;
+	int c, ok = 1;
+
+	for (c = 0; c < COL_NCOL; c++) {
+		d->fd[c] = -1;
+	}
+	d->day = ns / COL_DAY_NS;
+	d->rows = 0;
+	d->seq_id = 0;
+	d->last_tag = 0;
+
+	col_dayname(ns, name);
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	if (mkdir(path, 00755) != 0 && errno != EEXIST) {
+		return -1;
+	}
+	snprintf(path, sizeof(path), "%s/%s/schema", dir, name);
+	if (col_schema(path, d->day * COL_DAY_NS) != 0) {
+		return -1;
+	}
+	for (c = 0; c < COL_NCOL && ok; c++) {
+		snprintf(path, sizeof(path), "%s/%s/%s", dir, name, col_names[c]);
+		d->fd[c] = open(path, O_RDWR|O_CREAT|O_APPEND, 00644);
+		ok = d->fd[c] != -1 && fstat(d->fd[c], &st) == 0;
+		if (ok && (uint64_t)st.st_size / col_sizes[c] < rows) {
+			rows = st.st_size / col_sizes[c];
+		}
+	}
+	for (c = 0; c < COL_NCOL && ok; c++) {
+		ok = ftruncate(d->fd[c], rows * col_sizes[c]) == 0;
+	}
+	if (!ok) {
+		col_close(d);
+		return -1;
+	}
+	d->rows = rows;
+	d->seq_id = col_last_seq(d->fd[COL_SEQ], rows);
+	return 0;
+}
+/* end of function: col_open */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : col_close
+ * Inputs     : struct col_day *d - day
+ * Returns    : Nothing
+ */
+void col_close(struct col_day *d) {
+	int c;
+
+	for (c = 0; c < COL_NCOL; c++) {
+		if (d->fd[c] != -1) {
+			close(d->fd[c]);
+			d->fd[c] = -1;
+		}
+	}
+}
+/* end of function: col_close */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : col_seq_id
+ * Inputs     : struct col_day *d - day the row goes into
+ *		uint64_t tag - the row's col_pend tag
+ * Returns    : Its sequence id, 0 for none
+ * Description: The rows of a sequence are written one after another, so a
+ *		tag not seen just before is the day's next sequence.
+ */
+uint32_t col_seq_id(struct col_day *d, uint64_t tag) {
+	if (tag == 0) {
+		return 0;
+	}
+	if (tag != d->last_tag) {
+		d->last_tag = tag;
+		d->seq_id++;
+	}
+	return d->seq_id;
+}
+/* end of function: col_seq_id */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : col_pend_add
+ * Inputs     : struct col_pend *p - rows held back
+ *		int64_t ns - time of the next event
+ *		uint32_t flags - its REC_LOCK_* state
+ * Returns    : 0 on success
+ *             -1 if every row is taken, leaving the event out
+ * Description: Callers make room first by taking rows off with col_pend_next,
+ *		which gives up the oldest once every row is taken, so no event
+ *		is left out.
+ */
+int col_pend_add(struct col_pend *p, int64_t ns, uint32_t flags) {
+	struct col_row *r;
+
+	if (p->head - p->tail == COL_PENDING) {
+		return -1;
+	}
+	r = &p->row[p->head++ % COL_PENDING];
+	r->ns = ns;
+	r->flags = flags & COL_LOCK_MASK;
+	r->tag = 0;
+	return 0;
+}
+/* end of function: col_pend_add */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : col_pend_tag
+ * Inputs     : struct col_pend *p - rows held back
+ *		const struct seq_result *seq - a sequence the detector finished
+ * Returns    : Nothing
+ * Description: Marks the rows of its pulses with its pulse numbers and a
+ *		new tag.  The pulses and rows are both in time order, so one pass
+ *		finds them.
+ */
+void col_pend_tag(struct col_pend *p, const struct seq_result *seq) {
+	struct col_row *r;
+	uint64_t i = p->tail;
+	uint32_t flags;
+	int k;
+
+	p->tags++;
+	flags = (seq->table << COL_TABLE_SHIFT) & COL_TABLE_MASK;
+	if (seq->found == seq->npulse) {
+		flags |= COL_COMPLETE;
+	}
+	for (k = 0; k < seq->npulse; k++) {
+		if (!(seq->present & (1U << k))) {
+			continue;
+		}
+		for (; i != p->head; i++) {
+			r = &p->row[i % COL_PENDING];
+			if (r->ns >= seq->ns[k] && r->tag == 0) {
+				break;
+			}
+		}
+		if (i == p->head) {
+			return;
+		}
+		if (r->ns == seq->ns[k]) {
+			r->flags |= flags | (k + 1) << COL_PULSE_SHIFT;
+			r->tag = p->tags;
+			i++;
+		}
+	}
+}
+/* end of function: col_pend_tag */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : col_pend_next
+ * Inputs     : const struct col_pend *p - rows held back
+ *		int64_t upto - the detector may still need rows from this time
+ *			       on, INT64_MAX if none
+ * Returns    : The oldest row, if it is earlier than upto or every row is
+ *		taken, otherwise NULL
+ * Description: The row stays until col_pend_pop.
+ */
+const struct col_row *col_pend_next(const struct col_pend *p, int64_t upto) {
+	const struct col_row *r;
+
+	if (p->head == p->tail) {
+		return NULL;
+	}
+	r = &p->row[p->tail % COL_PENDING];
+	return r->ns < upto || p->head - p->tail == COL_PENDING ? r : NULL;
+}
+/* end of function: col_pend_next */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : col_pend_pop
+ * Inputs     : struct col_pend *p - rows held back
+ * Returns    : Nothing
+ * Description: Lets go of the row col_pend_next returned.
+ */
+void col_pend_pop(struct col_pend *p) {
+	p->tail++;
+}
+/* end of function: col_pend_pop */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : col_map
+ * Inputs     : const char *daydir - a day's directory, dir/YYYYMMDD
+ *		struct col_view *v - receives its columns
+ * Returns    : 0 on success
+ *             -1 if it is not a day of this version's store
+ * Description: Maps each column read only.  The rows are those every
+ *		column has; one still being appended to may have more.
+ */
+int col_map(const char *daydir, struct col_view *v) {
+	char path[PATH_MAX];
+	struct col_schema sch;
+	struct stat st;
+	int fd, c, ok;
+
+	memset(v, 0, sizeof(*v));
+	snprintf(path, sizeof(path), "%s/schema", daydir);
+	fd = open(path, O_RDONLY);
+	ok = fd != -1 && read(fd, &sch, sizeof(sch)) == sizeof(sch) && sch.magic == COL_MAGIC
+		&& sch.version == COL_VERSION && sch.ncol == COL_NCOL;
+	if (fd != -1) {
+		close(fd);
+	}
+	v->rows = UINT64_MAX;
+	for (c = 0; c < COL_NCOL && ok; c++) {
+		snprintf(path, sizeof(path), "%s/%s", daydir, col_names[c]);
+		fd = open(path, O_RDONLY);
+		ok = fd != -1 && fstat(fd, &st) == 0;
+		if (ok && st.st_size > 0) {
+			v->map[c] = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+			ok = v->map[c] != MAP_FAILED;
+			v->len[c] = ok ? st.st_size : 0;
+			v->map[c] = ok ? v->map[c] : NULL;
+		}
+		if (ok && (uint64_t)st.st_size / col_sizes[c] < v->rows) {
+			v->rows = st.st_size / col_sizes[c];
+		}
+		if (fd != -1) {
+			close(fd);
+		}
+	}
+	if (!ok) {
+		col_unmap(v);
+		return -1;
+	}
+	v->ns = v->map[COL_TIME];
+	v->flags = v->map[COL_FLAGS];
+	v->seq = v->map[COL_SEQ];
+	return 0;
+}
+/* end of function: col_map */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : col_unmap
+ * Inputs     : struct col_view *v - mapped day
+ * Returns    : Nothing
+ */
+void col_unmap(struct col_view *v) {
+	int c;
+
+	for (c = 0; c < COL_NCOL; c++) {
+		if (v->map[c] != NULL) {
+			munmap(v->map[c], v->len[c]);
+		}
+	}
+	memset(v, 0, sizeof(*v));
+}
+/* end of function: col_unmap */
+/*******************************************************************************/
@@ -0,0 +1,135 @@
+/* File : 	sym560_column.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Column store of the events, one directory per UTC day, for
+ *		analysis over months without parsing any text.  Each day's
+ *		directory dir/YYYYMMDD holds a 64 byte schema and one file per
+ *		column, every file a plain array in host byte order with a row per
+ *		event, in capture order:
+ *
+ *		    time	int64	UTC time, ns
+ *		    flags	uint32	COL_* bits below
+ *		    seq		uint32	the day's sequence the event is a pulse of,
+ *					counting from 1, 0 for none
+ *
+ *		so numpy.memmap("dir/YYYYMMDD/time", dtype="<i8") or a mmap from
+ *		C++ reads them as they are.  The files are only ever appended to,
+ *		row by row in the same order, so a reader may map them while they
+ *		grow; one that was cut short (by a crash) may be longer than the
+ *		others, and col_open cuts them all back to the shortest.
+ *
+ *		The automatic mode's writer adds the rows (see cap_columns) and
+ *		"sym560_cmdline backfill -D" those of archived timestamp files.
+ *		With a tracker, an event is held back until the detector has
+ *		finished every sequence it could still be a pulse of, so that it
+ *		is written with its sequence and pulse number.
+ */
+
+#ifndef SYM560_COLUMN_H
+#define SYM560_COLUMN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sym560_seq.h"
+
+/* schema, in host byte order */
+#define COL_MAGIC		0x43594d53	/* "SYMC" */
+#define COL_VERSION		1
+
+/* the columns, in the order of the schema */
+#define COL_NCOL		3
+#define COL_TIME		0
+#define COL_FLAGS		1
+#define COL_SEQ			2
+
+/* flags */
+#define COL_LOCK_MASK		0x000000ff	/* REC_LOCK_* state of the event */
+#define COL_PULSE_SHIFT		8		/* pulse of its sequence, from 1, 0 = none */
+#define COL_PULSE_MASK		0x0000ff00
+#define COL_TABLE_SHIFT		16		/* pulse table of its sequence */
+#define COL_TABLE_MASK		0x000f0000
+#define COL_COMPLETE		0x00100000	/* its sequence has every pulse */
+
+#define COL_DAY_NS		86400000000000LL
+
+/* longest name produced by col_dayname */
+#define COL_DAYNAME_LEN		16
+
+/* rows held back for the detector; with all of them taken col_pend_next hands
+ * over the oldest, which is written without its sequence if it is still
+ * being found */
+#define COL_PENDING		4096
+
+/* rows the writer keeps for each of its buffers, a buffer is written early
+ * rather than take more */
+#define COL_SLICE		4096
+
+/* one column, as numpy names its type */
+struct col_desc {
+	char name[8];
+	char dtype[4];			/* e.g. "<i8" */
+	uint32_t size;			/* bytes a row */
+};
+
+/* dir/YYYYMMDD/schema */
+struct col_schema {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t ncol;
+	int64_t day_ns;			/* UTC start of the day */
+	struct col_desc col[COL_NCOL];
+};
+
+/* a day being appended to */
+struct col_day {
+	int fd[COL_NCOL];		/* -1 if not open */
+	int64_t day;			/* UTC ns / COL_DAY_NS, -1 = none */
+	uint64_t rows;			/* in the files when opened */
+	uint32_t seq_id;		/* last sequence id given */
+	uint64_t last_tag;		/* col_pend tag it was given for */
+};
+
+/* an event waiting for the detector */
+struct col_row {
+	int64_t ns;
+	uint32_t flags;
+	uint64_t tag;			/* its sequence in col_pend order, 0 = none */
+};
+
+struct col_pend {
+	struct col_row row[COL_PENDING];
+	uint64_t head;			/* next row to fill */
+	uint64_t tail;			/* oldest row */
+	uint64_t tags;			/* sequences tagged */
+};
+
+/* the rows of one writer buffer, a column at a time */
+struct col_slice {
+	int64_t ns[COL_SLICE];
+	uint32_t flags[COL_SLICE];
+	uint32_t seq[COL_SLICE];
+};
+
+/* a day mapped for reading */
+struct col_view {
+	const int64_t *ns;
+	const uint32_t *flags;
+	const uint32_t *seq;
+	uint64_t rows;
+	void *map[COL_NCOL];
+	size_t len[COL_NCOL];
+};
+
+/* function declarations */
+void col_dayname(int64_t ns, char *name);
+int col_open(struct col_day *d, const char *dir, int64_t ns);
+void col_close(struct col_day *d);
+uint32_t col_seq_id(struct col_day *d, uint64_t tag);
+int col_pend_add(struct col_pend *p, int64_t ns, uint32_t flags);
+void col_pend_tag(struct col_pend *p, const struct seq_result *seq);
+const struct col_row *col_pend_next(const struct col_pend *p, int64_t upto);
+void col_pend_pop(struct col_pend *p);
+int col_map(const char *daydir, struct col_view *v);
+void col_unmap(struct col_view *v);
+
+#endif /* SYM560_COLUMN_H */
@@ -0,0 +1,356 @@
+/* File : 	sym560_control.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Control socket thread for the automatic mode.  The protocol is
+ *		one command per line, each answered with a single line starting
+ *		"OK" or "ERR", so it can be driven by hand, e.g.
+ *
+ *		    echo status | socat - UNIX-CONNECT:/tmp/sym560.ctl
+ *
+ *		Commands:
+ *		    status	capture counters and lock state, and with a tracker
+ *				(see sym560_tracker.c) the sequences found so far
+ *		    setup	current event source and trigger edge (ev_view_setup)
+ *		    source N	event source, numbered as in the ev_source menu (1-8)
+ *		    rate N	rate generator rate, numbered as in the rg_rate menu (1-10)
+ *		    rgenable	route the rate generator to CODE OUT and turn it on
+ *		    rotate	start a new output file at the next event
+ *		    flush	write out and sync everything captured so far
+ *		    help	list the commands
+ *
+ *		Changes to the card are made from this thread while the capture
+ *		thread carries on waiting for events, and each one is written into
+ *		the output as a MARKER line among the events around it.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include "sym560_functions.h"
+#include "sym560_control.h"
+
+/* rates in the order of the rg_rate menu */
+static const char *ctl_rates[] = {
+	"DISABLED", "1 PPS", "10 PPS", "100 PPS", "1K PPS", "10K PPS",
+	"100K PPS", "1M PPS", "5M PPS", "10M PPS"
+};
+
+/*******************************************************************************/
+/* Function   : ctl_reply
+ * Inputs     : int sock - client socket
+ *		const char *reply - line to send, including the newline
+ * Returns    : Nothing
+ * Description: MSG_NOSIGNAL so that a client hanging up does not raise SIGPIPE
+ *		in the daemon.
+ */
+static void ctl_reply(int sock, const char *reply) {
+	send(sock, reply, strlen(reply), MSG_NOSIGNAL);
+}
+/* end of function: ctl_reply */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : ctl_change
+ * Inputs     : struct control *ctl - control state
+ *		const char *text - description of the change just made
+ *		char *reply - receives the reply line
+ * Returns    : Nothing
+ * Description: Records a change in the output stream and the daemon's log.
+ */
+static void ctl_change(struct control *ctl, const char *text, char *reply) {
+	if (cap_mark(ctl->cap, text) == 0) {
+		sprintf(reply, "OK %s\n", text);
+	}
+	else {
+		sprintf(reply, "OK %s (marker queue full, not recorded in the output)\n", text);
+	}
+	printf("\nControl: %s\n", text);
+	fflush(stdout);
+}
+/* end of function: ctl_change */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : ctl_command
+ * Inputs     : struct control *ctl - control state
+ *		char *cmd - one command line, without the newline
+ *		char *reply - buffer of at least 2 * CTL_LINE_MAX bytes for the reply
+ * Returns    : Nothing
+ */
+static void ctl_command(struct control *ctl, char *cmd, char *reply) {
+	struct capture *cap = ctl->cap;
+	char word[16], event[25], edge[10], text[REC_MARKER_MAX + 1];
+	struct tracker *trk;
+	int num = 0, args, len;
+
+	args = sscanf(cmd, "%15s %d", word, &num);
+	if (args < 1) {
+		strcpy(reply, "ERR empty command\n");
+		return;
+	}
+	atomic_fetch_add(&ctl->commands, 1);
+
+	if (strcmp(word, "status") == 0) {
+		len = sprintf(reply, "OK captured=%llu written=%llu dropped=%llu rotations=%llu lock=0x%02x",
+				(unsigned long long)cap->captured, (unsigned long long)cap->written,
+				(unsigned long long)(cap->overflows + cap->dropped), (unsigned long long)cap->rotations,
+				atomic_load(&cap->lock));
+		trk = atomic_load_explicit(&cap->tracker, memory_order_acquire);
+		if (trk != NULL) {
+			len += sprintf(reply + len, " sequences=%llu complete=%llu missing=%llu strays=%llu",
+					(unsigned long long)trk->sequences, (unsigned long long)trk->complete,
+					(unsigned long long)trk->missing, (unsigned long long)trk->strays);
+		}
+		strcpy(reply + len, "\n");
+	}
+	else if (strcmp(word, "setup") == 0) {
+		if (ev_get_setup(ctl->devfd, event, edge) == -1) {
+			strcpy(reply, "ERR could not read the card\n");
+			return;
+		}
+		sprintf(reply, "OK source=%s edge=%s\n", event, edge);
+	}
+	else if (strcmp(word, "source") == 0) {
+		if (args != 2 || num < 1 || num > 8) {
+			strcpy(reply, "ERR usage: source 1-8\n");
+			return;
+		}
+		if (ev_set_source(ctl->devfd, num) == -1
+				|| ev_get_setup(ctl->devfd, event, edge) == -1) {
+			strcpy(reply, "ERR could not write to the card, event source not changed\n");
+			return;
+		}
+		sprintf(text, "event source set to %s, %s edge", event, edge);
+		ctl_change(ctl, text, reply);
+	}
+	else if (strcmp(word, "rate") == 0) {
+		if (args != 2 || num < 1 || num > 10) {
+			strcpy(reply, "ERR usage: rate 1-10\n");
+			return;
+		}
+		if (rg_set_rate(ctl->devfd, num) == -1) {
+			strcpy(reply, "ERR could not write to the card, rate not changed\n");
+			return;
+		}
+		sprintf(text, "rate generator set to %s", ctl_rates[num - 1]);
+		ctl_change(ctl, text, reply);
+	}
+	else if (strcmp(word, "rgenable") == 0) {
+		if (ctl->devfd == -1) {
+			strcpy(reply, "ERR no card\n");
+			return;
+		}
+		rg_enable(ctl->devfd);
+		ctl_change(ctl, "rate generator output enabled on CODE OUT", reply);
+	}
+	else if (strcmp(word, "rotate") == 0) {
+		cap_rotate(cap);
+		strcpy(reply, "OK new file at the next event\n");
+	}
+	else if (strcmp(word, "flush") == 0) {
+		if (cap_flush(cap) == 0) {
+			sprintf(reply, "OK written=%llu\n", (unsigned long long)cap->written);
+		}
+		else {
+			strcpy(reply, "ERR writer did not answer\n");
+		}
+	}
+	else if (strcmp(word, "help") == 0) {
+		strcpy(reply, "OK status | setup | source 1-8 | rate 1-10 | rgenable | rotate | flush\n");
+	}
+	else {
+		strcpy(reply, "ERR unknown command, try help\n");
+	}
+}
+/* end of function: ctl_command */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : ctl_read
+ * Inputs     : struct control *ctl - control state
+ *		int slot - client to read from
+ * Returns    : 0 while the client is connected
+ *             -1 once it has gone away
+ * Description: Collects input from a client and runs every complete line.
+ */
+static int ctl_read(struct control *ctl, int slot) {
+	char buff[CTL_LINE_MAX], reply[2 * CTL_LINE_MAX];
+	char *line = ctl->line[slot];
+	int ret, cnt;
+
+	ret = recv(ctl->client[slot], buff, sizeof(buff), 0);
+	if (ret <= 0) {
+		return (ret == -1 && errno == EINTR) ? 0 : -1;
+	}
+	for (cnt = 0; cnt < ret; cnt++) {
+		if (buff[cnt] == '\r') {
+			continue;
+		}
+		if (buff[cnt] != '\n') {
+			if (ctl->linelen[slot] < CTL_LINE_MAX - 1) {
+				line[ctl->linelen[slot]] = buff[cnt];
+			}
+			ctl->linelen[slot]++;
+			continue;
+		}
+		if (ctl->linelen[slot] >= CTL_LINE_MAX) {
+			strcpy(reply, "ERR command too long\n");
+		}
+		else {
+			line[ctl->linelen[slot]] = '\0';
+			ctl_command(ctl, line, reply);
+		}
+		ctl_reply(ctl->client[slot], reply);
+		ctl->linelen[slot] = 0;
+	}
+	return 0;
+}
+/* end of function: ctl_read */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : ctl_thread_main
+ * Inputs     : void *arg - the struct control
+ * Returns    : NULL
+ * Description: Serves the listening socket and up to CTL_MAX_CLIENTS clients.
+ *		Polls with a short timeout so ctl_stop is noticed promptly.
+ */
+static void *ctl_thread_main(void *arg) {
+	struct control *ctl = arg;
+	struct pollfd pfd[CTL_MAX_CLIENTS + 1];
+	int cnt, slot, sock;
+
+	while (atomic_load(&ctl->stop) == 0) {
+		pfd[0].fd = ctl->lsock;
+		pfd[0].events = POLLIN;
+		for (cnt = 0; cnt < CTL_MAX_CLIENTS; cnt++) {
+			pfd[cnt + 1].fd = ctl->client[cnt];
+			pfd[cnt + 1].events = POLLIN;
+		}
+		if (poll(pfd, CTL_MAX_CLIENTS + 1, 200) <= 0) {
+			continue;
+		}
+
+		for (cnt = 0; cnt < CTL_MAX_CLIENTS; cnt++) {
+			if (ctl->client[cnt] != -1 && pfd[cnt + 1].revents != 0) {
+				if (ctl_read(ctl, cnt) == -1) {
+					close(ctl->client[cnt]);
+					ctl->client[cnt] = -1;
+				}
+			}
+		}
+
+		if (pfd[0].revents & POLLIN) {
+			sock = accept(ctl->lsock, NULL, NULL);
+			if (sock == -1) {
+				continue;
+			}
+			for (slot = 0; slot < CTL_MAX_CLIENTS; slot++) {
+				if (ctl->client[slot] == -1) {
+					break;
+				}
+			}
+			if (slot == CTL_MAX_CLIENTS) {
+				ctl_reply(sock, "ERR too many clients\n");
+				close(sock);
+				continue;
+			}
+			ctl->client[slot] = sock;
+			ctl->linelen[slot] = 0;
+		}
+	}
+	return NULL;
+}
+/* end of function: ctl_thread_main */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : ctl_start
+ * Inputs     : struct control *ctl - control state to set up
+ *		struct capture *cap - running capture the commands apply to
+ *		int devfd - device file descriptor, -1 with a simulated source
+ *		const char *path - socket path
+ * Returns    : 0 on success
+ *             -1 on failure
+ * Description: Creates the socket (replacing a stale one left by a previous
+ *		run), readable and writable by the owner and group only, and starts
+ *		the control thread.  Call after cap_start so the thread inherits the
+ *		same signal mask and CPU set as the other non-capture threads.
+ */
+int ctl_start(struct control *ctl, struct capture *cap, int devfd, const char *path) {
+	struct sockaddr_un addr;
+	mode_t old;
+	int cnt, ret;
+
+	memset(ctl, 0, sizeof(*ctl));
+	ctl->cap = cap;
+	ctl->devfd = devfd;
+	for (cnt = 0; cnt < CTL_MAX_CLIENTS; cnt++) {
+		ctl->client[cnt] = -1;
+	}
+	if (strlen(path) >= sizeof(ctl->path)) {
+		printf("\nControl socket path %s is too long\n", path);
+		return -1;
+	}
+	strcpy(ctl->path, path);
+
+	ctl->lsock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (ctl->lsock == -1) {
+		printf("\nCould not create the control socket (errno %d)\n", errno);
+		return -1;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, ctl->path);
+	unlink(ctl->path);
+	/* bind creates the socket with the umask applied, so it is never open
+	 * to others, not even until a chmod after it */
+	old = umask(0117);
+	ret = bind(ctl->lsock, (struct sockaddr *)&addr, sizeof(addr));
+	umask(old);
+	if (ret == -1 || listen(ctl->lsock, CTL_MAX_CLIENTS) == -1) {
+		printf("\nCould not listen on %s (errno %d)\n", ctl->path, errno);
+		close(ctl->lsock);
+		return -1;
+	}
+
+	if (pthread_create(&ctl->thread, NULL, ctl_thread_main, ctl) != 0) {
+		printf("\nCould not start the control thread\n");
+		close(ctl->lsock);
+		unlink(ctl->path);
+		return -1;
+	}
+	return 0;
+}
+/* end of function: ctl_start */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : ctl_stop
+ * Inputs     : struct control *ctl - control started by ctl_start
+ * Returns    : Nothing
+ * Description: Stops the control thread, disconnects any clients and removes
+ *		the socket.
+ */
+void ctl_stop(struct control *ctl) {
+	int cnt;
+
+	atomic_store(&ctl->stop, 1);
+	pthread_join(ctl->thread, NULL);
+	for (cnt = 0; cnt < CTL_MAX_CLIENTS; cnt++) {
+		if (ctl->client[cnt] != -1) {
+			close(ctl->client[cnt]);
+		}
+	}
+	close(ctl->lsock);
+	unlink(ctl->path);
+}
+/* end of function: ctl_stop */
+/*******************************************************************************/
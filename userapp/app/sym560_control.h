@@ -0,0 +1,42 @@
+/* File : 	sym560_control.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Local control socket for the automatic mode.  Lets the event
+ *		source and rate generator be changed, the setup and capture counters
+ *		be queried, and the output be rotated or flushed without stopping
+ *		capture.  See sym560_control.c for the protocol.
+ */
+
+#ifndef SYM560_CONTROL_H
+#define SYM560_CONTROL_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/un.h>
+#include "sym560_capture.h"
+
+/* where the automatic mode listens unless told otherwise */
+#define CTL_DEFAULT_PATH	"/tmp/sym560.ctl"
+
+/* clients served at once, and the longest command line accepted */
+#define CTL_MAX_CLIENTS		8
+#define CTL_LINE_MAX		128
+
+struct control {
+	struct capture *cap;
+	int devfd;			/* /dev/symgps, -1 with a simulated source */
+	int lsock;			/* listening socket */
+	int client[CTL_MAX_CLIENTS];	/* connected clients, -1 = free */
+	char line[CTL_MAX_CLIENTS][CTL_LINE_MAX];	/* partial command from each client */
+	int linelen[CTL_MAX_CLIENTS];
+	char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+	pthread_t thread;
+	_Atomic int stop;
+	_Atomic uint64_t commands;	/* commands handled */
+};
+
+/* function declarations */
+int ctl_start(struct control *ctl, struct capture *cap, int devfd, const char *path);
+void ctl_stop(struct control *ctl);
+
+#endif /* SYM560_CONTROL_H */
@@ -0,0 +1,176 @@
+/* File : 	sym560_convert.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Timestamp file conversion (see sym560_convert.h).  The input
+ *		is mapped and parsed in place by rec_map_text, or decoded a block
+ *		at a time if it is compressed, and the output goes out in large
+ *		writes, so converting an archive runs as fast as the disk can
+ *		read it.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sym560_record.h"
+#include "sym560_delta.h"
+#include "sym560_convert.h"
+
+/* stdio buffer for the output */
+#define CONV_BUFFER	(1 << 20)
+
+/* the input, and its decoded block if it is compressed */
+struct conv_in {
+	struct rec_map map;
+	int delta;			/* made of compressed blocks */
+	int64_t ns[DLT_BLOCK];
+	int n, next;			/* events in the block, next one to return */
+	int bad;			/* a block could not be decoded */
+};
+
+
+/*******************************************************************************/
+/* Function   : conv_read
+ * Inputs     : struct conv_in *in - input
+ *		int64_t *ns - receives the time of the next timestamp
+ * Returns    : 0 on success
+ *             -1 at the end of the input
+ * Description: Text is parsed as findpulse reads it.  Compressed input
+ *		stops at a block that does not decode, setting in->bad.
+ */
+static int conv_read(struct conv_in *in, int64_t *ns) {
+	size_t used;
+
+	if (!in->delta) {
+		return rec_map_text(&in->map, ns);
+	}
+	if (in->next == in->n) {
+		if (in->map.pos == in->map.size) {
+			return -1;
+		}
+		in->n = dlt_decode(in->map.buf + in->map.pos, in->map.size - in->map.pos, in->ns, &used);
+		if (in->n < 0) {
+			in->n = 0;
+			in->bad = 1;
+			return -1;
+		}
+		in->map.pos += used;
+		in->next = 0;
+	}
+	*ns = in->ns[in->next++];
+	return 0;
+}
+/* end of function: conv_read */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : convert
+ * Inputs     : const char *infile - plain text timestamp file, or a
+ *		compressed one
+ *		const char *outfile - output file, "-" for stdout
+ *		int format - CONV_RAW, CONV_DELTA or CONV_TEXT
+ * Returns    : 0 on success
+ *             -1 if a file cannot be opened, read or written
+ * Description: Writes each timestamp in infile to outfile, stopping where
+ *		findpulse would.  A file that starts with a compressed block is
+ *		read as one.  Says how many there were.
+ */
+int convert(const char *infile, const char *outfile, int format) {
+	unsigned char raw[REC_RAW_LEN];
+	char txt[REC_TEXT_MAX], *blk;
+	struct conv_in *in;
+	struct dlt_enc *enc;
+	uint64_t count = 0, bytes = 0;
+	uint32_t magic;
+	int64_t ns;
+	size_t len;
+	FILE *out;
+	int ret = 0;
+
+	if (format != CONV_RAW && format != CONV_DELTA && format != CONV_TEXT) {
+		printf("\nUnknown output format %d\n", format);
+		return -1;
+	}
+	in = calloc(1, sizeof(*in));
+	enc = malloc(sizeof(*enc));
+	blk = malloc(DLT_BLOCK_MAX);
+	if (in == NULL || enc == NULL || blk == NULL) {
+		printf("\nCould not allocate memory to convert %s\n", infile);
+		free(in);
+		free(enc);
+		free(blk);
+		return -1;
+	}
+	if (rec_map_open(&in->map, infile) != 0) {
+		printf("\nCould not open %s: %s\n", infile, strerror(errno));
+		free(in);
+		free(enc);
+		free(blk);
+		return -1;
+	}
+	if (in->map.size >= (long)sizeof(magic)) {
+		memcpy(&magic, in->map.buf, sizeof(magic));
+		in->delta = magic == DLT_MAGIC;
+	}
+	out = strcmp(outfile, "-") == 0 ? stdout : fopen(outfile, "w");
+	if (out == NULL) {
+		printf("\nCould not open %s: %s\n", outfile, strerror(errno));
+		rec_map_close(&in->map);
+		free(in);
+		free(enc);
+		free(blk);
+		return -1;
+	}
+	setvbuf(out, NULL, _IOFBF, CONV_BUFFER);
+	dlt_enc_init(enc);
+
+	while (conv_read(in, &ns) == 0) {
+		if (format == CONV_DELTA) {
+			len = dlt_enc_add(enc, ns, blk);
+			fwrite(blk, len, 1, out);
+			bytes += len;
+		}
+		else if (format == CONV_TEXT) {
+			rec_encode(ns, raw);
+			len = rec_format_text(raw, txt);
+			fwrite(txt, len, 1, out);
+		}
+		else {
+			rec_encode(ns, raw);
+			fwrite(raw, REC_RAW_LEN, 1, out);
+		}
+		count++;
+	}
+	if (format == CONV_DELTA) {
+		len = dlt_enc_flush(enc, blk);
+		fwrite(blk, len, 1, out);
+		bytes += len;
+	}
+	if (in->bad) {
+		printf("\nCould not decode %s after %llu timestamps\n", infile, (unsigned long long)count);
+		ret = -1;
+	}
+	if (fflush(out) != 0 || ferror(out)) {
+		printf("\nCould not write %s: %s\n", outfile, strerror(errno));
+		ret = -1;
+	}
+	if (out != stdout && fclose(out) != 0 && ret == 0) {
+		printf("\nCould not write %s: %s\n", outfile, strerror(errno));
+		ret = -1;
+	}
+	if (out != stdout && format == CONV_DELTA) {
+		printf("%s: %llu timestamps, %.2f bytes each\n", outfile, (unsigned long long)count,
+				count ? (double)bytes / count : 0.0);
+	}
+	else if (out != stdout) {
+		printf("%s: %llu timestamps\n", outfile, (unsigned long long)count);
+	}
+	rec_map_close(&in->map);
+	free(in);
+	free(enc);
+	free(blk);
+	return ret;
+}
+/* end of function: convert */
+/*******************************************************************************/
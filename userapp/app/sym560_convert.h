@@ -0,0 +1,22 @@
+/* File : 	sym560_convert.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Converts plain text timestamp files to the 12 byte BCD event
+ *		times the driver returns, which findpulse -r and batch -r read
+ *		several times faster and which take a seventh of the space, or
+ *		to delta of delta compressed blocks (see sym560_delta.h) for
+ *		archiving, and those back to text or event times.
+ */
+
+#ifndef SYM560_CONVERT_H
+#define SYM560_CONVERT_H
+
+/* output formats */
+#define CONV_RAW		0	/* 12 byte BCD event times */
+#define CONV_DELTA		1	/* compressed blocks */
+#define CONV_TEXT		2	/* plain text timestamps */
+
+/* function declarations */
+int convert(const char *infile, const char *outfile, int format);
+
+#endif /* SYM560_CONVERT_H */
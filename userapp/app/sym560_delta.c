@@ -0,0 +1,293 @@
+/* File : 	sym560_delta.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Delta of delta block codec for event times (see
+ *		sym560_delta.h).  dlt_encode codes one block and dlt_decode
+ *		reads one back; dlt_enc_add keeps events until there are enough
+ *		for a block, so it can be fed one event at a time as they are
+ *		captured.
+ */
+
+#include <string.h>
+#include "sym560_delta.h"
+
+/* gaps larger than this (over 36 years) make a lag 0 block, so no
+ * difference of two of them can overflow its token */
+#define DLT_GAP_MAX		(1LL << 60)
+
+/* the lag is chosen on this many events from the start of each block, as
+ * trying every lag on all of them would cost more than the rest together */
+#define DLT_SAMPLE		512
+
+/*******************************************************************************/
+/* Function   : dlt_zigzag
+ * Inputs     : int64_t v - signed value
+ * Returns    : v with its sign in the lowest bit, so small values either
+ *		side of 0 are small
+ */
+static inline uint64_t dlt_zigzag(int64_t v) {
+	return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+/* end of function: dlt_zigzag */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : dlt_varint_len
+ * Inputs     : uint64_t v - value
+ * Returns    : Bytes its varint takes
+ */
+static inline int dlt_varint_len(uint64_t v) {
+	return (70 - __builtin_clzll(v | 1)) / 7;
+}
+/* end of function: dlt_varint_len */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : dlt_put
+ * Inputs     : unsigned char *p - where to write
+ *		uint64_t v - value
+ * Returns    : Where the next byte goes
+ * Description: 7 bits to a byte, lowest first, the top bit set on all but
+ *		the last.
+ */
+static inline unsigned char *dlt_put(unsigned char *p, uint64_t v) {
+	while (v >= 0x80) {
+		*p++ = (unsigned char)(v | 0x80);
+		v >>= 7;
+	}
+	*p++ = (unsigned char)v;
+	return p;
+}
+/* end of function: dlt_put */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : dlt_encode
+ * Inputs     : const int64_t *ns - event times
+ *		int n - how many, 1 to DLT_BLOCK
+ *		char *out - buffer of at least DLT_BLOCK_MAX bytes
+ * Returns    : Length of the block
+ * Description: Works out, for every lag, roughly how long the tokens of the
+ *		differences that are not 0 would be over the first DLT_SAMPLE
+ *		events, and codes the block with the shortest.  The gaps before
+ *		the block's first event count as 0, so its first lag differences
+ *		are the gaps themselves.
+ */
+size_t dlt_encode(const int64_t *ns, int n, char *out) {
+	struct dlt_block *h = (struct dlt_block *)out;
+	unsigned char *p = (unsigned char *)(h + 1);
+	int64_t d[DLT_BLOCK], r, unit = 100;
+	uint64_t cost[DLT_MAX_LAG + 1], c, run = 0;
+	int i, k, m, lag = 1;
+
+	memset(h, 0, sizeof(*h));
+	h->magic = DLT_MAGIC;
+	h->version = DLT_VERSION;
+	h->count = n;
+	h->first_ns = ns[0];
+	h->last_ns = ns[n - 1];
+
+	d[0] = 0;
+	for (i = 1; i < n; i++) {
+		d[i] = ns[i] - ns[i - 1];
+		if (d[i] > DLT_GAP_MAX || d[i] < -DLT_GAP_MAX) {
+			lag = 0;
+		}
+		if (ns[i] % 100 != 0) {
+			unit = 1;
+		}
+	}
+	if (ns[0] % 100 != 0) {
+		unit = 1;
+	}
+	if (lag == 0) {
+		memcpy(p, ns + 1, (n - 1) * sizeof(*ns));
+		h->bytes = (n - 1) * sizeof(*ns);
+		return sizeof(*h) + h->bytes;
+	}
+
+	for (i = 1; unit == 100 && i < n; i++) {
+		d[i] /= 100;
+	}
+	/* a 0 would take a byte on its own, but costs nothing in a run */
+	m = n < DLT_SAMPLE ? n : DLT_SAMPLE;
+	for (k = 1; k <= DLT_MAX_LAG; k++) {
+		c = 0;
+		for (i = 1; i < m; i++) {
+			r = d[i] - (i > k ? d[i - k] : 0);
+			c += dlt_varint_len(dlt_zigzag(r) << 1) - (r == 0);
+		}
+		cost[k] = c;
+	}
+	for (k = 2; k <= DLT_MAX_LAG; k++) {
+		if (cost[k] < cost[lag]) {
+			lag = k;
+		}
+	}
+
+	for (i = 1; i < n; i++) {
+		r = d[i] - (i > lag ? d[i - lag] : 0);
+		if (r == 0) {
+			run++;
+			continue;
+		}
+		if (run != 0) {
+			p = dlt_put(p, run << 1 | 1);
+			run = 0;
+		}
+		p = dlt_put(p, dlt_zigzag(r) << 1);
+	}
+	if (run != 0) {
+		p = dlt_put(p, run << 1 | 1);
+	}
+	h->lag = lag;
+	h->unit = unit;
+	h->bytes = p - (unsigned char *)(h + 1);
+	return sizeof(*h) + h->bytes;
+}
+/* end of function: dlt_encode */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : dlt_decode
+ * Inputs     : const char *buf - a block
+ *		size_t len - bytes from buf to the end of the input
+ *		int64_t *ns - receives its event times, room for DLT_BLOCK
+ *		size_t *used - receives the length of the block
+ * Returns    : Events in the block
+ *             -1 if it is not a whole, valid block
+ * Description: Each event is the one before plus the gap lag events back
+ *		plus its difference, so a run of 0 differences is one add and
+ *		one subtract per event.  The sums are done unsigned so a
+ *		damaged block cannot overflow them.
+ */
+int dlt_decode(const char *buf, size_t len, int64_t *ns, size_t *used) {
+	struct dlt_block hdr, *h = &hdr;
+	const unsigned char *p, *end;
+	uint64_t *t = (uint64_t *)ns, v, unit;
+	int i, k, n, shift;
+
+	if (len < sizeof(*h)) {
+		return -1;
+	}
+	/* blocks follow each other unaligned */
+	memcpy(h, buf, sizeof(*h));
+	if (h->magic != DLT_MAGIC || h->version != DLT_VERSION
+			|| h->count == 0 || h->count > DLT_BLOCK || h->lag > DLT_MAX_LAG
+			|| (h->unit != 1 && h->unit != 100) || h->bytes > len - sizeof(*h)) {
+		return -1;
+	}
+	p = (const unsigned char *)buf + sizeof(*h);
+	end = p + h->bytes;
+	n = h->count;
+	k = h->lag;
+	unit = h->unit;
+	ns[0] = h->first_ns;
+
+	if (k == 0) {
+		if (h->bytes != (n - 1) * sizeof(*ns)) {
+			return -1;
+		}
+		memcpy(ns + 1, p, h->bytes);
+	}
+	i = 1;
+	while (k != 0 && i < n) {
+		if (p == end) {
+			return -1;
+		}
+		v = *p++;
+		if (v & 0x80) {
+			v &= 0x7f;
+			for (shift = 7; ; shift += 7) {
+				if (p == end || shift > 63) {
+					return -1;
+				}
+				v |= (uint64_t)(*p & 0x7f) << shift;
+				if (!(*p++ & 0x80)) {
+					break;
+				}
+			}
+		}
+		if (v & 1) {
+			/* a run of 0 differences */
+			v >>= 1;
+			if (v == 0 || v > (uint64_t)(n - i)) {
+				return -1;
+			}
+			for (; v > 0 && i <= k; v--, i++) {
+				t[i] = t[i - 1];
+			}
+			for (; v > 0; v--, i++) {
+				t[i] = t[i - 1] + t[i - k] - t[i - k - 1];
+			}
+		}
+		else {
+			v >>= 1;
+			v = ((v >> 1) ^ -(v & 1)) * unit;
+			t[i] = t[i - 1] + v + (i > k ? t[i - k] - t[i - k - 1] : 0);
+			i++;
+		}
+	}
+	if ((k != 0 && p != end) || ns[n - 1] != h->last_ns) {
+		return -1;
+	}
+	*used = sizeof(*h) + h->bytes;
+	return n;
+}
+/* end of function: dlt_decode */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : dlt_enc_init
+ * Inputs     : struct dlt_enc *e - encoder
+ * Returns    : Nothing
+ */
+void dlt_enc_init(struct dlt_enc *e) {
+	e->n = 0;
+}
+/* end of function: dlt_enc_init */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : dlt_enc_add
+ * Inputs     : struct dlt_enc *e - encoder
+ *		int64_t ns - next event time
+ *		char *out - buffer of at least DLT_BLOCK_MAX bytes
+ * Returns    : Length of the block written to out if the event filled one,
+ *		otherwise 0
+ */
+size_t dlt_enc_add(struct dlt_enc *e, int64_t ns, char *out) {
+	e->ns[e->n++] = ns;
+	if (e->n < DLT_BLOCK) {
+		return 0;
+	}
+	e->n = 0;
+	return dlt_encode(e->ns, DLT_BLOCK, out);
+}
+/* end of function: dlt_enc_add */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : dlt_enc_flush
+ * Inputs     : struct dlt_enc *e - encoder
+ *		char *out - buffer of at least DLT_BLOCK_MAX bytes
+ * Returns    : Length of the block of the events kept, 0 if there are none
+ */
+size_t dlt_enc_flush(struct dlt_enc *e, char *out) {
+	int n = e->n;
+
+	if (n == 0) {
+		return 0;
+	}
+	e->n = 0;
+	return dlt_encode(e->ns, n, out);
+}
+/* end of function: dlt_enc_flush */
+/*******************************************************************************/
@@ -0,0 +1,69 @@
+/* File : 	sym560_delta.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Compressed event archives.  Event times are cut into blocks
+ *		of up to DLT_BLOCK, each starting with its first time in full as
+ *		an anchor, so any block can be decoded without those before it.
+ *		The rest of a block is the difference of each gap between
+ *		events from the gap lag events earlier, zigzag varint coded.
+ *
+ *		Pulse sequences repeat their separations every sequence, so with
+ *		lag set to the pulses in a sequence those differences are only
+ *		the jitter, and for a steady radar mostly 0.  Runs of 0 are a
+ *		single varint.  The encoder picks the lag (1 is plain
+ *		delta-of-delta) that codes each block smallest, and works in units
+ *		of 100 ns, the card's resolution, when every time in the block
+ *		is a whole number of them.
+ *
+ *		A token is a varint v: v even is a difference of zigzag(v / 2)
+ *		units, v odd a run of v / 2 differences of 0.  A block with
+ *		lag 0 holds its times after the first as they are (a difference
+ *		too large to code, which real timestamps never have).
+ */
+
+#ifndef SYM560_DELTA_H
+#define SYM560_DELTA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* block header, in host byte order */
+#define DLT_MAGIC		0x44594d53	/* "SYMD" */
+#define DLT_VERSION		1
+
+/* most events in a block */
+#define DLT_BLOCK		4096
+
+/* longest lag tried, the most pulses in a sequence it helps with */
+#define DLT_MAX_LAG		16
+
+/* longest block, for output buffers */
+#define DLT_BLOCK_MAX		(sizeof(struct dlt_block) + DLT_BLOCK * 10)
+
+/* start of each block, followed by bytes of tokens */
+struct dlt_block {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t lag;			/* 1 to DLT_MAX_LAG, 0 = times stored as they are */
+	uint32_t unit;			/* ns the differences are counted in, 1 or 100 */
+	uint32_t count;			/* events, 1 to DLT_BLOCK */
+	int64_t first_ns;		/* the anchor */
+	int64_t last_ns;
+	uint32_t bytes;			/* of tokens after the header */
+	uint32_t spare;
+};
+
+/* streaming encoder: events are kept until a block is full */
+struct dlt_enc {
+	int64_t ns[DLT_BLOCK];
+	int n;
+};
+
+/* function declarations */
+size_t dlt_encode(const int64_t *ns, int n, char *out);
+int dlt_decode(const char *buf, size_t len, int64_t *ns, size_t *used);
+void dlt_enc_init(struct dlt_enc *e);
+size_t dlt_enc_add(struct dlt_enc *e, int64_t ns, char *out);
+size_t dlt_enc_flush(struct dlt_enc *e, char *out);
+
+#endif /* SYM560_DELTA_H */
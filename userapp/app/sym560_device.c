@@ -0,0 +1,453 @@
+/* File : 	sym560_device.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Non-interactive access to the card's registers (see
+ *		sym560_device.h).  Moved here from sym560_functions.c unchanged,
+ *		apart from GPS_sync and the time_ functions, which were part of
+ *		GPS_start and fetch_time.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "sym560_device.h"
+#include "sym560_record.h"
+#include "sym560_status.h"
+
+/*******************************************************************************/
+/* Function   : read_pci
+ * Inputs     : int fd - file descriptor for the GPS-PCI device
+ *              off_t regoff - location to read from
+ *              char *user_buff - user buffer that will contain the read data
+                int nbytes - Number of bytes to read
+ * Returns    : 0 on Success
+ *             -1 on Failure
+ * Description: Reads data from the GPS-PCI device into a user buffer.  The position
+ *              is passed with the read (pread) rather than set with lseek first,
+ *              so the capture and lock threads can share the descriptor.
+ */
+int read_pci(int fd, off_t regoff, char *user_buff, int nbytes) {
+	int ret;
+	
+	/* read from device at regoff */
+	ret = pread(fd, user_buff, nbytes, regoff);
+	if (ret == -1) {
+		return -1;
+	}
+	
+	return 0;
+}
+/* end of function: read_pci */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : write_pci
+ * Inputs     : int fd - file descriptor for the GPS-PCI device
+ *              off_t regoff - location to write to
+ *              char *user_buff - user buffer containing the data to be written
+                int nbytes - Number of bytes to write
+ * Returns    : 0 on Success
+ *             -1 on Failure
+ * Description: Writes data to the GPS-PCI device from a user buffer at the given
+ *              position (pwrite, see read_pci).
+ */
+int write_pci(int fd, off_t regoff, char *user_buff, int nbytes) {
+	int ret;
+	
+	/* write to device at regoff */
+	ret = pwrite(fd, user_buff, nbytes, regoff);
+	if (ret == -1) {
+		return -1;
+	}
+	
+	return 0;
+}
+/* end of function: write_pci */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : GPS_lock_status
+ * Inputs     : int fd - file descriptor for the GPS-PCI device
+ * Returns    : The lock bits of the software time lock register (REC_LOCK_ALL when
+ *		fully locked)
+ *             -1 on Failure
+ * Description: Single register read, cheap enough to poll while capturing.
+ */
+int GPS_lock_status(int fd) {
+	char user_buff[4];
+	
+	if (read_pci(fd, REG_SOFTTIME_LOCK, user_buff, 1) == -1) {
+		return -1;
+	}
+	return user_buff[0] & REC_LOCK_ALL;
+}
+/* end of function: GPS_lock_status */
+/*******************************************************************************/
+
+/*******************************************************************************/
+/* Function   : GPS_sync
+ * Inputs     : int fd - file descriptor for the GPS-PCI device
+ * Returns    : 0 on Success
+ *             -1 on Failure
+ * Description: Sets the card to run in synchronized generator mode with the GPS
+ *		as its reference (the register part of GPS_start).
+ */
+int GPS_sync(int fd) {
+	char user_buff[4];
+	
+	user_buff[0] = 0x21;
+	return write_pci(fd, REG_CONFIG1_TSC, user_buff, 1);
+}
+/* end of function: GPS_sync */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : time_read
+ * Inputs     : int fd - file descriptor for the GPS-PCI device
+ *		unsigned char *raw - receives the 12 bytes of the software time
+ *				     capture register
+ * Returns    : 0 on Success
+ *             -1 on Failure
+ * Description: Latches the card's current time into the software time capture
+ *		register by writing to it and reads it back.
+ */
+int time_read(int fd, unsigned char *raw) {
+	raw[0] = 0xff;
+	if (write_pci(fd, REG_SOFTTIME, raw, 1) == -1) {
+		return -1;
+	}
+	if (read_pci(fd, REG_SOFTTIME, raw, 4) == -1 || read_pci(fd, REG_SOFTTIME + 4, raw + 4, 4) == -1
+			|| read_pci(fd, REG_SOFTTIME + 8, raw + 8, 4) == -1) {
+		return -1;
+	}
+	return 0;
+}
+/* end of function: time_read */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : time_decode
+ * Inputs     : const unsigned char *raw - 12 bytes as read by time_read
+ * Returns    : The time in UTC nanoseconds since 1970-01-01
+ * Description: The software time capture register holds the same BCD digits as
+ *		the event time capture but laid out differently (see fetch_time),
+ *		so it cannot go through rec_decode.
+ */
+int64_t time_decode(const unsigned char *raw) {
+	int year, day, hour, min, sec;
+	int64_t subsec;	/* units of 100 ns */
+
+	subsec = (raw[4] >> 4) * 1000000 + (raw[4] & 0x0F) * 100000
+		+ (raw[1] >> 4) * 10000 + (raw[1] & 0x0F) * 1000
+		+ (raw[0] >> 4) * 100 + (raw[0] & 0x0F) * 10 + (raw[3] >> 4);
+	sec = (raw[5] >> 4) * 10 + (raw[5] & 0x0F);
+	min = (raw[6] >> 4) * 10 + (raw[6] & 0x0F);
+	hour = (raw[7] >> 4) * 10 + (raw[7] & 0x0F);
+	day = (raw[9] & 0x0F) * 100 + (raw[8] >> 4) * 10 + (raw[8] & 0x0F);
+	year = (raw[11] >> 4) * 1000 + (raw[11] & 0x0F) * 100 + (raw[10] >> 4) * 10
+		+ (raw[10] & 0x0F);
+
+	return rec_ns(year, day, hour, min, sec, subsec);
+}
+/* end of function: time_decode */
+/*******************************************************************************/
+
+
+/*******************************************************************************
+ * Function   : sat_read
+ * Inputs     : int fd - device file descriptor.
+ *		unsigned char *sat - receives the 24 bytes of the six satellite
+ *				     signal strength registers
+ * Returns    : 0 on success
+ *		1 if signal is being updated
+ *	       -1 on failure
+ * Description: Reads the signal strength registers, checking the update status
+ *		before and after each one so that a half updated set is never used.
+ */
+int sat_read(int fd, unsigned char *sat) {
+	unsigned char user_buff[4];
+	int cnt;
+
+	/* Check satelite update status */
+	if (read_pci(fd, REG_SATSTAT, user_buff, 1) == -1) {
+		return -1;
+	}
+	if (user_buff[0] != 0) {
+		return 1;
+	}
+	
+	/* loop through all six satellite locks */
+	for (cnt = 0; cnt < 6; cnt++) {
+		if (read_pci(fd, REG_SATSIG_SATA + (cnt*4), &sat[cnt*4], 4) == -1) {
+			return -1;
+		}
+		/* Check satelite update status */
+		if (read_pci(fd, REG_SATSTAT, user_buff, 1) == -1) {
+			return -1;
+		}
+		if (user_buff[0] != 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
+/* end of function: sat_read */
+/*******************************************************************************/
+
+
+/*******************************************************************************
+ * Function   : position_read
+ * Inputs     : int fd - device file descriptor.
+ *		unsigned char *pos - receives the 16 bytes of the position register
+ * Returns    : 0 on success
+ *		1 if the two readings differ
+ *             -1 on failure
+ * Description: Reads the position register twice (as recommended pg 30 of
+ *		manual) and only accepts it if the readings agree.
+ */
+int position_read(int fd, unsigned char *pos) {
+	int ret, cnt, good_data;
+	/* buffers being used to fetch the data */
+	unsigned char quad_1[2][4];
+	unsigned char quad_2[2][4];
+	unsigned char quad_3[2][4];
+	unsigned char quad_4[2][4];
+	
+	/* read the position register twice (as recommended pg 30 of manual)*/
+	for (cnt = 0; cnt < 2; cnt++) {
+		ret = read_pci(fd, REG_ANT_POSITION, &quad_1[cnt][0], 4);
+		if (ret == -1) {
+			return -1;
+		}
+		ret = read_pci(fd, REG_ANT_POSITION + 4, &quad_2[cnt][0], 4);
+		if (ret == -1) {
+			return -1;
+		}
+		ret = read_pci(fd, REG_ANT_POSITION + 8, &quad_3[cnt][0], 4);
+		if (ret == -1) {
+			return -1;
+		}
+		ret = read_pci(fd, REG_ANT_POSITION + 12, &quad_4[cnt][0], 4);
+		if (ret == -1) {
+			return -1;
+		}
+	}
+	
+	/* verify the two readings are identical */
+	good_data = 1;
+	for (cnt = 0; cnt < 3; cnt++) {
+		if ((quad_1[0][cnt] != quad_1[1][cnt]) && (quad_2[0][cnt] != quad_2[1][cnt])) {
+			good_data = 0;
+		}
+		if ((quad_3[0][cnt] != quad_3[1][cnt]) && (quad_4[0][cnt] != quad_4[1][cnt])) {
+			good_data = 0;
+		}
+	}
+	if (good_data == 0) {
+		return 1;
+	}
+	memcpy(pos, quad_1[0], 4);
+	memcpy(pos + 4, quad_2[0], 4);
+	memcpy(pos + 8, quad_3[0], 4);
+	memcpy(pos + 12, quad_4[0], 4);
+	return 0;
+}
+/* end of function: position_read */
+/*******************************************************************************/
+
+
+/*******************************************************************************
+ * Function   : ev_set_source
+ * Inputs     : int fd - device file descriptor.
+ *		int num - event source as numbered in the ev_source menu (1-8)
+ * Returns    : 0 on success
+ *	       -1 if num is invalid or the register could not be written
+ * Description: Non-interactive part of ev_source, also used by the control
+ *		socket while capturing.
+ */
+int ev_set_source(int fd, int num) {
+	unsigned char user_buff[4];
+	
+	switch(num) {
+		case 1:
+			user_buff[0] = 0x04;
+			break;
+		case 2:
+			user_buff[0] = 0x05;
+			break;
+		case 3:
+			user_buff[0] = 0x06;
+			break;
+		case 4:
+			user_buff[0] = 0x07;
+			break;
+		case 5:
+			user_buff[0] = 0x00;
+			break;
+		case 6:
+			user_buff[0] = 0x01;
+			break;
+		case 7:
+			user_buff[0] = 0x02;
+			break;
+		case 8:
+			user_buff[0] = 0x03;
+			break;
+		default:
+			return -1;
+	}
+	
+	/* write the chosen source to config2 register */
+	return write_pci(fd, REG_CONFIG2_ETCC, user_buff, 1);
+}
+/* end of function: ev_set_source */
+/*******************************************************************************/
+
+
+/*******************************************************************************
+ * Function   : ev_get_setup
+ * Inputs     : int fd - device file descriptor.
+ *		char *event - receives the event source name (at least 25 bytes)
+ *		char *edge - receives the trigger edge name (at least 10 bytes)
+ * Returns    : 0 on success
+ *	       -1 if the register could not be read
+ * Description: Reads the current external event source and edge
+ */
+int ev_get_setup(int fd, char *event, char *edge) {
+	unsigned char user_buff[4];
+	
+	if (read_pci(fd, REG_CONFIG2_ETCC, user_buff, 1) == -1) {
+		return -1;
+	}
+	
+	/* the first two bits indicate the event source */
+	if ((user_buff[0] & 0x03) == 0x00) {
+		strcpy(event, "EXTERNAL EVENT");
+	}
+	else if ((user_buff[0] & 0x03) == 0x01) {
+		strcpy(event, "RATE SYNTHESIZER");
+	}
+	else if ((user_buff[0] & 0x03) == 0x02) {
+		strcpy(event, "RATE GENERATOR");
+	}
+	else if ((user_buff[0] & 0x03) == 0x03) {
+		strcpy(event, "TIME COMPARE");
+	}
+	
+	/* the 3rd bit indicates the edge */
+	if ((user_buff[0] & 0x04) == 0x00) {
+		strcpy(edge, "FALLING");
+	}
+	else {
+		strcpy(edge, "RISING");
+	}
+	
+	return 0;
+}
+/* end of function: ev_get_setup */
+/*******************************************************************************/
+
+
+/*******************************************************************************
+ * Function   : antenna_read
+ * Inputs     : int fd - GSP-PCI device file descriptor
+ * Returns    : The antenna bits of the hardware status register (STAT_ANT_OK
+ *		when there is neither a short nor an open load)
+ *	       -1 on failure
+ */
+int antenna_read(int fd) {
+	unsigned char user_buff[4];
+	
+	user_buff[0] = 0x70;
+	if (write_pci(fd, REG_HARD_STATUS, user_buff, 1) == -1
+			|| read_pci(fd, REG_HARD_STATUS, user_buff, 1) == -1) {
+		return -1;
+	}
+	return user_buff[0] & STAT_ANT_OK;
+}
+/* end of function: antenna_read */
+/*******************************************************************************/
+
+
+/*******************************************************************************
+ * Function   : rg_set_rate
+ * Inputs     : int fd - device file descriptor.
+ *		int num - rate as numbered in the rg_rate menu (1-10)
+ * Returns    : 0 on success
+ *	       -1 if num is invalid or the register could not be written
+ * Description: Non-interactive part of rg_rate, also used by the control socket
+ *		while capturing.
+ */
+int rg_set_rate(int fd, int num) {
+	unsigned char user_buff[4];
+	
+	switch(num) {
+		case 1:
+			user_buff[0] = 0x00;
+			break;
+		case 2:
+			user_buff[0] = 0x50;
+			break;
+		case 3:
+			user_buff[0] = 0x40;
+			break;
+		case 4:
+			user_buff[0] = 0x30;
+			break;
+		case 5:
+			user_buff[0] = 0x20;
+			break;
+		case 6:
+			user_buff[0] = 0x10;
+			break;
+		case 7:
+			user_buff[0] = 0x60;
+			break;
+		case 8:
+			user_buff[0] = 0x70;
+			break;
+		case 9:
+			user_buff[0] = 0x80;
+			break;
+		case 10:
+			user_buff[0] = 0x90;
+			break;
+		default:
+			return -1;
+	}
+	
+	/* write the chosen rate to config1 register */
+	return write_pci(fd, REG_CONFIG1_RGC, user_buff, 1);
+}
+/* end of function: rg_set_rate */
+/*******************************************************************************/
+
+
+/*******************************************************************************
+ * Function   : rg_enable
+ * Inputs     : int fd - device file descriptor.
+ * Returns    : Nothing
+ * Description: Ensures generator is both on, and being output to the CODE OUT
+ *		BNC port	
+ */
+void rg_enable(int fd) {
+	unsigned char user_buff[4], tmp;
+	
+	printf("\nSetting the 'CODE OUT' BNC port to Rate Generator\n");
+	user_buff[0] = 0x02;
+	write_pci(fd, REG_CONFIG2_BNC, user_buff, 1);
+	
+	read_pci(fd, REG_CONFIG1, user_buff, 1);
+	printf("Turning on generator\n");
+	tmp = user_buff[0] & 0x08;
+	if (tmp == 0x08) {
+		user_buff[0] = user_buff[0] & 0xF7; /* clears 4th bit */
+		write_pci(fd, REG_CONFIG1, user_buff, 1);
+	}
+}
+/* end of function: rg_enable */
+/*******************************************************************************/
@@ -0,0 +1,121 @@
+/* File : 	sym560_device.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Register definitions and the non-interactive access to the
+ *		Symmetricom 560-5908-U, separated from the menus in
+ *		sym560_functions.c so that the capture pipeline and libsym560 (see
+ *		sym560.h) can use the card without them.  None of these functions
+ *		ask for input, and only rg_enable prints anything.
+ */
+
+#ifndef SYM560_DEVICE_H
+#define SYM560_DEVICE_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+/********************************************************/
+/*PCI CARD REGISTERS */
+/* See chapter 3 in the Sym560 user manual for details */
+
+/***************************************/
+/*Configuration #1 Register(4 bytes)*/
+#define REG_CONFIG1		0x118
+/* BYTE 1: Time Source Control*/
+#define REG_CONFIG1_TSC		0x118
+
+/* BYTE 2: Timecode Control */
+#define REG_CONFIG1_TCC		0x119
+
+/* BYTE 4: Rate Generator Control */
+#define REG_CONFIG1_RGC		0x11B
+/***************************************/
+
+/***************************************/
+/*Configuration #2 Register(4 bytes)*/
+#define REG_CONFIG2		0x12C
+/* BYTE 1: Miscellaneous Control*/
+#define REG_CONFIG2_MISC	0x12C
+
+/* BYTE 2: Rate Synthesizer Control */
+#define REG_CONFIG2_RSC		0x12D
+
+/* BYTE 3: Event Time Capture Control */
+#define REG_CONFIG2_ETCC	0x12E
+
+/* BYTE 4: Code Out BNC (J1) Source Select */
+#define REG_CONFIG2_BNC		0x12F
+/***************************************/
+
+/***************************************/
+/*Hardware Control Register(1 byte)*/
+#define REG_HARD_CTRL		0xF8
+/***************************************/
+
+/***************************************/
+/*Hardware Status Register(1 byte)*/
+#define REG_HARD_STATUS		0xFE
+/***************************************/
+
+/***************************************/
+/*Satellite Signal Strength Register(24 bytes)*/
+/* Bytes 1-4 */
+#define REG_SATSIG_SATA		0x198
+
+/* Bytes 5-8 */
+#define REG_SATSIG_SATB		0x19C
+
+/* Bytes 9-12 */
+#define REG_SATSIG_SATC		0x1A0
+
+/* Bytes 13-16 */
+#define REG_SATSIG_SATD		0x1A4
+
+/* Bytes 17-20 */
+#define REG_SATSIG_SATE		0x1A8
+
+/* Bytes 21-24 */
+#define REG_SATSIG_SATF		0x1AC
+/***************************************/
+
+/***************************************/
+/* Satellite Update Status Register (1 byte) */
+#define REG_SATSTAT		0x1B0
+/***************************************/
+
+/***************************************/
+/* Software Time Capture (12 bytes) */
+#define REG_SOFTTIME		0xFC
+#define REG_SOFTTIME_LOCK	0x105
+/***************************************/
+
+/***************************************/
+/* Antenna Position Register */
+#define REG_ANT_POSITION	0x108
+/***************************************/
+
+/***************************************/
+/* Driver IO commands (see sym560_ioctl in the driver) */
+#define IOCTL_EVENT_CAPTURE	0x8008f800
+#define IOCTL_CHECK_INTCSR	0x0000f803
+/***************************************/
+
+/* end of register definitions */
+/********************************************************/
+
+/* function declarations */
+int read_pci(int fd, off_t regoff, char *user_buff, int nbytes);
+int write_pci(int fd, off_t regoff, char *user_buff, int nbytes);
+int GPS_lock_status(int fd);
+int GPS_sync(int fd);
+int time_read(int fd, unsigned char *raw);
+int64_t time_decode(const unsigned char *raw);
+int sat_read(int fd, unsigned char *sat);
+int position_read(int fd, unsigned char *pos);
+int antenna_read(int fd);
+int ev_set_source(int fd, int num);
+int ev_get_setup(int fd, char *event, char *edge);
+int rg_set_rate(int fd, int num);
+void rg_enable(int fd);
+
+#endif /* SYM560_DEVICE_H */
@@ -0,0 +1,663 @@
+/* File : 	sym560_emu.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Userspace emulator of /dev/symgps, built by make emu as
+ *		sym560_emu.so.  Preloaded into an unmodified sym560_cmdline,
+ *
+ *		    LD_PRELOAD=./sym560_emu.so SYM560_EMU="rate=1000" ./sym560_cmdline auto
+ *
+ *		it takes over the opens of /dev/symgps and serves the file
+ *		operations of the driver (sym560_driver.c) from a simulated register
+ *		map: reads and writes of 1, 2 or 4 bytes at the position set by
+ *		lseek or given to pread/pwrite, and the event capture ioctl, which
+ *		blocks until the next event and returns its 12 byte time, or the
+ *		previous event's when interrupted by a signal, as the driver does.
+ *		Like the card it holds only the most recent event, so events that
+ *		arrive faster than they are read overwrite each other.
+ *
+ *		The card's clock is the system clock.  The software time capture,
+ *		lock, antenna, satellite and position registers read as a healthy,
+ *		locked card, and every other register reads back what was written.
+ *		Event interrupts are enabled and disabled through the hardware
+ *		control register as on the card.
+ *
+ *		SYM560_EMU holds comma separated settings for the pulse generator:
+ *		    rate=N	events per second, 0 for one on every ioctl (default 1000)
+ *		    seps=a/b/..	pulse separations in ms, a sequence instead of a rate
+ *		    period=ms	time between sequence starts (default 100)
+ *		    jitter=ns	each event up to this far early or late (default 0)
+ *		    loss=p	probability an event never happens (default 0)
+ *		    burst=n	n extra events every burst_ms ms (default 0)
+ *		    burst_ms=ms, burst_us=us  their spacing (default 1000 and 10)
+ *		    count=N	stop generating after N events (default no limit)
+ *		    lock_s=s	lock bits only set s seconds after GPS_sync (default 0)
+ *		    seed=N	random number seed (default 560)
+ *		SYM560_EMU_DEV is the device path to take over (default /dev/symgps)
+ *		and SYM560_EMU_STATS a file the counts are appended to when the
+ *		device is closed, one line each time, instead of stderr.
+ *
+ *		CUSE would present a real character device, but it passes neither
+ *		lseek nor the file position to the server, so the register
+ *		interface cannot be emulated that way.
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "sym560_device.h"
+#include "sym560_record.h"
+#include "sym560_sim.h"
+
+/* size of the card's register window, the limit for lseek */
+#define EMU_MEMLEN		0x200
+
+/* event capture time register */
+#define EMU_EVENTCAP		0x174
+
+/* descriptors the emulated device can be opened as */
+#define EMU_MAXFD		1024
+
+/* hardware control register bit enabling event interrupts */
+#define EMU_INT_ENABLE		0x08
+
+/* how often a wait for a disabled interrupt looks again */
+#define EMU_DISABLED_NS		10000000LL
+
+struct emu_gen {
+	struct sim sim;			/* base schedule, see sym560_sim.c */
+	int64_t jitter;
+	double loss;
+	int burst;
+	int64_t burst_every;
+	int64_t burst_gap;
+	uint64_t count;
+	unsigned int seed;
+	uint64_t base;			/* next base event */
+	int64_t base_ns;		/* its time, if have_base */
+	int have_base;
+	uint64_t burst_no;		/* next burst */
+	int burst_left;			/* events of it still to come */
+	int64_t last_ns;		/* time of the last event generated */
+	uint64_t made;			/* events generated */
+	uint64_t never;			/* events dropped by loss */
+};
+
+struct emu {
+	pthread_mutex_t lock;
+	int open_count;
+	int inited;
+	const char *dev;
+	unsigned char reg[EMU_MEMLEN];
+	int64_t pos[EMU_MAXFD];		/* file position of each emulated descriptor, -1 = not ours */
+	struct emu_gen gen;
+	int64_t next_ns;		/* time of the next event, relative to gen.sim.t0 */
+	int64_t lock_at;		/* CLOCK_MONOTONIC time the lock comes in, 0 = locked */
+	int64_t lock_delay;
+	unsigned char evdata[REC_RAW_LEN];	/* last event delivered */
+	uint64_t delivered;		/* events returned by the ioctl */
+	uint64_t overwritten;		/* events replaced before being read */
+	uint64_t interrupted;		/* ioctls ended by a signal */
+	const char *spec;		/* SYM560_EMU, NULL if not set or not understood */
+	const char *stats;
+};
+
+static struct emu emu = {PTHREAD_MUTEX_INITIALIZER};
+
+static int (*real_open)(const char *, int, ...);
+static int (*real_close)(int);
+static ssize_t (*real_read)(int, void *, size_t);
+static ssize_t (*real_write)(int, const void *, size_t);
+static ssize_t (*real_pread)(int, void *, size_t, off_t);
+static ssize_t (*real_pwrite)(int, const void *, size_t, off_t);
+static off_t (*real_lseek)(int, off_t, int);
+static int (*real_ioctl)(int, unsigned long, ...);
+
+/*******************************************************************************/
+/* Function   : emu_parse
+ * Inputs     : struct emu_gen *g - generator to configure
+ *		const char *spec - SYM560_EMU, NULL for the defaults
+ * Returns    : 0 on success
+ *             -1 if a setting is not understood
+ */
+static int emu_parse(struct emu_gen *g, const char *spec) {
+	char buf[512], *tok, *save, *val, *sep;
+	double rate = 1000, period = 100, psep[SIM_MAX_PULSES];
+	int npsep = 0;
+
+	memset(g, 0, sizeof(*g));
+	g->burst_every = 1000000000LL;
+	g->burst_gap = 10000;
+	g->seed = 560;
+	snprintf(buf, sizeof(buf), "%s", spec != NULL ? spec : "");
+	for (tok = strtok_r(buf, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save)) {
+		val = strchr(tok, '=');
+		if (val == NULL) {
+			return -1;
+		}
+		*val++ = '\0';
+		if (strcmp(tok, "rate") == 0) {
+			rate = atof(val);
+		}
+		else if (strcmp(tok, "seps") == 0) {
+			for (sep = val; sep != NULL && npsep < SIM_MAX_PULSES - 1; sep = strchr(sep, '/')) {
+				if (*sep == '/') {
+					sep++;
+				}
+				psep[npsep++] = atof(sep);
+			}
+		}
+		else if (strcmp(tok, "period") == 0) {
+			period = atof(val);
+		}
+		else if (strcmp(tok, "jitter") == 0) {
+			g->jitter = atoll(val);
+		}
+		else if (strcmp(tok, "loss") == 0) {
+			g->loss = atof(val);
+		}
+		else if (strcmp(tok, "burst") == 0) {
+			g->burst = atoi(val);
+		}
+		else if (strcmp(tok, "burst_ms") == 0) {
+			g->burst_every = (int64_t)(atof(val) * 1e6);
+		}
+		else if (strcmp(tok, "burst_us") == 0) {
+			g->burst_gap = (int64_t)(atof(val) * 1e3);
+		}
+		else if (strcmp(tok, "count") == 0) {
+			g->count = strtoull(val, NULL, 10);
+		}
+		else if (strcmp(tok, "lock_s") == 0) {
+			emu.lock_delay = (int64_t)(atof(val) * 1e9);
+		}
+		else if (strcmp(tok, "seed") == 0) {
+			g->seed = atoi(val);
+		}
+		else {
+			return -1;
+		}
+	}
+	if (g->burst_every <= 0) {
+		g->burst = 0;
+	}
+	if (npsep != 0) {
+		return sim_init_pattern(&g->sim, psep, npsep, period, 0);
+	}
+	sim_init(&g->sim, rate, 0);
+	return 0;
+}
+/* end of function: emu_parse */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : emu_next
+ * Inputs     : struct emu_gen *g - generator
+ * Returns    : Time of the next event relative to the start, in ns, -1 once
+ *		count events have been generated
+ * Description: Merges the base schedule, with its jitter and losses, and the
+ *		bursts.  Times never go backwards, however large the jitter.
+ */
+static int64_t emu_next(struct emu_gen *g) {
+	int64_t ns, burst_ns;
+
+	if (g->count != 0 && g->made >= g->count) {
+		return -1;
+	}
+	while (!g->have_base) {
+		ns = sim_event_ns(&g->sim, g->base++);
+		if (g->loss > 0 && rand_r(&g->seed) < g->loss * ((double)RAND_MAX + 1)) {
+			g->never++;
+			continue;
+		}
+		if (g->jitter > 0) {
+			ns += (int64_t)(((double)rand_r(&g->seed) / RAND_MAX * 2 - 1) * g->jitter);
+		}
+		g->base_ns = ns;
+		g->have_base = 1;
+	}
+	ns = g->base_ns;
+	if (g->burst > 0) {
+		if (g->burst_left == 0) {
+			g->burst_no++;
+			g->burst_left = g->burst;
+		}
+		burst_ns = (int64_t)g->burst_no * g->burst_every + (g->burst - g->burst_left) * g->burst_gap;
+		if (burst_ns < ns) {
+			g->burst_left--;
+			ns = burst_ns;
+		}
+		else {
+			g->have_base = 0;
+		}
+	}
+	else {
+		g->have_base = 0;
+	}
+	if (ns <= g->last_ns && g->made != 0) {
+		ns = g->last_ns + 100;
+	}
+	g->last_ns = ns;
+	g->made++;
+	return ns;
+}
+/* end of function: emu_next */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : emu_bcd
+ * Inputs     : int val - 0 to 99
+ * Returns    : val in BCD
+ */
+static unsigned char emu_bcd(int val) {
+	return (val / 10) << 4 | val % 10;
+}
+/* end of function: emu_bcd */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : emu_softtime
+ * Inputs     : None, called with emu.lock held
+ * Returns    : Nothing
+ * Description: Latches the current time into the software time capture
+ *		register, laid out as time_decode expects.  The hardware status
+ *		byte in the middle of it and the lock bits are left alone.
+ */
+static void emu_softtime(void) {
+	unsigned char raw[REC_RAW_LEN], *st = &emu.reg[REG_SOFTTIME];
+	struct timespec now;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	/* rec_encode does the calendar, only the digits move */
+	rec_encode(now.tv_sec * 1000000000LL + now.tv_nsec, raw);
+	st[0] = raw[0];
+	st[1] = raw[1];
+	st[3] = raw[10];
+	st[4] = raw[2];
+	st[5] = raw[3];
+	st[6] = raw[4];
+	st[7] = raw[5];
+	st[8] = raw[6];
+	st[9] = (st[9] & 0xF0) | (raw[7] & 0x0F);
+	st[10] = raw[8];
+	st[11] = raw[9];
+}
+/* end of function: emu_softtime */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : emu_init
+ * Inputs     : None, called with emu.lock held
+ * Returns    : Nothing
+ * Description: Powers up the simulated card on the first open.
+ */
+static void emu_init(void) {
+	static const unsigned char sat[6] = {3, 7, 11, 16, 20, 28};
+	int cnt;
+
+	if (emu.inited) {
+		return;
+	}
+	emu.inited = 1;
+	emu.dev = getenv("SYM560_EMU_DEV") != NULL ? getenv("SYM560_EMU_DEV") : "/dev/symgps";
+	emu.stats = getenv("SYM560_EMU_STATS");
+	for (cnt = 0; cnt < EMU_MAXFD; cnt++) {
+		emu.pos[cnt] = -1;
+	}
+	emu.spec = getenv("SYM560_EMU");
+	if (emu_parse(&emu.gen, emu.spec) != 0) {
+		fprintf(stderr, "sym560_emu: SYM560_EMU not understood, using the defaults\n");
+		emu.spec = NULL;
+		emu.lock_delay = 0;
+		emu_parse(&emu.gen, NULL);
+	}
+	emu.next_ns = emu_next(&emu.gen);
+	emu.reg[REG_HARD_STATUS] = 0x30;
+	emu.reg[REG_SOFTTIME_LOCK] = emu.lock_delay == 0 ? REC_LOCK_ALL : 0;
+	emu.reg[REG_CONFIG1_TSC] = emu.lock_delay == 0 ? 0x21 : 0;
+	for (cnt = 0; cnt < 6; cnt++) {
+		/* SV number, then signal strength tens and tenths */
+		emu.reg[REG_SATSIG_SATA + cnt*4] = emu_bcd(sat[cnt]);
+		emu.reg[REG_SATSIG_SATA + cnt*4 + 2] = emu_bcd(cnt * 7 % 10);
+		emu.reg[REG_SATSIG_SATA + cnt*4 + 3] = emu_bcd(40 + cnt);
+	}
+	emu.reg[REG_ANT_POSITION] = 0x52;
+	emu.reg[REG_ANT_POSITION + 4] = 0x10;
+	emu.reg[REG_ANT_POSITION + 8] = 0x06;
+}
+/* end of function: emu_init */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : emu_restart
+ * Inputs     : None, called with emu.lock held
+ * Returns    : Nothing
+ * Description: Starts the pulse generator again from now, when the event
+ *		interrupt is enabled, so that the events the card saw while
+ *		nobody was capturing are not counted as overwritten.
+ */
+static void emu_restart(void) {
+	uint64_t never = emu.gen.never;
+
+	emu_parse(&emu.gen, emu.spec);
+	emu.gen.never = never;
+	emu.next_ns = emu_next(&emu.gen);
+}
+/* end of function: emu_restart */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : emu_is_dev
+ * Inputs     : int fd - file descriptor
+ * Returns    : 1 if fd is the emulated device
+ */
+static int emu_is_dev(int fd) {
+	return fd >= 0 && fd < EMU_MAXFD && emu.inited && emu.pos[fd] >= 0;
+}
+/* end of function: emu_is_dev */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : emu_resolve
+ * Inputs     : None
+ * Returns    : Nothing
+ * Description: Finds the C library's own file operations.
+ */
+__attribute__((constructor)) static void emu_resolve(void) {
+	real_open = dlsym(RTLD_NEXT, "open");
+	real_close = dlsym(RTLD_NEXT, "close");
+	real_read = dlsym(RTLD_NEXT, "read");
+	real_write = dlsym(RTLD_NEXT, "write");
+	real_pread = dlsym(RTLD_NEXT, "pread");
+	real_pwrite = dlsym(RTLD_NEXT, "pwrite");
+	real_lseek = dlsym(RTLD_NEXT, "lseek");
+	real_ioctl = dlsym(RTLD_NEXT, "ioctl");
+}
+/* end of function: emu_resolve */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : emu_access
+ * Inputs     : int fd - emulated device
+ *		void *buf - data to write, or buffer to read into
+ *		size_t count - 1, 2 or 4 as for the driver
+ *		int64_t off - register offset
+ *		int wr - 1 to write
+ * Returns    : count on success
+ *             -1 with errno EPERM for any other count (the driver returns
+ *		-1) and EINVAL beyond the register window
+ * Description: What the card does on a write: the software time capture
+ *		register latches the time, the hardware status register reports
+ *		the antenna, the hardware control register enables and clears the
+ *		event interrupt, and setting the synchronized generator starts the
+ *		lock.
+ */
+static ssize_t emu_access(int fd, void *buf, size_t count, int64_t off, int wr) {
+	if (count != 1 && count != 2 && count != 4) {
+		errno = EPERM;
+		return -1;
+	}
+	if (off < 0 || off + (int64_t)count > EMU_MEMLEN) {
+		errno = EINVAL;
+		return -1;
+	}
+	pthread_mutex_lock(&emu.lock);
+	if (emu.lock_at != 0 && sim_now() >= emu.lock_at) {
+		emu.reg[REG_SOFTTIME_LOCK] |= REC_LOCK_ALL;
+		emu.lock_at = 0;
+	}
+	if (!wr) {
+		memcpy(buf, &emu.reg[off], count);
+	}
+	else if (off == REG_SOFTTIME) {
+		emu_softtime();
+	}
+	else if (off == REG_HARD_STATUS) {
+		/* antenna status, always good */
+	}
+	else if (off == REG_HARD_CTRL) {
+		if ((emu.reg[REG_HARD_CTRL] & EMU_INT_ENABLE) == 0 && (*(unsigned char *)buf & EMU_INT_ENABLE) != 0) {
+			emu_restart();
+		}
+		memcpy(&emu.reg[off], buf, count);
+	}
+	else {
+		memcpy(&emu.reg[off], buf, count);
+		if (off == REG_CONFIG1_TSC && emu.reg[REG_CONFIG1_TSC] == 0x21
+				&& (emu.reg[REG_SOFTTIME_LOCK] & REC_LOCK_ALL) != REC_LOCK_ALL) {
+			emu.lock_at = sim_now() + emu.lock_delay;
+		}
+	}
+	pthread_mutex_unlock(&emu.lock);
+	return count;
+}
+/* end of function: emu_access */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : emu_event
+ * Inputs     : void *arg - user buffer for the 12 byte event time
+ * Returns    : 0
+ *             -1 with errno EFAULT for a NULL buffer
+ * Description: The event capture ioctl.  Sleeps until the next event is due
+ *		and the interrupt is enabled, then returns the latest event that
+ *		has happened, counting the ones it replaced.  With rate=0 an event
+ *		is due on every call.  Once count events have been generated it
+ *		waits for a signal.  A signal ends the wait with the previous
+ *		event, as wait_event_interruptible does in the driver.
+ */
+static int emu_event(void *arg) {
+	struct timespec until;
+	int64_t due, now, latest;
+
+	if (arg == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+	pthread_mutex_lock(&emu.lock);
+	for (;;) {
+		now = sim_now() - emu.gen.sim.t0;
+		if ((emu.reg[REG_HARD_CTRL] & EMU_INT_ENABLE) == 0) {
+			due = now + EMU_DISABLED_NS;
+		}
+		else if (emu.next_ns < 0) {
+			due = now + 1000000000LL;
+		}
+		else if (!emu.gen.sim.paced || emu.next_ns <= now) {
+			break;
+		}
+		else {
+			due = emu.next_ns;
+		}
+		pthread_mutex_unlock(&emu.lock);
+		due += emu.gen.sim.t0;
+		until.tv_sec = due / 1000000000LL;
+		until.tv_nsec = due % 1000000000LL;
+		if (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) == EINTR) {
+			pthread_mutex_lock(&emu.lock);
+			emu.interrupted++;
+			memcpy(arg, emu.evdata, REC_RAW_LEN);
+			pthread_mutex_unlock(&emu.lock);
+			return 0;
+		}
+		pthread_mutex_lock(&emu.lock);
+	}
+
+	/* only the most recent of the events that have happened is kept */
+	latest = emu.next_ns;
+	emu.next_ns = emu_next(&emu.gen);
+	while (emu.gen.sim.paced && emu.next_ns >= 0 && emu.next_ns <= now) {
+		emu.overwritten++;
+		latest = emu.next_ns;
+		emu.next_ns = emu_next(&emu.gen);
+	}
+	rec_encode(emu.gen.sim.start_ns + latest, emu.evdata);
+	memcpy(&emu.reg[EMU_EVENTCAP], emu.evdata, REC_RAW_LEN);
+	emu.delivered++;
+	memcpy(arg, emu.evdata, REC_RAW_LEN);
+	pthread_mutex_unlock(&emu.lock);
+	return 0;
+}
+/* end of function: emu_event */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : emu_report
+ * Inputs     : None, called with emu.lock held
+ * Returns    : Nothing
+ * Description: generated counts every event that happened; each was either
+ *		delivered or overwritten, apart from the one waiting to be read.
+ */
+static void emu_report(void) {
+	FILE *fp = stderr;
+
+	if (emu.stats != NULL && (fp = fopen(emu.stats, "a")) == NULL) {
+		fp = stderr;
+	}
+	fprintf(fp, "sym560_emu: generated %llu delivered %llu overwritten %llu never_happened %llu interrupted %llu\n",
+			(unsigned long long)(emu.delivered + emu.overwritten),
+			(unsigned long long)emu.delivered, (unsigned long long)emu.overwritten,
+			(unsigned long long)emu.gen.never, (unsigned long long)emu.interrupted);
+	if (fp != stderr) {
+		fclose(fp);
+	}
+}
+/* end of function: emu_report */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* The interposed C library functions.  Anything not on the emulated device
+ * goes straight through. */
+
+int open(const char *path, int flags, ...) {
+	va_list ap;
+	mode_t mode = 0;
+	int fd;
+
+	if (flags & O_CREAT) {
+		va_start(ap, flags);
+		mode = va_arg(ap, mode_t);
+		va_end(ap);
+	}
+	pthread_mutex_lock(&emu.lock);
+	emu_init();
+	if (strcmp(path, emu.dev) != 0) {
+		pthread_mutex_unlock(&emu.lock);
+		return real_open(path, flags, mode);
+	}
+	/* a real descriptor, so the number is not handed out twice */
+	fd = real_open("/dev/null", O_RDWR);
+	if (fd >= EMU_MAXFD) {
+		real_close(fd);
+		errno = EMFILE;
+		fd = -1;
+	}
+	if (fd >= 0) {
+		emu.pos[fd] = 0;
+		emu.open_count++;
+	}
+	pthread_mutex_unlock(&emu.lock);
+	return fd;
+}
+
+int open64(const char *path, int flags, ...) __attribute__((alias("open")));
+
+int close(int fd) {
+	if (emu_is_dev(fd)) {
+		pthread_mutex_lock(&emu.lock);
+		emu.pos[fd] = -1;
+		if (--emu.open_count == 0) {
+			emu_report();
+		}
+		pthread_mutex_unlock(&emu.lock);
+	}
+	return real_close(fd);
+}
+
+ssize_t read(int fd, void *buf, size_t count) {
+	if (emu_is_dev(fd)) {
+		return emu_access(fd, buf, count, emu.pos[fd], 0);
+	}
+	return real_read(fd, buf, count);
+}
+
+ssize_t write(int fd, const void *buf, size_t count) {
+	if (emu_is_dev(fd)) {
+		return emu_access(fd, (void *)buf, count, emu.pos[fd], 1);
+	}
+	return real_write(fd, buf, count);
+}
+
+ssize_t pread(int fd, void *buf, size_t count, off_t off) {
+	if (emu_is_dev(fd)) {
+		return emu_access(fd, buf, count, off, 0);
+	}
+	return real_pread(fd, buf, count, off);
+}
+
+ssize_t pread64(int fd, void *buf, size_t count, off_t off) __attribute__((alias("pread")));
+
+ssize_t pwrite(int fd, const void *buf, size_t count, off_t off) {
+	if (emu_is_dev(fd)) {
+		return emu_access(fd, (void *)buf, count, off, 1);
+	}
+	return real_pwrite(fd, buf, count, off);
+}
+
+ssize_t pwrite64(int fd, const void *buf, size_t count, off_t off) __attribute__((alias("pwrite")));
+
+off_t lseek(int fd, off_t off, int whence) {
+	if (emu_is_dev(fd)) {
+		/* as sym560_llseek: only absolute positions inside the window */
+		if (whence != SEEK_SET || off < 0 || off > EMU_MEMLEN) {
+			errno = EINVAL;
+			return -1;
+		}
+		emu.pos[fd] = off;
+		return off;
+	}
+	return real_lseek(fd, off, whence);
+}
+
+off_t lseek64(int fd, off_t off, int whence) __attribute__((alias("lseek")));
+
+int ioctl(int fd, unsigned long request, ...) {
+	va_list ap;
+	void *arg;
+
+	va_start(ap, request);
+	arg = va_arg(ap, void *);
+	va_end(ap);
+	if (!emu_is_dev(fd)) {
+		return real_ioctl(fd, request, arg);
+	}
+	if (request == IOCTL_EVENT_CAPTURE) {
+		return emu_event(arg);
+	}
+	if (request == IOCTL_CHECK_INTCSR || request == 0xf801 || request == 0xf802) {
+		/* the interrupt controller is always set up, the tests do nothing */
+		return 0;
+	}
+	errno = ENOTTY;
+	return -1;
+}
+/* end of interposed functions */
+/*******************************************************************************/
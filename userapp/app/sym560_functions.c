@@ -91,38 +91,6 @@ int print_rategen_menu() {
 /*******************************************************************************/
 
 
-/*******************************************************************************/
-/* Function   : read_pci
- * Inputs     : int fd - file descriptor for the GPS-PCI device
- *              off_t regoff - location to read from
- *              char *user_buff - user buffer that will contain the read data
-                int nbytes - Number of bytes to read
- * Returns    : 0 on Success
- *             -1 on Failure
- * Description: Reads data from the GPS-PCI device into a user buffer by first setting
- *              the position with lseek and then reading.
- */
-int read_pci(int fd, off_t regoff, char *user_buff, int nbytes) {
-	int ret;
-	
-	/* set position to read from */
-	ret = lseek(fd, regoff, SEEK_SET);
-	if (ret == -1) {
-		return -1;
-	}
-	
-	/* read from device */
-	ret = read(fd, user_buff, nbytes);
-	if (ret == -1) {
-		return -1;
-	}
-	
-	return 0;
-}
-/* end of function: read_pci */
-/*******************************************************************************/
-
-
 /*******************************************************************************/
 /* Function   : read_pci_verbose
  * Inputs     : int fd - file descriptor for the GPS-PCI device
@@ -157,38 +125,6 @@ int read_pci_verbose(int fd, off_t regoff, char *user_buff, int nbytes) {
 /*******************************************************************************/
 
 
-/*******************************************************************************/
-/* Function   : write_pci
- * Inputs     : int fd - file descriptor for the GPS-PCI device
- *              off_t regoff - location to write to
- *              char *user_buff - user buffer containing the data to be written
-                int nbytes - Number of bytes to write
- * Returns    : 0 on Success
- *             -1 on Failure
- * Description: Writes data to the GPS-PCI device from a user buffer by first setting
- *              the position and then writing.
- */
-int write_pci(int fd, off_t regoff, char *user_buff, int nbytes) {
-	int ret;
-	
-	/* set position to write to */
-	ret = lseek(fd, regoff, SEEK_SET);
-	if (ret == -1) {
-		return -1;
-	}
-	
-	/* write to device */
-	ret = write(fd, user_buff, nbytes);
-	if (ret == -1) {
-		return -1;
-	}
-	
-	return 0;
-}
-/* end of function: write_pci */
-/*******************************************************************************/
-
-
 /*******************************************************************************/
 /* Function   : write_pci_verbose
  * Inputs     : int fd - file descriptor for the GPS-PCI device
@@ -225,19 +161,17 @@ int write_pci_verbose(int fd, off_t regoff, char *user_buff, int nbytes) {
 
 
 /*******************************************************************************/
-/* Function   : GPS_init
+/* Function   : GPS_start
  * Inputs     : int fd - file descriptor for the GPS-PCI device
  * Returns    : 0 on Success
- *             -1 if GPS was not properly initialized
- * Description: Checks antenna for any shorts or open loads and then sets the PCI 
- *		card to run in synchronized generator mode.  Then checks in 20 sec
- *		intervals for a certain number of times to acquire a gps lock.
+ *             -1 on Failure
+ * Description: First half of GPS_init.  Checks antenna for any shorts or open
+ *		loads and then sets the PCI card to run in synchronized generator
+ *		mode, without waiting for the lock.
  */
-int GPS_init(int fd) {
-	int ret, cnt, gpslock;
-	int maxtime = 15;
-	unsigned char binbuff[10];
-	char user_buff[4], tmp;
+int GPS_start(int fd) {
+	int ret;
+	char user_buff[4];
 	
 	/* Check the antenna status */
 	printf("\n\nChecking GPS Antenna...\n");
@@ -265,11 +199,34 @@ int GPS_init(int fd) {
 	
 	/* start synchronized generator and use gps reference */
 	printf("\nStarting synchronized generator with GPS reference\n");
-	user_buff[0] = 0x21;
-	ret = write_pci(fd, REG_CONFIG1_TSC, user_buff, 1);
+	ret = GPS_sync(fd);
 	if (ret == -1) {
 		return -1;
 	}
+	return 0;
+}
+/* end of function: GPS_start */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : GPS_init
+ * Inputs     : int fd - file descriptor for the GPS-PCI device
+ * Returns    : 0 on Success
+ *             -1 if GPS was not properly initialized
+ * Description: Checks antenna for any shorts or open loads and then sets the PCI 
+ *		card to run in synchronized generator mode.  Then checks in 20 sec
+ *		intervals for a certain number of times to acquire a gps lock.
+ */
+int GPS_init(int fd) {
+	int ret, cnt, gpslock;
+	int maxtime = 15;
+	unsigned char binbuff[10];
+	char user_buff[4], tmp;
+	
+	if (GPS_start(fd) == -1) {
+		return -1;
+	}
 	
 	/* Wait until lock status bits are set */
 	printf("\nChecking GPS Signal Status...\n");
@@ -342,35 +299,19 @@ int GPS_init(int fd) {
 
 
 /*******************************************************************************
- * Function   : satsig
- * Inputs     : int fd - device file descriptor.
- * Returns    : 0 on success
- *         	1 if signal is being updated
- * Description: Checks and prints out the satellite signal strength for the six
- *              satellites that are locked.  If the GPS is not hooked up or the 
- *              satellite lock has not been achieved, then the strength will be
- *              0.
+ * Function   : sat_print
+ * Inputs     : const unsigned char *sat - 24 bytes as read by sat_read
+ * Returns    : Nothing
  */
-int satsig(int fd) {
-	unsigned char user_buff[4];
+void sat_print(const unsigned char *sat) {
 	unsigned char svnum_tens, svnum_unit, sig_tens, sig_unit, sig_tenths, sig_hunds;
-	int cnt, ret, offset;
+	const unsigned char *user_buff;
+	int cnt;
 
-	printf("\n\n\n");
-	
-	/* Check satelite update status */
-	ret = read_pci(fd, REG_SATSTAT, user_buff, 1);
-	if (user_buff[0] != 0) {
-		printf("Satellite signal status is being updated, try again\n");
-		return 1;
-	}
-	
 	printf("Satellite Signals (6 can be tracked at one time)\n\n");
 	
-	/* loop through all six satellite locks */
 	for (cnt = 0; cnt < 6; cnt++) {
-		offset = REG_SATSIG_SATA + (cnt*4);
-		ret = read_pci(fd, offset, user_buff, 4);
+		user_buff = &sat[cnt*4];
 		
 		/* store proper data into variables */
 		svnum_tens = user_buff[0] >> 4;
@@ -394,34 +335,56 @@ int satsig(int fd) {
 		printf("%d%d.%d%d \n\n", sig_tens, sig_unit, sig_tenths, sig_hunds);
 		//STARTBLACK();
 		printf("\n");
-		
-		/* Check satelite update status */
-		ret = read_pci(fd, REG_SATSTAT, user_buff, 1);
-		if (user_buff[0] != 0) {
-			printf("(data was being updated, try again)\n");
-			return 1;
-		}
 	}
-	return 0;
 }
-/* end of function: sat_sig */
+/* end of function: sat_print */
 /*******************************************************************************/
 
 
 /*******************************************************************************
- * Function   : fetch_position
+ * Function   : satsig
  * Inputs     : int fd - device file descriptor.
  * Returns    : 0 on success
- *             -1 on failure
- * Description: Read longitude, latitude and altitude from device and print it out
+ *         	1 if signal is being updated
+ * Description: Checks and prints out the satellite signal strength for the six
+ *              satellites that are locked.  If the GPS is not hooked up or the 
+ *              satellite lock has not been achieved, then the strength will be
+ *              0.  While the automatic mode is running the values it publishes
+ *              (see sym560_status.c) are shown instead of reading the card.
  */
-int fetch_position(int fd) {
-	int ret, cnt, good_data;
-	/* buffers being used to fetch the data */
-	unsigned char quad_1[2][4];
-	unsigned char quad_2[2][4];
-	unsigned char quad_3[2][4];
-	unsigned char quad_4[2][4];
+int satsig(int fd) {
+	struct sym560_status st;
+	unsigned char sat[24];
+	int ret;
+
+	printf("\n\n\n");
+	
+	if (stat_read(&st) == 0 && st.sat_valid) {
+		stat_print_age(&st);
+		sat_print(st.sat);
+		return 0;
+	}
+	
+	ret = sat_read(fd, sat);
+	if (ret != 0) {
+		printf("Satellite signal status is being updated, try again\n");
+		return 1;
+	}
+	sat_print(sat);
+	return 0;
+}
+/* end of function: sat_sig */
+/*******************************************************************************/
+
+
+/*******************************************************************************
+ * Function   : position_print
+ * Inputs     : const unsigned char *pos - 16 bytes as read by position_read
+ * Returns    : Nothing
+ * Description: Prints longitude, latitude and altitude.
+ */
+void position_print(const unsigned char *pos) {
+	const unsigned char *quad_1 = pos, *quad_2 = pos + 4, *quad_3 = pos + 8, *quad_4 = pos + 12;
 	/* variables to hold the latitude/longitude info */
 	unsigned char lat_unit_deg, lat_tens_deg, lat_hund_deg;
 	unsigned char lat_unit_min, lat_tens_min;
@@ -434,74 +397,35 @@ int fetch_position(int fd) {
 	unsigned char alt_unit_km, alt_tens_km, alt_sign;
 	unsigned char alt_tenths_m, alt_unit_m, alt_tens_m, alt_hund_m;
 	
-	/* read the position register twice (as recommended pg 30 of manual)*/
-	for (cnt = 0; cnt < 2; cnt++) {
-		ret = read_pci(fd, REG_ANT_POSITION, &quad_1[cnt][0], 4);
-		if (ret == -1) {
-			printf("\nFailed to read time capture register\n");
-			return -1;
-		}
-		ret = read_pci(fd, REG_ANT_POSITION + 4, &quad_2[cnt][0], 4);
-		if (ret == -1) {
-			printf("\nFailed to read time capture register\n");
-			return -1;
-		}
-		ret = read_pci(fd, REG_ANT_POSITION + 8, &quad_3[cnt][0], 4);
-		if (ret == -1) {
-			printf("\nFailed to read time capture register\n");
-			return -1;
-		}
-		ret = read_pci(fd, REG_ANT_POSITION + 12, &quad_4[cnt][0], 4);
-		if (ret == -1) {
-			printf("\nFailed to read time capture register\n");
-			return -1;
-		}
-	}
-	
-	/* verify the two readings are identical */
-	good_data = 1;
-	for (cnt = 0; cnt < 3; cnt++) {
-		if ((quad_1[0][cnt] != quad_1[1][cnt]) && (quad_2[0][cnt] != quad_2[1][cnt])) {
-			good_data = 0;
-		}
-		if ((quad_3[0][cnt] != quad_3[1][cnt]) && (quad_4[0][cnt] != quad_4[1][cnt])) {
-			good_data = 0;
-		}
-	}
-	if (good_data == 0) {
-		printf("\n\nThere may be an error in position.  Try again\n");
-		return -1;
-	}
-	
 	/* assign the values */
-	lat_unit_deg = quad_1[0][0] & 0x0F;
-	lat_tens_deg = quad_1[0][0] >> 4;
-	lat_hund_deg = quad_1[0][1] & 0x0F;
-	lat_unit_min = quad_1[0][2] & 0x0F;
-	lat_tens_min = quad_1[0][2] >> 4;
-	lat_NorS = quad_1[0][3];
-	
-	lat_tenths_sec = quad_2[0][0] & 0x0F;
-	lat_unit_sec = quad_2[0][1] & 0x0F;
-	lat_tens_sec = quad_2[0][1] >> 4;
-	lon_unit_deg = quad_2[0][2] & 0X0F;
-	lon_tens_deg = quad_2[0][2] >> 4;
-	lon_hund_deg = quad_2[0][3] & 0x0F;
-	
-	lon_unit_min = quad_3[0][0] & 0x0F;
-	lon_tens_min = quad_3[0][0] >> 4;
-	lon_EorW = quad_3[0][1];
-	lon_tenths_sec = quad_3[0][2] & 0x0F;
-	lon_unit_sec = quad_3[0][3] & 0x0F;
-	lon_tens_sec = quad_3[0][3] >> 4;
-	
-	alt_unit_km = quad_4[0][0] & 0x0F;
-	alt_tens_km = quad_4[0][0] >> 4;
-	alt_sign = quad_4[0][1];
-	alt_tenths_m = quad_4[0][2] & 0x0F;
-	alt_unit_m = quad_4[0][2] >> 4;
-	alt_tens_m = quad_4[0][3] & 0x0F;
-	alt_hund_m = quad_4[0][3] >> 4;
+	lat_unit_deg = quad_1[0] & 0x0F;
+	lat_tens_deg = quad_1[0] >> 4;
+	lat_hund_deg = quad_1[1] & 0x0F;
+	lat_unit_min = quad_1[2] & 0x0F;
+	lat_tens_min = quad_1[2] >> 4;
+	lat_NorS = quad_1[3];
+	
+	lat_tenths_sec = quad_2[0] & 0x0F;
+	lat_unit_sec = quad_2[1] & 0x0F;
+	lat_tens_sec = quad_2[1] >> 4;
+	lon_unit_deg = quad_2[2] & 0X0F;
+	lon_tens_deg = quad_2[2] >> 4;
+	lon_hund_deg = quad_2[3] & 0x0F;
+	
+	lon_unit_min = quad_3[0] & 0x0F;
+	lon_tens_min = quad_3[0] >> 4;
+	lon_EorW = quad_3[1];
+	lon_tenths_sec = quad_3[2] & 0x0F;
+	lon_unit_sec = quad_3[3] & 0x0F;
+	lon_tens_sec = quad_3[3] >> 4;
+	
+	alt_unit_km = quad_4[0] & 0x0F;
+	alt_tens_km = quad_4[0] >> 4;
+	alt_sign = quad_4[1];
+	alt_tenths_m = quad_4[2] & 0x0F;
+	alt_unit_m = quad_4[2] >> 4;
+	alt_tens_m = quad_4[3] & 0x0F;
+	alt_hund_m = quad_4[3] >> 4;
 	
 
 	/* print out the position */
@@ -513,7 +437,41 @@ int fetch_position(int fd) {
 	printf("%d%d\' ", lon_tens_min, lon_unit_min);
 	printf("%d%d.%d\" %c\n", lon_tens_sec, lon_unit_sec, lon_tenths_sec, lon_EorW);
 	printf("   Altitude = %c%d%d%d%d%d.%dm\n",alt_sign, alt_tens_km, alt_unit_km, alt_hund_m, alt_tens_m, alt_unit_m, alt_tenths_m);
+}
+/* end of function: position_print */
+/*******************************************************************************/
+
+
+/*******************************************************************************
+ * Function   : fetch_position
+ * Inputs     : int fd - device file descriptor.
+ * Returns    : 0 on success
+ *             -1 on failure
+ * Description: Read longitude, latitude and altitude from device and print it
+ *		out, or take them from the automatic mode's status if it is running.
+ */
+int fetch_position(int fd) {
+	struct sym560_status st;
+	unsigned char pos[16];
+	int ret;
+	
+	if (stat_read(&st) == 0 && st.pos_valid) {
+		printf("\n");
+		stat_print_age(&st);
+		position_print(st.pos);
+		return 0;
+	}
 	
+	ret = position_read(fd, pos);
+	if (ret == -1) {
+		printf("\nFailed to read time capture register\n");
+		return -1;
+	}
+	if (ret == 1) {
+		printf("\n\nThere may be an error in position.  Try again\n");
+		return -1;
+	}
+	position_print(pos);
 	return 0;
 }
 /* end of function: fetch_position */ 
@@ -530,35 +488,14 @@ int fetch_position(int fd) {
  *		and print it out.
  */
 int fetch_time(int fd) {
-	int ret;
-	unsigned char quad_1[4];
-	unsigned char quad_2[4];
-	unsigned char quad_3[4];
+	unsigned char raw[REC_RAW_LEN];
+	unsigned char *quad_1 = raw, *quad_2 = raw + 4, *quad_3 = raw + 8;
 	unsigned char unit_micro, tens_micro, hunds_micro, unit_milli, hunds_nano, tens_milli;
 	unsigned char hunds_milli, unit_sec, tens_sec, unit_min, tens_min, unit_hr, tens_hr;
 	unsigned char unit_day, tens_day, hunds_day, unit_yr, tens_yr, hunds_yr, thou_yr;
 	
-	quad_1[0] = 0xff;
-	/* write any value to location 0xFC to update the time capture register*/
-	ret = write_pci(fd, REG_SOFTTIME, quad_1, 1);
-	if (ret == -1) {
-		printf("\nFailed to read time capture register\n");
-		return -1;
-	}
-	
-	/* read the time register */
-	ret = read_pci(fd, REG_SOFTTIME, quad_1, 4);
-	if (ret == -1) {
-		printf("\nFailed to read time capture register\n");
-		return -1;
-	}
-	ret = read_pci(fd, REG_SOFTTIME + 4, quad_2, 4);
-	if (ret == -1) {
-		printf("\nFailed to read time capture register\n");
-		return -1;
-	}
-	ret = read_pci(fd, REG_SOFTTIME + 8, quad_3, 4);
-	if (ret == -1) {
+	/* update the time capture register and read it */
+	if (time_read(fd, raw) == -1) {
 		printf("\nFailed to read time capture register\n");
 		return -1;
 	}
@@ -660,9 +597,7 @@ int event_capture_menu(int fd) {
  * Description: Gets user input to change the source for external events
  */
 void ev_source(int fd) {
-	int ret;
 	int num = 0;
-	unsigned char user_buff[4];
 	
 	/* print event source options */
 	printf("\n\nEvent Sources:\n");
@@ -682,40 +617,12 @@ void ev_source(int fd) {
 	scanf( "%d", &num);
 	jsw_flush();
 	
-	switch(num) {
-		case 1:
-			user_buff[0] = 0x04;
-			break;
-		case 2:
-			user_buff[0] = 0x05;
-			break;
-		case 3:
-			user_buff[0] = 0x06;
-			break;
-		case 4:
-			user_buff[0] = 0x07;
-			break;
-		case 5:
-			user_buff[0] = 0x00;
-			break;
-		case 6:
-			user_buff[0] = 0x01;
-			break;
-		case 7:
-			user_buff[0] = 0x02;
-			break;
-		case 8:
-			user_buff[0] = 0x03;
-			break;
-		default:
-			printf("\nERROR: ");
-			printf("Invalid Choice.  Event source not changed\n");
-			return;
+	if (num < 1 || num > 8) {
+		printf("\nERROR: ");
+		printf("Invalid Choice.  Event source not changed\n");
+		return;
 	}
-	
-	/* write the chosen source to config2 register */
-	ret = write_pci(fd, REG_CONFIG2_ETCC, user_buff, 1);
-	if (ret == 0) {
+	if (ev_set_source(fd, num) == 0) {
 		//printf("\nSUCCESS: ");
 		printf("Event source changed\n");
 	}
@@ -736,30 +643,10 @@ void ev_source(int fd) {
  */
 void ev_view_setup(int fd) {
 	char event[25], edge[10];
-	unsigned char user_buff[4];
 	
-	read_pci(fd, REG_CONFIG2_ETCC, user_buff, 1);
-	
-	/* the first two bits indicate the event source */
-	if ((user_buff[0] & 0x03) == 0x00) {
-		strcpy(event, "EXTERNAL EVENT");
-	}
-	else if ((user_buff[0] & 0x03) == 0x01) {
-		strcpy(event, "RATE SYNTHESIZER");
-	}
-	else if ((user_buff[0] & 0x03) == 0x02) {
-		strcpy(event, "RATE GENERATOR");
-	}
-	else if ((user_buff[0] & 0x03) == 0x03) {
-		strcpy(event, "TIME COMPARE");
-	}
-	
-	/* the 3rd bit indicates the edge */
-	if ((user_buff[0] & 0x04) == 0x00) {
-		strcpy(edge, "FALLING");
-	}
-	else {
-		strcpy(edge, "RISING");
+	if (ev_get_setup(fd, event, edge) == -1) {
+		printf("\nERROR: Could not read the event setup\n");
+		return;
 	}
 	
 	printf("\n Event Source = %s, Trigger Edge = %s\n", event, edge);
@@ -775,69 +662,56 @@ void ev_view_setup(int fd) {
  * Inputs     : int fd - device file descriptor.
  * Returns    : 0 on success
  *             -1 on error
- * Description: Spawns a child process which executes the event_cap process.  The
- *		event_cap process enables event interrupts and then waits for events 
- *		to occur, saving the timestamps into a temporary binary file.
- *		Meanwhile the  main parent process waits until a user presses 
- *		any key followed by enter, at which point the event_cap process is killed.
- *		and interrupts are once again disabled. The binary file containing the 
- *		timestamps is read in and the binary coded decimal numbers representing the
- *		date and time are then rewritten to a plain text file named by the user.
+ * Description: Starts the capture and writer threads (see sym560_capture.c), which
+ *		enable event interrupts and then write each timestamp in plain text
+ *		to a temporary file as it arrives.  Meanwhile the main thread waits
+ *		until a user presses any key followed by enter, at which point capture
+ *		is stopped and interrupts are once again disabled.  The temporary
+ *		file is then appended to a file named by the user.
  */
 int event_capture(int fd) {
-	int binfile, txtfile, ret, len;
-	pid_t pid;
-	int eof_check = 0;
-	char fd_arg[24], binfile_arg[24];
+	struct capture cap;
+	struct cap_config cfg;
+	int tmpfile, txtfile, ret, len;
 	char *filename;
-	unsigned char user_buff[4], ch[256], large_buff[12], txtbuff[512];
-	unsigned char unit_us, tens_us, hund_us, unit_ms, tens_ms, hund_ms, unit_s, tens_s;
-	unsigned char unit_min, tens_min, unit_hr, tens_hr, unit_day, tens_day, hund_day;
-	unsigned char unit_yr, tens_yr, hund_yr, thou_yr, hund_nano;
-	
-	/* open temporary binary output file */
-	binfile = open("interrupt_data", O_RDWR|O_CREAT|O_APPEND, 00644);
-	
+	char ch[256], buff[4096];
 	
-	/* Turn the file descriptors into char strings so they can be passed 
-	 * via execl to the event_cap process */
-	sprintf(fd_arg, "%d", fd);
-	sprintf(binfile_arg, "%d", binfile);
+	/* open temporary output file */
+	tmpfile = open("interrupt_data", O_RDWR|O_CREAT|O_TRUNC, 00644);
+	if (tmpfile == -1) {
+		printf("\n\nCould not create temporary file interrupt_data\n");
+		return -1;
+	}
 	
-	/* spawn the child process */
-	pid = fork();
-	if (pid == -1) {
-		printf("\n\nFork error. Exiting.\n");
-		close(binfile);
+	cap_config_default(&cfg);
+	if (cap_init(&cap, &cfg, fd, tmpfile, NULL) != 0) {
+		close(tmpfile);
 		remove("interrupt_data");
 		return -1;
 	}
-	if (pid == 0) {
-	/* if pid is 0 then this is the child process */
-		if (execl("/usr/bin/event_cap", "event_cap", fd_arg, binfile_arg, NULL) == -1){
-			printf("execl Error!\n");
-			close(binfile);
-			remove("interrupt_data");
-			return -1;
-		}
+	if (cap_start(&cap) != 0) {
+		cap_free(&cap);
+		close(tmpfile);
+		remove("interrupt_data");
+		return -1;
 	}
-	/* otherwise this is the parent and pid = id number of child process */
-	sleep(1);
 	
-	/* this process will now suspend until any key is entered */
+	/* this thread will now suspend until any key is entered */
 	printf("\nType any character followed by <enter> to stop event capture\n");
 	scanf( "%2s", ch);
 	jsw_flush();
 	
-	/*disable the interrupt and clear the status bits*/
-	user_buff[0] = 0x01;
-	write_pci(fd, REG_HARD_CTRL, user_buff, 1);
-	
-	/* kill the child process (event_cap) */
-	kill(pid, SIGKILL);
+	/* disables the interrupt and waits for the writer to finish */
+	cap_stop(&cap);
+	printf("\n%llu events captured", (unsigned long long)cap.captured);
+	if (cap.overflows != 0) {
+		printf(", %llu dropped", (unsigned long long)cap.overflows);
+	}
+	printf("\n");
+	cap_free(&cap);
 	
 	
-	/* stream the binary file into a text file */
+	/* copy the temporary file into the users text file */
 	/***********************************************/
 	filename = readline("\nSave as file: ");
 	
@@ -854,47 +728,13 @@ int event_capture(int fd) {
 	txtfile = open(filename, O_RDWR|O_CREAT|O_APPEND, 00644);
 	free(filename); /* need to free any variable set by readline */
 	
-	/*start from the top of the binary file */
-	lseek(binfile, 0x00, SEEK_SET);
-
-	/* Loop through the binary file reading 12 bytes at a time 
-	 * because each timestamp is 12 bytes long 
-	 */
-	while (eof_check == 0) {
-		ret = read(binfile, large_buff, 12);
-		if (ret == 0) {
-			eof_check = 1;
-			continue;
-		}
-		
-		unit_us = large_buff[0] & 0x0F;
-		tens_us = large_buff[0] >> 4;
-		hund_us = large_buff[1] & 0x0F;
-		unit_ms = large_buff[1] >> 4;
-		tens_ms = large_buff[2] & 0x0F;
-		hund_ms = large_buff[2] >> 4;
-		unit_s = large_buff[3] & 0x0F;
-		tens_s = large_buff[3] >> 4;
-		unit_min = large_buff[4] & 0x0F;
-		tens_min = large_buff[4] >> 4;
-		unit_hr = large_buff[5] & 0x0F;
-		tens_hr = large_buff[5] >> 4;
-		unit_day = large_buff[6] & 0x0F;
-		tens_day = large_buff[6] >> 4;
-		hund_day = large_buff[7] & 0x0F;
-		unit_yr = large_buff[8] & 0x0F;
-		tens_yr = large_buff[8] >> 4;
-		hund_yr = large_buff[9] & 0x0F;
-		thou_yr = large_buff[9] >> 4;
-		hund_nano = large_buff[10] >> 4;
-		
-		/* print the contents in readable text format to a text buffer */
-		sprintf(txtbuff, "       YEAR = %d%d%d%d\n        DAY = %d%d%d\n       TIME = %d%d:%d%d UTC\n        SEC = %d%d.%d%d%d%d%d%d%d\n\n", thou_yr, hund_yr, tens_yr, unit_yr, hund_day, tens_day, unit_day, tens_hr, unit_hr, tens_min, unit_min, tens_s, unit_s, hund_ms, tens_ms, unit_ms, hund_us, tens_us, unit_us, hund_nano);
-		/* write the plain text buffer to the text file */
-		write(txtfile, txtbuff, strlen(txtbuff));
+	/*start from the top of the temporary file */
+	lseek(tmpfile, 0x00, SEEK_SET);
+	while ((ret = read(tmpfile, buff, sizeof(buff))) > 0) {
+		write(txtfile, buff, ret);
 	}
 	/***********************************************/
-	close(binfile);
+	close(tmpfile);
 	close(txtfile);
 	remove("interrupt_data");
 	return 0;
@@ -1011,24 +851,16 @@ void jsw_flush ( void )
 
 
 /*******************************************************************************
- * Function   : check_antenna
- * Inputs     : int fd - GSP-PCI device file descriptor
- * Returns    : 0 on success
- *	       -1 on failure
- * Description: Checks antenna for shorts or open loads.
+ * Function   : antenna_print
+ * Inputs     : int status - as returned by antenna_read
+ * Returns    : Nothing
  */
-int check_antenna(int fd) {
-	int ret;
+void antenna_print(int status) {
 	unsigned char shorted, open;
-	unsigned char user_buff[4];
-	
-	user_buff[0] = 0x70;
-	write_pci(fd, REG_HARD_STATUS, user_buff, 1);
-	ret = read_pci(fd, REG_HARD_STATUS, user_buff, 1);
 
 	/* bits 5 and 6 indicate open and short status (0 = short/open)*/
-	shorted = (user_buff[0] & 0x20) >> 5;
-	open = (user_buff[0] & 0x10) >> 4;
+	shorted = (status & STAT_ANT_NOT_SHORTED) >> 5;
+	open = (status & STAT_ANT_NOT_OPEN) >> 4;
 	
 	if (shorted == 0) {
 		printf("WARNING: GPS Antenna Shorted\n");
@@ -1039,9 +871,36 @@ int check_antenna(int fd) {
 	if (shorted == 1 && open == 1) {
 		printf("GPS Antenna is Good (no SHORTS or OPEN loads detected)\n");
 	}
+}
+/* end of function: antenna_print */
+/*******************************************************************************/
+
+
+/*******************************************************************************
+ * Function   : check_antenna
+ * Inputs     : int fd - GSP-PCI device file descriptor
+ * Returns    : 0 on success
+ *	       -1 on failure
+ * Description: Checks antenna for shorts or open loads, or takes the state from
+ *		the automatic mode's status if it is running.
+ */
+int check_antenna(int fd) {
+	struct sym560_status st;
+	int status;
+	
+	if (stat_read(&st) == 0 && st.antenna != -1) {
+		stat_print_age(&st);
+		antenna_print(st.antenna);
+		return 0;
+	}
+	status = antenna_read(fd);
+	if (status == -1) {
+		return -1;
+	}
+	antenna_print(status);
 	return 0;
 }
-/* end of function: check_antenna
+/* end of function: check_antenna */
 /*******************************************************************************/
 
 
@@ -1199,9 +1058,7 @@ void rg_view_setup(int fd) {
  * Description: Changes generator rate, after prompting user	
  */
 void rg_rate(int fd) {
-	int ret;
 	int num = 0;
-	unsigned char user_buff[4];
 	
 	/* print event source options */
 	printf("\n\nRates (in PPS):\n");
@@ -1221,46 +1078,12 @@ void rg_rate(int fd) {
 	scanf( "%d", &num);
 	jsw_flush();
 	
-	switch(num) {
-		case 1:
-			user_buff[0] = 0x00;
-			break;
-		case 2:
-			user_buff[0] = 0x50;
-			break;
-		case 3:
-			user_buff[0] = 0x40;
-			break;
-		case 4:
-			user_buff[0] = 0x30;
-			break;
-		case 5:
-			user_buff[0] = 0x20;
-			break;
-		case 6:
-			user_buff[0] = 0x10;
-			break;
-		case 7:
-			user_buff[0] = 0x60;
-			break;
-		case 8:
-			user_buff[0] = 0x70;
-			break;
-		case 9:
-			user_buff[0] = 0x80;
-			break;
-		case 10:
-			user_buff[0] = 0x90;
-			break;
-		default:
-			printf("\nERROR: ");
-			printf("Invalid Choice.  Rate left unchanged\n");
-			return;
+	if (num < 1 || num > 10) {
+		printf("\nERROR: ");
+		printf("Invalid Choice.  Rate left unchanged\n");
+		return;
 	}
-	
-	/* write the chosen source to config2 register */
-	ret = write_pci(fd, REG_CONFIG1_RGC, user_buff, 1);
-	if (ret == 0) {
+	if (rg_set_rate(fd, num) == 0) {
 		printf("\nSUCCESS: ");
 		printf("Rate changed\n");
 	}
@@ -1274,151 +1097,204 @@ void rg_rate(int fd) {
 /*******************************************************************************/
 
 
-/*******************************************************************************
- * Function   : rg_enable
- * Inputs     : int fd - device file descriptor.
- * Returns    : Nothing
- * Description: Ensures generator is both on, and being output to the CODE OUT
- *		BNC port	
- */
-void rg_enable(int fd) {
-	unsigned char user_buff[4], tmp;
-	
-	printf("\nSetting the 'CODE OUT' BNC port to Rate Generator\n");
-	user_buff[0] = 0x02;
-	write_pci(fd, REG_CONFIG2_BNC, user_buff, 1);
-	
-	read_pci(fd, REG_CONFIG1, user_buff, 1);
-	printf("Turning on generator\n");
-	tmp = user_buff[0] & 0x08;
-	if (tmp == 0x08) {
-		user_buff[0] = user_buff[0] & 0xF7; /* clears 4th bit */
-		write_pci(fd, REG_CONFIG1, user_buff, 1);
-	}
-}
-/* end of function: rg_enable */
-/*******************************************************************************/
-
-
 /*******************************************************************************
  * Function   : autostamp
  * Inputs     : int fd - device file descriptor.
  * 	      : char * tsfilename - character buffer containing filename to write to
- * 	      : after interrupt data is complete
+ * 	      : const struct cap_config *cfg - automatic mode options
  * Returns    : 0 on success
  *	       -1 on failure
  * Description: This function is very similar to the event_capture function except
  *		that it does not require user input and thus can be run automatically.
+ *		Timestamps are written to tsfilename as they arrive.  Capture runs
+ *		until the process receives SIGTERM or SIGINT (see stopstamp.bash).
+ *		SIGHUP, or crossing a multiple of cfg->rotate_ns, moves the output to
+ *		a new YYYYMMDD.HHMM.timestampdata file without stopping capture.
+ *		The GPS is only reinitialized if it is not already locked, and
+ *		nothing is captured if that fails.  Capture does not wait for the
+ *		lock; until it is acquired the output carries a LOCK line saying so.  While capturing, the card can be
+ *		reconfigured through the control socket at cfg->ctl_path, and its
+ *		state is published every cfg->status_ns (see sym560_status.c).
+ *		Sequences radar control describes in cfg->radar_name are written
+ *		with their metadata (see sym560_radar.c), and with cfg->tables every
+ *		sequence of those tables is written as it is found (see
+ *		sym560_tracker.c).  With cfg->index_ns each file has a time index
+ *		beside it (see sym560_index.h), and with cfg->columns every event is
+ *		also appended to the column store there (see sym560_column.h).
  */
-int autostamp(int fd, char *tsfilename) {
-	int binfile, txtfile, len, ret;
-	pid_t pid;
-	int eof_check = 0;
-	char fd_arg[24], binfile_arg[24];
-	char filename[32];
-	unsigned char user_buff[4], large_buff[12], txtbuff[512];
-	unsigned char unit_us, tens_us, hund_us, unit_ms, tens_ms, hund_ms, unit_s, tens_s;
-	unsigned char unit_min, tens_min, unit_hr, tens_hr, unit_day, tens_day, hund_day;
-	unsigned char unit_yr, tens_yr, hund_yr, thou_yr, hund_nano;
+int autostamp(int fd, char *tsfilename, const struct cap_config *cfg) {
+	struct capture cap;
+	struct control ctl;
+	struct broker br;
+	struct stream str;
+	struct exporter ex;
+	struct joiner rad;
+	struct tracker trk;
+	int txtfile, sig, lock, ctl_running = 0, br_running = 0, str_running = 0, ex_running = 0;
+	int rad_running = 0, trk_running = 0;
+	int64_t start_ns;
+	sigset_t set;
 	
 
-	/* make sure drivers are loaded */
+	start_ns = sim_now();
 	
-	/* attempt to initialize the GPS for at most 5 minutes */
-	GPS_init(fd);
+	/* only reinitialize the GPS when it is not already locked, and then
+	 * don't wait for the lock: capture starts straight away and the capture's
+	 * lock thread tags records and reports when the lock comes in */
+	lock = GPS_lock_status(fd);
+	if (lock == REC_LOCK_ALL) {
+		printf("\nGPS already locked, skipping initialization\n");
+	}
+	else {
+		if (lock == -1) {
+			printf("\nCould not read the GPS lock status, initializing the GPS\n");
+		}
+		/* without the synchronized generator every timestamp would be
+		 * off, so don't capture at all */
+		if (GPS_start(fd) == -1) {
+			printf("\nCould not start the synchronized generator, not timestamping\n");
+			return -1;
+		}
+		if (lock != -1) {
+			printf("\nGPS is not locked yet (0x%02x), timestamping while it locks\n", lock);
+		}
+		else {
+			printf("\nTimestamping while the GPS locks\n");
+		}
+	}
 	
 	/* setup the output file */
-
-	binfile = open("interrupt_data", O_RDWR|O_CREAT|O_APPEND, 00644);
-	
+	txtfile = open(tsfilename, O_RDWR|O_CREAT|O_APPEND, 00644);
+	if (txtfile == -1) {
+		printf("\n\nCould not open %s\n", tsfilename);
+		return -1;
+	}
 	
-	/* Turn the file descriptors into char strings so they can be passed 
-	* via execl to the event_cap process */
-	sprintf(fd_arg, "%d", fd);
-	sprintf(binfile_arg, "%d", binfile);
+	/* block the stop and rotate signals so that they are collected by sigwait
+	 * below (the capture threads inherit the mask) */
+	sigemptyset(&set);
+	sigaddset(&set, SIGINT);
+	sigaddset(&set, SIGTERM);
+	sigaddset(&set, SIGHUP);
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
 	
-	/* spawn the child process */
-	pid = fork();
-	if (pid == -1) {
-		printf("\n\nFork error. Exiting.\n");
-		close(binfile);
-		remove("interrupt_data");
+	if (cap_init(&cap, cfg, fd, txtfile, NULL) != 0) {
+		close(txtfile);
 		return -1;
 	}
-	if (pid == 0) {
-		/* if pid is 0 then this is the child process */
-		if (execl("/usr/bin/event_cap", "event_cap", fd_arg, binfile_arg, NULL) == -1){
-			printf("execl Error!\n");
-			close(binfile);
-			remove("interrupt_data");
-			return -1;
+	
+	/* entries to find a time in the output by, see sym560_index.h */
+	if (cfg->index_ns != 0 && cap_index(&cap, tsfilename) == 0) {
+		printf("\nIndexing the output every %g s\n", cfg->index_ns / 1e9);
+	}
+	
+	/* every event as a row of its day, see sym560_column.h */
+	if (cfg->columns != NULL && cap_columns(&cap, cfg->columns) == 0) {
+		printf("\nWriting every event to the column store in %s\n", cfg->columns);
+	}
+	
+	/* pulse sequences found as they are captured, from the first event on,
+	 * see sym560_tracker.c */
+	if (cfg->tables != NULL && trk_start(&trk, &cap, cfg->tables, SEQ_DEFAULT_TOL_NS,
+			TIM_DEFAULT_WINDOW_NS) == 0) {
+		trk_running = 1;
+		printf("\nFinding pulse sequences of %s\n", cfg->tables);
+	}
+	if (cap_start(&cap) != 0) {
+		if (trk_running) {
+			trk_stop(&trk, &cap);
 		}
+		cap_free(&cap);
+		close(txtfile);
+		return -1;
 	}
+	cap_print_rt(&cap);
 	
-	printf("\nTimestamping external events\n");
-	printf("Run 'stopstamp.bash' in another terminal to stop\n");
-	/* will wait until the child process has been killed */
-	wait();
+	/* live reconfiguration, see sym560_control.c */
+	if (cfg->ctl_path != NULL && ctl_start(&ctl, &cap, fd, cfg->ctl_path) == 0) {
+		ctl_running = 1;
+		printf("\nListening for control commands on %s\n", cfg->ctl_path);
+	}
 	
-	/*disable the interrupt and clear the status bits*/
-	user_buff[0] = 0x01;
-	write_pci(fd, REG_HARD_CTRL, user_buff, 1);
+	/* live events for other processes, see sym560_stream.c */
+	if (cfg->stream_path != NULL && str_start(&str, &cap, cfg->stream_path) == 0) {
+		str_running = 1;
+		printf("\nServing live events on %s\n", cfg->stream_path);
+	}
 	
-	/* kill the child process (event_cap) */
-	kill(pid, SIGKILL);
+	/* radar control's sequence metadata, see sym560_radar.c */
+	if (cfg->radar_name != NULL && rad_start(&rad, &cap, cfg->radar_name, RAD_DEFAULT_TOL_NS) == 0) {
+		rad_running = 1;
+		printf("\nJoining radar control metadata from %s\n", cfg->radar_name);
+	}
 	
+	/* card state for monitoring tools, see sym560_status.c */
+	if (cfg->status_ns != 0 && stat_start(&br, &cap, fd, cfg->status_ns) == 0) {
+		br_running = 1;
+		printf("\nPublishing the card status in %s every %.0f s\n", STAT_SHM_NAME,
+				cfg->status_ns / 1e9);
+	}
 	
-	/* stream the binary file into a text file */
-	/***********************************************/
-//	strcpy(filename, "timestampdata.txt");
-// REMOVED OCT 24 2013 by KK, see above for more specific filename.	
-	strcpy(filename, tsfilename);
-	txtfile = open(filename, O_RDWR|O_CREAT|O_APPEND, 00644);
+	/* metrics for Prometheus, see sym560_metrics.c */
+	if (cfg->metrics_path != NULL && met_start(&ex, &cap, cfg->metrics_path) == 0) {
+		ex_running = 1;
+		printf("\nWriting metrics to %s\n", cfg->metrics_path);
+	}
 	
-	/*start from the top of the binary file */
-	lseek(binfile, 0x00, SEEK_SET);
-
-	/* Loop through the binary file reading 12 bytes at a time 
-	* because each timestamp is 12 bytes long 
-	*/
-	while (eof_check == 0) {
-		ret = read(binfile, large_buff, 12);
-		if (ret == 0) {
-			eof_check = 1;
-			continue;
+	printf("\nTimestamping external events\n");
+	printf("Run 'stopstamp.bash' in another terminal to stop\n");
+	fflush(stdout);
+	/* will wait until told to stop, starting new files on SIGHUP */
+	for (;;) {
+		sigwait(&set, &sig);
+		if (sig != SIGHUP) {
+			break;
 		}
-		
-		unit_us = large_buff[0] & 0x0F;
-		tens_us = large_buff[0] >> 4;
-		hund_us = large_buff[1] & 0x0F;
-		unit_ms = large_buff[1] >> 4;
-		tens_ms = large_buff[2] & 0x0F;
-		hund_ms = large_buff[2] >> 4;
-		unit_s = large_buff[3] & 0x0F;
-		tens_s = large_buff[3] >> 4;
-		unit_min = large_buff[4] & 0x0F;
-		tens_min = large_buff[4] >> 4;
-		unit_hr = large_buff[5] & 0x0F;
-		tens_hr = large_buff[5] >> 4;
-		unit_day = large_buff[6] & 0x0F;
-		tens_day = large_buff[6] >> 4;
-		hund_day = large_buff[7] & 0x0F;
-		unit_yr = large_buff[8] & 0x0F;
-		tens_yr = large_buff[8] >> 4;
-		hund_yr = large_buff[9] & 0x0F;
-		thou_yr = large_buff[9] >> 4;
-		hund_nano = large_buff[10] >> 4;
-		
-		/* print the contents in readable text format to a text buffer */
-		sprintf(txtbuff, "       YEAR = %d%d%d%d\n        DAY = %d%d%d\n       TIME = %d%d:%d%d UTC\n        SEC = %d%d.%d%d%d%d%d%d%d\n\n", thou_yr, hund_yr, tens_yr, unit_yr, hund_day, tens_day, unit_day, tens_hr, unit_hr, tens_min, unit_min, tens_s, unit_s, hund_ms, tens_ms, unit_ms, hund_us, tens_us, unit_us, hund_nano);
-		/* write the plain text buffer to the text file */
-		write(txtfile, txtbuff, strlen(txtbuff));
+		cap_rotate(&cap);
 	}
-	/***********************************************/
-	close(binfile);
-	close(txtfile);
-	remove("interrupt_data");
-
+	
+	if (ex_running) {
+		met_stop(&ex);
+	}
+	if (br_running) {
+		stat_stop(&br);
+	}
+	if (ctl_running) {
+		ctl_stop(&ctl);
+	}
+	
+	/* disables the interrupt and waits for the writer to finish */
+	cap_stop(&cap);
+	printf("\nTimestamping stopped: %llu events captured, %llu written, %llu file rotations",
+			(unsigned long long)cap.captured, (unsigned long long)cap.written,
+			(unsigned long long)cap.rotations);
+	if (cap.overflows != 0) {
+		printf(", %llu dropped", (unsigned long long)cap.overflows);
+	}
+	printf("\n");
+	cap_print_io(&cap);
+	/* subscribers get everything up to the end before being disconnected */
+	if (str_running) {
+		str_stop(&str);
+		str_print(&str);
+	}
+	if (rad_running) {
+		rad_stop(&rad, &cap);
+		rad_print(&rad);
+	}
+	if (trk_running) {
+		trk_stop(&trk, &cap);
+		trk_print(&trk);
+	}
+	if (cap.first_ns != 0) {
+		printf("First event captured %.3f s after start\n",
+				(cap.first_ns - start_ns) / 1e9);
+	}
+	cap_print_usage(&cap);
+	
+	/* the writer may have moved on from txtfile */
+	close(cap.outfd);
+	cap_free(&cap);
 	
 	return 0;
 }
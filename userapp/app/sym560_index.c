@@ -0,0 +1,311 @@
+/* File : 	sym560_index.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Sparse time index of timestamp files (see sym560_index.h) and
+ *		"sym560_cmdline extract", which uses it to read a time range out
+ *		of any number of files.
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sym560_record.h"
+#include "sym560_index.h"
+
+#define IDX_DATA_SUFFIX	".timestampdata"
+
+/*******************************************************************************/
+/* Function   : idx_name
+ * Inputs     : const char *path - timestamp file
+ *		char *name - receives the name of its index
+ *		size_t size - of name
+ * Returns    : 0 on success
+ *             -1 if the name does not fit
+ * Description: YYYYMMDD.HHMM.timestampdata has YYYYMMDD.HHMM.index, anything
+ *		else file.index.
+ */
+int idx_name(const char *path, char *name, size_t size) {
+	size_t len = strlen(path), suffix = strlen(IDX_DATA_SUFFIX);
+
+	if (len > suffix && strcmp(path + len - suffix, IDX_DATA_SUFFIX) == 0) {
+		len -= suffix;
+	}
+	return snprintf(name, size, "%.*s.index", (int)len, path) < (int)size ? 0 : -1;
+}
+/* end of function: idx_name */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : idx_open
+ * Inputs     : const char *path - index file
+ *		int format - IDX_TEXT or IDX_RAW, of the file it indexes
+ *		int64_t interval - of the entries, ns
+ *		int trunc - start it again rather than append to it
+ * Returns    : File descriptor to append entries to, -1 on failure
+ * Description: A new file gets its header here.  An entry left half written
+ *		by a run that did not finish is cut off, so the ones appended
+ *		after it are read back whole.
+ */
+int idx_open(const char *path, int format, int64_t interval, int trunc) {
+	struct idx_header hdr;
+	struct stat st;
+	off_t len;
+	int fd;
+
+	fd = open(path, O_WRONLY|O_CREAT|O_APPEND|(trunc ? O_TRUNC : 0), 00644);
+	if (fd == -1) {
+		return -1;
+	}
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return -1;
+	}
+	len = 0;
+	if (st.st_size >= (off_t)sizeof(hdr)) {
+		len = st.st_size - (st.st_size - sizeof(hdr)) % sizeof(struct idx_entry);
+	}
+	if (len != st.st_size && ftruncate(fd, len) != 0) {
+		close(fd);
+		return -1;
+	}
+	if (len == 0) {
+		memset(&hdr, 0, sizeof(hdr));
+		hdr.magic = IDX_MAGIC;
+		hdr.version = IDX_VERSION;
+		hdr.format = format;
+		hdr.interval_ns = interval;
+		if (write(fd, &hdr, sizeof(hdr)) != sizeof(hdr)) {
+			close(fd);
+			return -1;
+		}
+	}
+	return fd;
+}
+/* end of function: idx_open */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : idx_range
+ * Inputs     : const char *path - index file
+ *		int format - IDX_TEXT or IDX_RAW, of the file it indexes
+ *		int64_t from, to - time range wanted, ns, both included
+ *		long *begin - receives where to start reading the indexed file
+ *		long *end - receives where to stop, LONG_MAX for its end
+ * Returns    : 0 on success
+ *             -1 if there is no index of that format
+ * Description: Binary searches the mapped index for the last entry at or
+ *		before from and the first one after to.  The events before the
+ *		first are all earlier than from, and those from the second on all
+ *		later than to.
+ */
+int idx_range(const char *path, int format, int64_t from, int64_t to, long *begin, long *end) {
+	const struct idx_header *hdr;
+	const struct idx_entry *e;
+	struct stat st;
+	long n, lo, hi, mid;
+	void *map;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd == -1) {
+		return -1;
+	}
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(*hdr)) {
+		close(fd);
+		return -1;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		return -1;
+	}
+	hdr = map;
+	if (hdr->magic != IDX_MAGIC || hdr->version != IDX_VERSION || hdr->format != format) {
+		munmap(map, st.st_size);
+		return -1;
+	}
+	e = (const struct idx_entry *)(hdr + 1);
+	n = (st.st_size - sizeof(*hdr)) / sizeof(*e);
+
+	/* first entry after from, so the one before it is the last at or before */
+	lo = 0;
+	hi = n;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (e[mid].ns <= from) {
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
+		}
+	}
+	*begin = lo == 0 ? 0 : e[lo - 1].offset;
+
+	/* first entry after to, no earlier than that */
+	hi = n;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (e[mid].ns <= to) {
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
+		}
+	}
+	*end = lo == n ? LONG_MAX : e[lo].offset;
+	munmap(map, st.st_size);
+	return 0;
+}
+/* end of function: idx_range */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : idx_parse_time
+ * Inputs     : const char *s - YYYY:DDD:HH:MM:SS[.fraction], UTC
+ *		int64_t *ns - receives the time in UTC nanoseconds
+ * Returns    : 0 on success
+ *             -1 if s is not a time
+ * Description: The day is the day of the year, as in the timestamp files.
+ *		The fraction is kept to 100 ns, their resolution.
+ */
+int idx_parse_time(const char *s, int64_t *ns) {
+	int year, day, hour, min, sec, len, n = 0;
+	int64_t subsec = 0;
+
+	if (sscanf(s, "%d:%d:%d:%d:%d%n", &year, &day, &hour, &min, &sec, &n) != 5) {
+		return -1;
+	}
+	s += n;
+	if (*s == '.') {
+		for (len = 0, s++; isdigit((unsigned char)*s); len++, s++) {
+			if (len < 7) {
+				subsec = subsec * 10 + (*s - '0');
+			}
+		}
+		for (; len < 7; len++) {
+			subsec *= 10;
+		}
+	}
+	if (*s != '\0' || year < 1970 || day < 1 || day > 366 || hour < 0 || hour > 23
+			|| min < 0 || min > 59 || sec < 0 || sec > 60) {
+		return -1;
+	}
+	*ns = rec_ns(year, day, hour, min, sec, subsec);
+	return 0;
+}
+/* end of function: idx_parse_time */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : idx_file_time
+ * Inputs     : const char *path - timestamp file
+ * Returns    : UTC time its YYYYMMDD.HHMM name gives, ns, or -1 if it has no
+ *		such name
+ */
+static int64_t idx_file_time(const char *path) {
+	const char *base = strrchr(path, '/');
+	struct tm tm;
+	int n = 0;
+
+	base = base == NULL ? path : base + 1;
+	memset(&tm, 0, sizeof(tm));
+	if (sscanf(base, "%4d%2d%2d.%2d%2d%n", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+			&tm.tm_hour, &tm.tm_min, &n) != 5 || n != 13) {
+		return -1;
+	}
+	tm.tm_year -= 1900;
+	tm.tm_mon -= 1;
+	return (int64_t)timegm(&tm) * 1000000000LL;
+}
+/* end of function: idx_file_time */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : extract
+ * Inputs     : char **files - timestamp files, in the order they were captured
+ *		int nfile - how many
+ *		int format - IDX_TEXT or IDX_RAW
+ *		int64_t from, to - time range wanted, ns, both included
+ *		const char *outfile - output file, "-" for stdout
+ * Returns    : 0 on success
+ *             -1 if a file could not be opened
+ * Description: Writes every event from..to as plain text timestamps.  A
+ *		file named YYYYMMDD.HHMM by the automatic mode is passed over
+ *		without being opened if it starts after to or the next file
+ *		starts more than a minute before from.  Of the others only the
+ *		part idx_range gives is read, or the whole file if it has no
+ *		index.
+ */
+int extract(char **files, int nfile, int format, int64_t from, int64_t to, const char *outfile) {
+	char name[PATH_MAX], txt[REC_TEXT_MAX];
+	unsigned char raw[REC_RAW_LEN];
+	struct rec_map map;
+	int64_t start, next, ns;
+	uint64_t events = 0;
+	long begin, end, bytes = 0;
+	int f, ret = 0, len;
+	FILE *out;
+
+	out = strcmp(outfile, "-") == 0 ? stdout : fopen(outfile, "w");
+	if (out == NULL) {
+		printf("\nCould not open %s: %s\n", outfile, strerror(errno));
+		return -1;
+	}
+	for (f = 0; f < nfile && from <= to; f++) {
+		start = idx_file_time(files[f]);
+		next = f + 1 < nfile ? idx_file_time(files[f + 1]) : -1;
+		if (start > to || (start >= 0 && next >= 0 && next + 60000000000LL <= from)) {
+			continue;
+		}
+		if (idx_name(files[f], name, sizeof(name)) != 0
+				|| idx_range(name, format, from, to, &begin, &end) != 0) {
+			begin = 0;
+			end = LONG_MAX;
+		}
+		if (rec_map_open(&map, files[f]) != 0) {
+			printf("\nCould not open %s: %s\n", files[f], strerror(errno));
+			ret = -1;
+			continue;
+		}
+		if (end < map.size) {
+			map.size = end;
+		}
+		map.pos = begin < map.size ? begin : map.size;
+		bytes += map.size - map.pos;
+		while ((format == IDX_RAW ? rec_map_raw(&map, &ns) : rec_map_text(&map, &ns)) == 0) {
+			if (ns > to) {
+				break;
+			}
+			if (ns >= from) {
+				rec_encode(ns, raw);
+				len = rec_format_text(raw, txt);
+				fwrite(txt, len, 1, out);
+				events++;
+			}
+		}
+		rec_map_close(&map);
+	}
+	if (out != stdout) {
+		fclose(out);
+		printf("%llu events written to %s, %ld bytes of %d files read\n",
+				(unsigned long long)events, outfile, bytes, nfile);
+	}
+	else {
+		fflush(out);
+	}
+	return ret;
+}
+/* end of function: extract */
+/*******************************************************************************/
@@ -0,0 +1,85 @@
+/* File : 	sym560_index.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Sparse time index kept beside each timestamp file, so the
+ *		events of a few seconds can be read out of a year of files without
+ *		reading the rest of them.  YYYYMMDD.HHMM.timestampdata has its
+ *		index in YYYYMMDD.HHMM.index (any other file, such as one made by
+ *		convert, in file.index): a header and then one entry for the first
+ *		event of every interval (a second by default) that has any, giving
+ *		its time and where its record starts in the file.
+ *
+ *		The automatic mode's writer adds the entries as it formats the
+ *		records and writes each buffer's entries straight after the buffer
+ *		itself, so an entry never points past what is in the file.
+ *		"sym560_cmdline backfill" makes the index of files captured
+ *		without one.  "sym560_cmdline extract" finds a time range with
+ *		idx_range, a binary search of the index, and reads only the bytes
+ *		between the two entries either side of it.
+ *
+ *		Both rely on the events of a file being in time order, as they
+ *		are captured: an entry is only added for an interval later than
+ *		the last one.
+ */
+
+#ifndef SYM560_INDEX_H
+#define SYM560_INDEX_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* header of the files, in host byte order */
+#define IDX_MAGIC		0x58594d53	/* "SYMX" */
+#define IDX_VERSION		1
+
+/* what the indexed file holds, the same values as PLS_TEXT and PLS_RAW */
+#define IDX_TEXT		0	/* plain text timestamps */
+#define IDX_RAW			1	/* 12 byte event times */
+
+/* an entry for the first event of every second by default */
+#define IDX_DEFAULT_INTERVAL_NS	1000000000LL
+
+/* entries the writer keeps for each of its buffers; a buffer is written
+ * early rather than take more */
+#define IDX_SLICE		1024
+
+/* the file starts with this, 16 bytes like an entry */
+struct idx_header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t format;		/* IDX_TEXT or IDX_RAW */
+	int64_t interval_ns;		/* of the entries */
+};
+
+struct idx_entry {
+	int64_t ns;			/* time of the first event of its interval */
+	int64_t offset;			/* where its record starts in the indexed file */
+};
+
+/*******************************************************************************/
+/* Function   : idx_due
+ * Inputs     : int64_t *bucket - interval of the last entry, -1 for none yet
+ *		int64_t ns - time of the next event
+ *		int64_t interval - of the entries, ns
+ * Returns    : 1 if the event needs an entry, 0 if not
+ */
+static inline int idx_due(int64_t *bucket, int64_t ns, int64_t interval) {
+	int64_t b = ns / interval;
+
+	if (b <= *bucket) {
+		return 0;
+	}
+	*bucket = b;
+	return 1;
+}
+/* end of function: idx_due */
+/*******************************************************************************/
+
+/* function declarations */
+int idx_name(const char *path, char *name, size_t size);
+int idx_open(const char *path, int format, int64_t interval, int trunc);
+int idx_range(const char *path, int format, int64_t from, int64_t to, long *begin, long *end);
+int idx_parse_time(const char *s, int64_t *ns);
+int extract(char **files, int nfile, int format, int64_t from, int64_t to, const char *outfile);
+
+#endif /* SYM560_INDEX_H */
@@ -0,0 +1,537 @@
+/* File : 	sym560_io.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Ordered asynchronous IO for the writer thread (see sym560_io.h).
+ *		The io_uring backend talks to the kernel through the raw system
+ *		calls so that liburing is not needed.  Output files are opened
+ *		O_APPEND, where a write always lands at the end of the file whatever
+ *		offset is given, so requests must complete in the order they were
+ *		queued: both backends carry them out one at a time.  The IO thread
+ *		backend is used on kernels without io_uring (or where it is
+ *		disabled) and does the same work with ordinary system calls.
+ *		io_uring has no truncate operation on the kernels we run, so with
+ *		that backend IO_TRIM is done by the writer itself once everything
+ *		ahead of it has finished.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "sym560_io.h"
+
+/*******************************************************************************/
+/* Function   : io_account
+ * Inputs     : struct wio *io - IO state
+ *		const struct io_req *req - request that has finished
+ *		int res - its result, a negative errno on failure
+ *		uint64_t seq - its request number
+ * Returns    : Nothing
+ * Description: Updates the counters for a finished request.  Preallocation is
+ *		only a hint, so filesystems (or pipes) without it are not errors,
+ *		and neither is a pipe or socket that cannot be synced.
+ */
+static void io_account(struct wio *io, const struct io_req *req, int res, uint64_t seq) {
+	if (res < 0) {
+		if (req->op == IO_ALLOC || (req->op == IO_TRIM && res != -ECANCELED)
+				|| (req->op == IO_SYNC && res == -EINVAL)) {
+			return;
+		}
+		if (req->op == IO_WRITE && atomic_load_explicit(&io->failed_write, memory_order_relaxed) == 0) {
+			atomic_store_explicit(&io->failed_write, seq + 1, memory_order_relaxed);
+		}
+		if (atomic_fetch_add(&io->errors, 1) == 0) {
+			printf("\nOutput file IO failed (op %d, errno %d)\n", req->op, -res);
+			fflush(stdout);
+		}
+		return;
+	}
+	if (req->op == IO_WRITE) {
+		atomic_fetch_add_explicit(&io->writes, 1, memory_order_relaxed);
+		atomic_fetch_add_explicit(&io->bytes, req->len, memory_order_relaxed);
+	}
+	else if (req->op == IO_SYNC) {
+		atomic_fetch_add_explicit(&io->syncs, 1, memory_order_relaxed);
+	}
+}
+/* end of function: io_account */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : io_held
+ * Inputs     : struct wio *io - IO state
+ *		const struct io_req *req - request about to be carried out
+ * Returns    : 1 if it must be skipped, 0 if not
+ * Description: With io->hold nothing reaches a file after a write that failed,
+ *		so the file ends where the failed write began.  A trim would
+ *		extend it with zeros instead.
+ */
+static int io_held(struct wio *io, const struct io_req *req) {
+	return io->hold && (req->op == IO_WRITE || req->op == IO_TRIM)
+			&& atomic_load_explicit(&io->failed_write, memory_order_relaxed) != 0;
+}
+/* end of function: io_held */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : io_exec
+ * Inputs     : const struct io_req *req - request to carry out
+ * Returns    : 0 on success, a negative errno on failure
+ * Description: Synchronous version of every request, used by the IO thread.
+ */
+static int io_exec(const struct io_req *req) {
+	size_t off = 0;
+	ssize_t ret;
+
+	switch (req->op) {
+		case IO_WRITE:
+			while (off < req->len) {
+				ret = write(req->fd, req->data + off, req->len - off);
+				if (ret == -1) {
+					if (errno == EINTR) {
+						continue;
+					}
+					return -errno;
+				}
+				off += ret;
+			}
+			return 0;
+		case IO_SYNC:
+			return fdatasync(req->fd) == 0 ? 0 : -errno;
+		case IO_ALLOC:
+			return fallocate(req->fd, FALLOC_FL_KEEP_SIZE, req->off, req->len) == 0 ? 0 : -errno;
+		case IO_CLOSE:
+			return close(req->fd) == 0 ? 0 : -errno;
+		case IO_TRIM:
+			return ftruncate(req->fd, req->off) == 0 ? 0 : -errno;
+	}
+	return -EINVAL;
+}
+/* end of function: io_exec */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : io_thread_main
+ * Inputs     : void *arg - the struct wio
+ * Returns    : NULL
+ * Description: IO thread backend.  Carries out queued requests in order until
+ *		io_free asks it to stop and the queue is empty.
+ */
+static void *io_thread_main(void *arg) {
+	struct wio *io = arg;
+	struct io_req *req;
+	uint64_t done;
+	int res;
+
+	pthread_mutex_lock(&io->lock);
+	for (;;) {
+		done = atomic_load_explicit(&io->done, memory_order_relaxed);
+		if (done == atomic_load_explicit(&io->queued_head, memory_order_relaxed)) {
+			if (io->stop) {
+				break;
+			}
+			pthread_cond_wait(&io->queued, &io->lock);
+			continue;
+		}
+		pthread_mutex_unlock(&io->lock);
+
+		req = &io->req[done & (IO_QUEUE - 1)];
+		res = io_held(io, req) ? -ECANCELED : io_exec(req);
+		io_account(io, req, res, done);
+
+		pthread_mutex_lock(&io->lock);
+		atomic_store_explicit(&io->done, done + 1, memory_order_release);
+		pthread_cond_broadcast(&io->finished);
+	}
+	pthread_mutex_unlock(&io->lock);
+	return NULL;
+}
+/* end of function: io_thread_main */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : uring_setup
+ * Inputs     : struct wio *io - IO state
+ * Returns    : 0 on success
+ *             -1 if io_uring is unavailable or lacks an operation we need
+ * Description: Creates a small ring and maps its queues.  Requires the kernel to
+ *		support writes at the current file position and the write, fsync,
+ *		fallocate and close operations (Linux 5.6 or later).
+ */
+static int uring_setup(struct wio *io) {
+	struct io_uring_params p;
+	struct io_uring_probe *probe;
+	size_t probe_len;
+	int ok, op;
+	static const int needed[] = {IORING_OP_WRITE, IORING_OP_FSYNC,
+		IORING_OP_FALLOCATE, IORING_OP_CLOSE};
+
+	memset(&p, 0, sizeof(p));
+	io->ring_fd = syscall(__NR_io_uring_setup, 8, &p);
+	if (io->ring_fd < 0) {
+		return -1;
+	}
+	if ((p.features & IORING_FEAT_RW_CUR_POS) == 0) {
+		close(io->ring_fd);
+		return -1;
+	}
+
+	/* check every operation we use is there */
+	probe_len = sizeof(*probe) + 256 * sizeof(struct io_uring_probe_op);
+	probe = calloc(1, probe_len);
+	ok = probe != NULL
+		&& syscall(__NR_io_uring_register, io->ring_fd, IORING_REGISTER_PROBE, probe, 256) == 0;
+	for (op = 0; ok && op < 4; op++) {
+		if (needed[op] > probe->last_op
+				|| (probe->ops[needed[op]].flags & IO_URING_OP_SUPPORTED) == 0) {
+			ok = 0;
+		}
+	}
+	free(probe);
+	if (!ok) {
+		close(io->ring_fd);
+		return -1;
+	}
+
+	io->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	io->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (io->cq_len > io->sq_len) {
+			io->sq_len = io->cq_len;
+		}
+		io->cq_len = 0;
+	}
+	io->sq_ptr = mmap(NULL, io->sq_len, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+			io->ring_fd, IORING_OFF_SQ_RING);
+	if (io->sq_ptr == MAP_FAILED) {
+		close(io->ring_fd);
+		return -1;
+	}
+	io->cq_ptr = io->sq_ptr;
+	if (io->cq_len != 0) {
+		io->cq_ptr = mmap(NULL, io->cq_len, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+				io->ring_fd, IORING_OFF_CQ_RING);
+		if (io->cq_ptr == MAP_FAILED) {
+			munmap(io->sq_ptr, io->sq_len);
+			close(io->ring_fd);
+			return -1;
+		}
+	}
+	io->sqe_len = p.sq_entries * sizeof(struct io_uring_sqe);
+	io->sqes = mmap(NULL, io->sqe_len, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+			io->ring_fd, IORING_OFF_SQES);
+	if (io->sqes == MAP_FAILED) {
+		if (io->cq_len != 0) {
+			munmap(io->cq_ptr, io->cq_len);
+		}
+		munmap(io->sq_ptr, io->sq_len);
+		close(io->ring_fd);
+		return -1;
+	}
+
+	io->sq_tail = (unsigned *)((char *)io->sq_ptr + p.sq_off.tail);
+	io->sq_mask = (unsigned *)((char *)io->sq_ptr + p.sq_off.ring_mask);
+	io->sq_array = (unsigned *)((char *)io->sq_ptr + p.sq_off.array);
+	io->cq_head = (unsigned *)((char *)io->cq_ptr + p.cq_off.head);
+	io->cq_tail = (unsigned *)((char *)io->cq_ptr + p.cq_off.tail);
+	io->cq_mask = (unsigned *)((char *)io->cq_ptr + p.cq_off.ring_mask);
+	io->cqes = (struct io_uring_cqe *)((char *)io->cq_ptr + p.cq_off.cqes);
+	return 0;
+}
+/* end of function: uring_setup */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : uring_submit
+ * Inputs     : struct wio *io - IO state
+ *		const struct io_req *req - request to submit
+ * Returns    : Nothing
+ * Description: Puts one request on the submission queue and tells the kernel.
+ *		For a write, the part already done (io->partial) is skipped.
+ */
+static void uring_submit(struct wio *io, const struct io_req *req) {
+	unsigned tail = *io->sq_tail, idx = tail & *io->sq_mask;
+	struct io_uring_sqe *sqe = &io->sqes[idx];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->fd = req->fd;
+	switch (req->op) {
+		case IO_WRITE:
+			sqe->opcode = IORING_OP_WRITE;
+			sqe->addr = (unsigned long)(req->data + io->partial);
+			sqe->len = req->len - io->partial;
+			sqe->off = (uint64_t)-1;	/* current position (the end, O_APPEND) */
+			break;
+		case IO_SYNC:
+			sqe->opcode = IORING_OP_FSYNC;
+			sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+			break;
+		case IO_ALLOC:
+			sqe->opcode = IORING_OP_FALLOCATE;
+			sqe->off = req->off;
+			sqe->addr = req->len;
+			sqe->len = FALLOC_FL_KEEP_SIZE;
+			break;
+		case IO_CLOSE:
+			sqe->opcode = IORING_OP_CLOSE;
+			break;
+	}
+	io->sq_array[idx] = idx;
+	__atomic_store_n(io->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	while (syscall(__NR_io_uring_enter, io->ring_fd, 1, 0, 0, NULL, 0) == -1 && errno == EINTR) {
+	}
+}
+/* end of function: uring_submit */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : io_poll
+ * Inputs     : struct wio *io - IO state
+ * Returns    : Nothing
+ * Description: Never waits on the disk.  With io_uring, collects a finished
+ *		request (a short or interrupted write is resubmitted for the rest)
+ *		and submits the next one.  The IO thread makes progress on its own.
+ */
+void io_poll(struct wio *io) {
+	struct io_uring_cqe *cqe;
+	struct io_req *req;
+	unsigned head;
+	uint64_t done;
+	int res;
+
+	if (io->backend != IO_URING) {
+		return;
+	}
+	done = atomic_load_explicit(&io->done, memory_order_relaxed);
+	if (io->issued != done) {
+		head = *io->cq_head;
+		if (head == __atomic_load_n(io->cq_tail, __ATOMIC_ACQUIRE)) {
+			return;
+		}
+		cqe = &io->cqes[head & *io->cq_mask];
+		res = cqe->res;
+		__atomic_store_n(io->cq_head, head + 1, __ATOMIC_RELEASE);
+
+		req = &io->req[done & (IO_QUEUE - 1)];
+		if (res == -EINTR || res == -EAGAIN
+				|| (req->op == IO_WRITE && res > 0 && io->partial + res < req->len)) {
+			if (res > 0) {
+				io->partial += res;
+			}
+			uring_submit(io, req);
+			return;
+		}
+		io->partial = 0;
+		io_account(io, req, res, done);
+		atomic_store_explicit(&io->done, ++done, memory_order_release);
+	}
+	while (io->issued == done && io->issued != io->head) {
+		req = &io->req[io->issued & (IO_QUEUE - 1)];
+		io->issued++;
+		if (io_held(io, req)) {
+			io_account(io, req, -ECANCELED, done);
+			atomic_store_explicit(&io->done, ++done, memory_order_release);
+			continue;
+		}
+		if (req->op == IO_TRIM) {
+			io_account(io, req, io_exec(req), done);
+			atomic_store_explicit(&io->done, ++done, memory_order_release);
+			continue;
+		}
+		uring_submit(io, req);
+	}
+}
+/* end of function: io_poll */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : io_complete
+ * Inputs     : struct wio *io - IO state
+ *		uint64_t seq - request number returned by io_queue
+ * Returns    : 1 if the request has finished, 0 if not
+ */
+int io_complete(struct wio *io, uint64_t seq) {
+	return atomic_load_explicit(&io->done, memory_order_acquire) > seq;
+}
+/* end of function: io_complete */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : io_wait
+ * Inputs     : struct wio *io - IO state
+ *		uint64_t seq - request number returned by io_queue
+ * Returns    : Nothing
+ * Description: Blocks until request seq (and so every one before it) is done.
+ */
+void io_wait(struct wio *io, uint64_t seq) {
+	while (!io_complete(io, seq)) {
+		if (io->backend == IO_URING) {
+			io_poll(io);
+			if (!io_complete(io, seq)) {
+				syscall(__NR_io_uring_enter, io->ring_fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+			}
+		}
+		else {
+			pthread_mutex_lock(&io->lock);
+			while (!io_complete(io, seq)) {
+				pthread_cond_wait(&io->finished, &io->lock);
+			}
+			pthread_mutex_unlock(&io->lock);
+		}
+	}
+}
+/* end of function: io_wait */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : io_queue
+ * Inputs     : struct wio *io - IO state
+ *		int op - IO_WRITE, IO_SYNC, IO_ALLOC, IO_CLOSE or IO_TRIM
+ *		int fd - file the request applies to
+ *		const char *data, size_t len - data to write (IO_WRITE), or the
+ *				length to preallocate (IO_ALLOC)
+ *		int64_t off - where to preallocate from (IO_ALLOC) or the length
+ *			      to truncate to (IO_TRIM)
+ * Returns    : The request number, for io_complete and io_wait
+ * Description: Queues a request behind all earlier ones.  Only waits if
+ *		IO_QUEUE requests are already outstanding.
+ */
+uint64_t io_queue(struct wio *io, int op, int fd, const char *data, size_t len, int64_t off) {
+	struct io_req *req;
+	uint64_t seq = io->head;
+
+	if (seq - atomic_load_explicit(&io->done, memory_order_acquire) >= IO_QUEUE) {
+		io_wait(io, seq - IO_QUEUE);
+	}
+	req = &io->req[seq & (IO_QUEUE - 1)];
+	req->op = op;
+	req->fd = fd;
+	req->data = data;
+	req->len = len;
+	req->off = off;
+	io->head = seq + 1;
+
+	if (io->backend == IO_URING) {
+		io_poll(io);
+	}
+	else {
+		pthread_mutex_lock(&io->lock);
+		atomic_store_explicit(&io->queued_head, io->head, memory_order_relaxed);
+		pthread_cond_signal(&io->queued);
+		pthread_mutex_unlock(&io->lock);
+	}
+	return seq;
+}
+/* end of function: io_queue */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : io_drain
+ * Inputs     : struct wio *io - IO state
+ * Returns    : Nothing
+ * Description: Waits for every queued request to finish.
+ */
+void io_drain(struct wio *io) {
+	if (io->head != 0) {
+		io_wait(io, io->head - 1);
+	}
+}
+/* end of function: io_drain */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : io_init
+ * Inputs     : struct wio *io - IO state to set up
+ *		int backend - IO_AUTO, IO_URING or IO_THREAD
+ * Returns    : 0 on success
+ *             -1 on failure
+ * Description: IO_AUTO tries io_uring and falls back to the IO thread.  Asking
+ *		for IO_URING when it is not available also falls back, with a
+ *		warning.
+ */
+int io_init(struct wio *io, int backend) {
+	memset(io, 0, sizeof(*io));
+	io->ring_fd = -1;
+
+	if (backend != IO_THREAD) {
+		if (uring_setup(io) == 0) {
+			io->backend = IO_URING;
+			return 0;
+		}
+		if (backend == IO_URING) {
+			printf("\nWARNING: io_uring is not available, using an IO thread\n");
+		}
+	}
+
+	io->backend = IO_THREAD;
+	pthread_mutex_init(&io->lock, NULL);
+	pthread_cond_init(&io->queued, NULL);
+	pthread_cond_init(&io->finished, NULL);
+	if (pthread_create(&io->thread, NULL, io_thread_main, io) != 0) {
+		printf("\nCould not start the IO thread\n");
+		return -1;
+	}
+	return 0;
+}
+/* end of function: io_init */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : io_free
+ * Inputs     : struct wio *io - IO state set up by io_init
+ * Returns    : Nothing
+ * Description: Finishes any outstanding requests and releases the backend.
+ */
+void io_free(struct wio *io) {
+	io_drain(io);
+	if (io->backend == IO_URING) {
+		munmap(io->sqes, io->sqe_len);
+		if (io->cq_len != 0) {
+			munmap(io->cq_ptr, io->cq_len);
+		}
+		munmap(io->sq_ptr, io->sq_len);
+		close(io->ring_fd);
+		return;
+	}
+	pthread_mutex_lock(&io->lock);
+	io->stop = 1;
+	pthread_cond_signal(&io->queued);
+	pthread_mutex_unlock(&io->lock);
+	pthread_join(io->thread, NULL);
+	pthread_mutex_destroy(&io->lock);
+	pthread_cond_destroy(&io->queued);
+	pthread_cond_destroy(&io->finished);
+}
+/* end of function: io_free */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : io_backend_name
+ * Inputs     : const struct wio *io - IO state
+ * Returns    : "io_uring" or "IO thread"
+ */
+const char *io_backend_name(const struct wio *io) {
+	return io->backend == IO_URING ? "io_uring" : "IO thread";
+}
+/* end of function: io_backend_name */
+/*******************************************************************************/
@@ -0,0 +1,85 @@
+/* File : 	sym560_io.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Asynchronous, strictly ordered file IO for the writer thread.
+ *		Requests (write, fdatasync, preallocate, close) are queued by the
+ *		writer and carried out in order, either through io_uring or, where
+ *		that is not available, by an IO thread, so the writer never waits on
+ *		the disk unless it chooses to.
+ */
+
+#ifndef SYM560_IO_H
+#define SYM560_IO_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* requests in flight or waiting (a power of 2) */
+#define IO_QUEUE	64
+
+/* request types */
+#define IO_WRITE	0	/* write len bytes of data at the end of fd */
+#define IO_SYNC		1	/* fdatasync fd */
+#define IO_ALLOC	2	/* preallocate len bytes at off, file size unchanged */
+#define IO_CLOSE	3	/* close fd */
+#define IO_TRIM		4	/* truncate fd to off, dropping unused preallocation */
+
+/* backends */
+#define IO_AUTO		0	/* io_uring if the kernel allows it, else IO_THREAD */
+#define IO_URING	1
+#define IO_THREAD	2
+
+struct io_req {
+	int op;
+	int fd;
+	const char *data;		/* IO_WRITE: must stay valid until complete */
+	size_t len;
+	int64_t off;			/* IO_ALLOC and IO_TRIM only */
+};
+
+struct wio {
+	int backend;			/* IO_URING or IO_THREAD once set up */
+	struct io_req req[IO_QUEUE];
+	uint64_t head;			/* requests queued (writer only) */
+	_Atomic uint64_t done;		/* requests completed, in order */
+	_Atomic uint64_t writes;	/* write requests completed */
+	_Atomic uint64_t bytes;		/* bytes written */
+	_Atomic uint64_t syncs;		/* fdatasyncs completed */
+	_Atomic uint64_t errors;	/* failed requests */
+	_Atomic uint64_t failed_write;	/* request number + 1 of the first failed write, 0 = none */
+	int hold;			/* once a write has failed, skip later writes and
+					 * trims (set before the first io_queue) */
+
+	/* IO_THREAD */
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t queued;		/* head moved */
+	pthread_cond_t finished;	/* done moved */
+	_Atomic uint64_t queued_head;	/* head as published to the IO thread */
+	int stop;
+
+	/* IO_URING, one request in flight at a time to keep them in order */
+	int ring_fd;
+	uint64_t issued;		/* requests submitted */
+	size_t partial;			/* bytes of the current write already done */
+	void *sq_ptr, *cq_ptr;
+	size_t sq_len, cq_len, sqe_len;
+	unsigned *sq_tail, *sq_mask, *sq_array;
+	unsigned *cq_head, *cq_tail, *cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+};
+
+/* function declarations */
+int io_init(struct wio *io, int backend);
+uint64_t io_queue(struct wio *io, int op, int fd, const char *data, size_t len, int64_t off);
+void io_poll(struct wio *io);
+int io_complete(struct wio *io, uint64_t seq);
+void io_wait(struct wio *io, uint64_t seq);
+void io_drain(struct wio *io);
+void io_free(struct wio *io);
+const char *io_backend_name(const struct wio *io);
+
+#endif /* SYM560_IO_H */
@@ -0,0 +1,235 @@
+/* File : 	sym560_journal.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Opening, recovering and closing the capture journal (see
+ *		sym560_journal.h).  Nothing here runs while capturing: the capture
+ *		and writer threads use the journal's ring like any other.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sym560_journal.h"
+
+_Static_assert(sizeof(struct jnl_header) <= JNL_HDR_LEN, "journal header too large");
+
+/*******************************************************************************/
+/* Function   : jnl_valid
+ * Inputs     : const struct jnl_header *hdr - header as found in the file
+ *		unsigned int order - ring size wanted
+ * Returns    : 1 if the file is a journal this build can pick up from
+ */
+static int jnl_valid(const struct jnl_header *hdr, unsigned int order) {
+	uint64_t head, tail;
+
+	if (hdr->magic != JNL_MAGIC || hdr->version != JNL_VERSION
+			|| hdr->order != order || hdr->rec_len != sizeof(struct sym560_record)) {
+		return 0;
+	}
+	head = atomic_load(&hdr->ring.head);
+	tail = atomic_load(&hdr->ring.tail);
+	return head - tail <= (1ULL << order);
+}
+/* end of function: jnl_valid */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : jnl_settle
+ * Inputs     : struct journal *jnl - journal left by a run that did not finish
+ * Returns    : Number of records at the tail that are already in the output
+ * Description: Follows the buffers noted by jnl_mark from the tail on, in
+ *		ring order.  A buffer whose file still holds it in full was
+ *		written, so its records are skipped.  The first one that is not
+ *		is where the writer picks up; if part of it reached the file that
+ *		part is cut off, so the whole buffer can be written again.
+ */
+static uint64_t jnl_settle(struct journal *jnl) {
+	struct jnl_header *hdr = jnl->hdr;
+	const struct jnl_buf *b;
+	struct stat st;
+	uint64_t head = atomic_load(&hdr->ring.head);
+	uint64_t tail = atomic_load(&hdr->ring.tail), from = tail;
+	int k;
+
+	for (;;) {
+		for (k = 0; k < JNL_BUFS; k++) {
+			b = &hdr->buf[k];
+			if (b->ring_start == tail && b->ring_end > tail && b->ring_end <= head) {
+				break;
+			}
+		}
+		if (k == JNL_BUFS || b->path[0] == '\0' || memchr(b->path, '\0', JNL_PATH_LEN) == NULL
+				|| stat(b->path, &st) != 0 || (uint64_t)st.st_dev != b->dev
+				|| (uint64_t)st.st_ino != b->ino) {
+			break;
+		}
+		if (st.st_size >= b->off_end) {
+			tail = b->ring_end;
+			continue;
+		}
+		if (st.st_size > b->off_start) {
+			if (truncate(b->path, b->off_start) == 0) {
+				printf("\nCut %lld bytes of a buffer that did not finish off %s\n",
+						(long long)(st.st_size - b->off_start), b->path);
+			}
+			else {
+				printf("\nCould not cut a buffer that did not finish off %s (errno %d)\n", b->path, errno);
+			}
+		}
+		break;
+	}
+	atomic_store(&hdr->ring.tail, tail);
+	return tail - from;
+}
+/* end of function: jnl_settle */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : jnl_open
+ * Inputs     : struct journal *jnl - journal to set up
+ *		const char *path - journal file, created if it does not exist
+ *		unsigned int order - ring holds 2^order records
+ * Returns    : 0 on success
+ *             -1 on failure
+ * Description: Maps the journal and sets up its ring.  If the file is a valid
+ *		journal its indices are kept, so any records left between tail and
+ *		head by a run that did not finish are read out first by the next
+ *		writer, less those jnl_settle finds already in the output;
+ *		jnl->recovered says how many.  Anything else is replaced by
+ *		an empty journal.  The whole file is allocated on disk and mapped
+ *		in up front so that storing a record never waits for either,
+ *		though it can still wait on writeback (see sym560_journal.h).
+ */
+int jnl_open(struct journal *jnl, const char *path, unsigned int order) {
+	struct jnl_header *hdr;
+	struct stat st;
+	size_t len = JNL_HDR_LEN + (sizeof(struct sym560_record) << order);
+	int ret;
+
+	memset(jnl, 0, sizeof(*jnl));
+	jnl->fd = open(path, O_RDWR|O_CREAT, 00644);
+	if (jnl->fd == -1) {
+		printf("\nCould not open the journal %s (errno %d)\n", path, errno);
+		return -1;
+	}
+	if (fstat(jnl->fd, &st) != 0) {
+		st.st_size = 0;
+	}
+	if (st.st_size > (off_t)len) {
+		ftruncate(jnl->fd, len);
+	}
+	ret = posix_fallocate(jnl->fd, 0, len);
+	if (ret != 0) {
+		printf("\nCould not allocate the journal %s (errno %d)\n", path, ret);
+		close(jnl->fd);
+		return -1;
+	}
+	jnl->map = mmap(NULL, len, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, jnl->fd, 0);
+	if (jnl->map == MAP_FAILED) {
+		printf("\nCould not map the journal %s (errno %d)\n", path, errno);
+		close(jnl->fd);
+		return -1;
+	}
+	jnl->maplen = len;
+	jnl->hdr = hdr = jnl->map;
+
+	if (st.st_size == (off_t)len && jnl_valid(hdr, order)) {
+		jnl->skipped = jnl_settle(jnl);
+		hdr->ring.rec = (struct sym560_record *)((char *)jnl->map + JNL_HDR_LEN);
+		hdr->ring.owned = 0;
+		hdr->ring.mask = (1ULL << order) - 1;
+		hdr->ring.tail_cache = atomic_load(&hdr->ring.tail);
+		hdr->ring.head_cache = hdr->ring.tail_cache;
+		jnl->recovered = atomic_load(&hdr->ring.head) - hdr->ring.tail_cache;
+		return 0;
+	}
+
+	if (st.st_size != 0) {
+		printf("\nWARNING: %s is not a journal this version can read, starting a new one\n", path);
+	}
+	memset(hdr, 0, JNL_HDR_LEN);
+	hdr->version = JNL_VERSION;
+	hdr->order = order;
+	hdr->rec_len = sizeof(struct sym560_record);
+	ring_init_mem(&hdr->ring, order, (char *)jnl->map + JNL_HDR_LEN);
+	/* last, so a journal interrupted while being set up is never taken as valid */
+	atomic_thread_fence(memory_order_release);
+	hdr->magic = JNL_MAGIC;
+	return 0;
+}
+/* end of function: jnl_open */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : jnl_ring
+ * Inputs     : struct journal *jnl - journal set up by jnl_open
+ * Returns    : The ring stored in the journal
+ */
+struct ring *jnl_ring(struct journal *jnl) {
+	return &jnl->hdr->ring;
+}
+/* end of function: jnl_ring */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : jnl_mark
+ * Inputs     : struct journal *jnl - journal set up by jnl_open
+ *		int buf - writer buffer, below JNL_BUFS
+ *		uint64_t ring_start, ring_end - the ring records it holds
+ *		int64_t off_start, off_end - where it will be in the file
+ *		const struct stat *st - the file
+ *		const char *path - its absolute path, NULL if unknown
+ * Returns    : Nothing
+ * Description: Writer thread only, before the buffer is handed to the disk.
+ *		Nothing else moves the tail, so the note is only read after a
+ *		crash.
+ */
+void jnl_mark(struct journal *jnl, int buf, uint64_t ring_start, uint64_t ring_end, int64_t off_start,
+		int64_t off_end, const struct stat *st, const char *path) {
+	struct jnl_buf *b = &jnl->hdr->buf[buf];
+
+	b->ring_start = ring_start;
+	b->ring_end = ring_end;
+	b->off_start = off_start;
+	b->off_end = off_end;
+	b->dev = st->st_dev;
+	b->ino = st->st_ino;
+	/* a path cut short could name another file */
+	if (path == NULL || strlen(path) >= sizeof(b->path)) {
+		b->path[0] = '\0';
+	}
+	else {
+		strcpy(b->path, path);
+	}
+	atomic_thread_fence(memory_order_release);
+}
+/* end of function: jnl_mark */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : jnl_close
+ * Inputs     : struct journal *jnl - journal set up by jnl_open
+ * Returns    : Nothing
+ * Description: The file is kept for the next run.  After a clean stop its ring
+ *		is empty.
+ */
+void jnl_close(struct journal *jnl) {
+	if (jnl->map == NULL) {
+		return;
+	}
+	munmap(jnl->map, jnl->maplen);
+	close(jnl->fd);
+	jnl->map = NULL;
+	jnl->hdr = NULL;
+}
+/* end of function: jnl_close */
+/*******************************************************************************/
@@ -0,0 +1,91 @@
+/* File : 	sym560_journal.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Crash-safe capture journal.  The event ring, indices included,
+ *		lives in a file mapped MAP_SHARED, so every event the capture
+ *		thread has committed is in the page cache the moment it is
+ *		committed and survives the process being killed or crashing.  The
+ *		ring's tail only moves once the writer's output for a record has
+ *		reached the timestamp file, so on the next start the records between
+ *		tail and head are those that may not have made it out, and the
+ *		writer picks up from there.
+ *
+ *		A buffer can reach the file and the process be killed before the
+ *		writer sees it complete and moves the tail.  So before each buffer
+ *		is handed to the disk the writer notes in the header where it goes:
+ *		the file, the offsets it will span and the ring records it holds
+ *		(jnl_mark).  jnl_open skips the records of every such buffer the
+ *		file holds in full, and cuts a buffer that only partly reached it
+ *		back off the file, so each event is written to the timestamp files
+ *		exactly once.  The time index entries and column store rows that go
+ *		out behind a buffer are not covered, and may be missed or repeated
+ *		for the last buffers of a run that was killed.
+ *
+ *		The price is paid by the capture thread.  Its stores go to pages of
+ *		a file, which the kernel writes back on its own and then protects
+ *		again, so the next store to a page takes a fault into the
+ *		filesystem, and one to a page still being written waits for it
+ *		where the device needs pages kept stable.  A slow disk can so hold
+ *		up capture, which is why the journal is off unless asked for.
+ */
+
+#ifndef SYM560_JOURNAL_H
+#define SYM560_JOURNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/stat.h>
+#include "sym560_ring.h"
+
+/* file name suggested for the automatic mode's -J (in the output directory) */
+#define JNL_DEFAULT_PATH	"sym560.journal"
+
+#define JNL_MAGIC	0x31304c4e4a4d5953ULL	/* "SYMJNL01" */
+#define JNL_VERSION	2
+
+/* records start one page into the file */
+#define JNL_HDR_LEN	4096
+
+/* buffers the writer can have waiting on the disk at once, at least CAP_WRBUFS */
+#define JNL_BUFS	8
+
+/* longest output file path a buffer can be noted with */
+#define JNL_PATH_LEN	256
+
+/* a writer buffer handed to the disk, see jnl_mark */
+struct jnl_buf {
+	uint64_t ring_start;		/* its first record */
+	uint64_t ring_end;		/* the record after its last */
+	int64_t off_start;		/* where it starts in the file */
+	int64_t off_end;		/* where it ends */
+	uint64_t dev, ino;		/* the file */
+	char path[JNL_PATH_LEN];	/* and its absolute path, "" if unknown */
+};
+
+struct jnl_header {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t order;			/* ring holds 2^order records */
+	uint32_t rec_len;		/* sizeof(struct sym560_record) */
+	char pad[RING_CACHELINE - 20];
+	struct ring ring;		/* head = committed by capture, tail = written out */
+	struct jnl_buf buf[JNL_BUFS];	/* indexed by writer buffer */
+};
+
+struct journal {
+	int fd;
+	void *map;
+	size_t maplen;
+	struct jnl_header *hdr;
+	uint64_t recovered;		/* records the previous run left to be written */
+	uint64_t skipped;		/* records it left that were already in the output */
+};
+
+/* function declarations */
+int jnl_open(struct journal *jnl, const char *path, unsigned int order);
+struct ring *jnl_ring(struct journal *jnl);
+void jnl_mark(struct journal *jnl, int buf, uint64_t ring_start, uint64_t ring_end, int64_t off_start,
+		int64_t off_end, const struct stat *st, const char *path);
+void jnl_close(struct journal *jnl);
+
+#endif /* SYM560_JOURNAL_H */
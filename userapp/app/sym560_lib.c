@@ -0,0 +1,403 @@
+/* File : 	sym560_lib.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	libsym560 (see sym560.h).  The handle wraps a capture with no
+ *		writer thread (cap_init_consumer), and the caller's thread is
+ *		the ring's consumer in place of the writer.
+ */
+
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "sym560.h"
+
+/*******************************************************************************/
+/* Function   : sym560_open
+ * Inputs     : struct sym560 *h - handle to set up
+ *		const char *dev - device, normally "/dev/symgps"
+ *		const struct cap_config *cfg - options (see cap_config_default),
+ *					       only the lock polling and
+ *					       real-time ones apply
+ *		void *ring_mem - SYM560_RING_BYTES(order) bytes aligned to
+ *				 SYM560_RING_ALIGN, kept until sym560_close
+ *		unsigned int order - the ring holds 2^order events
+ * Returns    : 0 on success
+ *             -1 with errno set if the device could not be opened
+ * Description: With cfg->rt, locks all of the process's memory (see
+ *		sym560_rt_status if that fails).
+ */
+int sym560_open(struct sym560 *h, const char *dev, const struct cap_config *cfg, void *ring_mem,
+		unsigned int order) {
+	memset(h, 0, sizeof(*h));
+	h->devfd = open(dev, O_RDWR);
+	if (h->devfd == -1) {
+		return -1;
+	}
+	return cap_init_consumer(&h->cap, cfg, h->devfd, NULL, ring_mem, order);
+}
+/* end of function: sym560_open */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : sym560_open_sim
+ * Inputs     : struct sym560 *h - handle to set up
+ *		struct sim *sim - simulated source set up by sim_init or
+ *				  sim_init_pattern, kept until sym560_close
+ *		const struct cap_config *cfg, void *ring_mem, unsigned int order -
+ *				  as for sym560_open
+ * Returns    : 0
+ * Description: For testing without the card.  The configuration functions
+ *		fail, and the simulated card is always locked.
+ */
+int sym560_open_sim(struct sym560 *h, struct sim *sim, const struct cap_config *cfg, void *ring_mem,
+		unsigned int order) {
+	memset(h, 0, sizeof(*h));
+	h->devfd = -1;
+	h->sim = sim;
+	return cap_init_consumer(&h->cap, cfg, -1, sim, ring_mem, order);
+}
+/* end of function: sym560_open_sim */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : sym560_set_event_source
+ * Inputs     : struct sym560 *h - open handle
+ *		int source - 1-8, as numbered in the ev_source menu
+ * Returns    : 0 on success
+ *             -1 if source is invalid or the card could not be written
+ */
+int sym560_set_event_source(struct sym560 *h, int source) {
+	if (h->devfd == -1) {
+		return -1;
+	}
+	return ev_set_source(h->devfd, source);
+}
+/* end of function: sym560_set_event_source */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : sym560_get_event_setup
+ * Inputs     : struct sym560 *h - open handle
+ *		char *event - receives the event source name (at least 25 bytes)
+ *		char *edge - receives the trigger edge name (at least 10 bytes)
+ * Returns    : 0 on success
+ *             -1 if the card could not be read
+ */
+int sym560_get_event_setup(struct sym560 *h, char *event, char *edge) {
+	if (h->devfd == -1) {
+		return -1;
+	}
+	return ev_get_setup(h->devfd, event, edge);
+}
+/* end of function: sym560_get_event_setup */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : sym560_set_rate
+ * Inputs     : struct sym560 *h - open handle
+ *		int rate - 1-10, as numbered in the rg_rate menu
+ * Returns    : 0 on success
+ *             -1 if rate is invalid or the card could not be written
+ * Description: Sets the rate generator's rate only; it is enabled and routed
+ *		to the CODE OUT port by the automatic mode, or the menus.
+ */
+int sym560_set_rate(struct sym560 *h, int rate) {
+	if (h->devfd == -1) {
+		return -1;
+	}
+	return rg_set_rate(h->devfd, rate);
+}
+/* end of function: sym560_set_rate */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : sym560_gps_sync
+ * Inputs     : struct sym560 *h - open handle
+ * Returns    : 0 on success
+ *             -1 if the card could not be written
+ * Description: Synchronizes the card's generator to GPS, as GPS_start does
+ *		after checking the antenna.
+ */
+int sym560_gps_sync(struct sym560 *h) {
+	if (h->devfd == -1) {
+		return -1;
+	}
+	return GPS_sync(h->devfd);
+}
+/* end of function: sym560_gps_sync */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : sym560_start
+ * Inputs     : struct sym560 *h - open handle
+ * Returns    : 0 on success
+ *             -1 if the capture thread could not be started
+ * Description: With cfg->rt and cfg->rt_cpu set, the calling thread is moved
+ *		off rt_cpu for good, and threads it starts later with it.
+ */
+int sym560_start(struct sym560 *h) {
+	if (h->running) {
+		return 0;
+	}
+	if (cap_start(&h->cap) != 0) {
+		return -1;
+	}
+	h->running = 1;
+	return 0;
+}
+/* end of function: sym560_start */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : sym560_stop
+ * Inputs     : struct sym560 *h - open handle
+ * Returns    : 0
+ * Description: Events already captured stay in the ring and can still be
+ *		read.
+ */
+int sym560_stop(struct sym560 *h) {
+	if (h->running) {
+		cap_stop(&h->cap);
+		h->running = 0;
+	}
+	return 0;
+}
+/* end of function: sym560_stop */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : sym560_close
+ * Inputs     : struct sym560 *h - open handle
+ * Returns    : Nothing
+ * Description: Stops capture if it is running.  The ring memory is the
+ *		caller's again afterwards.
+ */
+void sym560_close(struct sym560 *h) {
+	sym560_stop(h);
+	cap_free(&h->cap);
+	if (h->devfd != -1) {
+		close(h->devfd);
+		h->devfd = -1;
+	}
+}
+/* end of function: sym560_close */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : sym560_status
+ * Inputs     : struct sym560 *h - open handle
+ *		struct sym560_status *st - receives the status
+ * Returns    : 0 on success
+ *             -1 if the card could not be read
+ * Description: The same snapshot the status broker publishes (sym560_status.h),
+ *		read from the card now rather than from shared memory.  The lock
+ *		state is the one being stamped on events while capturing with
+ *		lock polling, and read from the card otherwise.
+ */
+int sym560_status(struct sym560 *h, struct sym560_status *st) {
+	struct capture *cap = &h->cap;
+	struct timespec now;
+	int cnt;
+
+	memset(st, 0, sizeof(*st));
+	st->magic = STAT_MAGIC;
+	st->version = STAT_VERSION;
+	st->pid = getpid();
+	st->antenna = -1;
+	if (h->sim != NULL) {
+		st->lock = REC_LOCK_ALL;
+	}
+	else if (h->running && cap->cfg.lock_poll_ns != 0) {
+		st->lock = atomic_load(&cap->lock);
+	}
+	else {
+		st->lock = GPS_lock_status(h->devfd);
+		if (st->lock == -1) {
+			return -1;
+		}
+	}
+	if (h->devfd != -1) {
+		for (cnt = 0; cnt < 3 && !st->sat_valid; cnt++) {
+			st->sat_valid = sat_read(h->devfd, st->sat) == 0;
+		}
+		for (cnt = 0; cnt < 3 && !st->pos_valid; cnt++) {
+			st->pos_valid = position_read(h->devfd, st->pos) == 0;
+		}
+		st->antenna = antenna_read(h->devfd);
+	}
+	clock_gettime(CLOCK_REALTIME, &now);
+	st->updated_ns = now.tv_sec * 1000000000LL + now.tv_nsec;
+	st->card_ns = st->updated_ns;
+	st->samples = 1;
+	st->written = atomic_load(&cap->written);
+	st->captured = atomic_load(&cap->captured);
+	st->dropped = atomic_load(&cap->overflows);
+	st->backlog = ring_count(cap->ring);
+	return 0;
+}
+/* end of function: sym560_status */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : sym560_rt_status
+ * Inputs     : struct sym560 *h - open handle
+ * Returns    : the CAP_RT_* parts of the real-time profile that could not be
+ *		applied, 0 if all were or cfg->rt is off
+ * Description: Memory is locked on open and the threads placed on
+ *		sym560_start, so this is complete only after sym560_start.
+ */
+int sym560_rt_status(struct sym560 *h) {
+	return h->cap.rt_failed;
+}
+/* end of function: sym560_rt_status */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : sym560_time
+ * Inputs     : struct sym560 *h - open handle
+ *		int64_t *ns - receives the card's current time, UTC nanoseconds
+ *			      since 1970-01-01
+ * Returns    : 0 on success
+ *             -1 if the card could not be read
+ * Description: Resolution is that of the card, 100 ns.  A simulator's clock is
+ *		the one it stamps events with.
+ */
+int sym560_time(struct sym560 *h, int64_t *ns) {
+	unsigned char raw[REC_RAW_LEN];
+
+	if (h->sim != NULL) {
+		*ns = h->sim->start_ns + sim_now() - h->sim->t0;
+		return 0;
+	}
+	if (time_read(h->devfd, raw) == -1) {
+		return -1;
+	}
+	*ns = time_decode(raw);
+	return 0;
+}
+/* end of function: sym560_time */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : sym560_try_read
+ * Inputs     : struct sym560 *h - handle
+ *		struct sym560_record *recs - receives the events, oldest first
+ *		int max - room in recs
+ * Returns    : The number of events copied, 0 if there were none
+ * Description: Never blocks.
+ */
+int sym560_try_read(struct sym560 *h, struct sym560_record *recs, int max) {
+	struct ring *ring = h->cap.ring;
+	struct sym560_record *first;
+	uint64_t n;
+	int got = 0;
+
+	/* more than once when the events wrap round the end of the ring */
+	while (got < max) {
+		n = ring_peek(ring, &first);
+		if (n == 0) {
+			break;
+		}
+		if (n > (uint64_t)(max - got)) {
+			n = max - got;
+		}
+		memcpy(recs + got, first, n * sizeof(*first));
+		ring_release(ring, n);
+		got += n;
+	}
+	atomic_fetch_add_explicit(&h->cap.written, got, memory_order_relaxed);
+	return got;
+}
+/* end of function: sym560_try_read */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : sym560_read
+ * Inputs     : struct sym560 *h - handle
+ *		struct sym560_record *recs - receives the events, oldest first
+ *		int max - room in recs
+ *		int timeout_ms - longest wait for the first event, SYM560_FOREVER
+ *				 for no limit
+ * Returns    : The number of events copied, 0 on timeout
+ *             -1 once capture has ended and every event has been read
+ * Description: Returns as soon as any events are waiting, without waiting for
+ *		max of them.  Polls the ring every millisecond like the writer
+ *		thread does, so the capture thread never makes a system call to
+ *		wake it.
+ */
+int sym560_read(struct sym560 *h, struct sym560_record *recs, int max, int timeout_ms) {
+	struct timespec pause = {0, 1000000};
+	int got, waited = 0;
+
+	for (;;) {
+		got = sym560_try_read(h, recs, max);
+		if (got != 0) {
+			return got;
+		}
+		if (!h->running || atomic_load_explicit(&h->cap.cap_done, memory_order_acquire)) {
+			/* the capture thread may have committed more before exiting */
+			got = sym560_try_read(h, recs, max);
+			return got != 0 ? got : -1;
+		}
+		if (timeout_ms != SYM560_FOREVER && waited >= timeout_ms) {
+			return 0;
+		}
+		nanosleep(&pause, NULL);
+		waited++;
+	}
+}
+/* end of function: sym560_read */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : sym560_dispatch
+ * Inputs     : struct sym560 *h - handle
+ *		sym560_handler fn - called with each batch
+ *		void *arg - passed to fn
+ *		int max - most events per call of fn
+ * Returns    : The number of events handed to fn, 0 if there were none
+ * Description: Never blocks.  Each batch is passed in place in the ring and its
+ *		slots are only handed back to the capture thread once fn
+ *		returns, so a slow fn makes the ring fill sooner.
+ */
+int sym560_dispatch(struct sym560 *h, sym560_handler fn, void *arg, int max) {
+	struct ring *ring = h->cap.ring;
+	struct sym560_record *first;
+	uint64_t n, total = 0;
+
+	/* at most a ring's worth, so a fast source cannot keep it here */
+	for (;;) {
+		n = ring_peek(ring, &first);
+		if (n == 0) {
+			break;
+		}
+		if (n > (uint64_t)max) {
+			n = max;
+		}
+		fn(first, (int)n, arg);
+		ring_release(ring, n);
+		total += n;
+		if (total >= ring->mask + 1) {
+			break;
+		}
+	}
+	atomic_fetch_add_explicit(&h->cap.written, total, memory_order_relaxed);
+	return (int)total;
+}
+/* end of function: sym560_dispatch */
+/*******************************************************************************/
@@ -0,0 +1,381 @@
+/* File : 	sym560_metrics.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Exporter thread for the capture metrics (see sym560_metrics.h).
+ *		Everything is read with relaxed loads from counters the capture,
+ *		writer and status threads keep anyway, so exporting never holds any
+ *		of them up.  The file is written to a temporary name and renamed
+ *		into place, so a reader never sees half of one.  The satellite and
+ *		antenna figures come from the status broker (sym560_status.c) and
+ *		are left out while it is not running, and the pulse sequence
+ *		figures come from the tracker (sym560_tracker.c) when there is one.
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include "sym560_functions.h"
+#include "sym560_metrics.h"
+
+/* text being built up by met_format */
+struct met_text {
+	char *buff;
+	size_t len;
+	size_t pos;
+};
+
+/*******************************************************************************/
+/* Function   : met_printf
+ * Inputs     : struct met_text *t - text being built
+ *		const char *fmt, ... - as for printf
+ * Returns    : Nothing
+ * Description: Anything that does not fit is cut off, and met_format reports
+ *		the text as too long.
+ */
+static void met_printf(struct met_text *t, const char *fmt, ...) {
+	va_list ap;
+	int ret;
+
+	if (t->pos >= t->len) {
+		return;
+	}
+	va_start(ap, fmt);
+	ret = vsnprintf(t->buff + t->pos, t->len - t->pos, fmt, ap);
+	va_end(ap);
+	t->pos += ret > 0 ? ret : 0;
+}
+/* end of function: met_printf */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : met_metric
+ * Inputs     : struct met_text *t - text being built
+ *		const char *name - metric name
+ *		const char *type - counter or gauge
+ *		const char *help - description
+ *		double value - current value
+ * Returns    : Nothing
+ */
+static void met_metric(struct met_text *t, const char *name, const char *type,
+		const char *help, double value) {
+	met_printf(t, "# HELP %s %s\n# TYPE %s %s\n%s %.17g\n", name, help, name, type, name, value);
+}
+/* end of function: met_metric */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : met_histogram
+ * Inputs     : struct met_text *t - text being built
+ *		const char *name - metric name
+ *		const char *help - description
+ *		struct met_hist *h - histogram
+ *		double scale - converts the recorded values to the metric's unit
+ * Returns    : Nothing
+ * Description: The count is the total of the buckets as read, so the output is
+ *		consistent even if the writer adds to them meanwhile.
+ */
+static void met_histogram(struct met_text *t, const char *name, const char *help,
+		struct met_hist *h, double scale) {
+	uint64_t total = 0;
+	int cnt;
+
+	met_printf(t, "# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+	for (cnt = 0; cnt < MET_BUCKETS - 1; cnt++) {
+		total += atomic_load_explicit(&h->bucket[cnt], memory_order_relaxed);
+		met_printf(t, "%s_bucket{le=\"%.17g\"} %llu\n", name, (double)(1ULL << cnt) * scale,
+				(unsigned long long)total);
+	}
+	total += atomic_load_explicit(&h->bucket[cnt], memory_order_relaxed);
+	met_printf(t, "%s_bucket{le=\"+Inf\"} %llu\n", name, (unsigned long long)total);
+	met_printf(t, "%s_sum %.17g\n%s_count %llu\n", name,
+			atomic_load_explicit(&h->sum, memory_order_relaxed) * scale,
+			name, (unsigned long long)total);
+}
+/* end of function: met_histogram */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : met_satellites
+ * Inputs     : struct met_text *t - text being built
+ *		const unsigned char *sat - 24 bytes as read by sat_read
+ * Returns    : Nothing
+ * Description: One series per tracking channel, labelled with the SV number
+ *		it is on, decoded as in sat_print.
+ */
+static void met_satellites(struct met_text *t, const unsigned char *sat) {
+	const unsigned char *chan;
+	int cnt;
+
+	met_printf(t, "# HELP sym560_satellite_signal Signal level of each satellite being tracked.\n"
+			"# TYPE sym560_satellite_signal gauge\n");
+	for (cnt = 0; cnt < 6; cnt++) {
+		chan = &sat[cnt*4];
+		met_printf(t, "sym560_satellite_signal{channel=\"%d\",sv=\"%d%d\"} %d%d.%d%d\n", cnt + 1,
+				chan[0] >> 4, chan[0] & 0x0F, chan[3] >> 4, chan[3] & 0x0F,
+				chan[2] >> 4, chan[2] & 0x0F);
+	}
+}
+/* end of function: met_satellites */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : met_tracker
+ * Inputs     : struct met_text *t - text being built
+ *		struct exporter *ex - exporter state
+ *		const struct tracker *trk - the writer's tracker
+ * Returns    : Nothing
+ * Description: The completeness is of the sequences found since the previous
+ *		export, so that it falls as soon as pulses start going missing.
+ */
+static void met_tracker(struct met_text *t, struct exporter *ex, const struct tracker *trk) {
+	uint64_t seen, missing;
+	int c;
+
+	met_printf(t, "# HELP sym560_sequences_total Pulse sequences found, by table.\n"
+			"# TYPE sym560_sequences_total counter\n");
+	for (c = 0; c < trk->tab.ntab; c++) {
+		met_printf(t, "sym560_sequences_total{table=\"%s\"} %llu\n", trk->tab.tab[c].name,
+				(unsigned long long)atomic_load_explicit(&trk->by_table[c], memory_order_relaxed));
+	}
+	met_metric(t, "sym560_sequences_complete_total", "counter",
+			"Pulse sequences found with every pulse.",
+			atomic_load_explicit(&trk->complete, memory_order_relaxed));
+	missing = atomic_load_explicit(&trk->missing, memory_order_relaxed);
+	seen = atomic_load_explicit(&trk->pulses, memory_order_relaxed);
+	met_metric(t, "sym560_sequence_pulses_total", "counter",
+			"Events placed in pulse sequences.", seen);
+	met_metric(t, "sym560_sequence_pulses_missing_total", "counter",
+			"Pulses missing from the pulse sequences found.", missing);
+	met_metric(t, "sym560_sequence_strays_total", "counter",
+			"Events in no pulse sequence.",
+			atomic_load_explicit(&trk->strays, memory_order_relaxed));
+	if (seen + missing > ex->last_seen + ex->last_missing) {
+		met_metric(t, "sym560_sequence_completeness", "gauge",
+				"Fraction of the pulses of the sequences found since the previous export that were seen.",
+				(double)(seen - ex->last_seen)
+				/ (seen + missing - ex->last_seen - ex->last_missing));
+	}
+	ex->last_seen = seen;
+	ex->last_missing = missing;
+}
+/* end of function: met_tracker */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : met_format
+ * Inputs     : struct exporter *ex - exporter state
+ *		char *buff - receives the text
+ *		size_t len - room in buff
+ * Returns    : Length of the text
+ *             -1 if it did not fit
+ */
+int met_format(struct exporter *ex, char *buff, size_t len) {
+	struct capture *cap = ex->cap;
+	struct sym560_status st;
+	struct tracker *trk;
+	struct met_text t = {buff, len, 0};
+	struct timespec now;
+	uint64_t captured, head, tail;
+	int64_t now_ns, mono, last_ns;
+	int lock;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	now_ns = now.tv_sec * 1000000000LL + now.tv_nsec;
+	mono = sim_now();
+	captured = atomic_load_explicit(&cap->captured, memory_order_relaxed);
+
+	met_metric(&t, "sym560_events_captured_total", "counter",
+			"Events read from the card.", captured);
+	met_metric(&t, "sym560_events_written_total", "counter",
+			"Events written to the timestamp files.",
+			atomic_load_explicit(&cap->written, memory_order_relaxed));
+	met_metric(&t, "sym560_ring_overflows_total", "counter",
+			"Events lost because the capture ring was full.",
+			atomic_load_explicit(&cap->overflows, memory_order_relaxed));
+	met_metric(&t, "sym560_events_dropped_total", "counter",
+			"Events discarded by the drop-oldest output policy.",
+			atomic_load_explicit(&cap->dropped, memory_order_relaxed));
+	met_metric(&t, "sym560_writer_stalls_total", "counter",
+			"Times the writer found every output buffer waiting on the disk.",
+			atomic_load_explicit(&cap->stalls, memory_order_relaxed));
+	met_metric(&t, "sym560_output_errors_total", "counter",
+			"Output file IO requests that failed.",
+			atomic_load_explicit(&cap->io.errors, memory_order_relaxed));
+	met_metric(&t, "sym560_output_write_failed", "gauge",
+			"1 once a write has failed; with a journal it then keeps the events from there on.",
+			atomic_load_explicit(&cap->io.failed_write, memory_order_relaxed) != 0);
+	met_metric(&t, "sym560_file_rotations_total", "counter",
+			"Timestamp files started.",
+			atomic_load_explicit(&cap->rotations, memory_order_relaxed));
+	if (ex->last_t != 0 && mono > ex->last_t) {
+		met_metric(&t, "sym560_events_per_second", "gauge",
+				"Events captured per second since the previous export.",
+				(captured - ex->last_captured) * 1e9 / (mono - ex->last_t));
+	}
+	ex->last_captured = captured;
+	ex->last_t = mono;
+
+	head = atomic_load_explicit(&cap->ring->head, memory_order_relaxed);
+	tail = atomic_load_explicit(&cap->ring->tail, memory_order_relaxed);
+	met_metric(&t, "sym560_ring_occupancy", "gauge",
+			"Records in the capture ring not yet released by the writer.", head - tail);
+	met_metric(&t, "sym560_ring_capacity", "gauge",
+			"Records the capture ring holds.", cap->ring->mask + 1);
+	met_histogram(&t, "sym560_writer_batch_records",
+			"Records the writer took from the ring at a time.", &cap->met_batch, 1);
+	met_histogram(&t, "sym560_writer_backlog_records",
+			"Records waiting in the ring each time the writer took a batch.",
+			&cap->met_backlog, 1);
+	met_histogram(&t, "sym560_writer_latency_seconds",
+			"Time from an event to the writer formatting it.", &cap->met_latency, 1e-6);
+
+	lock = atomic_load_explicit(&cap->lock, memory_order_relaxed);
+	met_metric(&t, "sym560_gps_lock_bits", "gauge",
+			"Lock bits of the software time lock register (0x70 = fully locked).", lock);
+	met_metric(&t, "sym560_gps_locked", "gauge",
+			"1 when GPS, input signal and phase are all locked.", lock == REC_LOCK_ALL);
+	last_ns = atomic_load_explicit(&cap->last_ns, memory_order_relaxed);
+	if (last_ns != 0) {
+		met_metric(&t, "sym560_seconds_since_last_event", "gauge",
+				"Time since the last event the writer took.", (now_ns - last_ns) / 1e9);
+	}
+
+	trk = atomic_load_explicit(&cap->tracker, memory_order_acquire);
+	if (trk != NULL) {
+		met_tracker(&t, ex, trk);
+	}
+
+	if (stat_read(&st) == 0) {
+		if (st.sat_valid) {
+			met_satellites(&t, st.sat);
+		}
+		if (st.antenna != -1) {
+			met_metric(&t, "sym560_antenna_ok", "gauge",
+					"1 when the antenna is neither open nor shorted.",
+					(st.antenna & STAT_ANT_OK) == STAT_ANT_OK);
+		}
+		met_metric(&t, "sym560_status_age_seconds", "gauge",
+				"Age of the card status sample.", (now_ns - st.card_ns) / 1e9);
+	}
+	met_metric(&t, "sym560_last_export_timestamp_seconds", "gauge",
+			"When this file was written.", now_ns / 1e9);
+	return t.pos < len ? (int)t.pos : -1;
+}
+/* end of function: met_format */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : met_write
+ * Inputs     : struct exporter *ex - exporter state
+ * Returns    : 0 on success
+ *             -1 on failure
+ * Description: Replaces the metrics file in one rename.
+ */
+int met_write(struct exporter *ex) {
+	int fd, len;
+
+	len = met_format(ex, ex->buff, MET_BUFF_LEN);
+	if (len == -1) {
+		return -1;
+	}
+	fd = open(ex->tmp, O_WRONLY|O_CREAT|O_TRUNC, 00644);
+	if (fd == -1) {
+		return -1;
+	}
+	if (write(fd, ex->buff, len) != len) {
+		close(fd);
+		unlink(ex->tmp);
+		return -1;
+	}
+	close(fd);
+	return rename(ex->tmp, ex->path);
+}
+/* end of function: met_write */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : met_thread_main
+ * Inputs     : void *arg - the struct exporter
+ * Returns    : NULL
+ * Description: Exports every MET_PERIOD_NS, sleeping in short steps so that
+ *		met_stop is not held up.
+ */
+static void *met_thread_main(void *arg) {
+	struct exporter *ex = arg;
+	struct timespec step = {0, 100000000};
+	int64_t slept;
+
+	while (atomic_load(&ex->stop) == 0) {
+		met_write(ex);
+		for (slept = 0; slept < MET_PERIOD_NS; slept += 100000000) {
+			if (atomic_load(&ex->stop) != 0) {
+				return NULL;
+			}
+			nanosleep(&step, NULL);
+		}
+	}
+	return NULL;
+}
+/* end of function: met_thread_main */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : met_start
+ * Inputs     : struct exporter *ex - exporter state to set up
+ *		struct capture *cap - running capture
+ *		const char *path - file to write
+ * Returns    : 0 on success
+ *             -1 on failure
+ * Description: Checks the file can be written and starts the exporter thread.
+ *		Call after cap_start, as for ctl_start.
+ */
+int met_start(struct exporter *ex, struct capture *cap, const char *path) {
+	memset(ex, 0, sizeof(*ex));
+	ex->cap = cap;
+	ex->path = path;
+	if (snprintf(ex->tmp, sizeof(ex->tmp), "%s.tmp", path) >= (int)sizeof(ex->tmp)) {
+		printf("\nMetrics file name %s is too long\n", path);
+		return -1;
+	}
+	ex->buff = malloc(MET_BUFF_LEN);
+	if (ex->buff == NULL) {
+		return -1;
+	}
+	if (met_write(ex) != 0) {
+		printf("\nCould not write the metrics to %s (errno %d)\n", path, errno);
+		free(ex->buff);
+		return -1;
+	}
+	if (pthread_create(&ex->thread, NULL, met_thread_main, ex) != 0) {
+		printf("\nCould not start the metrics thread\n");
+		free(ex->buff);
+		return -1;
+	}
+	return 0;
+}
+/* end of function: met_start */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : met_stop
+ * Inputs     : struct exporter *ex - exporter started by met_start
+ * Returns    : Nothing
+ * Description: Removes the file, so that a stopped daemon shows up as missing
+ *		metrics rather than as figures that stopped changing.
+ */
+void met_stop(struct exporter *ex) {
+	atomic_store(&ex->stop, 1);
+	pthread_join(ex->thread, NULL);
+	unlink(ex->path);
+	free(ex->buff);
+}
+/* end of function: met_stop */
+/*******************************************************************************/
@@ -0,0 +1,79 @@
+/* File : 	sym560_metrics.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Metrics for the capture pipeline.  The writer thread keeps a
+ *		few histograms alongside the capture's counters, and an exporter
+ *		thread writes all of them, with the card status, to a file in the
+ *		Prometheus text format every MET_PERIOD_NS for node_exporter's
+ *		textfile collector (or anything else that can read a file).
+ */
+
+#ifndef SYM560_METRICS_H
+#define SYM560_METRICS_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* file the automatic mode writes unless told otherwise (in the output directory) */
+#define MET_DEFAULT_PATH	"sym560.prom"
+
+/* how often the file is rewritten */
+#define MET_PERIOD_NS		5000000000LL
+
+/* histogram bucket i counts values up to 2^i, the last one everything larger */
+#define MET_BUCKETS		24
+
+/* room for one export */
+#define MET_BUFF_LEN		16384
+
+/* Power of 2 histogram with a single updating thread, so an observation is a
+ * few plain loads and stores: no locked instructions on the writer's path. */
+struct met_hist {
+	_Atomic uint64_t bucket[MET_BUCKETS];
+	_Atomic uint64_t sum;
+};
+
+struct capture;
+
+struct exporter {
+	struct capture *cap;
+	const char *path;		/* file written */
+	char tmp[256];			/* written first and renamed over path */
+	char *buff;			/* MET_BUFF_LEN bytes */
+	uint64_t last_captured;		/* for events per second */
+	uint64_t last_seen;		/* for the sequences' completeness, see met_tracker */
+	uint64_t last_missing;
+	int64_t last_t;
+	pthread_t thread;
+	_Atomic int stop;
+};
+
+/*******************************************************************************/
+/* Function   : met_observe
+ * Inputs     : struct met_hist *h - histogram, only ever updated by this thread
+ *		uint64_t v - value seen
+ * Returns    : Nothing
+ */
+static inline void met_observe(struct met_hist *h, uint64_t v) {
+	int idx = v <= 1 ? 0 : 64 - __builtin_clzll(v - 1);
+
+	if (idx >= MET_BUCKETS) {
+		idx = MET_BUCKETS - 1;
+	}
+	atomic_store_explicit(&h->bucket[idx],
+		atomic_load_explicit(&h->bucket[idx], memory_order_relaxed) + 1, memory_order_relaxed);
+	atomic_store_explicit(&h->sum,
+		atomic_load_explicit(&h->sum, memory_order_relaxed) + v, memory_order_relaxed);
+}
+/* end of function: met_observe */
+/*******************************************************************************/
+
+/* function declarations */
+int met_start(struct exporter *ex, struct capture *cap, const char *path);
+int met_format(struct exporter *ex, char *buff, size_t len);
+int met_write(struct exporter *ex);
+void met_stop(struct exporter *ex);
+
+#endif /* SYM560_METRICS_H */
@@ -0,0 +1,314 @@
+/* File : 	sym560_monitor.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Live terminal monitor (see sym560_monitor.h).  Subscribes to the
+ *		event stream like any other client, runs the pulse sequence
+ *		detector over what it receives and redraws the screen once per
+ *		refresh interval from that and the status segment.  It is just
+ *		another stream subscriber to the daemon, and a slow one is only
+ *		ever skipped ahead, so watching a station under load changes
+ *		nothing about how it captures.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <ncurses.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "sym560_functions.h"
+#include "sym560_seq.h"
+#include "sym560_monitor.h"
+
+struct mon {
+	const char *path;		/* stream socket */
+	int sock;			/* -1 while not connected */
+	struct seq_set tab;
+	struct seq_det det;
+	int64_t last_ns;		/* time of the last event received */
+	int64_t interval[MON_INTERVALS];	/* recent inter-pulse intervals, oldest first */
+	int nint;
+	uint64_t events;		/* received since the start */
+	uint64_t lags;			/* lag notices */
+	uint64_t missed;		/* events they said were skipped */
+	int64_t prev_t;			/* CLOCK_MONOTONIC time of the last redraw */
+	uint64_t prev_events;		/* counts at the last redraw */
+	uint64_t prev_captured;
+	uint64_t prev_seqs;
+	uint64_t prev_pulses;
+	uint64_t prev_missing;
+	uint64_t prev_strays;
+	uint64_t prev_by_table[SEQ_MAX_TABLES];
+};
+
+/*******************************************************************************/
+/* Function   : mon_connect
+ * Inputs     : struct mon *m - monitor state
+ * Returns    : Nothing
+ * Description: Tries to subscribe to the stream.  The detector starts afresh,
+ *		as the events up to now are lost.
+ */
+static void mon_connect(struct mon *m) {
+	struct sockaddr_un addr;
+	struct seq_result seq;
+	int64_t stray;
+
+	m->sock = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+	if (m->sock == -1) {
+		return;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, m->path, sizeof(addr.sun_path) - 1);
+	if (connect(m->sock, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+		close(m->sock);
+		m->sock = -1;
+		return;
+	}
+	seq_flush(&m->det, &seq, &stray);
+	m->last_ns = 0;
+}
+/* end of function: mon_connect */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : mon_read
+ * Inputs     : struct mon *m - monitor state
+ * Returns    : Nothing
+ * Description: Takes every packet waiting on the stream.  After a lag notice
+ *		the sequence being built is closed, since its remaining pulses may
+ *		have been among the events skipped.
+ */
+static void mon_read(struct mon *m) {
+	char pkt[sizeof(struct str_header) + STR_BATCH * sizeof(struct sym560_record)];
+	struct str_header *hdr = (struct str_header *)pkt;
+	struct sym560_record *rec = (struct sym560_record *)(pkt + sizeof(*hdr));
+	struct seq_result seq;
+	int64_t stray;
+	uint32_t cnt;
+	int ret;
+
+	for (;;) {
+		ret = recv(m->sock, pkt, sizeof(pkt), MSG_DONTWAIT);
+		if (ret == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+			return;
+		}
+		if (ret <= 0) {
+			close(m->sock);
+			m->sock = -1;
+			return;
+		}
+		if (hdr->type == STR_LAG) {
+			m->lags++;
+			m->missed += hdr->missed;
+			seq_flush(&m->det, &seq, &stray);
+			m->last_ns = 0;
+			continue;
+		}
+		for (cnt = 0; cnt < hdr->count; cnt++) {
+			if (m->last_ns != 0) {
+				if (m->nint == MON_INTERVALS) {
+					memmove(m->interval, m->interval + 1, (MON_INTERVALS - 1) * sizeof(int64_t));
+					m->nint--;
+				}
+				m->interval[m->nint++] = rec[cnt].ns - m->last_ns;
+			}
+			m->last_ns = rec[cnt].ns;
+			seq_feed(&m->det, rec[cnt].ns, &seq, &stray);
+		}
+		m->events += hdr->count;
+	}
+}
+/* end of function: mon_read */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : mon_draw
+ * Inputs     : struct mon *m - monitor state
+ * Returns    : Nothing
+ * Description: Rates are over the time since the previous redraw.  Without the
+ *		stream the event rate comes from the status segment's counters.
+ */
+static void mon_draw(struct mon *m) {
+	struct sym560_status st;
+	struct timespec now;
+	struct tm tm;
+	time_t secs;
+	char when[32];
+	const char *ant;
+	const unsigned char *chan;
+	double dt, rate;
+	uint64_t pulses, missing;
+	int64_t now_ns, mono = sim_now();
+	int have_st, cnt, row;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	now_ns = now.tv_sec * 1000000000LL + now.tv_nsec;
+	secs = now.tv_sec;
+	gmtime_r(&secs, &tm);
+	strftime(when, sizeof(when), "%Y-%j %H:%M:%S", &tm);
+	dt = m->prev_t != 0 ? (mono - m->prev_t) / 1e9 : 0;
+	have_st = stat_read(&st) == 0;
+
+	erase();
+	mvprintw(0, 0, "sym560 monitor    %s UTC    (q to quit)", when);
+
+	if (m->sock != -1 && dt > 0) {
+		rate = (m->events - m->prev_events) / dt;
+	}
+	else if (have_st && dt > 0 && m->prev_captured != 0) {
+		rate = (st.captured - m->prev_captured) / dt;
+	}
+	else {
+		rate = 0;
+	}
+	if (have_st) {
+		mvprintw(2, 0, "Capture     %10.1f events/s   captured %llu   written %llu", rate,
+				(unsigned long long)st.captured, (unsigned long long)st.written);
+		mvprintw(3, 0, "Writer      backlog %llu records   lost %llu   disk stalls %llu",
+				(unsigned long long)st.backlog, (unsigned long long)st.dropped,
+				(unsigned long long)st.stalls);
+		mvprintw(4, 0, "GPS         %s (0x%02x)", st.lock == REC_LOCK_ALL ? "LOCKED" :
+				st.lock == REC_LOCK_UNKNOWN ? "lock not monitored" : "NOT LOCKED", st.lock);
+		if (st.antenna == -1) {
+			ant = "not read";
+		}
+		else if ((st.antenna & STAT_ANT_NOT_SHORTED) == 0) {
+			ant = "SHORTED";
+		}
+		else if ((st.antenna & STAT_ANT_NOT_OPEN) == 0) {
+			ant = "OPEN";
+		}
+		else {
+			ant = "OK";
+		}
+		mvprintw(5, 0, "Antenna     %s", ant);
+		mvprintw(6, 0, "Satellites ");
+		if (st.sat_valid) {
+			for (cnt = 0; cnt < 6; cnt++) {
+				chan = &st.sat[cnt*4];
+				printw(" SV%d%d %d%d.%d%d ", chan[0] >> 4, chan[0] & 0x0F, chan[3] >> 4,
+						chan[3] & 0x0F, chan[2] >> 4, chan[2] & 0x0F);
+			}
+		}
+		else {
+			printw(" not read");
+		}
+		mvprintw(7, 0, "Status      from process %d, card read %.1f s ago", (int)st.pid,
+				(now_ns - st.card_ns) / 1e9);
+		m->prev_captured = st.captured;
+	}
+	else {
+		mvprintw(2, 0, "Capture     %10.1f events/s", rate);
+		mvprintw(3, 0, "Status      no timestamping process is publishing its status (%s)",
+				STAT_SHM_NAME);
+	}
+
+	pulses = m->det.pulses - m->prev_pulses;
+	missing = m->det.missing - m->prev_missing;
+	if (m->sock == -1) {
+		mvprintw(9, 0, "Stream      not connected to %s", m->path);
+	}
+	else {
+		mvprintw(9, 0, "Sequences   %8.2f /s   %5.1f%% of pulses present   missing %.2f pulses/s"
+				"   strays %.2f /s", dt > 0 ? (m->det.sequences - m->prev_seqs) / dt : 0,
+				pulses + missing != 0 ? 100.0 * pulses / (pulses + missing) : 0,
+				dt > 0 ? missing / dt : 0,
+				dt > 0 ? (m->det.strays - m->prev_strays) / dt : 0);
+		if (m->last_ns != 0) {
+			mvprintw(10, 0, "Last pulse  %.3f s ago", (now_ns - m->last_ns) / 1e9);
+		}
+		mvprintw(11, 0, "Stream      %s, %llu lag notices, %llu events skipped", m->path,
+				(unsigned long long)m->lags, (unsigned long long)m->missed);
+		if (m->tab.ntab > 1) {
+			mvprintw(12, 0, "By table   ");
+			for (cnt = 0; cnt < m->tab.ntab; cnt++) {
+				printw(" %s %.2f /s ", m->tab.tab[cnt].name,
+						dt > 0 ? (m->det.by_table[cnt] - m->prev_by_table[cnt]) / dt : 0);
+			}
+		}
+		mvprintw(13, 0, "Recent inter-pulse intervals (ms, newest last):");
+		row = 14;
+		for (cnt = 0; cnt < m->nint; cnt++) {
+			if (cnt % 8 == 0) {
+				move(row++, 0);
+			}
+			printw("%10.4f", m->interval[cnt] / 1e6);
+		}
+	}
+	refresh();
+
+	m->prev_t = mono;
+	m->prev_events = m->events;
+	m->prev_seqs = m->det.sequences;
+	m->prev_pulses = m->det.pulses;
+	m->prev_missing = m->det.missing;
+	m->prev_strays = m->det.strays;
+	memcpy(m->prev_by_table, m->det.by_table, sizeof(m->prev_by_table));
+}
+/* end of function: mon_draw */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : monitor
+ * Inputs     : const char *stream_path - the daemon's stream socket
+ *		const char *seps - pulse tables (see seq_set_parse)
+ *		double refresh_s - seconds between redraws
+ * Returns    : 0 when the user quits
+ *             -1 if the pulse table is not valid
+ * Description: Keeps trying to connect to the stream at every redraw, so it
+ *		can be left running across restarts of the daemon.
+ */
+int monitor(const char *stream_path, const char *seps, double refresh_s) {
+	struct mon m;
+	struct pollfd pfd[2];
+	int64_t next = 0, now, wait;
+	int ch;
+
+	memset(&m, 0, sizeof(m));
+	m.path = stream_path;
+	m.sock = -1;
+	if (seq_set_parse(&m.tab, seps, SEQ_DEFAULT_TOL_NS) != 0) {
+		printf("\nInvalid pulse tables %s\n", seps);
+		return -1;
+	}
+	seq_init(&m.det, &m.tab);
+
+	initscr();
+	cbreak();
+	noecho();
+	nodelay(stdscr, TRUE);
+	curs_set(0);
+	for (;;) {
+		ch = getch();
+		if (ch == 'q' || ch == 'Q') {
+			break;
+		}
+		now = sim_now();
+		if (now >= next) {
+			if (m.sock == -1) {
+				mon_connect(&m);
+			}
+			mon_draw(&m);
+			next = now + (int64_t)(refresh_s * 1e9);
+		}
+		wait = (next - now) / 1000000;
+		pfd[0].fd = 0;
+		pfd[0].events = POLLIN;
+		pfd[1].fd = m.sock;
+		pfd[1].events = POLLIN;
+		if (poll(pfd, 2, wait < 100 ? (int)wait : 100) > 0 && pfd[1].revents != 0) {
+			mon_read(&m);
+		}
+	}
+	endwin();
+	if (m.sock != -1) {
+		close(m.sock);
+	}
+	seq_set_free(&m.tab);
+	return 0;
+}
+/* end of function: monitor */
+/*******************************************************************************/
@@ -0,0 +1,22 @@
+/* File : 	sym560_monitor.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Live terminal view of a running automatic mode, in the manner
+ *		of top.  Everything shown comes from the daemon's status segment
+ *		(sym560_status.c) and live event stream (sym560_stream.c), so the
+ *		monitor never opens /dev/symgps and cannot disturb capture.
+ */
+
+#ifndef SYM560_MONITOR_H
+#define SYM560_MONITOR_H
+
+/* default screen refresh interval, seconds */
+#define MON_REFRESH_S		1.0
+
+/* inter-pulse intervals shown */
+#define MON_INTERVALS		16
+
+/* function declarations */
+int monitor(const char *stream_path, const char *seps, double refresh_s);
+
+#endif /* SYM560_MONITOR_H */
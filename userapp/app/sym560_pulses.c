@@ -0,0 +1,430 @@
+/* File : 	sym560_pulses.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Compiled replacement for findpulse.pl (see sym560_pulses.h).
+ *		The output is byte for byte what findpulse.pl writes for the same
+ *		input as long as the input is well formed: the same header, a
+ *		PULSES TIMESTAMPED FOR block whenever the hour changes, sequences
+ *		with MISSING in place of the pulses not seen and N before events in
+ *		no sequence.  Where the two differ it is because of the following
+ *		in findpulse.pl, none of which are copied:
+ *		 - Times are compared by their seconds alone (plus 60 when the
+ *		   second one is smaller), so two events whose seconds differ by
+ *		   a pulse separation pair up however many minutes apart they are.
+ *		 - Each event in a sequence is numbered by matching it against the
+ *		   event before rather than against the start of the sequence, so
+ *		   a missing pulse can shift the numbers of those after it.
+ *		 - An event that does not fit the open sequence is printed as if
+ *		   it were the sequence's last pulse (with MISSING for the ones
+ *		   between), and the event after it is dropped.  Here the sequence
+ *		   ends with REMAINING PULSES IN SEQUENCE ARE MISSING and the event
+ *		   goes on to start the next one.
+ *		 - A stray as the second last event drops the last one.
+ *		 - Where it runs out of events decides between three spellings of
+ *		   the EOF line.  Here it is EOF ENCOUNTERED when the input ended in
+ *		   the middle of a sequence or on an event not yet placed, and EOF
+ *		   otherwise, which is what findpulse.pl writes in those cases for
+ *		   input that does not trip over the above.
+ *		 - The hour block depends on the hour alone, so it is not written
+ *		   again after a gap of exactly a whole number of days.
+ *		When looking for more than one table, each sequence starts with a
+ *		TABLE line naming the one it is.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include "sym560_record.h"
+#include "sym560_pulses.h"
+
+#define NS_PER_SEC	1000000000LL
+#define NS_PER_HOUR	(3600 * NS_PER_SEC)
+#define NS_PER_DAY	(86400 * NS_PER_SEC)
+
+/* " HH:MM:SS.sssssss", with the leading space findpulse.pl leaves on the hour */
+#define PLS_TIME_LEN	20
+
+/* stdio buffers for the input and output files */
+#define PLS_BUFFER	(1 << 20)
+
+
+/*******************************************************************************/
+/* Function   : pls_time
+ * Inputs     : int64_t ns - event time
+ *		char *txt - receives the time of day as findpulse.pl prints it
+ * Returns    : Nothing
+ */
+static void pls_time(int64_t ns, char *txt) {
+	int64_t sod = ns % NS_PER_DAY;
+
+	sprintf(txt, " %02d:%02d:%02d.%07d", (int)(sod / NS_PER_HOUR), (int)(sod / (60 * NS_PER_SEC) % 60),
+		(int)(sod / NS_PER_SEC % 60), (int)(sod % NS_PER_SEC / 100));
+}
+/* end of function: pls_time */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : pls_date
+ * Inputs     : struct pulses *p - output
+ *		int64_t ns - event time
+ * Returns    : Nothing
+ * Description: Brings p->year and p->yday up to the day of ns.  Only calls
+ *		gmtime_r when the day changes.
+ */
+static void pls_date(struct pulses *p, int64_t ns) {
+	struct tm tm;
+	time_t secs;
+
+	if (ns / NS_PER_DAY == p->day) {
+		return;
+	}
+	p->day = ns / NS_PER_DAY;
+	secs = ns / NS_PER_SEC;
+	gmtime_r(&secs, &tm);
+	p->year = tm.tm_year + 1900;
+	p->yday = tm.tm_yday + 1;
+}
+/* end of function: pls_date */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : pls_hour
+ * Inputs     : struct pulses *p - output
+ *		int64_t ns - time of the first event of a sequence or a stray
+ * Returns    : Nothing
+ * Description: Writes the date block when ns is in another hour from the last
+ *		one written, as findpulse.pl does at the start of each group.
+ */
+static void pls_hour(struct pulses *p, int64_t ns) {
+	if (ns / NS_PER_HOUR == p->hour) {
+		return;
+	}
+	p->hour = ns / NS_PER_HOUR;
+	pls_date(p, ns);
+	fprintf(p->fp, "\n\nPULSES TIMESTAMPED FOR\n  YEAR:  %04d\n  DAY:  %03d\n\n", p->year, p->yday);
+}
+/* end of function: pls_hour */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : pls_sequence
+ * Inputs     : struct pulses *p - output
+ *		const struct seq_result *seq - sequence found
+ *		int at_end - the input ended while it was open
+ * Returns    : Nothing
+ */
+static void pls_sequence(struct pulses *p, const struct seq_result *seq, int at_end) {
+	char txt[PLS_TIME_LEN];
+	int k;
+
+	pls_hour(p, seq->ns[__builtin_ctz(seq->present)]);
+	fputc('\n', p->fp);
+	if (p->det.s->ntab > 1) {
+		fprintf(p->fp, "TABLE %s\n", p->det.s->tab[seq->table].name);
+	}
+	for (k = 0; k <= seq->last; k++) {
+		if (seq->present & (1U << k)) {
+			pls_time(seq->ns[k], txt);
+			fprintf(p->fp, "%s\n", txt);
+		}
+		else {
+			fputs("MISSING\n", p->fp);
+		}
+	}
+	if (seq->last < seq->npulse - 1 && !at_end) {
+		fputs("REMAINING PULSES IN SEQUENCE ARE MISSING\n", p->fp);
+	}
+}
+/* end of function: pls_sequence */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : pls_stray
+ * Inputs     : struct pulses *p - output
+ *		int64_t ns - event in no sequence
+ * Returns    : Nothing
+ */
+static void pls_stray(struct pulses *p, int64_t ns) {
+	char txt[PLS_TIME_LEN];
+
+	pls_hour(p, ns);
+	pls_time(ns, txt);
+	fprintf(p->fp, "\nN %s\n", txt);
+}
+/* end of function: pls_stray */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : pls_filename
+ * Inputs     : int64_t ns - time of the first event
+ *		char *name - receives the name, PLS_FILENAME_LEN long
+ * Returns    : Nothing
+ * Description: The name findpulse.pl auto gives its output.
+ */
+void pls_filename(int64_t ns, char *name) {
+	struct tm tm;
+	time_t secs = ns / NS_PER_SEC;
+
+	gmtime_r(&secs, &tm);
+	sprintf(name, "pulses_%04d_%03d_%02d%02d.txt", tm.tm_year + 1900, tm.tm_yday + 1, tm.tm_hour,
+		tm.tm_min);
+}
+/* end of function: pls_filename */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : pls_resume
+ * Inputs     : struct pulses *p - output to set up
+ *		FILE *fp - where it goes
+ *		const struct seq_set *s - pulse tables, kept by the caller
+ *		int64_t hour - hour of the last PULSES TIMESTAMPED FOR written
+ *			       before, since 1970, -1 if none
+ * Returns    : Nothing
+ * Description: Carries on output that another struct pulses ended with
+ *		pls_break, so that the two together are what one would have
+ *		written.
+ */
+void pls_resume(struct pulses *p, FILE *fp, const struct seq_set *s, int64_t hour) {
+	memset(p, 0, sizeof(*p));
+	p->fp = fp;
+	p->hour = hour;
+	p->day = -1;
+	seq_init(&p->det, s);
+}
+/* end of function: pls_resume */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : pls_open
+ * Inputs     : struct pulses *p - output to set up
+ *		FILE *fp - where it goes
+ *		const struct seq_set *s - pulse tables, kept by the caller
+ * Returns    : Nothing
+ * Description: Writes findpulse.pl's explanation of the format.
+ */
+void pls_open(struct pulses *p, FILE *fp, const struct seq_set *s) {
+	pls_resume(p, fp, s, -1);
+	fputs("OUTPUT FORMAT IF A PULSE SEQUENCE IS FOUND: \n"
+		"   PULSE 1 (HH:MM:SS.mmmuuun)\n"
+		"   PULSE 2\n"
+		"   ...\n"
+		"   PULSE N\n\n"
+		"IF A PULSE IS MISSING THEN 'MISSING' IS INSERTED\n"
+		"IF A PULSE IS NOT PART OF A SEQUENCE THEN 'N' IS PRINTED BEFORE THE TIME\n\n", fp);
+}
+/* end of function: pls_open */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : pls_event
+ * Inputs     : struct pulses *p - output
+ *		int64_t ns - next event time, in order
+ * Returns    : Nothing
+ */
+void pls_event(struct pulses *p, int64_t ns) {
+	struct seq_result seq;
+	int64_t stray;
+
+	switch (seq_feed(&p->det, ns, &seq, &stray)) {
+		case SEQ_DONE:
+			pls_sequence(p, &seq, 0);
+			break;
+		case SEQ_STRAY:
+			pls_stray(p, stray);
+			break;
+	}
+}
+/* end of function: pls_event */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : pls_close
+ * Inputs     : struct pulses *p - output
+ * Returns    : Nothing
+ * Description: Writes whatever the last events made and the EOF line, and
+ *		flushes the output.  Does not close it.
+ */
+void pls_close(struct pulses *p) {
+	struct seq_result seq;
+	int64_t stray;
+
+	switch (seq_flush(&p->det, &seq, &stray)) {
+		case SEQ_DONE:
+			pls_sequence(p, &seq, 1);
+			fputs("\nEOF ENCOUNTERED\n", p->fp);
+			break;
+		case SEQ_STRAY:
+			pls_stray(p, stray);
+			fputs("\nEOF ENCOUNTERED\n", p->fp);
+			break;
+		default:
+			fputs("\nEOF\n", p->fp);
+	}
+	fflush(p->fp);
+}
+/* end of function: pls_close */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : pls_break
+ * Inputs     : struct pulses *p - output
+ * Returns    : Nothing
+ * Description: Writes whatever the last events made, as pls_event would for
+ *		a next event too far after them to join them in a sequence, and
+ *		flushes the output.  The output can be carried on from that next
+ *		event with pls_resume.
+ */
+void pls_break(struct pulses *p) {
+	struct seq_result seq;
+	int64_t stray;
+
+	switch (seq_flush(&p->det, &seq, &stray)) {
+		case SEQ_DONE:
+			pls_sequence(p, &seq, 0);
+			break;
+		case SEQ_STRAY:
+			pls_stray(p, stray);
+			break;
+	}
+	fflush(p->fp);
+}
+/* end of function: pls_break */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : pls_read
+ * Inputs     : struct pls_input *in - input
+ *		int64_t *ns - receives the next event time
+ * Returns    : 0 on success
+ *             -1 at end of input
+ */
+int pls_read(struct pls_input *in, int64_t *ns) {
+	unsigned char raw[REC_RAW_LEN];
+
+	if (in->fp == NULL) {
+		return in->format == PLS_TEXT ? rec_map_text(&in->map, ns) : rec_map_raw(&in->map, ns);
+	}
+	if (in->format == PLS_TEXT) {
+		return rec_parse_text(in->fp, ns);
+	}
+	if (fread(raw, REC_RAW_LEN, 1, in->fp) != 1) {
+		return -1;
+	}
+	*ns = rec_decode(raw);
+	return 0;
+}
+/* end of function: pls_read */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : pls_done
+ * Inputs     : struct pls_input *in - input opened by findpulse
+ * Returns    : Nothing
+ * Description: Unmaps a file.  stdin is left open.
+ */
+static void pls_done(struct pls_input *in) {
+	if (in->fp == NULL) {
+		rec_map_close(&in->map);
+	}
+}
+/* end of function: pls_done */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : findpulse
+ * Inputs     : const char *infile - timestamp file, "-" for stdin
+ *		const char *outfile - output file, appended to, "-" for stdout
+ *				      and NULL to name it after the first event
+ *				      (pls_filename)
+ *		int format - PLS_TEXT or PLS_RAW
+ *		const char *tables - pulse tables (see seq_set_parse)
+ *		int64_t tol - how far from them a separation may be, ns
+ * Returns    : 0 on success, including when there was nothing to write
+ *             -1 if a table is not valid or a file cannot be opened
+ * Description: findpulse.pl auto.  As there, nothing is written when the input
+ *		holds fewer than two events.  A file is mapped and read with
+ *		rec_map_text or rec_map_raw, stdin through stdio.
+ */
+int findpulse(const char *infile, const char *outfile, int format, const char *tables, int64_t tol) {
+	struct seq_set set;
+	struct pulses p;
+	struct pls_input in;
+	FILE *out;
+	char name[PLS_FILENAME_LEN], txt[PLS_TIME_LEN];
+	int64_t first, second, ns;
+	int got;
+
+	if (seq_set_parse(&set, tables, tol) != 0) {
+		printf("\nInvalid pulse tables %s\n", tables);
+		return -1;
+	}
+	memset(&in, 0, sizeof(in));
+	in.format = format;
+	if (strcmp(infile, "-") == 0) {
+		in.fp = stdin;
+		setvbuf(in.fp, NULL, _IOFBF, PLS_BUFFER);
+	}
+	else if (rec_map_open(&in.map, infile) != 0) {
+		printf("\nCould not open %s: %s\n", infile, strerror(errno));
+		seq_set_free(&set);
+		return -1;
+	}
+
+	got = pls_read(&in, &first) == 0;
+	got += got && pls_read(&in, &second) == 0;
+	if (got == 0) {
+		printf("\nNO TIMESTAMPS FOUND\n");
+	}
+	else if (got == 1) {
+		pls_time(first, txt);
+		printf("\nOnly 1 timestamp found :%s\n", txt);
+	}
+	if (got < 2) {
+		pls_done(&in);
+		seq_set_free(&set);
+		return 0;
+	}
+
+	if (outfile == NULL) {
+		pls_filename(first, name);
+		outfile = name;
+	}
+	out = strcmp(outfile, "-") == 0 ? stdout : fopen(outfile, "a");
+	if (out == NULL) {
+		printf("\nCould not open %s: %s\n", outfile, strerror(errno));
+		pls_done(&in);
+		seq_set_free(&set);
+		return -1;
+	}
+	setvbuf(out, NULL, _IOFBF, PLS_BUFFER);
+
+	pls_open(&p, out, &set);
+	pls_event(&p, first);
+	pls_event(&p, second);
+	while (pls_read(&in, &ns) == 0) {
+		pls_event(&p, ns);
+	}
+	pls_close(&p);
+	seq_set_free(&set);
+
+	pls_done(&in);
+	if (out != stdout) {
+		fclose(out);
+	}
+	return 0;
+}
+/* end of function: findpulse */
+/*******************************************************************************/
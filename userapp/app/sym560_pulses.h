@@ -0,0 +1,52 @@
+/* File : 	sym560_pulses.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Compiled replacement for findpulse.pl.  Event times are fed
+ *		one at a time through the pulse sequence detector (sym560_seq.h)
+ *		and written out in findpulse.pl's condensed pulses_*.txt format as
+ *		each sequence or stray event is decided, so the work per event is
+ *		fixed and the whole input is never held in memory.
+ */
+
+#ifndef SYM560_PULSES_H
+#define SYM560_PULSES_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "sym560_seq.h"
+#include "sym560_record.h"
+
+/* length of the names made by pls_filename (pulses_YYYY_DDD_HHMM.txt) */
+#define PLS_FILENAME_LEN	32
+
+/* input formats */
+#define PLS_TEXT		0	/* plain text timestamp file */
+#define PLS_RAW			1	/* 12 byte BCD event times, as from the driver */
+
+/* where pls_read takes events from: fp if it is set, otherwise map */
+struct pls_input {
+	int format;			/* PLS_TEXT or PLS_RAW */
+	FILE *fp;
+	struct rec_map map;
+};
+
+struct pulses {
+	FILE *fp;
+	struct seq_det det;
+	int64_t hour;			/* hour of the last PULSES TIMESTAMPED FOR, since 1970 */
+	int64_t day;			/* day the year and yday below are for */
+	int year;
+	int yday;
+};
+
+/* function declarations */
+void pls_filename(int64_t ns, char *name);
+void pls_resume(struct pulses *p, FILE *fp, const struct seq_set *s, int64_t hour);
+void pls_open(struct pulses *p, FILE *fp, const struct seq_set *s);
+void pls_event(struct pulses *p, int64_t ns);
+void pls_break(struct pulses *p);
+void pls_close(struct pulses *p);
+int pls_read(struct pls_input *in, int64_t *ns);
+int findpulse(const char *infile, const char *outfile, int format, const char *tables, int64_t tol);
+
+#endif /* SYM560_PULSES_H */
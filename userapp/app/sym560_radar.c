@@ -0,0 +1,356 @@
+/* File : 	sym560_radar.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Join of radar control's sequence metadata with the timestamps
+ *		(see sym560_radar.h).  The writer calls rad_feed for every event
+ *		and rad_idle while the ring is empty; each does a fixed amount of
+ *		work and writes at most one SEQUENCE line, so the join adds nothing
+ *		to the writer but a detector step and two loads.  Sequences and
+ *		entries both arrive in time order, so only the oldest of each ever
+ *		needs comparing: whichever is older than the other by more than the
+ *		tolerance can have no partner left and is let go.
+ */
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sym560_functions.h"
+#include "sym560_radar.h"
+
+/*******************************************************************************/
+/* Function   : rad_format
+ * Inputs     : const struct rad_held *s - sequence found
+ *		const struct rad_meta *m - its entry
+ *		char *txtbuff - buffer of at least RAD_TEXT_MAX bytes
+ * Returns    : Number of characters written to txtbuff
+ * Description: Stamped with the time of the sequence's first pulse, inferred
+ *		if it is missing, and gives how far that was from the intended
+ *		start, the pulses found and which ones (bit k for pulse k + 1).  Like
+ *		the MARKER line it has no YEAR in it.
+ */
+static int rad_format(const struct rad_held *s, const struct rad_meta *m, char *txtbuff) {
+	time_t secs = s->start_ns / 1000000000LL;
+	struct tm tm;
+
+	gmtime_r(&secs, &tm);
+	return sprintf(txtbuff, "     SEQUENCE = %04d-%03d %02d:%02d:%02d.%07lld UTC ID %llu BEAM %u "
+			"FREQ %u kHz OFFSET %+.1f us PULSES %d/%d 0x%x\n\n",
+			tm.tm_year + 1900, tm.tm_yday + 1, tm.tm_hour, tm.tm_min, tm.tm_sec,
+			(long long)(s->start_ns % 1000000000LL) / 100, (unsigned long long)m->seq_id,
+			m->beam, m->freq_khz, (s->start_ns - m->start_ns) / 1e3, s->found,
+			s->npulse, s->present);
+}
+/* end of function: rad_format */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rad_hold
+ * Inputs     : struct joiner *j - joiner
+ *		const struct seq_result *seq - sequence just found
+ * Returns    : Nothing
+ * Description: If RAD_HOLD sequences are already waiting the oldest is given
+ *		up on.
+ */
+static void rad_hold(struct joiner *j, const struct seq_result *seq) {
+	struct rad_held *s;
+
+	if (j->held_head - j->held_tail == RAD_HOLD) {
+		j->held_tail++;
+		j->unjoined++;
+	}
+	s = &j->held[j->held_head & (RAD_HOLD - 1)];
+	s->start_ns = seq->start_ns;
+	s->present = seq->present;
+	s->found = seq->found;
+	s->npulse = seq->npulse;
+	j->held_head++;
+}
+/* end of function: rad_hold */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rad_match
+ * Inputs     : struct joiner *j - joiner
+ *		int64_t now - current time, on the events' clock
+ *		char *txtbuff - buffer of at least RAD_TEXT_MAX bytes
+ * Returns    : Number of characters written to txtbuff
+ * Description: Lets go of everything that can no longer be joined and writes
+ *		the first join found, if any.  The entry is copied out before its
+ *		slot is handed back to the producer.
+ */
+static int rad_match(struct joiner *j, int64_t now, char *txtbuff) {
+	struct rad_channel *ch = j->ch;
+	struct rad_held *s;
+	struct rad_meta m;
+	uint64_t tail = atomic_load_explicit(&ch->tail, memory_order_relaxed);
+	uint64_t head = atomic_load_explicit(&ch->head, memory_order_acquire);
+	int len = 0;
+
+	if (head - tail > RAD_SLOTS) {
+		/* a producer that does not check for room; nothing in it can be trusted */
+		tail = head;
+	}
+	for (;;) {
+		s = j->held_tail != j->held_head ? &j->held[j->held_tail & (RAD_HOLD - 1)] : NULL;
+		if (tail != head) {
+			m = ch->slot[tail & (RAD_SLOTS - 1)];
+		}
+		if (s != NULL && tail != head) {
+			if (m.start_ns < s->start_ns - j->tol) {
+				j->orphans++;
+				tail++;
+				continue;
+			}
+			if (s->start_ns < m.start_ns - j->tol) {
+				j->unjoined++;
+				j->held_tail++;
+				continue;
+			}
+			len = rad_format(s, &m, txtbuff);
+			j->joined++;
+			j->held_tail++;
+			tail++;
+			break;
+		}
+		if (s != NULL && now - s->start_ns > RAD_WINDOW_NS) {
+			j->unjoined++;
+			j->held_tail++;
+			continue;
+		}
+		if (tail != head && now - m.start_ns > RAD_WINDOW_NS) {
+			j->orphans++;
+			tail++;
+			continue;
+		}
+		break;
+	}
+	atomic_store_explicit(&ch->tail, tail, memory_order_release);
+	return len;
+}
+/* end of function: rad_match */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rad_feed
+ * Inputs     : struct joiner *j - joiner
+ *		int64_t ns - time of the next event
+ *		char *txtbuff - buffer of at least RAD_TEXT_MAX bytes
+ * Returns    : Number of characters written to txtbuff
+ * Description: Writer thread only, for every event in order.
+ */
+int rad_feed(struct joiner *j, int64_t ns, char *txtbuff) {
+	struct seq_result seq;
+	int64_t stray;
+
+	if (seq_feed(&j->det, ns, &seq, &stray) == SEQ_DONE) {
+		rad_hold(j, &seq);
+	}
+	return rad_match(j, ns, txtbuff);
+}
+/* end of function: rad_feed */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rad_idle
+ * Inputs     : struct joiner *j - joiner
+ *		int64_t now - UTC time, INT64_MAX to finish everything
+ *		char *txtbuff - buffer of at least RAD_TEXT_MAX bytes
+ * Returns    : Number of characters written to txtbuff
+ * Description: Writer thread only, while no events are coming in.  Finishes
+ *		a sequence whose last pulses are missing, allowing CAP_LATE_NS for
+ *		them to get through, and joins late entries.  Call again while it
+ *		returns a line.
+ */
+int rad_idle(struct joiner *j, int64_t now, char *txtbuff) {
+	struct seq_result seq;
+	int64_t stray;
+
+	/* the events' clock, which runs behind by as much as they can be late */
+	if (now != INT64_MAX) {
+		now -= CAP_LATE_NS;
+	}
+	if (seq_idle(&j->det, now, &seq, &stray) == SEQ_DONE) {
+		rad_hold(j, &seq);
+	}
+	return rad_match(j, now, txtbuff);
+}
+/* end of function: rad_idle */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rad_start
+ * Inputs     : struct joiner *j - joiner to set up
+ *		struct capture *cap - running capture
+ *		const char *name - shared memory object for the channel
+ *		int64_t tol - join tolerance in ns
+ * Returns    : 0 on success
+ *             -1 on failure
+ * Description: Creates the channel afresh, so that a producer still attached
+ *		to one left by an earlier run finds it closed, and hands the
+ *		joiner to the writer.  Sequences are those of findpulse.pl's @psep.
+ *		Call after cap_start, as for str_start.
+ */
+int rad_start(struct joiner *j, struct capture *cap, const char *name, int64_t tol) {
+	int fd;
+
+	memset(j, 0, sizeof(*j));
+	j->tol = tol;
+	if (strlen(name) >= sizeof(j->name)) {
+		printf("\nRadar channel name %s is too long\n", name);
+		return -1;
+	}
+	strcpy(j->name, name);
+
+	/* only the owner and group (radar control's) may write entries, as for
+	 * the control socket; the umask can only narrow that until the fchmod */
+	shm_unlink(name);
+	fd = shm_open(name, O_RDWR|O_CREAT|O_EXCL, 00660);
+	if (fd == -1) {
+		printf("\nCould not create the radar channel %s (errno %d)\n", name, errno);
+		return -1;
+	}
+	fchmod(fd, 00660);
+	if (ftruncate(fd, sizeof(struct rad_channel)) == -1) {
+		printf("\nCould not size the radar channel %s (errno %d)\n", name, errno);
+		close(fd);
+		shm_unlink(name);
+		return -1;
+	}
+	j->ch = mmap(NULL, sizeof(struct rad_channel), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (j->ch == MAP_FAILED) {
+		printf("\nCould not map the radar channel %s (errno %d)\n", name, errno);
+		shm_unlink(name);
+		return -1;
+	}
+	if (seq_set_parse(&j->tab, SEQ_DEFAULT_SEPS, SEQ_DEFAULT_TOL_NS) != 0) {
+		munmap(j->ch, sizeof(struct rad_channel));
+		shm_unlink(name);
+		return -1;
+	}
+	seq_init(&j->det, &j->tab);
+	j->ch->version = RAD_VERSION;
+	j->ch->slots = RAD_SLOTS;
+	j->ch->pid = getpid();
+	atomic_store_explicit(&j->ch->magic, RAD_MAGIC, memory_order_release);
+	atomic_store_explicit(&cap->radar, j, memory_order_release);
+	return 0;
+}
+/* end of function: rad_start */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rad_stop
+ * Inputs     : struct joiner *j - joiner started by rad_start
+ *		struct capture *cap - its capture
+ * Returns    : Nothing
+ * Description: Call after cap_stop, by which time the writer has finished
+ *		every join it could.  Producers see the channel close.
+ */
+void rad_stop(struct joiner *j, struct capture *cap) {
+	atomic_store_explicit(&cap->radar, NULL, memory_order_release);
+	atomic_store_explicit(&j->ch->magic, 0, memory_order_release);
+	j->refused = atomic_load(&j->ch->refused);
+	munmap(j->ch, sizeof(struct rad_channel));
+	shm_unlink(j->name);
+	seq_set_free(&j->tab);
+}
+/* end of function: rad_stop */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rad_print
+ * Inputs     : const struct joiner *j - stopped joiner
+ * Returns    : Nothing
+ */
+void rad_print(const struct joiner *j) {
+	printf("Radar control: %llu sequences joined, %llu found with no entry, %llu entries with no sequence",
+			(unsigned long long)j->joined, (unsigned long long)j->unjoined,
+			(unsigned long long)j->orphans);
+	if (j->refused != 0) {
+		printf(", %llu entries refused with the channel full", (unsigned long long)j->refused);
+	}
+	printf("\n");
+}
+/* end of function: rad_print */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rad_open
+ * Inputs     : struct rad_producer *p - producer to set up
+ *		const char *name - the automatic mode's channel
+ * Returns    : 0 on success
+ *             -1 if the automatic mode is not running
+ * Description: For radar control.  Only one producer may push at a time.
+ */
+int rad_open(struct rad_producer *p, const char *name) {
+	int fd;
+
+	fd = shm_open(name, O_RDWR, 0);
+	if (fd == -1) {
+		return -1;
+	}
+	p->ch = mmap(NULL, sizeof(struct rad_channel), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (p->ch == MAP_FAILED) {
+		return -1;
+	}
+	if (atomic_load_explicit(&p->ch->magic, memory_order_acquire) != RAD_MAGIC
+			|| p->ch->version != RAD_VERSION || p->ch->slots != RAD_SLOTS) {
+		munmap(p->ch, sizeof(struct rad_channel));
+		return -1;
+	}
+	return 0;
+}
+/* end of function: rad_open */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rad_push
+ * Inputs     : struct rad_producer *p - producer from rad_open
+ *		const struct rad_meta *m - the next sequence, in start order
+ * Returns    : 0 on success
+ *             -1 if the channel is full (counted) or has been closed, in
+ *		  which case rad_close and rad_open again once it is back
+ * Description: Never blocks.  Push as soon as the start time is known; the
+ *		entry waits for its sequence, or the sequence for its entry, for up
+ *		to RAD_WINDOW_NS.
+ */
+int rad_push(struct rad_producer *p, const struct rad_meta *m) {
+	struct rad_channel *ch = p->ch;
+	uint64_t head = atomic_load_explicit(&ch->head, memory_order_relaxed);
+
+	if (atomic_load_explicit(&ch->magic, memory_order_relaxed) != RAD_MAGIC) {
+		return -1;
+	}
+	if (head - atomic_load_explicit(&ch->tail, memory_order_acquire) >= RAD_SLOTS) {
+		atomic_fetch_add_explicit(&ch->refused, 1, memory_order_relaxed);
+		return -1;
+	}
+	ch->slot[head & (RAD_SLOTS - 1)] = *m;
+	atomic_store_explicit(&ch->head, head + 1, memory_order_release);
+	return 0;
+}
+/* end of function: rad_push */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rad_close
+ * Inputs     : struct rad_producer *p - producer from rad_open
+ * Returns    : Nothing
+ */
+void rad_close(struct rad_producer *p) {
+	munmap(p->ch, sizeof(struct rad_channel));
+}
+/* end of function: rad_close */
+/*******************************************************************************/
@@ -0,0 +1,115 @@
+/* File : 	sym560_radar.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Join of radar control's sequence metadata with the timestamps.
+ *		Given -C, the automatic mode creates a single producer / single
+ *		consumer channel in POSIX shared memory, into which the radar
+ *		control process pushes the intended start time, beam, frequency
+ *		and ID of each pulse sequence it transmits (rad_open / rad_push).  The writer
+ *		thread runs the pulse sequence detector (sym560_seq.c) over the
+ *		events it takes from the capture ring and pairs each sequence found
+ *		with the entry whose start time is within the tolerance of it,
+ *		writing a SEQUENCE line into the output after its last pulse.
+ *		Either side waits at most RAD_WINDOW_NS for the other, in fixed
+ *		storage, so a radar that stops reporting or pulses that never
+ *		arrive cost nothing but a count.
+ */
+
+#ifndef SYM560_RADAR_H
+#define SYM560_RADAR_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "sym560_capture.h"
+#include "sym560_seq.h"
+
+/* shared memory object radar control expects, created by the automatic mode's -C */
+#define RAD_DEFAULT_NAME	"/sym560_radar"
+
+#define RAD_MAGIC		0x31524441524d5953ULL	/* "SYMRADR1" */
+#define RAD_VERSION		1
+
+/* entries the channel holds (a power of 2), 40 s of sequences at 100 per second */
+#define RAD_SLOTS		4096
+
+/* a sequence and an entry are joined if their start times are this close */
+#define RAD_DEFAULT_TOL_NS	1000000LL
+
+/* how long a sequence waits for its entry, or an entry for its sequence */
+#define RAD_WINDOW_NS		1000000000LL
+
+/* sequences held waiting for their entries (a power of 2) */
+#define RAD_HOLD		64
+
+/* longest SEQUENCE line written by rad_feed and rad_idle */
+#define RAD_TEXT_MAX		192
+
+/* what radar control says about one sequence */
+struct rad_meta {
+	int64_t start_ns;		/* intended UTC time of its first pulse */
+	uint64_t seq_id;		/* radar control's own sequence number */
+	uint32_t beam;
+	uint32_t freq_khz;
+};
+
+/* The shared memory.  Entries must be pushed in order of start_ns. */
+struct rad_channel {
+	_Atomic uint64_t magic;		/* cleared when the automatic mode stops */
+	uint32_t version;
+	uint32_t slots;			/* RAD_SLOTS */
+	pid_t pid;			/* consuming process */
+	char pad0[RING_CACHELINE - 24];
+
+	/* producer side */
+	_Atomic uint64_t head;		/* next slot to be filled */
+	_Atomic uint64_t refused;	/* entries not pushed because the channel was full */
+	char pad1[RING_CACHELINE - 16];
+
+	/* consumer side */
+	_Atomic uint64_t tail;		/* next entry to be taken */
+	char pad2[RING_CACHELINE - 8];
+
+	struct rad_meta slot[RAD_SLOTS];
+};
+
+/* a sequence found by the detector, waiting for its entry */
+struct rad_held {
+	int64_t start_ns;
+	uint32_t present;
+	int found;
+	int npulse;
+};
+
+/* The automatic mode's side.  Used only by the writer thread once started. */
+struct joiner {
+	struct rad_channel *ch;		/* the shared memory */
+	char name[64];
+	int64_t tol;
+	struct seq_set tab;
+	struct seq_det det;
+	struct rad_held held[RAD_HOLD];
+	uint64_t held_head;		/* next held slot to fill */
+	uint64_t held_tail;		/* oldest sequence held */
+	uint64_t joined;		/* sequences written with their entries */
+	uint64_t unjoined;		/* sequences no entry turned up for */
+	uint64_t orphans;		/* entries no sequence turned up for */
+	uint64_t refused;		/* the channel's count, once stopped */
+};
+
+/* Radar control's side. */
+struct rad_producer {
+	struct rad_channel *ch;
+};
+
+/* function declarations */
+int rad_start(struct joiner *j, struct capture *cap, const char *name, int64_t tol);
+int rad_feed(struct joiner *j, int64_t ns, char *txtbuff);
+int rad_idle(struct joiner *j, int64_t now, char *txtbuff);
+void rad_stop(struct joiner *j, struct capture *cap);
+void rad_print(const struct joiner *j);
+int rad_open(struct rad_producer *p, const char *name);
+int rad_push(struct rad_producer *p, const struct rad_meta *m);
+void rad_close(struct rad_producer *p);
+
+#endif /* SYM560_RADAR_H */
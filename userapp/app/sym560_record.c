@@ -0,0 +1,695 @@
+/* File : 	sym560_record.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Conversion of the 12 byte BCD event time (see the Event Time Capture
+ *		register in Chapter 3 of the Symmetricom manual) to nanoseconds, back
+ *		again, and to the plain text format written by the automatic and manual
+ *		timestamping modes.
+ */
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "sym560_record.h"
+
+#define NS_PER_SEC	1000000000LL
+#define SEC_PER_DAY	86400LL
+
+/*******************************************************************************/
+/* Function   : days_before_year
+ * Inputs     : int year - year (1970 or later)
+ * Returns    : Number of days between Jan 1 1970 and Jan 1 of year
+ * Description: Gregorian calendar day count used to turn year + day of year into
+ *		a day number.
+ */
+static int64_t days_before_year(int year) {
+	int64_t y = year - 1;
+
+	return 365LL * (year - 1970) + (y / 4 - 1969 / 4) - (y / 100 - 1969 / 100)
+		+ (y / 400 - 1969 / 400);
+}
+/* end of function: days_before_year */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rec_ns
+ * Inputs     : int year, day (1-366), hour, min, sec - UTC date and time
+ *		int64_t subsec - fraction of a second in units of 100 ns
+ * Returns    : The time in UTC nanoseconds since 1970-01-01
+ */
+int64_t rec_ns(int year, int day, int hour, int min, int sec, int64_t subsec) {
+	return ((days_before_year(year) + day - 1) * SEC_PER_DAY + hour * 3600LL
+		+ min * 60 + sec) * NS_PER_SEC + subsec * 100;
+}
+/* end of function: rec_ns */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rec_decode
+ * Inputs     : const unsigned char *raw - 12 bytes of BCD event time
+ * Returns    : The event time in UTC nanoseconds since 1970-01-01
+ * Description: Unpacks the BCD digits in the same order as the plain text output
+ *		and converts them to a single integer.  The card resolves 100 ns so
+ *		the last two decimal digits are always zero.
+ */
+int64_t rec_decode(const unsigned char *raw) {
+	int year, day, hour, min, sec;
+	int64_t subsec;	/* units of 100 ns */
+
+	subsec = (raw[2] >> 4) * 1000000 + (raw[2] & 0x0F) * 100000
+		+ (raw[1] >> 4) * 10000 + (raw[1] & 0x0F) * 1000
+		+ (raw[0] >> 4) * 100 + (raw[0] & 0x0F) * 10 + (raw[10] >> 4);
+	sec = (raw[3] >> 4) * 10 + (raw[3] & 0x0F);
+	min = (raw[4] >> 4) * 10 + (raw[4] & 0x0F);
+	hour = (raw[5] >> 4) * 10 + (raw[5] & 0x0F);
+	day = (raw[7] & 0x0F) * 100 + (raw[6] >> 4) * 10 + (raw[6] & 0x0F);
+	year = (raw[9] >> 4) * 1000 + (raw[9] & 0x0F) * 100 + (raw[8] >> 4) * 10
+		+ (raw[8] & 0x0F);
+
+	return rec_ns(year, day, hour, min, sec, subsec);
+}
+/* end of function: rec_decode */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rec_encode
+ * Inputs     : int64_t ns - UTC nanoseconds since 1970-01-01
+ *		unsigned char *raw - 12 byte buffer that will hold the BCD time
+ * Returns    : Nothing
+ * Description: Inverse of rec_decode.  Used by the event simulator to produce
+ *		records that look exactly like the ones read from the card.
+ */
+void rec_encode(int64_t ns, unsigned char *raw) {
+	int64_t days, secs, subsec;
+	int year, day, hour, min, sec, cnt;
+
+	days = ns / (NS_PER_SEC * SEC_PER_DAY);
+	secs = ns / NS_PER_SEC - days * SEC_PER_DAY;
+	subsec = (ns % NS_PER_SEC) / 100;
+
+	year = 1970 + days / 366;
+	while (days_before_year(year + 1) <= days) {
+		year++;
+	}
+	day = days - days_before_year(year) + 1;
+	hour = secs / 3600;
+	min = (secs / 60) % 60;
+	sec = secs % 60;
+
+	for (cnt = 0; cnt < 12; cnt++) {
+		raw[cnt] = 0;
+	}
+	raw[10] = (subsec % 10) << 4;
+	subsec /= 10;
+	raw[0] = (subsec % 10) | ((subsec / 10) % 10) << 4;
+	subsec /= 100;
+	raw[1] = (subsec % 10) | ((subsec / 10) % 10) << 4;
+	subsec /= 100;
+	raw[2] = (subsec % 10) | ((subsec / 10) % 10) << 4;
+	raw[3] = (sec % 10) | (sec / 10) << 4;
+	raw[4] = (min % 10) | (min / 10) << 4;
+	raw[5] = (hour % 10) | (hour / 10) << 4;
+	raw[6] = (day % 10) | ((day / 10) % 10) << 4;
+	raw[7] = day / 100;
+	raw[8] = (year % 10) | ((year / 10) % 10) << 4;
+	raw[9] = ((year / 100) % 10) | (year / 1000) << 4;
+}
+/* end of function: rec_encode */
+/*******************************************************************************/
+
+
+/* A BCD byte as text, high digit first, so that a pair of digits is a single
+ * 2 byte copy.  Bytes with a nibble over 9 never come from the card in normal
+ * operation; rec_bcd_bad flags them and rec_format_text hands those records to
+ * the sprintf version, which prints such a nibble as two digits. */
+#define BCD_TXT(h, l)	{ '0' + (h), '0' + (l) }
+#define BCD_ROW(h)	BCD_TXT(h, 0), BCD_TXT(h, 1), BCD_TXT(h, 2), BCD_TXT(h, 3), \
+			BCD_TXT(h, 4), BCD_TXT(h, 5), BCD_TXT(h, 6), BCD_TXT(h, 7), \
+			BCD_TXT(h, 8), BCD_TXT(h, 9), BCD_TXT(h, 10), BCD_TXT(h, 11), \
+			BCD_TXT(h, 12), BCD_TXT(h, 13), BCD_TXT(h, 14), BCD_TXT(h, 15)
+static const char rec_bcd_text[256][2] = {
+	BCD_ROW(0), BCD_ROW(1), BCD_ROW(2), BCD_ROW(3), BCD_ROW(4), BCD_ROW(5),
+	BCD_ROW(6), BCD_ROW(7), BCD_ROW(8), BCD_ROW(9), BCD_ROW(10), BCD_ROW(11),
+	BCD_ROW(12), BCD_ROW(13), BCD_ROW(14), BCD_ROW(15)
+};
+
+#define BCD_BAD(h, l)	((h) > 9 || (l) > 9)
+#define BCD_BAD_ROW(h)	BCD_BAD(h, 0), BCD_BAD(h, 1), BCD_BAD(h, 2), BCD_BAD(h, 3), \
+			BCD_BAD(h, 4), BCD_BAD(h, 5), BCD_BAD(h, 6), BCD_BAD(h, 7), \
+			BCD_BAD(h, 8), BCD_BAD(h, 9), BCD_BAD(h, 10), BCD_BAD(h, 11), \
+			BCD_BAD(h, 12), BCD_BAD(h, 13), BCD_BAD(h, 14), BCD_BAD(h, 15)
+static const unsigned char rec_bcd_bad[256] = {
+	BCD_BAD_ROW(0), BCD_BAD_ROW(1), BCD_BAD_ROW(2), BCD_BAD_ROW(3),
+	BCD_BAD_ROW(4), BCD_BAD_ROW(5), BCD_BAD_ROW(6), BCD_BAD_ROW(7),
+	BCD_BAD_ROW(8), BCD_BAD_ROW(9), BCD_BAD_ROW(10), BCD_BAD_ROW(11),
+	BCD_BAD_ROW(12), BCD_BAD_ROW(13), BCD_BAD_ROW(14), BCD_BAD_ROW(15)
+};
+
+/* the plain text record with every digit as '0', and where the digits go */
+#define REC_TEXT_TEMPLATE \
+	"       YEAR = 0000\n" \
+	"        DAY = 000\n" \
+	"       TIME = 00:00 UTC\n" \
+	"        SEC = 00.0000000\n\n"
+static const char rec_text_template[] = REC_TEXT_TEMPLATE;
+#define REC_TEXT_LEN	(sizeof(rec_text_template) - 1)
+#define TXT_YEAR	14
+#define TXT_DAY		33
+#define TXT_HOUR	51
+#define TXT_MIN		54
+#define TXT_SEC		75
+#define TXT_FRAC	78
+
+/*******************************************************************************/
+/* Function   : rec_format_text_sprintf
+ * Inputs     : const unsigned char *raw - 12 bytes of BCD event time
+ *		char *txtbuff - buffer of at least REC_TEXT_MAX bytes
+ * Returns    : Number of characters written to txtbuff
+ * Description: The original formatter, one digit per nibble through sprintf.
+ *		Kept as the reference for rec_format_text and for the records it
+ *		cannot handle.
+ */
+int rec_format_text_sprintf(const unsigned char *raw, char *txtbuff) {
+	unsigned char unit_us, tens_us, hund_us, unit_ms, tens_ms, hund_ms, unit_s, tens_s;
+	unsigned char unit_min, tens_min, unit_hr, tens_hr, unit_day, tens_day, hund_day;
+	unsigned char unit_yr, tens_yr, hund_yr, thou_yr, hund_nano;
+
+	unit_us = raw[0] & 0x0F;
+	tens_us = raw[0] >> 4;
+	hund_us = raw[1] & 0x0F;
+	unit_ms = raw[1] >> 4;
+	tens_ms = raw[2] & 0x0F;
+	hund_ms = raw[2] >> 4;
+	unit_s = raw[3] & 0x0F;
+	tens_s = raw[3] >> 4;
+	unit_min = raw[4] & 0x0F;
+	tens_min = raw[4] >> 4;
+	unit_hr = raw[5] & 0x0F;
+	tens_hr = raw[5] >> 4;
+	unit_day = raw[6] & 0x0F;
+	tens_day = raw[6] >> 4;
+	hund_day = raw[7] & 0x0F;
+	unit_yr = raw[8] & 0x0F;
+	tens_yr = raw[8] >> 4;
+	hund_yr = raw[9] & 0x0F;
+	thou_yr = raw[9] >> 4;
+	hund_nano = raw[10] >> 4;
+
+	return sprintf(txtbuff, "       YEAR = %d%d%d%d\n        DAY = %d%d%d\n       TIME = %d%d:%d%d UTC\n        SEC = %d%d.%d%d%d%d%d%d%d\n\n", thou_yr, hund_yr, tens_yr, unit_yr, hund_day, tens_day, unit_day, tens_hr, unit_hr, tens_min, unit_min, tens_s, unit_s, hund_ms, tens_ms, unit_ms, hund_us, tens_us, unit_us, hund_nano);
+}
+/* end of function: rec_format_text_sprintf */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rec_format_text
+ * Inputs     : const unsigned char *raw - 12 bytes of BCD event time
+ *		char *txtbuff - buffer of at least REC_TEXT_MAX bytes
+ * Returns    : Number of characters written to txtbuff
+ * Description: Prints the event time in the readable plain text format used by
+ *		the timestampdata files (and expected by findpulse.pl).  Copies a
+ *		fixed template and drops the digits into it two at a time from
+ *		rec_bcd_text; the output is byte for byte that of
+ *		rec_format_text_sprintf.
+ */
+int rec_format_text(const unsigned char *raw, char *txtbuff) {
+	if (rec_bcd_bad[raw[0]] | rec_bcd_bad[raw[1]] | rec_bcd_bad[raw[2]]
+			| rec_bcd_bad[raw[3]] | rec_bcd_bad[raw[4]] | rec_bcd_bad[raw[5]]
+			| rec_bcd_bad[raw[6]] | rec_bcd_bad[raw[8]] | rec_bcd_bad[raw[9]]
+			| ((raw[7] & 0x0F) > 9) | ((raw[10] >> 4) > 9)) {
+		return rec_format_text_sprintf(raw, txtbuff);
+	}
+
+	memcpy(txtbuff, rec_text_template, REC_TEXT_LEN + 1);
+	memcpy(txtbuff + TXT_YEAR, rec_bcd_text[raw[9]], 2);
+	memcpy(txtbuff + TXT_YEAR + 2, rec_bcd_text[raw[8]], 2);
+	txtbuff[TXT_DAY] = '0' + (raw[7] & 0x0F);
+	memcpy(txtbuff + TXT_DAY + 1, rec_bcd_text[raw[6]], 2);
+	memcpy(txtbuff + TXT_HOUR, rec_bcd_text[raw[5]], 2);
+	memcpy(txtbuff + TXT_MIN, rec_bcd_text[raw[4]], 2);
+	memcpy(txtbuff + TXT_SEC, rec_bcd_text[raw[3]], 2);
+	memcpy(txtbuff + TXT_FRAC, rec_bcd_text[raw[2]], 2);
+	memcpy(txtbuff + TXT_FRAC + 2, rec_bcd_text[raw[1]], 2);
+	memcpy(txtbuff + TXT_FRAC + 4, rec_bcd_text[raw[0]], 2);
+	txtbuff[TXT_FRAC + 6] = '0' + (raw[10] >> 4);
+	return REC_TEXT_LEN;
+}
+/* end of function: rec_format_text */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rec_format_lock
+ * Inputs     : int lock - REC_LOCK_* bits
+ *		char *txtbuff - buffer of at least REC_TEXT_MAX bytes
+ * Returns    : Number of characters written to txtbuff
+ * Description: Line written ahead of the first timestamp taken in a different
+ *		lock state from the one before it.  It has no YEAR in it so
+ *		findpulse.pl and rec_parse_text skip over it.
+ */
+int rec_format_lock(int lock, char *txtbuff) {
+	if (lock == REC_LOCK_ALL) {
+		return sprintf(txtbuff, "       LOCK = LOCKED\n\n");
+	}
+	return sprintf(txtbuff, "       LOCK = NOT LOCKED (input %s, phase %s, GPS %s)\n\n",
+			(lock & REC_LOCK_INPUT) ? "valid" : "invalid",
+			(lock & REC_LOCK_PHASE) ? "locked" : "not locked",
+			(lock & REC_LOCK_GPS) ? "locked" : "not locked");
+}
+/* end of function: rec_format_lock */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rec_format_marker
+ * Inputs     : int64_t ns - UTC time of the change being recorded
+ *		const char *text - description, at most REC_MARKER_MAX characters
+ *		char *txtbuff - buffer of at least REC_TEXT_MAX bytes
+ * Returns    : Number of characters written to txtbuff
+ * Description: In-band marker line for a change made while capturing (see
+ *		sym560_control.c).  Like the LOCK line it has no YEAR in it.
+ */
+int rec_format_marker(int64_t ns, const char *text, char *txtbuff) {
+	time_t secs = ns / NS_PER_SEC;
+	struct tm tm;
+
+	gmtime_r(&secs, &tm);
+	return sprintf(txtbuff, "     MARKER = %04d-%03d %02d:%02d:%02d.%07lld UTC %.*s\n\n",
+			tm.tm_year + 1900, tm.tm_yday + 1, tm.tm_hour, tm.tm_min, tm.tm_sec,
+			(long long)(ns % NS_PER_SEC) / 100, REC_MARKER_MAX, text);
+}
+/* end of function: rec_format_marker */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rec_parse_text
+ * Inputs     : FILE *fp - plain text timestamp file
+ *		int64_t *ns - receives the next timestamp
+ * Returns    : 0 on success
+ *             -1 at end of file
+ * Description: Reads lines until one containing YEAR and then takes the DAY,
+ *		TIME and SEC lines that follow, the same way findpulse.pl's
+ *		get_timestamp does.  Leading whitespace does not matter.
+ */
+int rec_parse_text(FILE *fp, int64_t *ns) {
+	char line[256];
+	int year, day, hour, min, sec;
+	char frac[16];
+	int64_t subsec;
+	int cnt, len;
+
+	do {
+		if (fgets(line, sizeof(line), fp) == NULL) {
+			return -1;
+		}
+	} while (strstr(line, "YEAR") == NULL);
+
+	if (sscanf(line, " YEAR = %d", &year) != 1) {
+		return -1;
+	}
+	if (fgets(line, sizeof(line), fp) == NULL || sscanf(line, " DAY = %d", &day) != 1) {
+		return -1;
+	}
+	if (fgets(line, sizeof(line), fp) == NULL
+			|| sscanf(line, " TIME = %d:%d", &hour, &min) != 2) {
+		return -1;
+	}
+	if (fgets(line, sizeof(line), fp) == NULL
+			|| sscanf(line, " SEC = %d.%15[0-9]", &sec, frac) != 2) {
+		return -1;
+	}
+
+	/* the fraction is printed to 100 ns (7 digits) */
+	len = strlen(frac);
+	subsec = 0;
+	for (cnt = 0; cnt < 7; cnt++) {
+		subsec = subsec * 10 + (cnt < len ? frac[cnt] - '0' : 0);
+	}
+	*ns = rec_ns(year, day, hour, min, sec, subsec);
+	return 0;
+}
+/* end of function: rec_parse_text */
+/*******************************************************************************/
+
+
+/* The four lines of a record as rec_format_text writes them, without the blank
+ * line after, padded to whole 16 byte blocks for the vector compare.  Bits set
+ * in rec_match_skip are the bytes of each block past the record. */
+#define REC_MATCH_LEN		(REC_TEXT_LEN - 1)
+#define REC_MATCH_BLOCKS	6
+static const char rec_match_template[REC_MATCH_BLOCKS * 16] __attribute__((aligned(16))) = REC_TEXT_TEMPLATE;
+#ifdef __SSE2__
+static const int rec_match_skip[REC_MATCH_BLOCKS] = {0, 0, 0, 0, 0,
+	0xFFFF & (0xFFFF << (REC_MATCH_LEN - 16 * (REC_MATCH_BLOCKS - 1)))};
+#endif
+
+/* longest line rec_parse_text reads at once, as its fgets buffer */
+#define REC_LINE_MAX	256
+
+/* whitespace as isspace has it in the C locale */
+#define REC_SPACE(c)	((c) == ' ' || ((c) >= '\t' && (c) <= '\r'))
+
+/*******************************************************************************/
+/* Function   : rec_digits
+ * Inputs     : const char *p - n decimal digits
+ *		int n - how many
+ * Returns    : Their value
+ */
+static inline int rec_digits(const char *p, int n) {
+	int v = 0;
+
+	while (n-- > 0) {
+		v = v * 10 + (*p++ - '0');
+	}
+	return v;
+}
+/* end of function: rec_digits */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rec_match_bytes
+ * Inputs     : const char *p - REC_MATCH_LEN bytes
+ * Returns    : 0 if they are a record laid out as rec_format_text writes it
+ *             -1 otherwise
+ */
+static int rec_match_bytes(const char *p) {
+	int cnt;
+
+	for (cnt = 0; cnt < (int)REC_MATCH_LEN; cnt++) {
+		if (rec_match_template[cnt] == '0' ? (unsigned char)(p[cnt] - '0') > 9
+				: p[cnt] != rec_match_template[cnt]) {
+			return -1;
+		}
+	}
+	return 0;
+}
+/* end of function: rec_match_bytes */
+/*******************************************************************************/
+
+
+#ifdef __SSE2__
+/*******************************************************************************/
+/* Function   : rec_match_sse2
+ * Inputs     : const char *p - REC_MATCH_BLOCKS * 16 readable bytes
+ * Returns    : 0 if they start with a record laid out as rec_format_text
+ *		writes it
+ *             -1 otherwise
+ * Description: rec_match_bytes 16 bytes at a time.  Where the template has a
+ *		digit the byte minus '0' must be at most 9 unsigned, elsewhere it
+ *		must equal the template.
+ */
+static int rec_match_sse2(const char *p) {
+	const __m128i zero = _mm_set1_epi8('0'), nine = _mm_set1_epi8(9);
+	__m128i v, t, d, want, ok;
+	int cnt;
+
+	for (cnt = 0; cnt < REC_MATCH_BLOCKS; cnt++) {
+		v = _mm_loadu_si128((const __m128i *)(p + 16 * cnt));
+		t = _mm_load_si128((const __m128i *)(rec_match_template + 16 * cnt));
+		d = _mm_sub_epi8(v, zero);
+		want = _mm_cmpeq_epi8(t, zero);
+		ok = _mm_or_si128(_mm_and_si128(want, _mm_cmpeq_epi8(_mm_min_epu8(d, nine), d)),
+			_mm_andnot_si128(want, _mm_cmpeq_epi8(v, t)));
+		if ((_mm_movemask_epi8(ok) | rec_match_skip[cnt]) != 0xFFFF) {
+			return -1;
+		}
+	}
+	return 0;
+}
+/* end of function: rec_match_sse2 */
+/*******************************************************************************/
+#endif
+
+
+/*******************************************************************************/
+/* Function   : rec_match
+ * Inputs     : const char *p - start of a line
+ *		long avail - bytes readable from p
+ *		int64_t *ns - receives the time
+ * Returns    : 0 if the record at p is exactly as rec_format_text writes it
+ *             -1 otherwise, without reading past avail
+ * Description: The whole record is checked before any digit is converted, with
+ *		SSE2 where there is room for its full blocks.
+ */
+static int rec_match(const char *p, long avail, int64_t *ns) {
+	if (avail < (long)REC_MATCH_LEN) {
+		return -1;
+	}
+#ifdef __SSE2__
+	if (avail >= REC_MATCH_BLOCKS * 16 ? rec_match_sse2(p) != 0 : rec_match_bytes(p) != 0) {
+		return -1;
+	}
+#else
+	if (rec_match_bytes(p) != 0) {
+		return -1;
+	}
+#endif
+	*ns = rec_ns(rec_digits(p + TXT_YEAR, 4), rec_digits(p + TXT_DAY, 3), rec_digits(p + TXT_HOUR, 2),
+		rec_digits(p + TXT_MIN, 2), rec_digits(p + TXT_SEC, 2), rec_digits(p + TXT_FRAC, 7));
+	return 0;
+}
+/* end of function: rec_match */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rec_line
+ * Inputs     : struct rec_map *m - input
+ *		const char **line - receives the start of the next line
+ *		const char **end - receives its end
+ * Returns    : 0 on success
+ *             -1 at the end of the input
+ * Description: The next line as rec_parse_text's fgets would read it, at most
+ *		REC_LINE_MAX - 1 bytes and up to the first NUL in it.
+ */
+static int rec_line(struct rec_map *m, const char **line, const char **end) {
+	long max = m->size - m->pos;
+	const char *nl;
+
+	if (max <= 0) {
+		return -1;
+	}
+	if (max > REC_LINE_MAX - 1) {
+		max = REC_LINE_MAX - 1;
+	}
+	*line = m->buf + m->pos;
+	nl = memchr(*line, '\n', max);
+	m->pos += nl != NULL ? nl - *line + 1 : max;
+	*end = *line + strnlen(*line, m->buf + m->pos - *line);
+	return 0;
+}
+/* end of function: rec_line */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rec_int
+ * Inputs     : const char *p, *end - part of a line
+ *		int *v - receives the number
+ * Returns    : Where the number ends, NULL if there is none, read as
+ *		sscanf's %d does: any whitespace, an optional sign and digits
+ */
+static const char *rec_int(const char *p, const char *end, int *v) {
+	int neg = 0;
+
+	while (p < end && REC_SPACE(*p)) {
+		p++;
+	}
+	if (p < end && (*p == '-' || *p == '+')) {
+		neg = *p++ == '-';
+	}
+	if (p == end || *p < '0' || *p > '9') {
+		return NULL;
+	}
+	for (*v = 0; p < end && *p >= '0' && *p <= '9'; p++) {
+		*v = *v * 10 + (*p - '0');
+	}
+	if (neg) {
+		*v = -*v;
+	}
+	return p;
+}
+/* end of function: rec_int */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rec_field
+ * Inputs     : const char *p, *end - a line
+ *		const char *name - field name
+ *		int *v - receives the number after it
+ * Returns    : Where the number ends, NULL if the line is not " name = %d"
+ *		as sscanf reads it
+ */
+static const char *rec_field(const char *p, const char *end, const char *name, int *v) {
+	int len = strlen(name);
+
+	while (p < end && REC_SPACE(*p)) {
+		p++;
+	}
+	if (end - p < len || memcmp(p, name, len) != 0) {
+		return NULL;
+	}
+	for (p += len; p < end && REC_SPACE(*p); p++);
+	if (p == end || *p != '=') {
+		return NULL;
+	}
+	return rec_int(p + 1, end, v);
+}
+/* end of function: rec_field */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rec_map_open
+ * Inputs     : struct rec_map *m - receives the file
+ *		const char *path - file to read
+ * Returns    : 0 on success
+ *             -1 if it cannot be opened or mapped, with errno set
+ * Description: Maps the whole file for reading with rec_map_text or
+ *		rec_map_raw, from the start.  Close it with rec_map_close.
+ */
+int rec_map_open(struct rec_map *m, const char *path) {
+	struct stat st;
+	void *buf;
+	int fd;
+
+	memset(m, 0, sizeof(*m));
+	fd = open(path, O_RDONLY);
+	if (fd == -1) {
+		return -1;
+	}
+	if (fstat(fd, &st) == -1) {
+		close(fd);
+		return -1;
+	}
+	if (st.st_size > 0) {
+		buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (buf == MAP_FAILED) {
+			close(fd);
+			return -1;
+		}
+		madvise(buf, st.st_size, MADV_SEQUENTIAL);
+		m->buf = buf;
+		m->size = st.st_size;
+		m->mapped = st.st_size;
+	}
+	close(fd);
+	return 0;
+}
+/* end of function: rec_map_open */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rec_map_close
+ * Inputs     : struct rec_map *m - file opened by rec_map_open
+ * Returns    : Nothing
+ */
+void rec_map_close(struct rec_map *m) {
+	if (m->mapped) {
+		munmap((void *)m->buf, m->mapped);
+	}
+	memset(m, 0, sizeof(*m));
+}
+/* end of function: rec_map_close */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rec_map_text
+ * Inputs     : struct rec_map *m - plain text timestamps
+ *		int64_t *ns - receives the next timestamp
+ * Returns    : 0 on success
+ *             -1 at the end of the input or a record that cannot be read
+ * Description: rec_parse_text on memory.  It finds the same timestamps and
+ *		stops in the same place, leaving m->pos after the last line it
+ *		read.  A record laid out exactly as rec_format_text writes it is
+ *		matched and converted in one go (rec_match).  Anything else, such
+ *		as other indentation, CRLF line ends or LOCK and MARKER lines, is
+ *		read a line at a time with the same rules as the sscanf formats
+ *		of rec_parse_text, without copying.
+ */
+int rec_map_text(struct rec_map *m, int64_t *ns) {
+	const char *line, *end, *p;
+	int year, day, hour, min, sec, cnt, len;
+	int64_t subsec;
+
+	/* blank lines have no YEAR in them */
+	while (m->pos < m->size && m->buf[m->pos] == '\n') {
+		m->pos++;
+	}
+	if (rec_match(m->buf + m->pos, m->size - m->pos, ns) == 0) {
+		m->pos += REC_MATCH_LEN;
+		return 0;
+	}
+
+	do {
+		if (rec_line(m, &line, &end) != 0) {
+			return -1;
+		}
+	} while (memmem(line, end - line, "YEAR", 4) == NULL);
+	if (rec_field(line, end, "YEAR", &year) == NULL) {
+		return -1;
+	}
+	if (rec_line(m, &line, &end) != 0 || rec_field(line, end, "DAY", &day) == NULL) {
+		return -1;
+	}
+	if (rec_line(m, &line, &end) != 0 || (p = rec_field(line, end, "TIME", &hour)) == NULL
+			|| p == end || *p != ':') {
+		return -1;
+	}
+	if (rec_int(p + 1, end, &min) == NULL) {
+		return -1;
+	}
+	if (rec_line(m, &line, &end) != 0 || (p = rec_field(line, end, "SEC", &sec)) == NULL
+			|| p == end || *p != '.') {
+		return -1;
+	}
+
+	/* the fraction is printed to 100 ns (7 digits), %15[0-9] reads up to 15 */
+	for (len = 0, p++; len < 15 && p + len < end && p[len] >= '0' && p[len] <= '9'; len++);
+	if (len == 0) {
+		return -1;
+	}
+	subsec = 0;
+	for (cnt = 0; cnt < 7; cnt++) {
+		subsec = subsec * 10 + (cnt < len ? p[cnt] - '0' : 0);
+	}
+	*ns = rec_ns(year, day, hour, min, sec, subsec);
+	return 0;
+}
+/* end of function: rec_map_text */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : rec_map_raw
+ * Inputs     : struct rec_map *m - 12 byte BCD event times
+ *		int64_t *ns - receives the next one
+ * Returns    : 0 on success
+ *             -1 at the end of the input
+ */
+int rec_map_raw(struct rec_map *m, int64_t *ns) {
+	if (m->size - m->pos < REC_RAW_LEN) {
+		return -1;
+	}
+	*ns = rec_decode((const unsigned char *)m->buf + m->pos);
+	m->pos += REC_RAW_LEN;
+	return 0;
+}
+/* end of function: rec_map_raw */
+/*******************************************************************************/
@@ -0,0 +1,73 @@
+/* File : 	sym560_record.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Fixed size record passed between the capture, writer and output
+ *		stages, along with the helpers used to convert the BCD event time
+ *		returned by the driver to and from nanoseconds and to the plain text
+ *		timestamp format, and to read that format back.
+ */
+
+#ifndef SYM560_RECORD_H
+#define SYM560_RECORD_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* Record types */
+#define REC_EVENT	0	/* external event timestamp */
+
+/* GPS lock state kept with each record: the lock bits of the software time lock
+ * register (REG_SOFTTIME_LOCK) in effect when the event was captured */
+#define REC_LOCK_GPS		0x10	/* GPS locked */
+#define REC_LOCK_INPUT		0x20	/* input signal valid */
+#define REC_LOCK_PHASE		0x40	/* phase locked to input ref */
+#define REC_LOCK_ALL		0x70
+#define REC_LOCK_UNKNOWN	0x80	/* lock state not being monitored */
+
+/* Size of the event time capture data returned by the 0x8008f800 ioctl */
+#define REC_RAW_LEN	12
+
+/* Longest plain text timestamp produced by rec_format_text (with room to spare) */
+#define REC_TEXT_MAX	128
+
+/* Longest description accepted by rec_format_marker */
+#define REC_MARKER_MAX	64
+
+/* A timestamp file, or part of one, in memory.  rec_map_open maps a whole file,
+ * and any other buffer can be read by filling in buf, size and pos.
+ */
+struct rec_map {
+	const char *buf;
+	long size;			/* read up to here */
+	long pos;			/* where the next read starts */
+	long mapped;			/* bytes mapped by rec_map_open, 0 if none */
+};
+
+/* One captured record (32 bytes).  raw[] holds the event time capture register
+ * exactly as the driver returned it so that the plain text output is unchanged,
+ * ns holds the same time decoded to UTC nanoseconds since 1970-01-01.
+ */
+struct sym560_record {
+	int64_t ns;			/* decoded event time */
+	uint64_t seq;			/* capture sequence number, starting at 0 */
+	unsigned char raw[REC_RAW_LEN];	/* BCD event time from the driver */
+	unsigned char type;		/* REC_EVENT */
+	unsigned char lock;		/* REC_LOCK_* bits */
+	unsigned char spare[2];
+};
+
+/* function declarations */
+int64_t rec_ns(int year, int day, int hour, int min, int sec, int64_t subsec);
+int64_t rec_decode(const unsigned char *raw);
+void rec_encode(int64_t ns, unsigned char *raw);
+int rec_format_text(const unsigned char *raw, char *txtbuff);
+int rec_format_text_sprintf(const unsigned char *raw, char *txtbuff);
+int rec_format_lock(int lock, char *txtbuff);
+int rec_format_marker(int64_t ns, const char *text, char *txtbuff);
+int rec_parse_text(FILE *fp, int64_t *ns);
+int rec_map_open(struct rec_map *m, const char *path);
+void rec_map_close(struct rec_map *m);
+int rec_map_text(struct rec_map *m, int64_t *ns);
+int rec_map_raw(struct rec_map *m, int64_t *ns);
+
+#endif /* SYM560_RECORD_H */
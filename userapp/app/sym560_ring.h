@@ -0,0 +1,212 @@
+/* File : 	sym560_ring.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Lock-free single producer / single consumer ring of sym560_records.
+ *		The capture thread is the only producer and the writer thread the
+ *		only consumer.  Storage is allocated once by ring_init so nothing on
+ *		the capture path allocates memory or makes a system call.
+ */
+
+#ifndef SYM560_RING_H
+#define SYM560_RING_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "sym560_record.h"
+
+#define RING_CACHELINE	64
+
+struct ring {
+	/* producer side */
+	_Atomic uint64_t head;		/* next slot to be written */
+	uint64_t tail_cache;		/* producer's copy of tail */
+	char pad1[RING_CACHELINE - 16];
+
+	/* consumer side */
+	_Atomic uint64_t tail;		/* next slot to be read */
+	uint64_t head_cache;		/* consumer's copy of head */
+	char pad2[RING_CACHELINE - 16];
+
+	uint64_t mask;			/* capacity - 1, capacity is a power of 2 */
+	struct sym560_record *rec;	/* preallocated record storage */
+	int owned;			/* rec was allocated by ring_init */
+};
+
+/*******************************************************************************/
+/* Function   : ring_init_mem
+ * Inputs     : struct ring *r - ring to set up
+ *		unsigned int order - capacity will be 2^order records
+ *		void *mem - storage for 2^order records, cache line aligned
+ * Returns    : Nothing
+ * Description: Sets up a ring over storage provided (and later freed) by the
+ *		caller, for instance locked or hugepage memory.
+ */
+static inline void ring_init_mem(struct ring *r, unsigned int order, void *mem) {
+	r->rec = mem;
+	r->owned = 0;
+	r->mask = (1ULL << order) - 1;
+	atomic_init(&r->head, 0);
+	atomic_init(&r->tail, 0);
+	r->tail_cache = 0;
+	r->head_cache = 0;
+}
+/* end of function: ring_init_mem */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : ring_init
+ * Inputs     : struct ring *r - ring to set up
+ *		unsigned int order - capacity will be 2^order records
+ * Returns    : 0 on success
+ *             -1 on failure
+ * Description: Allocates the record storage and resets both indices.
+ */
+static inline int ring_init(struct ring *r, unsigned int order) {
+	void *mem;
+
+	if (posix_memalign(&mem, RING_CACHELINE, sizeof(struct sym560_record) << order) != 0) {
+		return -1;
+	}
+	ring_init_mem(r, order, mem);
+	r->owned = 1;
+	return 0;
+}
+/* end of function: ring_init */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : ring_free
+ * Inputs     : struct ring *r - ring set up by ring_init or ring_init_mem
+ * Returns    : Nothing
+ */
+static inline void ring_free(struct ring *r) {
+	if (r->owned) {
+		free(r->rec);
+	}
+	r->rec = NULL;
+}
+/* end of function: ring_free */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : ring_reserve
+ * Inputs     : struct ring *r - ring (producer side)
+ * Returns    : Pointer to the next free slot, NULL if the ring is full
+ * Description: The slot is not visible to the consumer until ring_commit.  The
+ *		consumer's tail is only re-read when the cached copy says full.
+ */
+static inline struct sym560_record *ring_reserve(struct ring *r) {
+	uint64_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+
+	if (head - r->tail_cache > r->mask) {
+		r->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+		if (head - r->tail_cache > r->mask) {
+			return NULL;
+		}
+	}
+	return &r->rec[head & r->mask];
+}
+/* end of function: ring_reserve */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : ring_commit
+ * Inputs     : struct ring *r - ring (producer side)
+ * Returns    : Nothing
+ * Description: Publishes the slot returned by the last ring_reserve.
+ */
+static inline void ring_commit(struct ring *r) {
+	uint64_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+
+	atomic_store_explicit(&r->head, head + 1, memory_order_release);
+}
+/* end of function: ring_commit */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : ring_peek_from
+ * Inputs     : struct ring *r - ring (consumer side)
+ *		uint64_t pos - first record wanted, between tail and head
+ *		struct sym560_record **first - set to that record
+ * Returns    : Number of records that can be read contiguously from *first
+ * Description: For a consumer that reads ahead of what it has released, i.e.
+ *		keeps records in the ring until it is done with them for good.
+ */
+static inline uint64_t ring_peek_from(struct ring *r, uint64_t pos, struct sym560_record **first) {
+	uint64_t n, contig;
+
+	if (r->head_cache == pos) {
+		r->head_cache = atomic_load_explicit(&r->head, memory_order_acquire);
+	}
+	n = r->head_cache - pos;
+	contig = r->mask + 1 - (pos & r->mask);
+	*first = &r->rec[pos & r->mask];
+	return n < contig ? n : contig;
+}
+/* end of function: ring_peek_from */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : ring_peek
+ * Inputs     : struct ring *r - ring (consumer side)
+ *		struct sym560_record **first - set to the oldest unread record
+ * Returns    : Number of records that can be read contiguously from *first
+ * Description: Lets the consumer work through a batch in place.  The records
+ *		stay owned by the consumer until ring_release.
+ */
+static inline uint64_t ring_peek(struct ring *r, struct sym560_record **first) {
+	return ring_peek_from(r, atomic_load_explicit(&r->tail, memory_order_relaxed), first);
+}
+/* end of function: ring_peek */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : ring_release
+ * Inputs     : struct ring *r - ring (consumer side)
+ *		uint64_t n - number of records consumed
+ * Returns    : Nothing
+ * Description: Hands n slots back to the producer.
+ */
+static inline void ring_release(struct ring *r, uint64_t n) {
+	uint64_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+	atomic_store_explicit(&r->tail, tail + n, memory_order_release);
+}
+/* end of function: ring_release */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : ring_release_to
+ * Inputs     : struct ring *r - ring (consumer side)
+ *		uint64_t pos - every record before this one has been consumed
+ * Returns    : Nothing
+ */
+static inline void ring_release_to(struct ring *r, uint64_t pos) {
+	atomic_store_explicit(&r->tail, pos, memory_order_release);
+}
+/* end of function: ring_release_to */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : ring_count
+ * Inputs     : struct ring *r - ring (either side)
+ * Returns    : Approximate number of records waiting to be read
+ */
+static inline uint64_t ring_count(struct ring *r) {
+	return atomic_load_explicit(&r->head, memory_order_relaxed)
+		- atomic_load_explicit(&r->tail, memory_order_relaxed);
+}
+/* end of function: ring_count */
+/*******************************************************************************/
+
+#endif /* SYM560_RING_H */
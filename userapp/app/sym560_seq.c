@@ -0,0 +1,542 @@
+/* File : 	sym560_seq.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Streaming pulse sequence detector (see sym560_seq.h).  Works
+ *		on nanosecond times, so it is not affected by minute, hour or day
+ *		boundaries, and does a fixed amount of work per event whatever the
+ *		length of the stream.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sym560_seq.h"
+
+/* offset of the pulse at lag multiples of mpinc_us into a sequence */
+#define SEQ_LAG(mpinc_us, lag)	((int64_t)(lag) * (mpinc_us) * 1000)
+
+/* Tables known by name.  katscan is findpulse.pl's @psep. */
+static const struct seq_table seq_known[] = {
+	{"katscan", 8, {SEQ_LAG(1500, 0), SEQ_LAG(1500, 14), SEQ_LAG(1500, 22), SEQ_LAG(1500, 24),
+			SEQ_LAG(1500, 27), SEQ_LAG(1500, 31), SEQ_LAG(1500, 42), SEQ_LAG(1500, 43)}},
+	{"7pulse", 7, {SEQ_LAG(2400, 0), SEQ_LAG(2400, 9), SEQ_LAG(2400, 12), SEQ_LAG(2400, 20),
+			SEQ_LAG(2400, 22), SEQ_LAG(2400, 26), SEQ_LAG(2400, 27)}},
+};
+
+#define SEQ_NKNOWN	(int)(sizeof(seq_known) / sizeof(seq_known[0]))
+
+
+/*******************************************************************************/
+/* Function   : seq_table_parse
+ * Inputs     : struct seq_table *t - table to fill in
+ *		const char *spec - a table name from seq_known, or the
+ *				   separations between pulses in ms, comma
+ *				   separated, e.g. SEQ_DEFAULT_SEPS, optionally
+ *				   after "name="
+ *		int len - length of spec
+ *		int num - which table of the set, for the default name
+ * Returns    : 0 on success
+ *             -1 if the list is empty, too long or not all positive
+ */
+static int seq_table_parse(struct seq_table *t, const char *spec, int len, int num) {
+	char buff[512], *p, *end;
+	double sep;
+	int cnt;
+
+	memset(t, 0, sizeof(*t));
+	if (len >= (int)sizeof(buff)) {
+		return -1;
+	}
+	memcpy(buff, spec, len);
+	buff[len] = '\0';
+	for (cnt = 0; cnt < SEQ_NKNOWN; cnt++) {
+		if (strcmp(buff, seq_known[cnt].name) == 0) {
+			*t = seq_known[cnt];
+			return 0;
+		}
+	}
+
+	p = strchr(buff, '=');
+	if (p != NULL) {
+		*p = '\0';
+		if (p == buff || p - buff >= SEQ_NAME_LEN) {
+			return -1;
+		}
+		strcpy(t->name, buff);
+		p++;
+	}
+	else {
+		sprintf(t->name, "table%d", num + 1);
+		p = buff;
+	}
+	t->npulse = 1;
+	while (*p != '\0') {
+		sep = strtod(p, &end);
+		if (end == p || sep <= 0 || t->npulse == SEQ_MAX_PULSES) {
+			return -1;
+		}
+		t->off[t->npulse] = t->off[t->npulse - 1] + llround(sep * 1e6);
+		t->npulse++;
+		p = *end == ',' ? end + 1 : end;
+		if (*end != ',' && *end != '\0') {
+			return -1;
+		}
+	}
+	return t->npulse > 1 ? 0 : -1;
+}
+/* end of function: seq_table_parse */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : seq_index
+ * Inputs     : struct seq_set *s - set with its tables and tolerance filled in
+ * Returns    : 0 on success
+ *             -1 if out of memory
+ * Description: Buckets are at least twice the tolerance wide and every pair
+ *		goes in each bucket its window of matching separations touches, so
+ *		the candidates for a separation are all in the one bucket it falls
+ *		in.  Pairs go in in table, i, j order, which is the order they are
+ *		tried in.
+ */
+static int seq_index(struct seq_set *s) {
+	const struct seq_table *t;
+	int64_t sep, lo, hi;
+	uint32_t *fill, total = 0;
+	int tab, i, j, b;
+
+	s->span = 0;
+	for (tab = 0; tab < s->ntab; tab++) {
+		t = &s->tab[tab];
+		if (t->off[t->npulse - 1] > s->span) {
+			s->span = t->off[t->npulse - 1];
+		}
+	}
+	s->shift = 0;
+	while ((1LL << s->shift) < 2 * s->tol) {
+		s->shift++;
+	}
+	while (((s->span + s->tol) >> s->shift) + 1 > SEQ_MAX_BUCKETS) {
+		s->shift++;
+	}
+	s->nbucket = ((s->span + s->tol) >> s->shift) + 1;
+	s->bucket = calloc(s->nbucket + 1, sizeof(*s->bucket));
+	fill = calloc(s->nbucket, sizeof(*fill));
+	if (s->bucket == NULL || fill == NULL) {
+		free(fill);
+		return -1;
+	}
+
+	/* count, then place */
+	for (tab = 0; tab < s->ntab; tab++) {
+		t = &s->tab[tab];
+		for (i = 0; i < t->npulse - 1; i++) {
+			for (j = i + 1; j < t->npulse; j++) {
+				sep = t->off[j] - t->off[i];
+				lo = sep - s->tol + 1 > 0 ? sep - s->tol + 1 : 0;
+				hi = sep + s->tol - 1;
+				for (b = lo >> s->shift; b <= hi >> s->shift; b++) {
+					s->bucket[b + 1]++;
+					total++;
+				}
+			}
+		}
+	}
+	for (b = 0; b < s->nbucket; b++) {
+		s->bucket[b + 1] += s->bucket[b];
+	}
+	s->pair = malloc((total ? total : 1) * sizeof(*s->pair));
+	if (s->pair == NULL) {
+		free(fill);
+		return -1;
+	}
+	for (tab = 0; tab < s->ntab; tab++) {
+		t = &s->tab[tab];
+		for (i = 0; i < t->npulse - 1; i++) {
+			for (j = i + 1; j < t->npulse; j++) {
+				sep = t->off[j] - t->off[i];
+				lo = sep - s->tol + 1 > 0 ? sep - s->tol + 1 : 0;
+				hi = sep + s->tol - 1;
+				for (b = lo >> s->shift; b <= hi >> s->shift; b++) {
+					s->pair[s->bucket[b] + fill[b]++] = (struct seq_pair){sep, tab, i, j};
+				}
+			}
+		}
+	}
+	free(fill);
+	return 0;
+}
+/* end of function: seq_index */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : seq_set_parse
+ * Inputs     : struct seq_set *s - set to fill in
+ *		const char *spec - tables separated by '/', each a name known
+ *				   to seq_table_parse or a list of separations,
+ *				   e.g. "katscan/7pulse/exp=3.0,6.0,9.0"
+ *		int64_t tol - matching tolerance in ns
+ * Returns    : 0 on success
+ *             -1 if a table is not valid, there are too many or out of memory
+ * Description: Free the set with seq_set_free.
+ */
+int seq_set_parse(struct seq_set *s, const char *spec, int64_t tol) {
+	const char *end;
+
+	memset(s, 0, sizeof(*s));
+	if (tol <= 0) {
+		return -1;
+	}
+	s->tol = tol;
+	for (;;) {
+		end = strchr(spec, '/');
+		if (end == NULL) {
+			end = spec + strlen(spec);
+		}
+		if (s->ntab == SEQ_MAX_TABLES
+				|| seq_table_parse(&s->tab[s->ntab], spec, end - spec, s->ntab) != 0) {
+			return -1;
+		}
+		s->ntab++;
+		if (*end == '\0') {
+			break;
+		}
+		spec = end + 1;
+	}
+	if (seq_index(s) != 0) {
+		seq_set_free(s);
+		return -1;
+	}
+	return 0;
+}
+/* end of function: seq_set_parse */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : seq_set_free
+ * Inputs     : struct seq_set *s - set made by seq_set_parse
+ * Returns    : Nothing
+ */
+void seq_set_free(struct seq_set *s) {
+	free(s->bucket);
+	free(s->pair);
+	s->bucket = NULL;
+	s->pair = NULL;
+}
+/* end of function: seq_set_free */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : seq_init
+ * Inputs     : struct seq_det *d - detector to set up
+ *		const struct seq_set *s - pulse tables, kept by the caller
+ * Returns    : Nothing
+ */
+void seq_init(struct seq_det *d, const struct seq_set *s) {
+	memset(d, 0, sizeof(*d));
+	d->s = s;
+}
+/* end of function: seq_init */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : seq_place
+ * Inputs     : struct seq_result *r - open sequence
+ *		int k - pulse, counting from 0
+ *		int64_t ns - its time
+ *		int64_t err - how far that is from where the table puts it
+ * Returns    : Nothing
+ */
+static void seq_place(struct seq_result *r, int k, int64_t ns, int64_t err) {
+	r->present |= 1U << k;
+	r->ns[k] = ns;
+	r->found++;
+	r->last = k;
+	r->err += err < 0 ? -err : err;
+}
+/* end of function: seq_place */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : seq_close
+ * Inputs     : struct seq_det *d - detector with open sequences
+ *		int c - the one to keep, the others are dropped
+ *		struct seq_result *out - receives the sequence
+ * Returns    : SEQ_DONE
+ */
+static int seq_close(struct seq_det *d, int c, struct seq_result *out) {
+	*out = d->cur[c];
+	d->open = 0;
+	d->sequences++;
+	d->pulses += out->found;
+	d->missing += out->npulse - out->found;
+	d->by_table[out->table]++;
+	return SEQ_DONE;
+}
+/* end of function: seq_close */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : seq_best
+ * Inputs     : struct seq_det *d - detector with open sequences
+ * Returns    : The open sequence with most pulses found, of those the one
+ *		whose pulses are closest to their places in its table, and of
+ *		those the first table's
+ */
+static int seq_best(const struct seq_det *d) {
+	const struct seq_result *r, *b;
+	int c, best = 0;
+
+	for (c = 1; c < d->open; c++) {
+		r = &d->cur[c];
+		b = &d->cur[best];
+		if (r->found > b->found || (r->found == b->found && r->err < b->err)) {
+			best = c;
+		}
+	}
+	return best;
+}
+/* end of function: seq_best */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : seq_settled
+ * Inputs     : struct seq_det *d - detector with open sequences
+ * Returns    : The best of them once one is complete and none of those still
+ *		being filled in could catch it up, otherwise -1
+ * Description: With a single table the first to be complete is the answer
+ *		straight away.
+ */
+static int seq_settled(const struct seq_det *d) {
+	const struct seq_result *r;
+	int c, best = seq_best(d);
+
+	if (d->cur[best].last != d->cur[best].npulse - 1) {
+		return -1;
+	}
+	for (c = 0; c < d->open; c++) {
+		r = &d->cur[c];
+		if (r->last != r->npulse - 1 && r->found + r->npulse - 1 - r->last >= d->cur[best].found) {
+			return -1;
+		}
+	}
+	return best;
+}
+/* end of function: seq_settled */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : seq_feed
+ * Inputs     : struct seq_det *d - detector
+ *		int64_t ns - next event time, in order
+ *		struct seq_result *out - receives a finished sequence
+ *		int64_t *stray - receives an event that belongs to no sequence
+ * Returns    : SEQ_NONE, SEQ_DONE or SEQ_STRAY
+ * Description: Each open sequence still being filled in tries to place the
+ *		event in one of its remaining pulses, and those that cannot are
+ *		dropped.  An event that none of them can place ends the best of
+ *		them (seq_best), as in findpulse.pl, and may start the next.
+ *		Otherwise the event is paired with the one before it: the first
+ *		pair of pulses (in table order) whose separation matches starts a
+ *		sequence, in each table that has one, and if none does the earlier
+ *		event is a stray.
+ */
+int seq_feed(struct seq_det *d, int64_t ns, struct seq_result *out, int64_t *stray) {
+	const struct seq_set *s = d->s;
+	const struct seq_table *t;
+	const struct seq_pair *p, *end;
+	struct seq_result *r;
+	int64_t rel, diff = 0, err[SEQ_MAX_TABLES];
+	int fit[SEQ_MAX_TABLES];
+	int c, j, kept = 0, placed = 0;
+
+	if (d->open == 1) {
+		/* one table's sequence, as in findpulse.pl */
+		r = &d->cur[0];
+		t = &s->tab[r->table];
+		rel = ns - r->start_ns;
+		for (j = r->last + 1; j < t->npulse; j++) {
+			diff = rel - t->off[j];
+			if (diff < s->tol) {
+				break;
+			}
+		}
+		if (j < t->npulse && diff > -s->tol) {
+			seq_place(r, j, ns, diff);
+			return j == t->npulse - 1 ? seq_close(d, 0, out) : SEQ_NONE;
+		}
+		d->pending = 1;
+		d->prev = ns;
+		return seq_close(d, 0, out);
+	}
+	if (d->open) {
+		for (c = 0; c < d->open; c++) {
+			r = &d->cur[c];
+			t = &s->tab[r->table];
+			fit[c] = -1;
+			rel = ns - r->start_ns;
+			/* the first pulse not already behind it, if it is close enough */
+			for (j = r->last + 1; j < t->npulse; j++) {
+				diff = rel - t->off[j];
+				if (diff < s->tol) {
+					break;
+				}
+			}
+			if (j < t->npulse && diff > -s->tol) {
+				fit[c] = j;
+				err[c] = diff;
+				placed++;
+			}
+		}
+		if (placed == 0) {
+			d->pending = 1;
+			d->prev = ns;
+			return seq_close(d, seq_best(d), out);
+		}
+		/* keep those that took it and those already complete */
+		for (c = 0; c < d->open; c++) {
+			r = &d->cur[c];
+			if (fit[c] == -1 && r->last != r->npulse - 1) {
+				continue;
+			}
+			if (kept != c) {
+				d->cur[kept] = *r;
+			}
+			if (fit[c] != -1) {
+				seq_place(&d->cur[kept], fit[c], ns, err[c]);
+			}
+			kept++;
+		}
+		d->open = kept;
+		c = seq_settled(d);
+		return c != -1 ? seq_close(d, c, out) : SEQ_NONE;
+	}
+
+	if (!d->pending) {
+		d->pending = 1;
+		d->prev = ns;
+		return SEQ_NONE;
+	}
+	rel = ns - d->prev;
+	if (rel >= 0 && rel >> s->shift < s->nbucket) {
+		p = &s->pair[s->bucket[rel >> s->shift]];
+		end = &s->pair[s->bucket[(rel >> s->shift) + 1]];
+		for (; p < end; p++) {
+			/* |rel - sep| < tol in one comparison */
+			if ((uint64_t)(rel - p->sep + s->tol - 1) >= (uint64_t)(2 * s->tol - 1)
+					|| (d->open != 0 && d->cur[d->open - 1].table == p->table)) {
+				continue;
+			}
+			r = &d->cur[d->open++];
+			r->present = 0;
+			r->found = 0;
+			r->err = 0;
+			r->table = p->table;
+			r->npulse = s->tab[p->table].npulse;
+			r->start_ns = d->prev - s->tab[p->table].off[p->i];
+			seq_place(r, p->i, d->prev, 0);
+			seq_place(r, p->j, ns, rel - p->sep);
+		}
+	}
+	if (d->open) {
+		d->pending = 0;
+		c = seq_settled(d);
+		return c != -1 ? seq_close(d, c, out) : SEQ_NONE;
+	}
+	*stray = d->prev;
+	d->strays++;
+	d->prev = ns;
+	return SEQ_STRAY;
+}
+/* end of function: seq_feed */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : seq_flush
+ * Inputs     : struct seq_det *d - detector
+ *		struct seq_result *out - receives the open sequence
+ *		int64_t *stray - receives the last event if it was not placed
+ * Returns    : SEQ_NONE, SEQ_DONE or SEQ_STRAY
+ * Description: At the end of the stream.  Of several open sequences the best
+ *		is kept (seq_best).
+ */
+int seq_flush(struct seq_det *d, struct seq_result *out, int64_t *stray) {
+	if (d->open) {
+		return seq_close(d, seq_best(d), out);
+	}
+	if (d->pending) {
+		*stray = d->prev;
+		d->strays++;
+		d->pending = 0;
+		return SEQ_STRAY;
+	}
+	return SEQ_NONE;
+}
+/* end of function: seq_flush */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : seq_oldest
+ * Inputs     : const struct seq_det *d - detector
+ * Returns    : Time of the earliest event it may still put in a sequence,
+ *		INT64_MAX if none
+ * Description: Those before it are settled: either in a sequence already
+ *		returned or in none.
+ */
+int64_t seq_oldest(const struct seq_det *d) {
+	const struct seq_result *r;
+	int64_t oldest = d->pending ? d->prev : INT64_MAX;
+	int c;
+
+	for (c = 0; c < d->open; c++) {
+		r = &d->cur[c];
+		if (r->ns[__builtin_ctz(r->present)] < oldest) {
+			oldest = r->ns[__builtin_ctz(r->present)];
+		}
+	}
+	return oldest;
+}
+/* end of function: seq_oldest */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : seq_idle
+ * Inputs     : struct seq_det *d - detector
+ *		int64_t now - time up to which no event has arrived
+ *		struct seq_result *out - receives the open sequence
+ *		int64_t *stray - receives the last event if it was not placed
+ * Returns    : SEQ_NONE, SEQ_DONE or SEQ_STRAY
+ * Description: Finishes as seq_flush would, but only once no event after now
+ *		could still belong with the last one, so that a sequence whose
+ *		last pulses are missing does not wait for the next sequence.
+ */
+int seq_idle(struct seq_det *d, int64_t now, struct seq_result *out, int64_t *stray) {
+	const struct seq_set *s = d->s;
+	const struct seq_table *t;
+	int c;
+
+	for (c = 0; c < d->open; c++) {
+		t = &s->tab[d->cur[c].table];
+		if (now - d->cur[c].start_ns < t->off[t->npulse - 1] + s->tol) {
+			return SEQ_NONE;
+		}
+	}
+	if (!d->open && d->pending && now - d->prev < s->span + s->tol) {
+		return SEQ_NONE;
+	}
+	return seq_flush(d, out, stray);
+}
+/* end of function: seq_idle */
+/*******************************************************************************/
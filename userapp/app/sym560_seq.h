@@ -0,0 +1,101 @@
+/* File : 	sym560_seq.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Streaming pulse sequence detector.  Groups event times, one at
+ *		a time and in integer nanoseconds, into pulse sequences defined by
+ *		the separations between their pulses, in the way findpulse.pl's
+ *		check_sequence does: two events whose separation matches that of
+ *		some pair of pulses in the table start a sequence, and following
+ *		events fill in its remaining pulses.
+ *
+ *		Any number of tables up to SEQ_MAX_TABLES can be looked for at
+ *		once, and each sequence found says which table it was.  Every
+ *		pulse separation of every table is indexed by its length when the
+ *		set is made, so pairing two events is a single lookup however many
+ *		tables there are.  A pair that fits several tables is followed in
+ *		each of them until the events that come next rule out all but one.
+ */
+
+#ifndef SYM560_SEQ_H
+#define SYM560_SEQ_H
+
+#include <stdint.h>
+
+/* longest pulse table, and most tables in a set */
+#define SEQ_MAX_PULSES		32
+#define SEQ_MAX_TABLES		8
+
+/* longest table name */
+#define SEQ_NAME_LEN		16
+
+/* findpulse.pl's @psep (ms) and $range */
+#define SEQ_DEFAULT_SEPS	"21.0,12.0,3.0,4.5,6.0,16.5,1.5"
+#define SEQ_DEFAULT_TOL_NS	50000
+
+/* most buckets in a set's separation index */
+#define SEQ_MAX_BUCKETS		65536
+
+/* seq_feed and seq_flush results */
+#define SEQ_NONE		0
+#define SEQ_DONE		1	/* *out holds a finished sequence */
+#define SEQ_STRAY		2	/* *stray is an event in no sequence */
+
+struct seq_table {
+	char name[SEQ_NAME_LEN];
+	int npulse;
+	int64_t off[SEQ_MAX_PULSES];	/* offset of each pulse from the first */
+};
+
+/* one separation between pulses i and j of a table */
+struct seq_pair {
+	int64_t sep;
+	uint8_t table;
+	uint8_t i;
+	uint8_t j;
+};
+
+struct seq_set {
+	int ntab;
+	struct seq_table tab[SEQ_MAX_TABLES];
+	int64_t tol;			/* a separation matches if it is less than this out */
+	int64_t span;			/* longest table, first pulse to last */
+	int shift;			/* separations are bucketed by sep >> shift */
+	int nbucket;
+	uint32_t *bucket;		/* pairs of bucket b are pair[bucket[b]] to pair[bucket[b + 1] - 1] */
+	struct seq_pair *pair;		/* in table, i, j order within each bucket */
+};
+
+struct seq_result {
+	int64_t start_ns;		/* time of pulse 1, inferred if it is missing */
+	uint32_t present;		/* bit k set if pulse k + 1 was seen */
+	int table;			/* which table of the set */
+	int npulse;			/* pulses in it */
+	int found;			/* pulses seen */
+	int last;			/* highest pulse seen, counting from 0 */
+	int64_t err;			/* sum of how far each pulse seen was from its place */
+	int64_t ns[SEQ_MAX_PULSES];	/* time of each pulse seen */
+};
+
+struct seq_det {
+	const struct seq_set *s;
+	int open;			/* sequences open, one per table at most */
+	int pending;			/* prev is an event not yet placed */
+	int64_t prev;
+	struct seq_result cur[SEQ_MAX_TABLES];	/* the open ones, in table order */
+	uint64_t sequences;		/* sequences finished */
+	uint64_t pulses;		/* events placed in them */
+	uint64_t missing;		/* pulses missing from them */
+	uint64_t strays;		/* events in no sequence */
+	uint64_t by_table[SEQ_MAX_TABLES];	/* sequences finished of each table */
+};
+
+/* function declarations */
+int seq_set_parse(struct seq_set *s, const char *spec, int64_t tol);
+void seq_set_free(struct seq_set *s);
+void seq_init(struct seq_det *d, const struct seq_set *s);
+int seq_feed(struct seq_det *d, int64_t ns, struct seq_result *out, int64_t *stray);
+int seq_flush(struct seq_det *d, struct seq_result *out, int64_t *stray);
+int seq_idle(struct seq_det *d, int64_t now, struct seq_result *out, int64_t *stray);
+int64_t seq_oldest(const struct seq_det *d);
+
+#endif /* SYM560_SEQ_H */
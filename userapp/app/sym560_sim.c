@@ -0,0 +1,193 @@
+/* File : 	sym560_sim.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Simulated event source.  Events are scheduled either at a fixed
+ *		rate or as a repeating pulse sequence (the @psep table of findpulse.pl)
+ *		and are returned in the same BCD format the driver produces.
+ */
+
+#include <time.h>
+#include "sym560_sim.h"
+#include "sym560_record.h"
+
+/*******************************************************************************/
+/* Function   : sim_now
+ * Inputs     : None
+ * Returns    : CLOCK_MONOTONIC time in nanoseconds
+ */
+int64_t sim_now(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+/* end of function: sim_now */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : sim_start
+ * Inputs     : struct sim *sim - simulator
+ *		uint64_t limit - number of events to generate (0 = no limit)
+ * Returns    : Nothing
+ * Description: Common part of sim_init and sim_init_pattern.  The UTC time of
+ *		the first event is taken from the system clock.
+ */
+static void sim_start(struct sim *sim, uint64_t limit) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	sim->start_ns = (ts.tv_sec * 1000000000LL + ts.tv_nsec) / 100 * 100;
+	sim->t0 = sim_now();
+	sim->limit = limit;
+	sim->next = 0;
+	sim->lost = 0;
+}
+/* end of function: sim_start */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : sim_init
+ * Inputs     : struct sim *sim - simulator
+ *		double rate - events per second, 0 for unpaced
+ *		uint64_t limit - number of events to generate (0 = no limit)
+ * Returns    : Nothing
+ * Description: Events at a constant rate.  An unpaced simulator hands out a
+ *		new event (1 us apart in card time) on every wait and never loses
+ *		any, which measures the pipeline on its own.
+ */
+void sim_init(struct sim *sim, double rate, uint64_t limit) {
+	sim->npulse = 1;
+	sim->offset_ns[0] = 0;
+	sim->paced = (rate > 0);
+	sim->period_ns = sim->paced ? (int64_t)(1e9 / rate) : 1000;
+	if (sim->period_ns < 100) {
+		sim->period_ns = 100;
+	}
+	sim_start(sim, limit);
+}
+/* end of function: sim_init */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : sim_init_pattern
+ * Inputs     : struct sim *sim - simulator
+ *		const double *psep - pulse separations in ms (like @psep)
+ *		int npsep - number of separations
+ *		double period_ms - time between sequence starts in ms
+ *		uint64_t limit - number of events to generate (0 = no limit)
+ * Returns    : 0 on success
+ *             -1 if the table is too long or does not fit in the period
+ * Description: Paced pulse sequences, npsep + 1 pulses each.
+ */
+int sim_init_pattern(struct sim *sim, const double *psep, int npsep, double period_ms, uint64_t limit) {
+	int cnt;
+
+	if (npsep + 1 > SIM_MAX_PULSES) {
+		return -1;
+	}
+	sim->npulse = npsep + 1;
+	sim->offset_ns[0] = 0;
+	for (cnt = 0; cnt < npsep; cnt++) {
+		sim->offset_ns[cnt + 1] = sim->offset_ns[cnt] + (int64_t)(psep[cnt] * 1e6 + 0.5);
+	}
+	sim->period_ns = (int64_t)(period_ms * 1e6 + 0.5);
+	if (sim->offset_ns[npsep] >= sim->period_ns) {
+		return -1;
+	}
+	sim->paced = 1;
+	sim_start(sim, limit);
+	return 0;
+}
+/* end of function: sim_init_pattern */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : sim_event_ns
+ * Inputs     : struct sim *sim - simulator
+ *		uint64_t idx - event number
+ * Returns    : Time of event idx relative to the first event, in ns
+ */
+int64_t sim_event_ns(struct sim *sim, uint64_t idx) {
+	return (int64_t)(idx / sim->npulse) * sim->period_ns + sim->offset_ns[idx % sim->npulse];
+}
+/* end of function: sim_event_ns */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : sim_latest
+ * Inputs     : struct sim *sim - simulator
+ *		int64_t now - time relative to the first event, in ns
+ * Returns    : Number of the most recent event at or before now
+ */
+static uint64_t sim_latest(struct sim *sim, int64_t now) {
+	uint64_t seq;
+	int64_t within;
+	int pulse;
+
+	seq = now / sim->period_ns;
+	within = now - (int64_t)seq * sim->period_ns;
+	for (pulse = sim->npulse - 1; pulse > 0; pulse--) {
+		if (sim->offset_ns[pulse] <= within) {
+			break;
+		}
+	}
+	return seq * sim->npulse + pulse;
+}
+/* end of function: sim_latest */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : sim_wait
+ * Inputs     : struct sim *sim - simulator
+ *		unsigned char *raw - 12 byte buffer that receives the event time
+ * Returns    : 0 on success
+ *             -1 once limit events have been generated
+ * Description: Stand-in for ioctl(fd, 0x8008f800, raw).  Waits for the next
+ *		event and returns the most recent one; any events that came and went
+ *		while the caller was busy are added to sim->lost.
+ */
+int sim_wait(struct sim *sim, unsigned char *raw) {
+	struct timespec ts;
+	int64_t now, due;
+	uint64_t idx, latest;
+
+	if (sim->limit != 0 && sim->next >= sim->limit) {
+		return -1;
+	}
+	idx = sim->next;
+	if (sim->paced) {
+		/* wait for the next event, sleeping only when it is far off */
+		for (;;) {
+			now = sim_now() - sim->t0;
+			due = sim_event_ns(sim, idx);
+			if (now >= due) {
+				break;
+			}
+			if (due - now > 200000) {
+				ts.tv_sec = 0;
+				ts.tv_nsec = due - now - 100000;
+				nanosleep(&ts, NULL);
+			}
+		}
+		/* skip forward to the latest event that has already happened */
+		latest = sim_latest(sim, now);
+		if (sim->limit != 0 && latest >= sim->limit) {
+			latest = sim->limit - 1;
+		}
+		if (latest > idx) {
+			idx = latest;
+		}
+		sim->lost += idx - sim->next;
+	}
+	sim->next = idx + 1;
+	rec_encode(sim->start_ns + sim_event_ns(sim, idx), raw);
+	return 0;
+}
+/* end of function: sim_wait */
+/*******************************************************************************/
@@ -0,0 +1,38 @@
+/* File : 	sym560_sim.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Simulated event source used in place of /dev/symgps for
+ *		benchmarking the capture pipeline.
+ */
+
+#ifndef SYM560_SIM_H
+#define SYM560_SIM_H
+
+#include <stdint.h>
+
+#define SIM_MAX_PULSES	32
+
+/* The simulator behaves like the driver: the card holds only the most recent
+ * event, so if more than one event occurs between two waits the older ones are
+ * overwritten and counted as lost.
+ */
+struct sim {
+	int64_t t0;			/* CLOCK_MONOTONIC time of the first event */
+	int64_t start_ns;		/* UTC time stamped on the first event */
+	int64_t period_ns;		/* time between the starts of two sequences */
+	int64_t offset_ns[SIM_MAX_PULSES]; /* pulse offsets within a sequence */
+	int npulse;			/* pulses per sequence */
+	int paced;			/* 0 = deliver events as fast as they are read */
+	uint64_t limit;			/* number of events to generate, 0 = forever */
+	uint64_t next;			/* index of the next event that can be read */
+	uint64_t lost;			/* events overwritten before being read */
+};
+
+/* function declarations */
+int64_t sim_now(void);
+void sim_init(struct sim *sim, double rate, uint64_t limit);
+int sim_init_pattern(struct sim *sim, const double *psep, int npsep, double period_ms, uint64_t limit);
+int64_t sim_event_ns(struct sim *sim, uint64_t idx);
+int sim_wait(struct sim *sim, unsigned char *raw);
+
+#endif /* SYM560_SIM_H */
@@ -0,0 +1,276 @@
+/* File : 	sym560_status.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Status broker thread for the automatic mode and the reader used
+ *		by the interactive menu and monitoring tools.  The status is a
+ *		single struct in the shared memory object /sym560_status (see
+ *		/dev/shm), guarded by a sequence counter: the broker makes it odd,
+ *		updates the struct and makes it even again, and a reader retries
+ *		its copy until it sees the same even value before and after.  The
+ *		GPS lock bits are the ones the capture's lock thread already polls,
+ *		so only the satellite, antenna and position registers are read
+ *		here, once per period.  The capture counters cost nothing to read
+ *		and are published every STAT_COUNTER_NS, for live monitors.
+ */
+
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include "sym560_functions.h"
+#include "sym560_status.h"
+
+/*******************************************************************************/
+/* Function   : stat_sample
+ * Inputs     : struct broker *br - broker state
+ *		int card - read the card's registers too
+ * Returns    : Nothing
+ * Description: Reads everything into a local copy and then publishes it, so the
+ *		struct is only odd for the time it takes to copy it.  A reading
+ *		the card was in the middle of updating is tried again a few times
+ *		before it is marked invalid.  Without card the previous reading is
+ *		published again.
+ */
+static void stat_sample(struct broker *br, int card) {
+	struct sym560_status s;
+	struct capture *cap = br->cap;
+	struct timespec now;
+	uint32_t seq;
+	int cnt;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	memset(&s, 0, sizeof(s));
+	s.lock = atomic_load(&cap->lock);
+	s.antenna = -1;
+	if (!card) {
+		/* only this thread writes the struct, so it can read it as it is */
+		s.antenna = br->st->antenna;
+		s.sat_valid = br->st->sat_valid;
+		s.pos_valid = br->st->pos_valid;
+		memcpy(s.sat, br->st->sat, sizeof(s.sat));
+		memcpy(s.pos, br->st->pos, sizeof(s.pos));
+		s.card_ns = br->st->card_ns;
+	}
+	else if (br->devfd != -1) {
+		for (cnt = 0; cnt < 3 && !s.sat_valid; cnt++) {
+			s.sat_valid = sat_read(br->devfd, s.sat) == 0;
+		}
+		for (cnt = 0; cnt < 3 && !s.pos_valid; cnt++) {
+			s.pos_valid = position_read(br->devfd, s.pos) == 0;
+		}
+		s.antenna = antenna_read(br->devfd);
+	}
+	if (card) {
+		s.card_ns = now.tv_sec * 1000000000LL + now.tv_nsec;
+	}
+	/* written first, so a reader never sees more written than captured */
+	s.written = atomic_load(&cap->written);
+	s.captured = atomic_load(&cap->captured);
+	s.dropped = atomic_load(&cap->overflows) + atomic_load(&cap->dropped);
+	s.backlog = atomic_load(&cap->ring->head) - atomic_load(&cap->ring->tail);
+	s.stalls = atomic_load(&cap->stalls);
+	s.updated_ns = now.tv_sec * 1000000000LL + now.tv_nsec;
+
+	seq = atomic_load_explicit(&br->st->seq, memory_order_relaxed);
+	atomic_store_explicit(&br->st->seq, seq + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	br->st->updated_ns = s.updated_ns;
+	br->st->card_ns = s.card_ns;
+	br->st->samples++;
+	br->st->lock = s.lock;
+	br->st->antenna = s.antenna;
+	br->st->sat_valid = s.sat_valid;
+	br->st->pos_valid = s.pos_valid;
+	memcpy(br->st->sat, s.sat, sizeof(s.sat));
+	memcpy(br->st->pos, s.pos, sizeof(s.pos));
+	br->st->captured = s.captured;
+	br->st->written = s.written;
+	br->st->dropped = s.dropped;
+	br->st->backlog = s.backlog;
+	br->st->stalls = s.stalls;
+	atomic_store_explicit(&br->st->seq, seq + 2, memory_order_release);
+}
+/* end of function: stat_sample */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : stat_thread_main
+ * Inputs     : void *arg - the struct broker
+ * Returns    : NULL
+ * Description: Reads the card straight away and then every period_ns, and
+ *		publishes the counters every STAT_COUNTER_NS in between (or every
+ *		period_ns if that is shorter).
+ */
+static void *stat_thread_main(void *arg) {
+	struct broker *br = arg;
+	struct timespec step = {0, STAT_COUNTER_NS};
+	int64_t last_card = 0, now;
+
+	if (br->period_ns < STAT_COUNTER_NS) {
+		step.tv_nsec = br->period_ns;
+	}
+	while (atomic_load(&br->stop) == 0) {
+		now = sim_now();
+		if (last_card == 0 || now - last_card >= br->period_ns) {
+			stat_sample(br, 1);
+			last_card = now;
+		}
+		else {
+			stat_sample(br, 0);
+		}
+		nanosleep(&step, NULL);
+	}
+	return NULL;
+}
+/* end of function: stat_thread_main */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : stat_start
+ * Inputs     : struct broker *br - broker state to set up
+ *		struct capture *cap - running capture (for the lock bits and counters)
+ *		int devfd - device file descriptor, -1 with a simulated source
+ *		int64_t period_ns - sampling interval
+ * Returns    : 0 on success
+ *             -1 on failure
+ * Description: Creates (or takes over) the shared memory object, readable by
+ *		everyone, and starts the broker thread.  Call after cap_start, as
+ *		for ctl_start.
+ */
+int stat_start(struct broker *br, struct capture *cap, int devfd, int64_t period_ns) {
+	int fd;
+
+	memset(br, 0, sizeof(*br));
+	br->cap = cap;
+	br->devfd = devfd;
+	br->period_ns = period_ns;
+
+	fd = shm_open(STAT_SHM_NAME, O_RDWR|O_CREAT, 00644);
+	if (fd == -1) {
+		printf("\nCould not create the status %s (errno %d)\n", STAT_SHM_NAME, errno);
+		return -1;
+	}
+	if (ftruncate(fd, sizeof(struct sym560_status)) == -1) {
+		printf("\nCould not size the status %s (errno %d)\n", STAT_SHM_NAME, errno);
+		close(fd);
+		return -1;
+	}
+	br->st = mmap(NULL, sizeof(struct sym560_status), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (br->st == MAP_FAILED) {
+		printf("\nCould not map the status %s (errno %d)\n", STAT_SHM_NAME, errno);
+		return -1;
+	}
+
+	/* readers ignore it until the magic is in place */
+	br->st->magic = 0;
+	atomic_thread_fence(memory_order_release);
+	br->st->version = STAT_VERSION;
+	br->st->pid = getpid();
+	br->st->period_ns = period_ns;
+	br->st->samples = 0;
+	atomic_store(&br->st->seq, 0);
+	atomic_thread_fence(memory_order_release);
+	br->st->magic = STAT_MAGIC;
+
+	if (pthread_create(&br->thread, NULL, stat_thread_main, br) != 0) {
+		printf("\nCould not start the status thread\n");
+		munmap(br->st, sizeof(struct sym560_status));
+		shm_unlink(STAT_SHM_NAME);
+		return -1;
+	}
+	return 0;
+}
+/* end of function: stat_start */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : stat_stop
+ * Inputs     : struct broker *br - broker started by stat_start
+ * Returns    : Nothing
+ * Description: Stops the thread and removes the shared memory object, so that
+ *		readers go back to the card.
+ */
+void stat_stop(struct broker *br) {
+	atomic_store(&br->stop, 1);
+	pthread_join(br->thread, NULL);
+	br->st->magic = 0;
+	munmap(br->st, sizeof(struct sym560_status));
+	shm_unlink(STAT_SHM_NAME);
+}
+/* end of function: stat_stop */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : stat_read
+ * Inputs     : struct sym560_status *out - receives a consistent copy
+ * Returns    : 0 on success
+ *             -1 if no live broker is publishing
+ * Description: Never blocks the broker and never touches the card.  A status
+ *		left behind by a process that no longer exists, or not updated for
+ *		three periods, is not used.
+ */
+int stat_read(struct sym560_status *out) {
+	struct sym560_status *st;
+	struct timespec now, pause = {0, 100000};
+	uint32_t seq;
+	int fd, cnt, ret = -1;
+
+	fd = shm_open(STAT_SHM_NAME, O_RDONLY, 0);
+	if (fd == -1) {
+		return -1;
+	}
+	st = mmap(NULL, sizeof(struct sym560_status), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (st == MAP_FAILED) {
+		return -1;
+	}
+	for (cnt = 0; cnt < 1000; cnt++) {
+		seq = atomic_load_explicit(&st->seq, memory_order_acquire);
+		if (seq & 1) {
+			nanosleep(&pause, NULL);
+			continue;
+		}
+		memcpy(out, st, sizeof(*out));
+		atomic_thread_fence(memory_order_acquire);
+		if (atomic_load_explicit(&st->seq, memory_order_relaxed) == seq) {
+			ret = 0;
+			break;
+		}
+	}
+	munmap(st, sizeof(struct sym560_status));
+	if (ret != 0 || out->magic != STAT_MAGIC || out->version != STAT_VERSION
+			|| out->samples == 0) {
+		return -1;
+	}
+	if (kill(out->pid, 0) == -1 && errno == ESRCH) {
+		return -1;
+	}
+	clock_gettime(CLOCK_REALTIME, &now);
+	if (now.tv_sec * 1000000000LL + now.tv_nsec - out->updated_ns > 3 * out->period_ns) {
+		return -1;
+	}
+	return 0;
+}
+/* end of function: stat_read */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : stat_print_age
+ * Inputs     : const struct sym560_status *st - status from stat_read
+ * Returns    : Nothing
+ * Description: Says where the figures that follow came from.
+ */
+void stat_print_age(const struct sym560_status *st) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	printf("(from the timestamping process %d, %.1f s ago)\n", (int)st->pid,
+			(now.tv_sec * 1000000000LL + now.tv_nsec - st->card_ns) / 1e9);
+}
+/* end of function: stat_print_age */
+/*******************************************************************************/
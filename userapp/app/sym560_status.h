@@ -0,0 +1,76 @@
+/* File : 	sym560_status.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Status broker.  While the automatic mode runs, a thread samples
+ *		the GPS lock, satellite, antenna and position registers at a low
+ *		rate, and the capture counters every STAT_COUNTER_NS, and publishes
+ *		them in POSIX shared memory under a seqlock, so
+ *		any number of monitoring tools (and the interactive menu) can read
+ *		the card's state without touching the device.
+ */
+
+#ifndef SYM560_STATUS_H
+#define SYM560_STATUS_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "sym560_capture.h"
+
+/* shared memory object the status is published in */
+#define STAT_SHM_NAME		"/sym560_status"
+
+/* how often the automatic mode samples the card unless told otherwise */
+#define STAT_DEFAULT_NS		10000000000LL
+
+/* the capture counters are published this often whatever the card's period */
+#define STAT_COUNTER_NS		100000000LL
+
+#define STAT_MAGIC		0x31544154534d5953ULL	/* "SYMSTAT1" */
+#define STAT_VERSION		1
+
+/* antenna bits of the hardware status register, as returned by antenna_read */
+#define STAT_ANT_NOT_OPEN	0x10
+#define STAT_ANT_NOT_SHORTED	0x20
+#define STAT_ANT_OK		0x30
+
+/* The published status.  Readers copy it with stat_read, never in place. */
+struct sym560_status {
+	uint64_t magic;
+	uint32_t version;
+	_Atomic uint32_t seq;		/* odd while an update is in progress */
+	pid_t pid;			/* publishing process */
+	int64_t period_ns;		/* sampling interval */
+	int64_t updated_ns;		/* UTC time of the last update */
+	int64_t card_ns;		/* UTC time the card's registers were last read */
+	uint64_t samples;		/* samples published */
+	int lock;			/* REC_LOCK_* bits */
+	int antenna;			/* STAT_ANT_* bits, -1 if not read */
+	int sat_valid;			/* sat[] holds a complete reading */
+	int pos_valid;			/* pos[] holds a consistent reading */
+	unsigned char sat[24];		/* satellite signal strength registers (sat_read) */
+	unsigned char pos[16];		/* antenna position register (position_read) */
+	uint64_t captured;		/* capture counters at the time of the sample */
+	uint64_t written;
+	uint64_t dropped;		/* ring overflows plus events dropped by the writer */
+	uint64_t backlog;		/* records in the capture ring not yet written out */
+	uint64_t stalls;		/* times the writer found every buffer waiting on the disk */
+};
+
+struct broker {
+	struct capture *cap;
+	int devfd;			/* /dev/symgps, -1 with a simulated source */
+	int64_t period_ns;
+	struct sym560_status *st;	/* the shared memory */
+	pthread_t thread;
+	_Atomic int stop;
+};
+
+/* function declarations */
+int stat_start(struct broker *br, struct capture *cap, int devfd, int64_t period_ns);
+void stat_stop(struct broker *br);
+int stat_read(struct sym560_status *out);
+void stat_print_age(const struct sym560_status *st);
+
+#endif /* SYM560_STATUS_H */
@@ -0,0 +1,412 @@
+/* File : 	sym560_stream.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Live event stream server for the automatic mode.  Subscribers
+ *		connect a SOCK_SEQPACKET socket to the stream path and then only
+ *		receive.  Every packet starts with a struct str_header:
+ *
+ *		    STR_EVENTS	followed by count struct sym560_records, in order
+ *		    STR_LAG	the subscriber fell too far behind and the next
+ *				missed events were skipped
+ *
+ *		A new subscriber starts with the next event written.  Gaps in the
+ *		records' seq numbers not covered by an STR_LAG are events the
+ *		capture itself lost (ring overflows or the writer's drop-oldest
+ *		policy), which the timestamp file shows the same way.
+ *
+ *		The writer only copies records into the broadcast ring and moves its
+ *		head; it never waits for the server or a subscriber.  The server
+ *		reads each subscriber's records out of the ring as a seqlock reader
+ *		would: the writer claims slots before overwriting them, and a copy
+ *		that may have been overwritten while it was made is thrown away.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include "sym560_functions.h"
+#include "sym560_stream.h"
+
+/*******************************************************************************/
+/* Function   : str_packet
+ * Inputs     : struct str_client *c - subscriber
+ *		const char *pkt - packet to send
+ *		size_t len - its length
+ * Returns    : 1 once sent
+ *		0 if the subscriber's socket buffer is full
+ *             -1 if the subscriber has gone away
+ */
+static int str_packet(struct str_client *c, const char *pkt, size_t len) {
+	ssize_t ret;
+
+	ret = send(c->sock, pkt, len, MSG_DONTWAIT|MSG_NOSIGNAL);
+	if (ret == (ssize_t)len) {
+		return 1;
+	}
+	if (ret == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+		c->blocked = 1;
+		return 0;
+	}
+	return -1;
+}
+/* end of function: str_packet */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : str_send
+ * Inputs     : struct stream *str - stream state
+ *		struct str_client *c - subscriber
+ *		char *pkt - buffer for one packet of STR_BATCH records
+ * Returns    : 1 if a packet was sent
+ *		0 if there was nothing to send or the subscriber is blocked
+ *             -1 if the subscriber has to be disconnected
+ * Description: Sends the subscriber its next batch.  A subscriber the writer
+ *		has lapped is moved up to half a ring behind the head, so it has
+ *		room to catch up, and told how much it missed.
+ */
+static int str_send(struct stream *str, struct str_client *c, char *pkt) {
+	struct str_header *hdr = (struct str_header *)pkt;
+	uint64_t size = str->mask + 1, head, claim, pos, n;
+	int ret;
+
+	for (;;) {
+		head = atomic_load_explicit(&str->head, memory_order_acquire);
+		claim = atomic_load_explicit(&str->claim, memory_order_relaxed);
+		/* checked even while blocked, so one that has stopped reading is dropped */
+		if (claim - c->cursor > size) {
+			c->missed += claim - size / 2 - c->cursor;
+			c->cursor = claim - size / 2;
+			atomic_fetch_add_explicit(&str->lagged, 1, memory_order_relaxed);
+			if (++c->lags > STR_MAX_LAGS) {
+				atomic_fetch_add_explicit(&str->dropped, 1, memory_order_relaxed);
+				return -1;
+			}
+		}
+		if (c->blocked) {
+			return 0;
+		}
+		if (c->missed != 0) {
+			hdr->type = STR_LAG;
+			hdr->count = 0;
+			hdr->missed = c->missed;
+			ret = str_packet(c, pkt, sizeof(*hdr));
+			if (ret != 1) {
+				return ret;
+			}
+			c->missed = 0;
+		}
+		if (head == c->cursor) {
+			c->lags = 0;
+			return 0;
+		}
+
+		pos = c->cursor & str->mask;
+		n = head - c->cursor;
+		if (n > STR_BATCH) {
+			n = STR_BATCH;
+		}
+		if (n > size - pos) {
+			n = size - pos;
+		}
+		memcpy(pkt + sizeof(*hdr), &str->rec[pos], n * sizeof(struct sym560_record));
+		atomic_thread_fence(memory_order_acquire);
+		if (atomic_load_explicit(&str->claim, memory_order_relaxed) - c->cursor > size) {
+			/* overwritten while being copied */
+			continue;
+		}
+		hdr->type = STR_EVENTS;
+		hdr->count = n;
+		hdr->missed = 0;
+		ret = str_packet(c, pkt, sizeof(*hdr) + n * sizeof(struct sym560_record));
+		if (ret == 1) {
+			c->cursor += n;
+			atomic_fetch_add_explicit(&str->packets, 1, memory_order_relaxed);
+		}
+		return ret;
+	}
+}
+/* end of function: str_send */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : str_close
+ * Inputs     : struct str_client *c - subscriber
+ * Returns    : Nothing
+ */
+static void str_close(struct str_client *c) {
+	close(c->sock);
+	c->sock = -1;
+}
+/* end of function: str_close */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : str_thread_main
+ * Inputs     : void *arg - the struct stream
+ * Returns    : NULL
+ * Description: Goes round the subscribers sending one batch to each while any
+ *		has something to send, and otherwise waits up to a millisecond for
+ *		a new subscriber, a blocked one to drain or more events.  After
+ *		str_stop it carries on until every subscriber has caught up, or for
+ *		at most STR_DRAIN_MS.
+ */
+static void *str_thread_main(void *arg) {
+	struct stream *str = arg;
+	struct pollfd pfd[STR_MAX_CLIENTS + 1];
+	struct str_client *c;
+	char pkt[sizeof(struct str_header) + STR_BATCH * sizeof(struct sym560_record)];
+	char buff[64];
+	int64_t drain_end = 0;
+	int cnt, ret, busy, behind, slot, sock;
+
+	for (;;) {
+		busy = 0;
+		behind = 0;
+		for (cnt = 0; cnt < STR_MAX_CLIENTS; cnt++) {
+			c = &str->client[cnt];
+			if (c->sock == -1) {
+				continue;
+			}
+			switch (str_send(str, c, pkt)) {
+				case 1:
+					busy = 1;
+					break;
+				case -1:
+					str_close(c);
+					continue;
+			}
+			if (c->cursor != atomic_load_explicit(&str->head, memory_order_relaxed)
+					|| c->missed != 0) {
+				behind = 1;
+			}
+		}
+		if (atomic_load(&str->stop) != 0) {
+			if (!behind) {
+				break;
+			}
+			if (drain_end == 0) {
+				drain_end = sim_now() + STR_DRAIN_MS * 1000000LL;
+			}
+			else if (sim_now() > drain_end) {
+				break;
+			}
+		}
+
+		pfd[0].fd = str->lsock;
+		pfd[0].events = POLLIN;
+		for (cnt = 0; cnt < STR_MAX_CLIENTS; cnt++) {
+			pfd[cnt + 1].fd = str->client[cnt].sock;
+			pfd[cnt + 1].events = POLLIN | (str->client[cnt].blocked ? POLLOUT : 0);
+		}
+		if (poll(pfd, STR_MAX_CLIENTS + 1, busy ? 0 : 1) <= 0) {
+			continue;
+		}
+
+		/* subscribers only ever receive, so anything else means they hung up */
+		for (cnt = 0; cnt < STR_MAX_CLIENTS; cnt++) {
+			c = &str->client[cnt];
+			if (c->sock == -1 || pfd[cnt + 1].revents == 0) {
+				continue;
+			}
+			ret = 1;
+			if ((pfd[cnt + 1].revents & POLLIN) != 0) {
+				ret = recv(c->sock, buff, sizeof(buff), MSG_DONTWAIT);
+				if (ret == -1 && (errno == EAGAIN || errno == EINTR)) {
+					ret = 1;
+				}
+			}
+			if (ret <= 0 || (pfd[cnt + 1].revents & (POLLHUP|POLLERR)) != 0) {
+				str_close(c);
+				continue;
+			}
+			if ((pfd[cnt + 1].revents & POLLOUT) != 0) {
+				c->blocked = 0;
+			}
+		}
+
+		if ((pfd[0].revents & POLLIN) != 0) {
+			sock = accept(str->lsock, NULL, NULL);
+			if (sock == -1) {
+				continue;
+			}
+			fcntl(sock, F_SETFL, O_NONBLOCK);
+			for (slot = 0; slot < STR_MAX_CLIENTS; slot++) {
+				if (str->client[slot].sock == -1) {
+					break;
+				}
+			}
+			if (slot == STR_MAX_CLIENTS) {
+				close(sock);
+				continue;
+			}
+			memset(&str->client[slot], 0, sizeof(str->client[slot]));
+			str->client[slot].sock = sock;
+			str->client[slot].cursor = atomic_load_explicit(&str->head, memory_order_acquire);
+			atomic_fetch_add_explicit(&str->accepted, 1, memory_order_relaxed);
+		}
+	}
+	return NULL;
+}
+/* end of function: str_thread_main */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : str_start
+ * Inputs     : struct stream *str - stream state to set up
+ *		struct capture *cap - capture whose writer feeds the stream
+ *		const char *path - socket path
+ * Returns    : 0 on success
+ *             -1 on failure
+ * Description: Allocates the broadcast ring, creates the socket (replacing a
+ *		stale one, but not one another server still answers on) with the
+ *		same permissions as the control socket, starts the server thread
+ *		and hooks the stream into the writer.  Call after cap_start, as for
+ *		ctl_start.
+ */
+int str_start(struct stream *str, struct capture *cap, const char *path) {
+	struct sockaddr_un addr;
+	void *mem;
+	mode_t old;
+	int cnt, ret, probe;
+
+	memset(str, 0, sizeof(*str));
+	str->cap = cap;
+	for (cnt = 0; cnt < STR_MAX_CLIENTS; cnt++) {
+		str->client[cnt].sock = -1;
+	}
+	if (strlen(path) >= sizeof(str->path)) {
+		printf("\nStream socket path %s is too long\n", path);
+		return -1;
+	}
+	strcpy(str->path, path);
+	if (posix_memalign(&mem, RING_CACHELINE, sizeof(struct sym560_record) << STR_RING_ORDER) != 0) {
+		printf("\nCould not allocate the stream ring\n");
+		return -1;
+	}
+	str->rec = mem;
+	str->mask = (1ULL << STR_RING_ORDER) - 1;
+
+	str->lsock = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+	if (str->lsock == -1) {
+		printf("\nCould not create the stream socket (errno %d)\n", errno);
+		free(str->rec);
+		return -1;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, str->path);
+	/* only a socket nobody is listening on is stale */
+	probe = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+	if (probe != -1 && connect(probe, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+		printf("\nA stream server is already running on %s\n", str->path);
+		close(probe);
+		close(str->lsock);
+		free(str->rec);
+		return -1;
+	}
+	if (probe != -1) {
+		close(probe);
+	}
+	unlink(str->path);
+	/* created 0660 by bind itself, as in ctl_start */
+	old = umask(0117);
+	ret = bind(str->lsock, (struct sockaddr *)&addr, sizeof(addr));
+	umask(old);
+	if (ret == -1 || listen(str->lsock, STR_MAX_CLIENTS) == -1) {
+		printf("\nCould not listen on %s (errno %d)\n", str->path, errno);
+		close(str->lsock);
+		free(str->rec);
+		return -1;
+	}
+
+	if (pthread_create(&str->thread, NULL, str_thread_main, str) != 0) {
+		printf("\nCould not start the stream thread\n");
+		close(str->lsock);
+		unlink(str->path);
+		free(str->rec);
+		return -1;
+	}
+	atomic_store_explicit(&cap->stream, str, memory_order_release);
+	return 0;
+}
+/* end of function: str_start */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : str_publish
+ * Inputs     : struct stream *str - stream state
+ *		const struct sym560_record *rec - records taken from the capture ring
+ *		uint64_t n - how many
+ * Returns    : Nothing
+ * Description: Called by the writer thread only.  Claims each batch of slots
+ *		before overwriting them so that the server can tell when a copy it
+ *		was making went stale.
+ */
+void str_publish(struct stream *str, const struct sym560_record *rec, uint64_t n) {
+	uint64_t head = atomic_load_explicit(&str->head, memory_order_relaxed);
+	uint64_t chunk, cnt;
+
+	while (n > 0) {
+		chunk = n < STR_BATCH ? n : STR_BATCH;
+		atomic_store_explicit(&str->claim, head + chunk, memory_order_relaxed);
+		atomic_thread_fence(memory_order_release);
+		for (cnt = 0; cnt < chunk; cnt++) {
+			str->rec[(head + cnt) & str->mask] = rec[cnt];
+		}
+		head += chunk;
+		rec += chunk;
+		n -= chunk;
+		atomic_store_explicit(&str->head, head, memory_order_release);
+	}
+}
+/* end of function: str_publish */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : str_stop
+ * Inputs     : struct stream *str - stream started by str_start
+ * Returns    : Nothing
+ * Description: Call after cap_stop, so the writer has finished with the ring
+ *		and subscribers get every event up to the end.  Disconnects them
+ *		once they have caught up and removes the socket.
+ */
+void str_stop(struct stream *str) {
+	int cnt;
+
+	atomic_store_explicit(&str->cap->stream, NULL, memory_order_relaxed);
+	atomic_store(&str->stop, 1);
+	pthread_join(str->thread, NULL);
+	for (cnt = 0; cnt < STR_MAX_CLIENTS; cnt++) {
+		if (str->client[cnt].sock != -1) {
+			str_close(&str->client[cnt]);
+		}
+	}
+	close(str->lsock);
+	unlink(str->path);
+	free(str->rec);
+	str->rec = NULL;
+}
+/* end of function: str_stop */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : str_print
+ * Inputs     : const struct stream *str - stream state
+ * Returns    : Nothing
+ */
+void str_print(const struct stream *str) {
+	printf("Stream: %llu subscribers served, %llu packets sent, %llu lag notices, "
+			"%llu subscribers dropped for lagging\n",
+			(unsigned long long)str->accepted, (unsigned long long)str->packets,
+			(unsigned long long)str->lagged, (unsigned long long)str->dropped);
+}
+/* end of function: str_print */
+/*******************************************************************************/
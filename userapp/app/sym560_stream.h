@@ -0,0 +1,81 @@
+/* File : 	sym560_stream.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Live event stream for the automatic mode.  The writer thread
+ *		copies every record it takes from the capture ring into a broadcast
+ *		ring, and a server thread sends them on to any number of local
+ *		subscribers over a SOCK_SEQPACKET Unix socket, each from its own
+ *		cursor.  A subscriber that cannot keep up only ever holds up itself:
+ *		once the broadcast ring has moved on past its cursor it is told how
+ *		many events it missed, and if that happens more than STR_MAX_LAGS
+ *		times before it catches up it is disconnected.  See sym560_stream.c
+ *		for the protocol.
+ */
+
+#ifndef SYM560_STREAM_H
+#define SYM560_STREAM_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/un.h>
+#include "sym560_capture.h"
+
+/* where the automatic mode serves the stream unless told otherwise */
+#define STR_DEFAULT_PATH	"/tmp/sym560.stream"
+
+/* broadcast ring holds 2^STR_RING_ORDER records (2 MB, a minute of pulses at 1 kHz) */
+#define STR_RING_ORDER		16
+
+/* subscribers served at once, most records per packet, and how many times a
+ * subscriber may fall a whole ring behind before it is disconnected */
+#define STR_MAX_CLIENTS		16
+#define STR_BATCH		128
+#define STR_MAX_LAGS		3
+
+/* how long str_stop keeps sending to subscribers that are still catching up */
+#define STR_DRAIN_MS		1000
+
+/* packet types */
+#define STR_EVENTS		1	/* count records follow the header */
+#define STR_LAG			2	/* missed events were skipped, nothing follows */
+
+/* start of every packet */
+struct str_header {
+	uint32_t type;			/* STR_EVENTS or STR_LAG */
+	uint32_t count;			/* records following */
+	uint64_t missed;		/* STR_LAG: events skipped */
+};
+
+struct str_client {
+	int sock;			/* -1 = free */
+	uint64_t cursor;		/* next broadcast ring position to send */
+	uint64_t missed;		/* events skipped that it has not been told about */
+	int lags;			/* times it fell a whole ring behind without catching up */
+	int blocked;			/* its socket buffer was full last time */
+};
+
+struct stream {
+	struct capture *cap;
+	int lsock;			/* listening socket */
+	struct str_client client[STR_MAX_CLIENTS];
+	char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+	struct sym560_record *rec;	/* broadcast ring storage */
+	uint64_t mask;
+	_Atomic uint64_t head;		/* slots before this are filled */
+	_Atomic uint64_t claim;		/* slots before this may be being overwritten */
+	pthread_t thread;
+	_Atomic int stop;
+	_Atomic uint64_t accepted;	/* subscribers connected since the start */
+	_Atomic uint64_t packets;	/* STR_EVENTS packets sent */
+	_Atomic uint64_t lagged;	/* STR_LAG packets sent */
+	_Atomic uint64_t dropped;	/* subscribers disconnected for lagging */
+};
+
+/* function declarations */
+int str_start(struct stream *str, struct capture *cap, const char *path);
+void str_publish(struct stream *str, const struct sym560_record *rec, uint64_t n);
+void str_stop(struct stream *str);
+void str_print(const struct stream *str);
+
+#endif /* SYM560_STREAM_H */
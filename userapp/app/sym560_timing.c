@@ -0,0 +1,548 @@
+/* File : 	sym560_timing.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Pulse timing histograms (see sym560_timing.h): the record
+ *		format written for each table and minute, and the report of
+ *		"sym560_cmdline timing", which adds up any number of the day
+ *		files and gives, for each table and pulse, the spread of the
+ *		pulses and how many were inside the window, and the Allan
+ *		deviation of the sequence starts.  Only buckets that are not empty
+ *		are written, so a minute of a steady radar takes a few kB.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sym560_timing.h"
+
+/* most tables a report adds up */
+#define TIM_MAX_TOTALS		16
+
+/* a table's histograms over all the records read */
+struct tim_total {
+	char name[SEQ_NAME_LEN];
+	int npulse;
+	int64_t window;			/* -1 if the records disagree */
+	int64_t first_ns;		/* earliest and latest minute */
+	int64_t last_ns;
+	uint64_t minutes;		/* records added */
+	uint64_t sequences;
+	uint64_t missing;
+	uint64_t within[SEQ_MAX_PULSES];
+	uint64_t count[SEQ_MAX_PULSES][TIM_BUCKETS];
+	struct adev_sums adev;
+};
+
+
+/*******************************************************************************/
+/* Function   : tim_bounds
+ * Inputs     : int idx - bucket
+ *		int64_t *lo, int64_t *hi - receive the least and greatest
+ *				values it holds, ns
+ * Returns    : Nothing
+ * Description: The outermost buckets also hold everything beyond them.
+ */
+void tim_bounds(int idx, int64_t *lo, int64_t *hi) {
+	int i = idx >= TIM_HALF ? idx - TIM_HALF : TIM_HALF - 1 - idx;
+	int64_t a, width;
+
+	if (i < 16) {
+		a = i;
+		width = 1;
+	}
+	else {
+		width = 1LL << ((i - 16) / 8 + 1);
+		a = (8 + (i - 16) % 8) * width;
+	}
+	if (idx >= TIM_HALF) {
+		*lo = a;
+		*hi = a + width - 1;
+	}
+	else {
+		*lo = -(a + width);
+		*hi = -(a + 1);
+	}
+}
+/* end of function: tim_bounds */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : tim_filename
+ * Inputs     : int64_t ns - UTC time in nanoseconds
+ *		char *filename - buffer of at least TIM_FILENAME_LEN bytes
+ * Returns    : Nothing
+ * Description: Names the day's histogram file YYYYMMDD.timing, to go with
+ *		its YYYYMMDD.HHMM.timestampdata files.
+ */
+void tim_filename(int64_t ns, char *filename) {
+	time_t rawtime = ns / 1000000000LL;
+	struct tm tm;
+
+	gmtime_r(&rawtime, &tm);
+	sprintf(filename, "%04d%02d%02d.timing", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+}
+/* end of function: tim_filename */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : tim_encode
+ * Inputs     : const struct tim_hist *h - the table's minute
+ *		const struct adev_sums *sums - its Allan deviation sums
+ *		const struct seq_table *tab - the table
+ *		int64_t minute_ns - UTC start of the minute
+ *		int64_t window - the window within was counted for, ns
+ *		char *buf - buffer of at least TIM_RECORD_MAX bytes
+ * Returns    : Length of the record
+ */
+size_t tim_encode(const struct tim_hist *h, const struct adev_sums *sums, const struct seq_table *tab,
+		int64_t minute_ns, int64_t window, char *buf) {
+	struct tim_header *hdr = (struct tim_header *)buf;
+	struct tim_entry *e;
+	size_t len;
+	int k, b;
+
+	memset(hdr, 0, sizeof(*hdr));
+	hdr->magic = TIM_MAGIC;
+	hdr->version = TIM_VERSION;
+	hdr->npulse = tab->npulse;
+	hdr->minute_ns = minute_ns;
+	memcpy(hdr->table, tab->name, SEQ_NAME_LEN);
+	hdr->window_ns = window;
+	hdr->sequences = h->sequences;
+	hdr->missing = h->missing;
+	len = sizeof(*hdr);
+	memcpy(buf + len, h->within, tab->npulse * sizeof(uint32_t));
+	len += tab->npulse * sizeof(uint32_t);
+	memcpy(buf + len, sums, sizeof(*sums));
+	len += sizeof(*sums);
+
+	e = (struct tim_entry *)(buf + len);
+	for (k = 0; k < tab->npulse; k++) {
+		for (b = 0; b < TIM_BUCKETS; b++) {
+			if (h->count[k][b] != 0) {
+				e->pulse = k;
+				e->pad = 0;
+				e->bucket = b;
+				e->count = h->count[k][b];
+				e++;
+				hdr->entries++;
+			}
+		}
+	}
+	return len + hdr->entries * sizeof(struct tim_entry);
+}
+/* end of function: tim_encode */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : tim_acc_init
+ * Inputs     : struct tim_acc *a - accumulator
+ *		const struct seq_set *set - tables, kept until tim_acc_free
+ *		int64_t window - pulses this close to their places are counted
+ *		as inside the window, ns
+ * Returns    : 0 on success
+ *             -1 if it could not be allocated
+ */
+int tim_acc_init(struct tim_acc *a, const struct seq_set *set, int64_t window) {
+	int c;
+
+	memset(a, 0, sizeof(*a));
+	a->set = set;
+	a->window = window;
+	a->hist = calloc(set->ntab, sizeof(*a->hist));
+	a->adev = malloc(set->ntab * sizeof(*a->adev));
+	if (a->hist == NULL || a->adev == NULL) {
+		printf("\nCould not allocate the timing histograms\n");
+		tim_acc_free(a);
+		return -1;
+	}
+	for (c = 0; c < set->ntab; c++) {
+		adev_init(&a->adev[c]);
+	}
+	return 0;
+}
+/* end of function: tim_acc_init */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : tim_acc_due
+ * Inputs     : const struct tim_acc *a - accumulator
+ *		const struct seq_result *seq - next sequence
+ * Returns    : 1 if it starts in a later minute than the one being added
+ *		up, which should be taken first
+ *		0 otherwise
+ */
+int tim_acc_due(const struct tim_acc *a, const struct seq_result *seq) {
+	return a->minute != 0 && seq->start_ns - seq->start_ns % 60000000000LL > a->minute;
+}
+/* end of function: tim_acc_due */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : tim_acc_add
+ * Inputs     : struct tim_acc *a - accumulator
+ *		const struct seq_result *seq - sequence found
+ * Returns    : Nothing
+ * Description: Adds the sequence to the minute it started in, or to the one
+ *		being added up if that is later (by no more than the length of
+ *		a sequence, as they finish close to in order).
+ */
+void tim_acc_add(struct tim_acc *a, const struct seq_result *seq) {
+	const struct seq_table *tab = &a->set->tab[seq->table];
+	struct tim_hist *h = &a->hist[seq->table];
+	int64_t minute = seq->start_ns - seq->start_ns % 60000000000LL, resid, sum = 0;
+	int k;
+
+	if (minute > a->minute) {
+		a->minute = minute;
+	}
+	h->sequences++;
+	h->missing += seq->npulse - seq->found;
+	for (k = 0; k < seq->npulse; k++) {
+		if (seq->present & (1U << k)) {
+			resid = seq->ns[k] - seq->start_ns - tab->off[k];
+			tim_add(h, k, resid, a->window);
+			sum += resid;
+		}
+	}
+	adev_add(&a->adev[seq->table], seq->start_ns + sum / seq->found);
+}
+/* end of function: tim_acc_add */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : tim_acc_take
+ * Inputs     : struct tim_acc *a - accumulator
+ *		char *buf - buffer of at least ntab * TIM_RECORD_MAX bytes
+ * Returns    : Length of the minute's records, 0 if there was none
+ * Description: Encodes the minute being added up, a record for each table
+ *		that had sequences in it, and empties it.
+ */
+size_t tim_acc_take(struct tim_acc *a, char *buf) {
+	size_t len = 0;
+	int c;
+
+	for (c = 0; c < a->set->ntab; c++) {
+		if (a->hist[c].sequences != 0) {
+			len += tim_encode(&a->hist[c], &a->adev[c].s, &a->set->tab[c], a->minute, a->window,
+					buf + len);
+			memset(&a->hist[c], 0, sizeof(a->hist[c]));
+			memset(&a->adev[c].s, 0, sizeof(a->adev[c].s));
+		}
+	}
+	a->minute = 0;
+	return len;
+}
+/* end of function: tim_acc_take */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : tim_acc_free
+ * Inputs     : struct tim_acc *a - accumulator
+ * Returns    : Nothing
+ */
+void tim_acc_free(struct tim_acc *a) {
+	free(a->hist);
+	free(a->adev);
+	a->hist = NULL;
+	a->adev = NULL;
+}
+/* end of function: tim_acc_free */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : tim_quantile
+ * Inputs     : const uint64_t *count - TIM_BUCKETS counts
+ *		uint64_t total - their sum, not 0
+ *		double q - fraction, 0 to 1
+ * Returns    : The middle of the bucket holding that fraction of the
+ *		values, in us
+ */
+static double tim_quantile(const uint64_t *count, uint64_t total, double q) {
+	uint64_t rank = (uint64_t)(q * total), seen = 0;
+	int64_t lo, hi;
+	int b;
+
+	if (rank >= total) {
+		rank = total - 1;
+	}
+	for (b = 0; b < TIM_BUCKETS - 1; b++) {
+		seen += count[b];
+		if (seen > rank) {
+			break;
+		}
+	}
+	tim_bounds(b, &lo, &hi);
+	return (lo + hi) / 2e3;
+}
+/* end of function: tim_quantile */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : tim_worst
+ * Inputs     : const uint64_t *count - TIM_BUCKETS counts, not all 0
+ * Returns    : The outer edge of the bucket furthest from 0 that is not
+ *		empty, in us
+ */
+static double tim_worst(const uint64_t *count) {
+	int64_t lo, hi, worst = 0;
+	int b;
+
+	for (b = 0; b < TIM_BUCKETS; b++) {
+		if (count[b] != 0) {
+			tim_bounds(b, &lo, &hi);
+			worst = lo < 0 && -lo > worst ? -lo : worst;
+			worst = hi > worst ? hi : worst;
+		}
+	}
+	return worst / 1e3;
+}
+/* end of function: tim_worst */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : tim_line
+ * Inputs     : const uint64_t *count - TIM_BUCKETS counts
+ *		uint64_t within - of them inside the window
+ * Returns    : Nothing
+ * Description: The spread and window figures shared by the report's lines.
+ */
+static void tim_line(const uint64_t *count, uint64_t within) {
+	uint64_t total = 0;
+	int b;
+
+	for (b = 0; b < TIM_BUCKETS; b++) {
+		total += count[b];
+	}
+	if (total == 0) {
+		printf("%10s\n", "none seen");
+		return;
+	}
+	printf("%10llu %+8.2f %+8.2f %+8.2f %8.2f %9.3f%%\n", (unsigned long long)total,
+			tim_quantile(count, total, 0.01), tim_quantile(count, total, 0.5),
+			tim_quantile(count, total, 0.99), tim_worst(count), 100.0 * within / total);
+}
+/* end of function: tim_line */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : tim_read
+ * Inputs     : FILE *fp - histogram file
+ *		struct tim_header *hdr - receives the record's header
+ *		uint32_t *within - receives its within counts
+ *		struct adev_sums *sums - receives its Allan deviation sums
+ *		uint64_t (*count)[TIM_BUCKETS] - its counts are added to these
+ *		uint64_t *all - and to these, all pulses together
+ * Returns    : 0 on success
+ *		1 at the end of the file
+ *             -1 at a record that is not whole, or not a record
+ */
+int tim_read(FILE *fp, struct tim_header *hdr, uint32_t *within, struct adev_sums *sums,
+		uint64_t (*count)[TIM_BUCKETS], uint64_t *all) {
+	struct tim_entry e;
+	uint32_t cnt;
+	size_t got;
+
+	got = fread(hdr, 1, sizeof(*hdr), fp);
+	if (got == 0 && feof(fp)) {
+		return 1;
+	}
+	if (got != sizeof(*hdr) || hdr->magic != TIM_MAGIC
+			|| hdr->version != TIM_VERSION || hdr->npulse > SEQ_MAX_PULSES
+			|| fread(within, sizeof(uint32_t), hdr->npulse, fp) != hdr->npulse
+			|| fread(sums, sizeof(*sums), 1, fp) != 1) {
+		return -1;
+	}
+	hdr->table[SEQ_NAME_LEN - 1] = '\0';
+	for (cnt = 0; cnt < hdr->entries; cnt++) {
+		if (fread(&e, sizeof(e), 1, fp) != 1 || e.pulse >= hdr->npulse || e.bucket >= TIM_BUCKETS) {
+			return -1;
+		}
+		count[e.pulse][e.bucket] += e.count;
+		all[e.bucket] += e.count;
+	}
+	return 0;
+}
+/* end of function: tim_read */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : tim_total_for
+ * Inputs     : struct tim_total *tot - totals so far
+ *		int *ntot - how many
+ *		const struct tim_header *hdr - record to add
+ * Returns    : Its table's totals, NULL if there are already TIM_MAX_TOTALS
+ *		other tables
+ */
+static struct tim_total *tim_total_for(struct tim_total *tot, int *ntot, const struct tim_header *hdr) {
+	struct tim_total *t;
+	int c;
+
+	for (c = 0; c < *ntot; c++) {
+		if (strcmp(tot[c].name, hdr->table) == 0 && tot[c].npulse == hdr->npulse) {
+			return &tot[c];
+		}
+	}
+	if (*ntot == TIM_MAX_TOTALS) {
+		return NULL;
+	}
+	t = &tot[(*ntot)++];
+	strcpy(t->name, hdr->table);
+	t->npulse = hdr->npulse;
+	t->window = hdr->window_ns;
+	t->first_ns = hdr->minute_ns;
+	t->last_ns = hdr->minute_ns;
+	return t;
+}
+/* end of function: tim_total_for */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : timing
+ * Inputs     : char **files - histogram files, in any order
+ *		int nfile - how many
+ *		int minutes - also print a line for each minute
+ * Returns    : 0 on success
+ *             -1 if a file could not be read, or held something else
+ * Description: Adds up every record of each table and prints, for each
+ *		pulse, how many were seen, the 1st, 50th and 99th percentiles
+ *		of how far they were from their places, the furthest, and the
+ *		share inside the window.  Each figure is good to the bucket
+ *		holding it.
+ */
+int timing(char **files, int nfile, int minutes) {
+	struct tim_total *tot, *t;
+	struct tim_header hdr;
+	struct adev_sums sums;
+	uint32_t within[SEQ_MAX_PULSES];
+	uint64_t (*count)[TIM_BUCKETS], all[TIM_BUCKETS], in_all, pulses, skipped = 0;
+	double tau, dev;
+	char when[32];
+	time_t secs;
+	struct tm tm;
+	FILE *fp;
+	int ntot = 0, ret = 0, f, k, c, got;
+
+	tot = calloc(TIM_MAX_TOTALS, sizeof(*tot));
+	count = calloc(SEQ_MAX_PULSES, sizeof(*count));
+	if (tot == NULL || count == NULL) {
+		free(tot);
+		free(count);
+		return -1;
+	}
+	if (minutes) {
+		printf("%-14s %-16s %6s %7s %10s %8s %8s %8s %8s %10s\n", "minute", "table", "seqs",
+				"missing", "pulses", "p1 us", "p50 us", "p99 us", "worst", "in window");
+	}
+	for (f = 0; f < nfile; f++) {
+		fp = fopen(files[f], "r");
+		if (fp == NULL) {
+			printf("\nCould not open %s: %s\n", files[f], strerror(errno));
+			ret = -1;
+			continue;
+		}
+		for (;;) {
+			memset(count, 0, SEQ_MAX_PULSES * sizeof(*count));
+			memset(all, 0, sizeof(all));
+			got = tim_read(fp, &hdr, within, &sums, count, all);
+			if (got != 0) {
+				break;
+			}
+			t = tim_total_for(tot, &ntot, &hdr);
+			if (t == NULL) {
+				skipped++;
+				continue;
+			}
+			in_all = 0;
+			for (k = 0; k < hdr.npulse; k++) {
+				t->within[k] += within[k];
+				in_all += within[k];
+				for (c = 0; c < TIM_BUCKETS; c++) {
+					t->count[k][c] += count[k][c];
+				}
+			}
+			adev_merge(&t->adev, &sums);
+			t->sequences += hdr.sequences;
+			t->missing += hdr.missing;
+			t->minutes++;
+			t->first_ns = hdr.minute_ns < t->first_ns ? hdr.minute_ns : t->first_ns;
+			t->last_ns = hdr.minute_ns > t->last_ns ? hdr.minute_ns : t->last_ns;
+			if (t->window != hdr.window_ns) {
+				t->window = -1;
+			}
+			if (minutes) {
+				secs = hdr.minute_ns / 1000000000LL;
+				gmtime_r(&secs, &tm);
+				strftime(when, sizeof(when), "%Y-%j %H:%M", &tm);
+				printf("%-14s %-16s %6u %7u ", when, hdr.table, hdr.sequences, hdr.missing);
+				tim_line(all, in_all);
+			}
+		}
+		if (got == -1) {
+			printf("\n%s is not a timing file, or is cut short\n", files[f]);
+			ret = -1;
+		}
+		fclose(fp);
+	}
+
+	for (c = 0; c < ntot; c++) {
+		t = &tot[c];
+		pulses = t->sequences * t->npulse;
+		secs = t->first_ns / 1000000000LL;
+		gmtime_r(&secs, &tm);
+		strftime(when, sizeof(when), "%Y-%j %H:%M", &tm);
+		printf("\n%s: %llu sequences in %llu minutes from %s", t->name,
+				(unsigned long long)t->sequences, (unsigned long long)t->minutes, when);
+		secs = t->last_ns / 1000000000LL;
+		gmtime_r(&secs, &tm);
+		strftime(when, sizeof(when), "%Y-%j %H:%M", &tm);
+		printf(" to %s, %.3f%% of their pulses missing\n", when,
+				pulses != 0 ? 100.0 * t->missing / pulses : 0.0);
+		printf("%6s %10s %8s %8s %8s %8s  ", "pulse", "seen", "p1 us", "p50 us", "p99 us", "worst");
+		if (t->window == -1) {
+			printf("in window (the files had different windows)\n");
+		}
+		else {
+			printf("within +-%.1f us\n", t->window / 1e3);
+		}
+		for (k = 0; k < t->npulse; k++) {
+			printf("%6d ", k + 1);
+			tim_line(t->count[k], t->within[k]);
+		}
+		if (adev_deviation(&t->adev, 0, &tau, &dev) != 0) {
+			continue;
+		}
+		printf("\nAllan deviation of the sequence starts, %u runs at a mean period of %.3f ms\n",
+				t->adev.runs, tau * 1e3);
+		printf("%12s %12s %12s\n", "tau s", "terms", "deviation");
+		for (k = 0; k < ADEV_OCTAVES; k++) {
+			if (adev_deviation(&t->adev, k, &tau, &dev) == 0) {
+				printf("%12.3f %12u %12.3e\n", tau, t->adev.n[k], dev);
+			}
+		}
+	}
+	if (skipped != 0) {
+		printf("\nOnly the first %d tables were added up, %llu minutes of others left out\n",
+				TIM_MAX_TOTALS, (unsigned long long)skipped);
+	}
+	free(tot);
+	free(count);
+	return ret;
+}
+/* end of function: timing */
+/*******************************************************************************/
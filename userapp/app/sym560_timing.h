@@ -0,0 +1,151 @@
+/* File : 	sym560_timing.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Histograms of how far each pulse of a sequence was from where
+ *		its table puts it, one per pulse of each table and minute.  The
+ *		tracker (sym560_tracker.c) adds every pulse it places and writes
+ *		each minute's histograms to the day's YYYYMMDD.timing file, so the
+ *		radar's timing can be followed over weeks without reading the
+ *		timestamps again; "sym560_cmdline timing" reads them back.
+ *
+ *		The buckets are exact up to 16 ns and then 8 to each power of 2,
+ *		so every value is known to within 1/8 of itself, from 0 out to
+ *		16.7 ms either side.  Adding a pulse is a bucket number and an
+ *		increment.  Whether a pulse was inside the window (+-8 us, ePOP's
+ *		requirement, by default) is counted exactly as well, since a
+ *		bucket may straddle its edge.
+ *
+ *		Each record also holds the minute's share of the Allan deviation
+ *		sums of the table's sequence starts (sym560_allan.h), so the
+ *		stability over a month is the sum of its records.  A sequence's
+ *		start is taken as the mean of where its pulses put it.
+ *
+ *		struct tim_acc adds up the minutes for the tracker and for
+ *		"sym560_cmdline backfill", which makes the files from archived
+ *		timestamps.
+ */
+
+#ifndef SYM560_TIMING_H
+#define SYM560_TIMING_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "sym560_seq.h"
+#include "sym560_allan.h"
+
+/* buckets either side of 0: 16 exact, then 8 to each power of 2 up to 2^24;
+ * 0 is in the first one above, so those below are for -1 and less */
+#define TIM_HALF		176
+#define TIM_BUCKETS		(2 * TIM_HALF)
+
+/* default window a pulse should be inside, ns */
+#define TIM_DEFAULT_WINDOW_NS	8000
+
+/* records of the files, in host byte order */
+#define TIM_MAGIC		0x544d5953	/* "SYMT" */
+#define TIM_VERSION		2
+
+/* longest name produced by tim_filename */
+#define TIM_FILENAME_LEN	24
+
+/* one table's minute */
+struct tim_hist {
+	uint32_t sequences;		/* of the table that started in the minute */
+	uint32_t missing;		/* pulses missing from them */
+	uint32_t within[SEQ_MAX_PULSES];	/* pulses inside the window, by pulse */
+	uint32_t count[SEQ_MAX_PULSES][TIM_BUCKETS];
+};
+
+/* Start of each record.  npulse within counts follow it, then the minute's
+ * struct adev_sums, then entries struct tim_entry, one for each bucket that
+ * is not empty. */
+struct tim_header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t npulse;
+	int64_t minute_ns;		/* UTC start of the minute */
+	char table[SEQ_NAME_LEN];
+	uint32_t window_ns;
+	uint32_t sequences;
+	uint32_t missing;
+	uint32_t entries;
+};
+
+struct tim_entry {
+	uint8_t pulse;
+	uint8_t pad;
+	uint16_t bucket;
+	uint32_t count;
+};
+
+/* most bytes tim_encode writes for one table */
+#define TIM_RECORD_MAX		(sizeof(struct tim_header) + SEQ_MAX_PULSES * sizeof(uint32_t) \
+				 + sizeof(struct adev_sums) + SEQ_MAX_PULSES * TIM_BUCKETS * sizeof(struct tim_entry))
+
+/* The minutes being added up, one table's of each in hist and adev.  The
+ * estimators carry on from one minute to the next; only their sums are
+ * emptied when a minute is written. */
+struct tim_acc {
+	const struct seq_set *set;
+	int64_t window;			/* pulses this close to their places are counted, ns */
+	int64_t minute;			/* UTC start of the minute, 0 = none */
+	struct tim_hist *hist;
+	struct adev *adev;
+};
+
+/*******************************************************************************/
+/* Function   : tim_bucket
+ * Inputs     : int64_t ns - how far a pulse was from its place
+ * Returns    : Its bucket, in order of value
+ */
+static inline int tim_bucket(int64_t ns) {
+	uint64_t a = ns < 0 ? -(uint64_t)ns - 1 : (uint64_t)ns;
+	int msb, idx;
+
+	if (a < 16) {
+		idx = (int)a;
+	}
+	else {
+		if (a >= 1ULL << 24) {
+			a = (1ULL << 24) - 1;
+		}
+		msb = 63 - __builtin_clzll(a);
+		idx = 16 + (msb - 4) * 8 + (int)(a >> (msb - 3)) - 8;
+	}
+	return ns < 0 ? TIM_HALF - 1 - idx : TIM_HALF + idx;
+}
+/* end of function: tim_bucket */
+/*******************************************************************************/
+
+/*******************************************************************************/
+/* Function   : tim_add
+ * Inputs     : struct tim_hist *h - the table's minute
+ *		int k - pulse, from 0
+ *		int64_t ns - how far it was from its place
+ *		int64_t window - the window, ns
+ * Returns    : Nothing
+ */
+static inline void tim_add(struct tim_hist *h, int k, int64_t ns, int64_t window) {
+	h->count[k][tim_bucket(ns)]++;
+	if (ns <= window && ns >= -window) {
+		h->within[k]++;
+	}
+}
+/* end of function: tim_add */
+/*******************************************************************************/
+
+/* function declarations */
+void tim_bounds(int idx, int64_t *lo, int64_t *hi);
+void tim_filename(int64_t ns, char *filename);
+size_t tim_encode(const struct tim_hist *h, const struct adev_sums *sums, const struct seq_table *tab,
+		int64_t minute_ns, int64_t window, char *buf);
+int tim_read(FILE *fp, struct tim_header *hdr, uint32_t *within, struct adev_sums *sums,
+		uint64_t (*count)[TIM_BUCKETS], uint64_t *all);
+int tim_acc_init(struct tim_acc *a, const struct seq_set *set, int64_t window);
+int tim_acc_due(const struct tim_acc *a, const struct seq_result *seq);
+void tim_acc_add(struct tim_acc *a, const struct seq_result *seq);
+size_t tim_acc_take(struct tim_acc *a, char *buf);
+void tim_acc_free(struct tim_acc *a);
+int timing(char **files, int nfile, int minutes);
+
+#endif /* SYM560_TIMING_H */
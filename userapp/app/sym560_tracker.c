@@ -0,0 +1,293 @@
+/* File : 	sym560_tracker.c
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Pulse sequences found while capturing (see sym560_tracker.h).
+ *		The writer calls trk_feed for every event and trk_idle while the
+ *		ring is empty, the same way as for the radar joiner; each is one
+ *		detector step and writes at most one line.  A DETECTED line reads
+ *
+ *		    DETECTED = 2026-290 12:00:00.1234567 UTC katscan 6/7 0x7d RESIDUALS +0.0 +0.4 - ... us
+ *
+ *		stamped with the time of the sequence's first pulse (inferred if
+ *		it is missing), then the table, the pulses seen out of the table's,
+ *		which ones (bit k for pulse k + 1) and for each pulse in order how
+ *		far it was from where the table puts it, or '-' if it was missing.
+ *		The pulse the sequence was placed by is at +0.0.  Like the MARKER
+ *		line it has no YEAR in it, so findpulse.pl and findpulse pass over
+ *		it.
+ *
+ *		Each sequence is added to the timing histograms and Allan deviation
+ *		sums of the minute it started in.  The minute's records go through
+ *		the writer's IO backend like the timestamps, from one of two
+ *		buffers in turn, so writing them never waits on the disk.
+ */
+
+#include "sym560_functions.h"
+#include "sym560_tracker.h"
+
+/*******************************************************************************/
+/* Function   : trk_residual
+ * Inputs     : const struct tracker *t - tracker
+ *		const struct seq_result *seq - sequence found
+ *		int k - one of its pulses that was seen
+ * Returns    : How far the pulse was from where the table puts it, ns
+ */
+static int64_t trk_residual(const struct tracker *t, const struct seq_result *seq, int k) {
+	return seq->ns[k] - seq->start_ns - t->tab.tab[seq->table].off[k];
+}
+/* end of function: trk_residual */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : trk_format
+ * Inputs     : const struct tracker *t - tracker
+ *		const struct seq_result *seq - sequence found
+ *		char *txtbuff - buffer of at least TRK_TEXT_MAX bytes
+ * Returns    : Number of characters written to txtbuff
+ */
+int trk_format(const struct tracker *t, const struct seq_result *seq, char *txtbuff) {
+	const struct seq_table *tab = &t->tab.tab[seq->table];
+	time_t secs = seq->start_ns / 1000000000LL;
+	struct tm tm;
+	int k, len;
+
+	gmtime_r(&secs, &tm);
+	len = sprintf(txtbuff, "     DETECTED = %04d-%03d %02d:%02d:%02d.%07lld UTC %s %d/%d 0x%x RESIDUALS",
+			tm.tm_year + 1900, tm.tm_yday + 1, tm.tm_hour, tm.tm_min, tm.tm_sec,
+			(long long)(seq->start_ns % 1000000000LL) / 100, tab->name, seq->found,
+			seq->npulse, seq->present);
+	for (k = 0; k < seq->npulse; k++) {
+		if (seq->present & (1U << k)) {
+			len += sprintf(txtbuff + len, " %+.1f", trk_residual(t, seq, k) / 1e3);
+		}
+		else {
+			strcpy(txtbuff + len, " -");
+			len += 2;
+		}
+	}
+	strcpy(txtbuff + len, " us\n\n");
+	return len + 5;
+}
+/* end of function: trk_format */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : trk_minute
+ * Inputs     : struct tracker *t - tracker
+ * Returns    : Nothing
+ * Description: Writes the minute being added up to its day's file and
+ *		empties it.  The buffer used last time but one is waited for
+ *		first, though that write finished long ago.
+ */
+static void trk_minute(struct tracker *t) {
+	struct wio *io = &t->cap->io;
+	char filename[TIM_FILENAME_LEN];
+	char *buf = t->hist_buf[t->hist_cur];
+	int64_t minute = t->acc.minute;
+	size_t len;
+	int fd;
+
+	if (t->hist_seq[t->hist_cur] != 0) {
+		io_wait(io, t->hist_seq[t->hist_cur] - 1);
+	}
+	len = tim_acc_take(&t->acc, buf);
+	if (len == 0) {
+		return;
+	}
+	tim_filename(minute, filename);
+	fd = open(filename, O_WRONLY|O_CREAT|O_APPEND, 00644);
+	if (fd == -1) {
+		atomic_fetch_add_explicit(&t->hist_errors, 1, memory_order_relaxed);
+		return;
+	}
+	t->hist_seq[t->hist_cur] = io_queue(io, IO_WRITE, fd, buf, len, 0) + 1;
+	io_queue(io, IO_CLOSE, fd, NULL, 0, 0);
+	t->hist_cur ^= 1;
+	atomic_fetch_add_explicit(&t->minutes, 1, memory_order_relaxed);
+}
+/* end of function: trk_minute */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : trk_count
+ * Inputs     : struct tracker *t - tracker
+ *		int ret - what the detector returned
+ *		const struct seq_result *seq - the sequence, for SEQ_DONE
+ * Returns    : Nothing
+ * Description: Only the writer updates the counts, so each is a plain load
+ *		and store, as for met_observe.  A sequence is also kept in
+ *		t->last, where the writer finds the pulses of its column rows.
+ */
+static void trk_count(struct tracker *t, int ret, const struct seq_result *seq) {
+	const struct seq_det *d = &t->det;
+
+	if (ret == SEQ_STRAY) {
+		atomic_store_explicit(&t->strays, d->strays, memory_order_relaxed);
+		return;
+	}
+	/* the last minute is written once a sequence of the next turns up */
+	if (tim_acc_due(&t->acc, seq)) {
+		trk_minute(t);
+	}
+	tim_acc_add(&t->acc, seq);
+	t->last = *seq;
+	atomic_store_explicit(&t->by_table[seq->table], d->by_table[seq->table], memory_order_relaxed);
+	if (seq->found == seq->npulse) {
+		atomic_store_explicit(&t->complete,
+			atomic_load_explicit(&t->complete, memory_order_relaxed) + 1, memory_order_relaxed);
+	}
+	atomic_store_explicit(&t->pulses, d->pulses, memory_order_relaxed);
+	atomic_store_explicit(&t->missing, d->missing, memory_order_relaxed);
+	atomic_store_explicit(&t->sequences, d->sequences, memory_order_relaxed);
+}
+/* end of function: trk_count */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : trk_feed
+ * Inputs     : struct tracker *t - tracker
+ *		int64_t ns - time of the next event
+ *		char *txtbuff - buffer of at least TRK_TEXT_MAX bytes
+ * Returns    : Number of characters written to txtbuff
+ * Description: Writer thread only, for every event in order, after the
+ *		event itself has been written.
+ */
+int trk_feed(struct tracker *t, int64_t ns, char *txtbuff) {
+	struct seq_result seq;
+	int64_t stray;
+	int ret;
+
+	ret = seq_feed(&t->det, ns, &seq, &stray);
+	if (ret == SEQ_NONE) {
+		return 0;
+	}
+	trk_count(t, ret, &seq);
+	return ret == SEQ_DONE ? trk_format(t, &seq, txtbuff) : 0;
+}
+/* end of function: trk_feed */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : trk_idle
+ * Inputs     : struct tracker *t - tracker
+ *		int64_t now - UTC time, INT64_MAX to finish everything
+ *		char *txtbuff - buffer of at least TRK_TEXT_MAX bytes
+ * Returns    : Number of characters written to txtbuff
+ * Description: Writer thread only, while no events are coming in.  Finishes
+ *		a sequence whose last pulses are missing once they can no longer
+ *		come, allowing CAP_LATE_NS for them to get through, and writes the
+ *		last minute's histograms once no more sequences can start in it.
+ *		Call again while it returns a line.
+ */
+int trk_idle(struct tracker *t, int64_t now, char *txtbuff) {
+	struct seq_result seq;
+	int64_t stray;
+	int ret;
+
+	ret = seq_idle(&t->det, now == INT64_MAX ? now : now - CAP_LATE_NS, &seq, &stray);
+	if (ret == SEQ_NONE) {
+		if (t->acc.minute != 0 && now - t->acc.minute >= 60000000000LL + TRK_MINUTE_SLACK_NS) {
+			trk_minute(t);
+		}
+		return 0;
+	}
+	trk_count(t, ret, &seq);
+	/* a stray leaves nothing to write, but there may be more to finish */
+	return ret == SEQ_DONE ? trk_format(t, &seq, txtbuff) : trk_idle(t, now, txtbuff);
+}
+/* end of function: trk_idle */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : trk_start
+ * Inputs     : struct tracker *t - tracker to set up
+ *		struct capture *cap - capture set up by cap_init
+ *		const char *tables - pulse tables, as for findpulse -p
+ *		int64_t tol - how far off its place a pulse may be, ns
+ *		int64_t window - pulses this close to their places are counted
+ *		as inside the window in the histograms, ns
+ * Returns    : 0 on success
+ *             -1 on failure
+ * Description: Hands the tracker to the writer.  Call between cap_init and
+ *		cap_start, so that it sees every event.
+ */
+int trk_start(struct tracker *t, struct capture *cap, const char *tables, int64_t tol, int64_t window) {
+	size_t size;
+
+	memset(t, 0, sizeof(*t));
+	if (seq_set_parse(&t->tab, tables, tol) != 0) {
+		return -1;
+	}
+	if (tim_acc_init(&t->acc, &t->tab, window) != 0) {
+		trk_stop(t, cap);
+		return -1;
+	}
+	size = t->tab.ntab * TIM_RECORD_MAX;
+	t->hist_buf[0] = malloc(size);
+	t->hist_buf[1] = malloc(size);
+	if (t->hist_buf[0] == NULL || t->hist_buf[1] == NULL) {
+		printf("\nCould not allocate the timing buffers\n");
+		trk_stop(t, cap);
+		return -1;
+	}
+	t->cap = cap;
+	seq_init(&t->det, &t->tab);
+	atomic_store_explicit(&cap->tracker, t, memory_order_release);
+	return 0;
+}
+/* end of function: trk_start */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : trk_stop
+ * Inputs     : struct tracker *t - tracker started by trk_start
+ *		struct capture *cap - its capture
+ * Returns    : Nothing
+ * Description: Call after cap_stop, by which time the writer has finished
+ *		every sequence and written the last histograms, and before
+ *		trk_print.
+ */
+void trk_stop(struct tracker *t, struct capture *cap) {
+	atomic_store_explicit(&cap->tracker, NULL, memory_order_release);
+	seq_set_free(&t->tab);
+	tim_acc_free(&t->acc);
+	free(t->hist_buf[0]);
+	free(t->hist_buf[1]);
+	t->hist_buf[0] = t->hist_buf[1] = NULL;
+}
+/* end of function: trk_stop */
+/*******************************************************************************/
+
+
+/*******************************************************************************/
+/* Function   : trk_print
+ * Inputs     : const struct tracker *t - stopped tracker
+ * Returns    : Nothing
+ */
+void trk_print(const struct tracker *t) {
+	uint64_t pulses = t->pulses + t->missing;
+	int c;
+
+	printf("Pulse sequences: %llu found, %llu with every pulse, %.2f%% of their pulses seen, %llu strays, "
+			"%llu minutes of timing", (unsigned long long)t->sequences, (unsigned long long)t->complete,
+			pulses != 0 ? 100.0 * t->pulses / pulses : 100.0,
+			(unsigned long long)t->strays, (unsigned long long)t->minutes);
+	if (t->hist_errors != 0) {
+		printf(" (%llu could not be written)", (unsigned long long)t->hist_errors);
+	}
+	printf("\n");
+	if (t->tab.ntab > 1) {
+		for (c = 0; c < t->tab.ntab; c++) {
+			printf("  %-16s %llu\n", t->tab.tab[c].name, (unsigned long long)t->by_table[c]);
+		}
+	}
+}
+/* end of function: trk_print */
+/*******************************************************************************/
@@ -0,0 +1,66 @@
+/* File : 	sym560_tracker.h
+ * Author: 	SuperDARN Canada
+ * Modified:	Oct 2026
+ * Description:	Pulse sequences found while capturing.  With a tracker the
+ *		writer thread runs the pulse sequence detector (sym560_seq.c) over
+ *		every event it takes from the capture ring and writes a DETECTED
+ *		line into the output after the event that finishes each sequence,
+ *		giving its start, which of its pulses were seen and how far each
+ *		one was from its place.  The detector is never reset when a new
+ *		file is started, so a sequence crossing a file boundary is found
+ *		whole, in the file its last pulse went to.  Its counts are kept
+ *		where the metrics and the control socket can read them, so the
+ *		completeness of the sequences is known while they are captured
+ *		rather than after findpulse has been run.  How far each pulse was
+ *		from its place is also added to that minute's histograms, and the
+ *		sequence's start to the Allan deviation of its table (see
+ *		sym560_timing.h), which are written to the day's YYYYMMDD.timing
+ *		file once the minute is over.
+ */
+
+#ifndef SYM560_TRACKER_H
+#define SYM560_TRACKER_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include "sym560_capture.h"
+#include "sym560_seq.h"
+#include "sym560_timing.h"
+
+/* a minute's histograms are written once sequences from the next one turn
+ * up, or this long after it ends if none do */
+#define TRK_MINUTE_SLACK_NS	2000000000LL
+
+/* longest DETECTED line written by trk_feed and trk_idle */
+#define TRK_TEXT_MAX		(96 + SEQ_NAME_LEN + 9 * SEQ_MAX_PULSES)
+
+/* The automatic mode's detector.  Used only by the writer thread once
+ * started; the counts may be read from any thread. */
+struct tracker {
+	struct capture *cap;		/* whose IO backend writes the histograms */
+	struct seq_set tab;
+	struct seq_det det;
+	struct tim_acc acc;		/* the minute's histograms */
+	struct seq_result last;		/* the sequence of the last DETECTED line */
+	char *hist_buf[2];		/* records being written, used in turn */
+	uint64_t hist_seq[2];		/* IO request writing each + 1, 0 = none */
+	int hist_cur;
+	_Atomic uint64_t sequences;	/* sequences found */
+	_Atomic uint64_t complete;	/* of them with every pulse */
+	_Atomic uint64_t pulses;	/* events placed in them */
+	_Atomic uint64_t missing;	/* pulses missing from them */
+	_Atomic uint64_t strays;	/* events in no sequence */
+	_Atomic uint64_t by_table[SEQ_MAX_TABLES];	/* sequences found of each table */
+	_Atomic uint64_t minutes;	/* minutes of histograms written */
+	_Atomic uint64_t hist_errors;	/* minutes lost because the day's file could not be opened */
+};
+
+/* function declarations */
+int trk_start(struct tracker *t, struct capture *cap, const char *tables, int64_t tol, int64_t window);
+int trk_feed(struct tracker *t, int64_t ns, char *txtbuff);
+int trk_idle(struct tracker *t, int64_t now, char *txtbuff);
+int trk_format(const struct tracker *t, const struct seq_result *seq, char *txtbuff);
+void trk_stop(struct tracker *t, struct capture *cap);
+void trk_print(const struct tracker *t);
+
+#endif /* SYM560_TRACKER_H */